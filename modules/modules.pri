@@ -0,0 +1,63 @@
+###################################################################################
+# OPP - libvlc modules, common qmake settings
+###################################################################################
+# This file is part of Open Projection Program (OPP).
+#
+# Copyright (C) 2013 Catalogue Ouvert du Cinéma <dev@cinemaouvert.fr>
+#
+# Authors: Jerome Blanchi <d.j.a.y@free.fr>
+#
+# Open Projection Program is free software: you can redistribute it and/or modify
+# it under the terms of the GNU General Public License as published by
+# the Free Software Foundation, either version 3 of the License, or
+# (at your option) any later version.
+#
+# Open Projection Program is distributed in the hope that it will be useful,
+# but WITHOUT ANY WARRANTY; without even the implied warranty of
+# MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+# GNU General Public License for more details.
+#
+# You should have received a copy of the GNU General Public License
+# along with Open Projection Program. If not, see <http://www.gnu.org/licenses/>.
+###################################################################################
+#
+# The modules are loaded by libvlc, not linked to OPP: VLCApplication adds the
+# "modules" directory next to the opp binary to the libvlc plugin path.
+
+TEMPLATE = lib
+CONFIG += plugin
+CONFIG -= qt
+
+# the modules are C99 with GCC options and builtins, as the modules of VLC
+win32-msvc*:error("The OPP libvlc modules are built with GCC or Clang")
+
+DESTDIR = $$OUT_PWD/../modules
+TARGET = $${MODULE_NAME}_plugin
+
+DEFINES += MODULE_STRING=\\\"$${MODULE_NAME}\\\"
+
+QMAKE_CFLAGS += -std=gnu99
+contains(QMAKE_HOST.arch, x86|i686|x86_64):QMAKE_CFLAGS += -msse2
+
+INCLUDEPATH += $$PWD
+
+# vlc core library and plugin headers: a module is only loaded by the core of
+# the ABI of its headers, so build against the libvlc found by pkg-config and
+# fall back on the bundled VLC 2.1 headers
+packagesExist(vlc-plugin) {
+    CONFIG += link_pkgconfig
+    PKGCONFIG += vlc-plugin
+    VLC_VERSION = $$system(pkg-config --modversion vlc-plugin)
+} else {
+    DEFINES += __PLUGIN__
+    DEFINES += _FILE_OFFSET_BITS=64
+    DEFINES += _REENTRANT
+    DEFINES += _THREAD_SAFE
+    INCLUDEPATH += $$PWD/../include/vlc/plugins
+    VLC_VERSION = 2.1.0
+
+    mac:LIBS += -L"/Applications/VLC.app/Contents/MacOS/lib"
+    unix:LIBS += -lvlccore
+    windows:LIBS += -L"C:/Program Files (x86)/VideoLAN/VLC/sdk/lib" -llibvlccore
+}
+DEFINES += OPP_VLC_MAJOR=$$section(VLC_VERSION, ., 0, 0)
@@ -0,0 +1,231 @@
+/**********************************************************************************
+ * This file is part of Open Projection Program (OPP).
+ *
+ * Copyright (C) 2013 Catalogue Ouvert du Cinéma <dev@cinemaouvert.fr>
+ *
+ * Authors: Jerome Blanchi <d.j.a.y@free.fr>
+ *
+ * Open Projection Program is an initiative of Catalogue Ouvert du Cinéma.
+ * The software was developed by four students of University of Poitiers
+ * as school project.
+ *
+ * Open Projection Program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Open Projection Program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Open Projection Program. If not, see <http://www.gnu.org/licenses/>.
+ **********************************************************************************/
+
+/*
+ * Parameters shared between OPP (the writer) and the OPP libvlc modules
+ * (the readers). The block lives in the MediaPlayer, its address is given to
+ * the modules as an integer option of each media (see FilterControl), read by
+ * the modules with var_InheritInteger.
+ *
+ * The block is protected by a sequence counter: the writer makes it odd while
+ * writing, the readers copy the block and retry if the counter moved. Readers
+ * never wait on the GUI thread.
+ */
+
+#ifndef OPP_CONTROL_H
+#define OPP_CONTROL_H
+
+#include <stdint.h>
+#include <string.h>
+
+#define OPP_VIDEO_FILTER        "oppadjust"
+#define OPP_VIDEO_CONTROL_VAR   "oppadjust-control"
+#define OPP_AUDIO_FILTER        "oppgain"
+#define OPP_AUDIO_CONTROL_VAR   "oppgain-control"
+#define OPP_METER_VAR           "oppgain-meter"
+#define OPP_METER_CHANNELS      8
+
+/* full barrier and atomic operations: GCC and Clang builtins, MSVC intrinsics */
+#if defined(_MSC_VER)
+# include <intrin.h>
+# define opp_barrier()              (_ReadWriteBarrier(), _mm_mfence())
+# define opp_fetch_add(p, v)        _InterlockedExchangeAdd((volatile long *)(p), (long)(v))
+# define opp_cas(p, o, n)           (_InterlockedCompareExchange((volatile long *)(p), (long)(n), (long)(o)) == (long)(o))
+# define opp_swap(p, v)             ((uint32_t)_InterlockedExchange((volatile long *)(p), (long)(v)))
+#else
+# define opp_barrier()              __sync_synchronize()
+# define opp_fetch_add(p, v)        __sync_fetch_and_add((p), (v))
+# define opp_cas(p, o, n)           __sync_bool_compare_and_swap((p), (o), (n))
+# define opp_swap(p, v)             __sync_lock_test_and_set((p), (v))
+#endif
+
+typedef struct opp_control_t
+{
+    volatile unsigned sequence;
+
+    /* media clock: the first frame after a start or a seek is at epoch_time */
+    unsigned epoch;
+    int64_t epoch_time;         /* ms */
+    int64_t paused;             /* total time spent in pause (us, libvlc clock) */
+
+    /* picture settings, same ranges as the libvlc adjust filter */
+    float gamma;
+    float brightness;
+    float contrast;
+    float saturation;
+    int hue;                    /* degrees */
+
+    /* video fades on the media clock (ms), no fade if the length is 0 */
+    int64_t video_in_start;
+    int64_t video_in_length;
+    int64_t video_out_start;
+    int64_t video_out_length;
+
+    /* audio gain (dB) and fades on the media clock (ms) */
+    float gain;
+    int64_t audio_in_start;
+    int64_t audio_in_length;
+    int64_t audio_out_start;
+    int64_t audio_out_length;
+
+    /* go to black and silence on the libvlc clock (us), off if the date is 0 */
+    int64_t black_date;
+    int64_t black_length;
+} opp_control_t;
+
+/*
+ * Levels of the samples leaving the audio module, for the meters of OPP.
+ * The module is the only writer of the sums, protected by their own sequence
+ * counter. The peaks are raised by the module and taken (reset) by OPP with
+ * atomic operations, so no peak is lost between two readings.
+ */
+typedef struct opp_meter_t
+{
+    volatile unsigned sequence;
+    unsigned channels;
+    uint64_t frames;                            /* frames measured since the start */
+    double squares[OPP_METER_CHANNELS];         /* sum of the squares since the start */
+
+    /* highest absolute sample since taken, as the bits of a positive float */
+    volatile uint32_t peaks[OPP_METER_CHANNELS];
+} opp_meter_t;
+
+/* media clock of a module, rebased on the first frame of each epoch */
+typedef struct opp_clock_t
+{
+    unsigned epoch;
+    int64_t origin;
+    int64_t paused;
+} opp_clock_t;
+
+static inline void opp_control_init(opp_control_t *control)
+{
+    memset((void *)control, 0, sizeof(*control));
+    control->gamma = 1.f;
+    control->brightness = 1.f;
+    control->contrast = 1.f;
+    control->saturation = 1.f;
+}
+
+static inline void opp_control_write_begin(opp_control_t *control)
+{
+    opp_fetch_add(&control->sequence, 1);
+    opp_barrier();
+}
+
+static inline void opp_control_write_end(opp_control_t *control)
+{
+    opp_barrier();
+    opp_fetch_add(&control->sequence, 1);
+}
+
+static inline void opp_control_read(const opp_control_t *control, opp_control_t *copy)
+{
+    unsigned sequence;
+
+    do {
+        while ((sequence = control->sequence) & 1)
+            ;
+        opp_barrier();
+        memcpy((void *)copy, (const void *)control, sizeof(*copy));
+        opp_barrier();
+    } while (sequence != control->sequence);
+}
+
+static inline void opp_clock_init(opp_clock_t *clock, const opp_control_t *control)
+{
+    clock->epoch = control->epoch - 1;
+    clock->origin = 0;
+    clock->paused = 0;
+}
+
+/* media time (us) of a frame from its date on the libvlc clock */
+static inline int64_t opp_clock_time(opp_clock_t *clock, const opp_control_t *control, int64_t date)
+{
+    if (control->epoch != clock->epoch) {
+        clock->epoch = control->epoch;
+        clock->origin = date;
+        clock->paused = control->paused;
+    }
+
+    return control->epoch_time * 1000 + date - clock->origin - (control->paused - clock->paused);
+}
+
+static inline void opp_meter_init(opp_meter_t *meter)
+{
+    memset((void *)meter, 0, sizeof(*meter));
+}
+
+/* module side: add the levels of a block */
+static inline void opp_meter_add(opp_meter_t *meter, unsigned channels, unsigned frames,
+                                 const float *peaks, const double *squares)
+{
+    if (channels > OPP_METER_CHANNELS)
+        channels = OPP_METER_CHANNELS;
+
+    opp_fetch_add(&meter->sequence, 1);
+    opp_barrier();
+    meter->channels = channels;
+    meter->frames += frames;
+    for (unsigned c = 0; c < channels; c++)
+        meter->squares[c] += squares[c];
+    opp_barrier();
+    opp_fetch_add(&meter->sequence, 1);
+
+    /* positive floats compare as their bits */
+    for (unsigned c = 0; c < channels; c++) {
+        uint32_t bits, old;
+        memcpy(&bits, &peaks[c], sizeof(bits));
+        while ((old = meter->peaks[c]) < bits
+               && !opp_cas(&meter->peaks[c], old, bits))
+            ;
+    }
+}
+
+/* OPP side: copy the sums and take the peaks, return the number of channels */
+static inline unsigned opp_meter_take(opp_meter_t *meter, uint64_t *frames,
+                                      double squares[OPP_METER_CHANNELS], float peaks[OPP_METER_CHANNELS])
+{
+    unsigned sequence, channels;
+
+    do {
+        while ((sequence = meter->sequence) & 1)
+            ;
+        opp_barrier();
+        channels = meter->channels;
+        *frames = meter->frames;
+        memcpy(squares, meter->squares, sizeof(meter->squares));
+        opp_barrier();
+    } while (sequence != meter->sequence);
+
+    for (unsigned c = 0; c < channels; c++) {
+        uint32_t bits = opp_swap(&meter->peaks[c], 0);
+        memcpy(&peaks[c], &bits, sizeof(bits));
+    }
+
+    return channels;
+}
+
+#endif // OPP_CONTROL_H
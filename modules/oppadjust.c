@@ -0,0 +1,420 @@
+/**********************************************************************************
+ * This file is part of Open Projection Program (OPP).
+ *
+ * Copyright (C) 2013 Catalogue Ouvert du Cinéma <dev@cinemaouvert.fr>
+ *
+ * Authors: Jerome Blanchi <d.j.a.y@free.fr>
+ *
+ * Open Projection Program is an initiative of Catalogue Ouvert du Cinéma.
+ * The software was developed by four students of University of Poitiers
+ * as school project.
+ *
+ * Open Projection Program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Open Projection Program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Open Projection Program. If not, see <http://www.gnu.org/licenses/>.
+ **********************************************************************************/
+
+/*
+ * libvlc video filter applying the picture settings and the fades of OPP.
+ *
+ * The filter follows the opp_control_t block of the media player: each picture
+ * gets the fade level of its own date, so the ramps are as smooth as the frame
+ * rate and do not depend on the GUI. The luma goes through an affine kernel
+ * (or a table when the gamma is not neutral), the chroma through a 2x2 matrix
+ * for the saturation and the hue. Kernels are SSE2 when available.
+ */
+
+#include <math.h>
+#include <stdlib.h>
+
+#include <vlc_common.h>
+#include <vlc_plugin.h>
+#include <vlc_filter.h>
+#include <vlc_picture.h>
+#include <vlc_cpu.h>
+
+/* no translation of the descriptions, outside of the VLC tree */
+#ifndef N_
+# define N_(str) (str)
+#endif
+
+#ifdef __SSE2__
+# include <emmintrin.h>
+#endif
+
+#include "opp_control.h"
+
+static int  Open (vlc_object_t *);
+static void Close(vlc_object_t *);
+
+vlc_module_begin ()
+    set_description (N_("OPP picture settings and fades"))
+    set_shortname (N_("OPP adjust"))
+    set_category (CAT_VIDEO)
+    set_subcategory (SUBCAT_VIDEO_VFILTER)
+#if OPP_VLC_MAJOR >= 3
+    set_capability ("video filter", 0)
+#else
+    set_capability ("video filter2", 0)
+#endif
+    add_shortcut (OPP_VIDEO_FILTER)
+    /* address of the opp_control_t block, an option of the media played */
+    add_integer (OPP_VIDEO_CONTROL_VAR, 0, N_("OPP control block"), NULL, true)
+        change_private ()
+    set_callbacks (Open, Close)
+vlc_module_end ()
+
+/* Fixed point parameters of the kernels for one picture */
+typedef struct
+{
+    int luma_scale;     /* contrast, Q9 */
+    int luma_offset;    /* brightness */
+    int level;          /* fade level, Q10 */
+    int black;          /* black level of the luma */
+    int chroma[4];      /* saturation and hue matrix, Q9 */
+} kernel_t;
+
+struct filter_sys_t
+{
+    opp_control_t *control;
+    int black;
+    bool swap_uv;
+    bool sse2;
+
+    /* media clock of the pictures */
+    opp_clock_t clock;
+
+    /* gamma table of the last gamma, luma table of the last picture */
+    float gamma;
+    uint8_t gamma_table[256];
+    uint8_t luma_table[256];
+};
+
+static picture_t *Filter(filter_t *, picture_t *);
+
+/*****************************************************************************\
+                                  KERNELS
+\*****************************************************************************/
+
+static void LumaAffine_C(uint8_t *dst, const uint8_t *src, int width, const kernel_t *k)
+{
+    for (int x = 0; x < width; x++) {
+        int y = ((src[x] * 128 * k->luma_scale) >> 16) + k->luma_offset;
+        y = VLC_CLIP(y, 0, 255);
+        dst[x] = clip_uint8_vlc(k->black + (((y - k->black) * 64 * k->level) >> 16));
+    }
+}
+
+static void LumaTable_C(uint8_t *dst, const uint8_t *src, int width, const uint8_t *table)
+{
+    for (int x = 0; x < width; x++)
+        dst[x] = table[src[x]];
+}
+
+static void Chroma_C(uint8_t *dst_u, uint8_t *dst_v, const uint8_t *src_u, const uint8_t *src_v,
+                     int width, const kernel_t *k)
+{
+    for (int x = 0; x < width; x++) {
+        int du = (src_u[x] - 128) * 128;
+        int dv = (src_v[x] - 128) * 128;
+        dst_u[x] = clip_uint8_vlc(128 + ((du * k->chroma[0]) >> 16) + ((dv * k->chroma[1]) >> 16));
+        dst_v[x] = clip_uint8_vlc(128 + ((du * k->chroma[2]) >> 16) + ((dv * k->chroma[3]) >> 16));
+    }
+}
+
+#ifdef __SSE2__
+/* same arithmetic as the C kernels, 16 pixels at once */
+static void LumaAffine_SSE2(uint8_t *dst, const uint8_t *src, int width, const kernel_t *k)
+{
+    const __m128i zero = _mm_setzero_si128();
+    const __m128i white = _mm_set1_epi16(255);
+    const __m128i scale = _mm_set1_epi16(k->luma_scale);
+    const __m128i offset = _mm_set1_epi16(k->luma_offset);
+    const __m128i level = _mm_set1_epi16(k->level);
+    const __m128i black = _mm_set1_epi16(k->black);
+    int x = 0;
+
+    for (; x + 16 <= width; x += 16) {
+        __m128i in = _mm_loadu_si128((const __m128i *)(src + x));
+        __m128i y[2] = { _mm_unpacklo_epi8(in, zero), _mm_unpackhi_epi8(in, zero) };
+
+        for (int i = 0; i < 2; i++) {
+            y[i] = _mm_add_epi16(_mm_mulhi_epi16(_mm_slli_epi16(y[i], 7), scale), offset);
+            y[i] = _mm_min_epi16(_mm_max_epi16(y[i], zero), white);
+            y[i] = _mm_mulhi_epi16(_mm_slli_epi16(_mm_sub_epi16(y[i], black), 6), level);
+            y[i] = _mm_add_epi16(y[i], black);
+        }
+        _mm_storeu_si128((__m128i *)(dst + x), _mm_packus_epi16(y[0], y[1]));
+    }
+
+    LumaAffine_C(dst + x, src + x, width - x, k);
+}
+
+static void Chroma_SSE2(uint8_t *dst_u, uint8_t *dst_v, const uint8_t *src_u, const uint8_t *src_v,
+                        int width, const kernel_t *k)
+{
+    const __m128i zero = _mm_setzero_si128();
+    const __m128i center = _mm_set1_epi16(128);
+    const __m128i m0 = _mm_set1_epi16(k->chroma[0]);
+    const __m128i m1 = _mm_set1_epi16(k->chroma[1]);
+    const __m128i m2 = _mm_set1_epi16(k->chroma[2]);
+    const __m128i m3 = _mm_set1_epi16(k->chroma[3]);
+    int x = 0;
+
+    for (; x + 16 <= width; x += 16) {
+        __m128i in_u = _mm_loadu_si128((const __m128i *)(src_u + x));
+        __m128i in_v = _mm_loadu_si128((const __m128i *)(src_v + x));
+        __m128i u[2] = { _mm_unpacklo_epi8(in_u, zero), _mm_unpackhi_epi8(in_u, zero) };
+        __m128i v[2] = { _mm_unpacklo_epi8(in_v, zero), _mm_unpackhi_epi8(in_v, zero) };
+
+        for (int i = 0; i < 2; i++) {
+            __m128i du = _mm_slli_epi16(_mm_sub_epi16(u[i], center), 7);
+            __m128i dv = _mm_slli_epi16(_mm_sub_epi16(v[i], center), 7);
+            u[i] = _mm_add_epi16(center, _mm_add_epi16(_mm_mulhi_epi16(du, m0), _mm_mulhi_epi16(dv, m1)));
+            v[i] = _mm_add_epi16(center, _mm_add_epi16(_mm_mulhi_epi16(du, m2), _mm_mulhi_epi16(dv, m3)));
+        }
+        _mm_storeu_si128((__m128i *)(dst_u + x), _mm_packus_epi16(u[0], u[1]));
+        _mm_storeu_si128((__m128i *)(dst_v + x), _mm_packus_epi16(v[0], v[1]));
+    }
+
+    Chroma_C(dst_u + x, dst_v + x, src_u + x, src_v + x, width - x, k);
+}
+#endif
+
+/*****************************************************************************\
+                                 PARAMETERS
+\*****************************************************************************/
+
+static float Clip(float value, float min, float max)
+{
+    return value < min ? min : (value > max ? max : value);
+}
+
+/* fade level of a picture, between 0 (black) and 1 */
+static float FadeLevel(const opp_control_t *control, int64_t time, mtime_t date)
+{
+    float level = 1.f;
+
+    if (control->video_in_length > 0)
+        level *= Clip((float)(time - control->video_in_start) / control->video_in_length, 0.f, 1.f);
+
+    if (control->video_out_length > 0)
+        level *= Clip((float)(control->video_out_start + control->video_out_length - time)
+                      / control->video_out_length, 0.f, 1.f);
+
+    if (control->black_date > 0) {
+        if (control->black_length > 0)
+            level *= Clip((float)(control->black_date + control->black_length - date)
+                          / control->black_length, 0.f, 1.f);
+        else if (date >= control->black_date)
+            level = 0.f;
+    }
+
+    return level;
+}
+
+static bool IsNeutral(const opp_control_t *control)
+{
+    return fabsf(control->gamma - 1.f) < .001f
+        && fabsf(control->brightness - 1.f) < .001f
+        && fabsf(control->contrast - 1.f) < .001f
+        && fabsf(control->saturation - 1.f) < .001f
+        && control->hue % 360 == 0;
+}
+
+static void SetupKernel(filter_sys_t *sys, const opp_control_t *control, float level, kernel_t *k)
+{
+    float contrast = Clip(control->contrast, 0.f, 2.f);
+    float brightness = Clip(control->brightness, 0.f, 2.f);
+    float saturation = Clip(control->saturation, 0.f, 3.f) * level;
+    float hue = control->hue * (float)M_PI / 180.f;
+
+    /* same curve as the adjust filter of libvlc */
+    k->luma_scale = lroundf(contrast * 512.f);
+    k->luma_offset = lroundf((brightness - 1.f) * 255.f + 128.f - contrast * 128.f);
+    k->level = lroundf(level * 1024.f);
+    k->black = sys->black;
+
+    k->chroma[0] = lroundf(cosf(hue) * saturation * 512.f);
+    k->chroma[1] = lroundf(sinf(hue) * saturation * 512.f);
+    k->chroma[2] = -k->chroma[1];
+    k->chroma[3] = k->chroma[0];
+}
+
+static bool SetupLumaTable(filter_sys_t *sys, const opp_control_t *control, const kernel_t *k)
+{
+    float gamma = Clip(control->gamma, .01f, 10.f);
+
+    if (fabsf(gamma - 1.f) < .001f)
+        return false;
+
+    if (gamma != sys->gamma) {
+        for (int i = 0; i < 256; i++)
+            sys->gamma_table[i] = clip_uint8_vlc(lroundf(powf(i / 255.f, 1.f / gamma) * 255.f));
+        sys->gamma = gamma;
+    }
+
+    for (int i = 0; i < 256; i++) {
+        int y = ((i * 128 * k->luma_scale) >> 16) + k->luma_offset;
+        y = sys->gamma_table[VLC_CLIP(y, 0, 255)];
+        sys->luma_table[i] = clip_uint8_vlc(k->black + (((y - k->black) * 64 * k->level) >> 16));
+    }
+
+    return true;
+}
+
+/*****************************************************************************\
+                                   FILTER
+\*****************************************************************************/
+
+static int Open(vlc_object_t *object)
+{
+    filter_t *filter = (filter_t *)object;
+    filter_sys_t *sys;
+    opp_control_t *control;
+    int black = 16;
+    bool swap_uv = false;
+
+    /* only the players of OPP give their parameters */
+    control = (opp_control_t *)(uintptr_t)var_InheritInteger(filter, OPP_VIDEO_CONTROL_VAR);
+    if (control == NULL) {
+        msg_Dbg(filter, "no OPP control block, filter disabled");
+        return VLC_EGENERIC;
+    }
+
+    switch (filter->fmt_in.video.i_chroma) {
+    case VLC_CODEC_J420:
+    case VLC_CODEC_J422:
+    case VLC_CODEC_J440:
+    case VLC_CODEC_J444:
+        black = 0;
+        break;
+    case VLC_CODEC_YV12:
+        swap_uv = true;
+        break;
+    case VLC_CODEC_I410:
+    case VLC_CODEC_I411:
+    case VLC_CODEC_I420:
+    case VLC_CODEC_I422:
+    case VLC_CODEC_I440:
+    case VLC_CODEC_I444:
+        break;
+    default:
+        msg_Dbg(filter, "unsupported chroma %4.4s", (char *)&filter->fmt_in.video.i_chroma);
+        return VLC_EGENERIC;
+    }
+
+    if (filter->fmt_in.video.i_chroma != filter->fmt_out.video.i_chroma) {
+        msg_Dbg(filter, "input and output chromas differ");
+        return VLC_EGENERIC;
+    }
+
+    sys = malloc(sizeof(*sys));
+    if (sys == NULL)
+        return VLC_ENOMEM;
+
+    sys->control = control;
+    sys->black = black;
+    sys->swap_uv = swap_uv;
+#ifdef __SSE2__
+    sys->sse2 = vlc_CPU_SSE2();
+#else
+    sys->sse2 = false;
+#endif
+    opp_clock_init(&sys->clock, control);
+    sys->gamma = 0.f;
+
+    filter->p_sys = sys;
+    filter->pf_video_filter = Filter;
+
+    return VLC_SUCCESS;
+}
+
+static void Close(vlc_object_t *object)
+{
+    filter_t *filter = (filter_t *)object;
+
+    free(filter->p_sys);
+}
+
+static picture_t *Filter(filter_t *filter, picture_t *src)
+{
+    filter_sys_t *sys = filter->p_sys;
+    opp_control_t control;
+    picture_t *dst;
+    kernel_t kernel;
+    float level;
+    bool table;
+
+    if (src == NULL)
+        return NULL;
+
+    opp_control_read(sys->control, &control);
+    level = FadeLevel(&control, opp_clock_time(&sys->clock, &control, src->date) / 1000, src->date);
+
+    if (level >= 1.f && IsNeutral(&control))
+        return src;
+
+    dst = filter_NewPicture(filter);
+    if (dst == NULL) {
+        picture_Release(src);
+        return NULL;
+    }
+
+    SetupKernel(sys, &control, level, &kernel);
+    table = SetupLumaTable(sys, &control, &kernel);
+
+    /* luma */
+    const plane_t *in = &src->p[Y_PLANE];
+    plane_t *out = &dst->p[Y_PLANE];
+    int width = __MIN(in->i_visible_pitch, out->i_visible_pitch);
+    int lines = __MIN(in->i_visible_lines, out->i_visible_lines);
+
+    for (int y = 0; y < lines; y++) {
+        const uint8_t *s = in->p_pixels + y * in->i_pitch;
+        uint8_t *d = out->p_pixels + y * out->i_pitch;
+
+        if (table)
+            LumaTable_C(d, s, width, sys->luma_table);
+#ifdef __SSE2__
+        else if (sys->sse2)
+            LumaAffine_SSE2(d, s, width, &kernel);
+#endif
+        else
+            LumaAffine_C(d, s, width, &kernel);
+    }
+
+    /* chroma, the matrix needs both planes */
+    int u = sys->swap_uv ? V_PLANE : U_PLANE;
+    int v = sys->swap_uv ? U_PLANE : V_PLANE;
+    width = __MIN(src->p[u].i_visible_pitch, dst->p[u].i_visible_pitch);
+    lines = __MIN(src->p[u].i_visible_lines, dst->p[u].i_visible_lines);
+
+    for (int y = 0; y < lines; y++) {
+        const uint8_t *su = src->p[u].p_pixels + y * src->p[u].i_pitch;
+        const uint8_t *sv = src->p[v].p_pixels + y * src->p[v].i_pitch;
+        uint8_t *du = dst->p[u].p_pixels + y * dst->p[u].i_pitch;
+        uint8_t *dv = dst->p[v].p_pixels + y * dst->p[v].i_pitch;
+
+#ifdef __SSE2__
+        if (sys->sse2)
+            Chroma_SSE2(du, dv, su, sv, width, &kernel);
+        else
+#endif
+            Chroma_C(du, dv, su, sv, width, &kernel);
+    }
+
+    picture_CopyProperties(dst, src);
+    picture_Release(src);
+
+    return dst;
+}
@@ -0,0 +1,333 @@
+/**********************************************************************************
+ * This file is part of Open Projection Program (OPP).
+ *
+ * Copyright (C) 2013 Catalogue Ouvert du Cinéma <dev@cinemaouvert.fr>
+ *
+ * Authors: Jerome Blanchi <d.j.a.y@free.fr>
+ *
+ * Open Projection Program is an initiative of Catalogue Ouvert du Cinéma.
+ * The software was developed by four students of University of Poitiers
+ * as school project.
+ *
+ * Open Projection Program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Open Projection Program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Open Projection Program. If not, see <http://www.gnu.org/licenses/>.
+ **********************************************************************************/
+
+/*
+ * libvlc audio filter applying the gain and the fades of OPP.
+ *
+ * The filter follows the opp_control_t block of the media player. The fade
+ * curve is computed exactly every SEGMENT frames from the date of the samples
+ * and the gain is ramped linearly in between, so there is no step to hear.
+ * The ramps are SSE when the channels fit in the vectors.
+ *
+ * The filter also measures the peak and the power of each channel of the
+ * samples it outputs, for the meters of OPP (opp_meter_t).
+ */
+
+#include <math.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <vlc_common.h>
+#include <vlc_plugin.h>
+#include <vlc_aout.h>
+#include <vlc_filter.h>
+#include <vlc_block.h>
+#include <vlc_cpu.h>
+
+/* no translation of the descriptions, outside of the VLC tree */
+#ifndef N_
+# define N_(str) (str)
+#endif
+
+#ifdef __SSE__
+# include <xmmintrin.h>
+#endif
+
+#include "opp_control.h"
+
+static int  Open (vlc_object_t *);
+static void Close(vlc_object_t *);
+
+vlc_module_begin ()
+    set_description (N_("OPP gain and fades"))
+    set_shortname (N_("OPP gain"))
+    set_category (CAT_AUDIO)
+    set_subcategory (SUBCAT_AUDIO_AFILTER)
+    set_capability ("audio filter", 0)
+    add_shortcut (OPP_AUDIO_FILTER)
+    /* addresses of the opp_control_t and opp_meter_t blocks, options of the media played */
+    add_integer (OPP_AUDIO_CONTROL_VAR, 0, N_("OPP control block"), NULL, true)
+        change_private ()
+    add_integer (OPP_METER_VAR, 0, N_("OPP meter block"), NULL, true)
+        change_private ()
+    set_callbacks (Open, Close)
+vlc_module_end ()
+
+/* frames between two exact points of the fade curve */
+#define SEGMENT 32
+
+struct filter_sys_t
+{
+    opp_control_t *control;
+    opp_meter_t *meter;
+    unsigned channels;
+    unsigned rate;
+    bool sse;
+
+    /* media clock of the samples */
+    opp_clock_t clock;
+};
+
+static block_t *Filter(filter_t *, block_t *);
+
+/*****************************************************************************\
+                                   RAMPS
+\*****************************************************************************/
+
+static void Ramp_C(float *samples, unsigned frames, unsigned channels, float gain, float step)
+{
+    for (unsigned n = 0; n < frames; n++, gain += step)
+        for (unsigned c = 0; c < channels; c++)
+            *samples++ *= gain;
+}
+
+#ifdef __SSE__
+/* 4 samples per vector: 4, 2 or 1 frames for 1, 2 or 4 channels, a part of a frame above */
+static void Ramp_SSE(float *samples, unsigned frames, unsigned channels, float gain, float step)
+{
+    unsigned count = frames * channels;
+    unsigned i = 0;
+    __m128 g, s;
+
+    if (channels % 4 == 0) {
+        for (unsigned n = 0; n < frames; n++, gain += step) {
+            g = _mm_set1_ps(gain);
+            for (unsigned c = 0; c < channels; c += 4, samples += 4)
+                _mm_storeu_ps(samples, _mm_mul_ps(_mm_loadu_ps(samples), g));
+        }
+        return;
+    }
+
+    if (channels == 1) {
+        g = _mm_set_ps(gain + 3 * step, gain + 2 * step, gain + step, gain);
+        s = _mm_set1_ps(4 * step);
+    } else {
+        g = _mm_set_ps(gain + step, gain + step, gain, gain);
+        s = _mm_set1_ps(2 * step);
+    }
+
+    for (; i + 4 <= count; i += 4) {
+        _mm_storeu_ps(samples + i, _mm_mul_ps(_mm_loadu_ps(samples + i), g));
+        g = _mm_add_ps(g, s);
+    }
+
+    Ramp_C(samples + i, (count - i) / channels, channels, gain + step * (i / channels), step);
+}
+#endif
+
+/*****************************************************************************\
+                                   METER
+\*****************************************************************************/
+
+static void Measure_C(const float *samples, unsigned frames, unsigned channels,
+                      float *peaks, double *squares)
+{
+    unsigned measured = __MIN(channels, OPP_METER_CHANNELS);
+
+    for (unsigned n = 0; n < frames; n++, samples += channels)
+        for (unsigned c = 0; c < measured; c++) {
+            float x = samples[c];
+            float a = fabsf(x);
+
+            if (a > peaks[c])
+                peaks[c] = a;
+            squares[c] += x * x;
+        }
+}
+
+#ifdef __SSE__
+/* 1, 2 or 4 channels: lane i of the vectors is always channel i % channels */
+static void Measure_SSE(const float *samples, unsigned frames, unsigned channels,
+                        float *peaks, double *squares)
+{
+    unsigned count = frames * channels;
+    unsigned i = 0;
+    const __m128 sign = _mm_set1_ps(-0.f);
+    __m128 max = _mm_setzero_ps();
+    __m128 sum = _mm_setzero_ps();
+    float lanes[2][4];
+
+    for (; i + 4 <= count; i += 4) {
+        __m128 x = _mm_loadu_ps(samples + i);
+
+        max = _mm_max_ps(max, _mm_andnot_ps(sign, x));
+        sum = _mm_add_ps(sum, _mm_mul_ps(x, x));
+    }
+
+    _mm_storeu_ps(lanes[0], max);
+    _mm_storeu_ps(lanes[1], sum);
+    for (unsigned l = 0; l < 4; l++) {
+        if (lanes[0][l] > peaks[l % channels])
+            peaks[l % channels] = lanes[0][l];
+        squares[l % channels] += lanes[1][l];
+    }
+
+    Measure_C(samples + i, (count - i) / channels, channels, peaks, squares);
+}
+#endif
+
+static void Meter(filter_sys_t *sys, const float *samples, unsigned frames)
+{
+    float peaks[OPP_METER_CHANNELS] = { 0.f };
+    double squares[OPP_METER_CHANNELS] = { 0. };
+
+#ifdef __SSE__
+    if (sys->sse && sys->channels <= 4 && 4 % sys->channels == 0)
+        Measure_SSE(samples, frames, sys->channels, peaks, squares);
+    else
+#endif
+        Measure_C(samples, frames, sys->channels, peaks, squares);
+
+    opp_meter_add(sys->meter, sys->channels, frames, peaks, squares);
+}
+
+/*****************************************************************************\
+                                   LEVEL
+\*****************************************************************************/
+
+/* smooth start and end, 0 before the fade and 1 after */
+static float Curve(float x)
+{
+    if (x <= 0.f)
+        return 0.f;
+    if (x >= 1.f)
+        return 1.f;
+
+    return .5f - .5f * cosf(x * (float)M_PI);
+}
+
+/* fade level of a frame, without the gain */
+static float FadeLevel(const opp_control_t *control, int64_t time, mtime_t date)
+{
+    float level = 1.f;
+
+    if (control->audio_in_length > 0)
+        level *= Curve((float)(time - control->audio_in_start * 1000)
+                       / (control->audio_in_length * 1000));
+
+    if (control->audio_out_length > 0)
+        level *= Curve((float)((control->audio_out_start + control->audio_out_length) * 1000 - time)
+                       / (control->audio_out_length * 1000));
+
+    if (control->black_date > 0) {
+        if (control->black_length > 0)
+            level *= Curve((float)(control->black_date + control->black_length - date)
+                           / control->black_length);
+        else if (date >= control->black_date)
+            level = 0.f;
+    }
+
+    return level;
+}
+
+/*****************************************************************************\
+                                   FILTER
+\*****************************************************************************/
+
+static int Open(vlc_object_t *object)
+{
+    filter_t *filter = (filter_t *)object;
+    filter_sys_t *sys;
+    opp_control_t *control;
+
+    /* only the players of OPP give their parameters */
+    control = (opp_control_t *)(uintptr_t)var_InheritInteger(filter, OPP_AUDIO_CONTROL_VAR);
+    if (control == NULL) {
+        msg_Dbg(filter, "no OPP control block, filter disabled");
+        return VLC_EGENERIC;
+    }
+
+    sys = malloc(sizeof(*sys));
+    if (sys == NULL)
+        return VLC_ENOMEM;
+
+    filter->fmt_in.audio.i_format = VLC_CODEC_FL32;
+    aout_FormatPrepare(&filter->fmt_in.audio);
+    filter->fmt_out.audio = filter->fmt_in.audio;
+
+    sys->control = control;
+    sys->meter = (opp_meter_t *)(uintptr_t)var_InheritInteger(filter, OPP_METER_VAR);
+    sys->channels = aout_FormatNbChannels(&filter->fmt_in.audio);
+    sys->rate = filter->fmt_in.audio.i_rate;
+#ifdef __SSE__
+    sys->sse = vlc_CPU_SSE() && (sys->channels <= 2 || sys->channels % 4 == 0);
+#else
+    sys->sse = false;
+#endif
+    opp_clock_init(&sys->clock, control);
+
+    filter->p_sys = sys;
+    filter->pf_audio_filter = Filter;
+
+    return VLC_SUCCESS;
+}
+
+static void Close(vlc_object_t *object)
+{
+    filter_t *filter = (filter_t *)object;
+
+    free(filter->p_sys);
+}
+
+static block_t *Filter(filter_t *filter, block_t *block)
+{
+    filter_sys_t *sys = filter->p_sys;
+    opp_control_t control;
+    float *samples = (float *)block->p_buffer;
+    unsigned frames = block->i_nb_samples;
+    int64_t time;
+    float gain, from, to;
+
+    if (frames == 0 || sys->channels == 0 || sys->rate == 0)
+        return block;
+
+    opp_control_read(sys->control, &control);
+    time = opp_clock_time(&sys->clock, &control, block->i_pts);
+    gain = powf(10.f, control.gain / 20.f);
+    from = gain * FadeLevel(&control, time, block->i_pts);
+
+    for (unsigned n = 0; n < frames; n += SEGMENT) {
+        unsigned count = __MIN(SEGMENT, frames - n);
+        mtime_t offset = (mtime_t)(n + count) * CLOCK_FREQ / sys->rate;
+
+        to = gain * FadeLevel(&control, time + offset, block->i_pts + offset);
+
+        if (from != 1.f || to != 1.f) {
+#ifdef __SSE__
+            if (sys->sse)
+                Ramp_SSE(samples + n * sys->channels, count, sys->channels, from, (to - from) / count);
+            else
+#endif
+                Ramp_C(samples + n * sys->channels, count, sys->channels, from, (to - from) / count);
+        }
+
+        from = to;
+    }
+
+    if (sys->meter != NULL)
+        Meter(sys, samples, frames);
+
+    return block;
+}
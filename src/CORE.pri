@@ -37,7 +37,22 @@ HEADERS += src/media.h \
     src/plugins.h \
     src/updater.h \
     src/config.h \
-    src/VLCApplication.h
+    src/VLCApplication.h \
+    src/loudnessmeter.h \
+    src/audioanalyzer.h \
+    src/loudnessanalyzer.h \
+    src/waveform.h \
+    src/waveformextractor.h \
+    src/videoanalyzer.h \
+    src/blackdetector.h \
+    src/cropdetector.h \
+    src/interlacedetector.h \
+    src/mediaverifier.h \
+    src/jobscheduler.h \
+    src/fingerprint.h \
+    src/filecopy.h \
+    src/showpackage.h \
+    src/thumbnailstore.h
 
 SOURCES += src/media.cpp \
     src/playback.cpp \
@@ -48,7 +63,22 @@ SOURCES += src/media.cpp \
     src/videotrack.cpp \
     src/updater.cpp \
     src/config.cpp \
-    src/VLCApplication.cpp
+    src/VLCApplication.cpp \
+    src/loudnessmeter.cpp \
+    src/audioanalyzer.cpp \
+    src/loudnessanalyzer.cpp \
+    src/waveform.cpp \
+    src/waveformextractor.cpp \
+    src/videoanalyzer.cpp \
+    src/blackdetector.cpp \
+    src/cropdetector.cpp \
+    src/interlacedetector.cpp \
+    src/mediaverifier.cpp \
+    src/jobscheduler.cpp \
+    src/fingerprint.cpp \
+    src/filecopy.cpp \
+    src/showpackage.cpp \
+    src/thumbnailstore.cpp
 
 # vlc library and headers
 mac:LIBS += -L"/Applications/VLC.app/Contents/MacOS/lib"
@@ -1,8 +1,14 @@
 HEADERS += \
-    src/C_MediaPlayer/MediaPlayer.h
+    src/C_MediaPlayer/MediaPlayer.h \
+    src/C_MediaPlayer/FilterControl.h \
+    modules/opp_control.h
 
 SOURCES += \
-    src/C_MediaPlayer/MediaPlayer.cpp
+    src/C_MediaPlayer/MediaPlayer.cpp \
+    src/C_MediaPlayer/FilterControl.cpp
 
 DEPENDPATH += ./src/C_MediaPlayer
 INCLUDEPATH += ./src/C_MediaPlayer
+
+# parameters shared with the OPP libvlc modules (see modules/modules.pro)
+INCLUDEPATH += ./modules
@@ -0,0 +1,217 @@
+/**********************************************************************************
+ * This file is part of Open Projection Program (OPP).
+ *
+ * Copyright (C) 2013 Catalogue Ouvert du Cinéma <dev@cinemaouvert.fr>
+ *
+ * Authors: Jerome Blanchi <d.j.a.y@free.fr>
+ *
+ * Open Projection Program is an initiative of Catalogue Ouvert du Cinéma.
+ * The software was developed by four students of University of Poitiers
+ * as school project.
+ *
+ * Open Projection Program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Open Projection Program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Open Projection Program. If not, see <http://www.gnu.org/licenses/>.
+ **********************************************************************************/
+
+#include "FilterControl.h"
+
+#include <math.h>
+#include <string.h>
+
+#include <QDebug>
+#include <QString>
+
+#include <vlc/vlc.h>
+
+/**
+ * @brief Tell if a module is in a list of filters given by libvlc
+ *
+ * Only the modules of the ABI of the core are listed, with the capability of
+ * their kind of filter.
+ */
+static bool hasModule(libvlc_module_description_t *list, const char *name)
+{
+    bool found = false;
+
+    for (libvlc_module_description_t *module = list; module != NULL; module = module->p_next)
+        if (qstrcmp(module->psz_name, name) == 0)
+            found = true;
+
+    libvlc_module_description_list_release(list);
+
+    return found;
+}
+
+FilterControl::FilterControl() :
+    _hasVideoFilter(false),
+    _hasAudioFilter(false),
+    _meterFrames(0),
+    _pauseDate(0)
+{
+    opp_control_init(&_control);
+    opp_meter_init(&_meter);
+    memset(_meterSquares, 0, sizeof(_meterSquares));
+}
+
+void FilterControl::attach(libvlc_instance_t *instance)
+{
+    _hasVideoFilter = hasModule(libvlc_video_filter_list_get(instance), OPP_VIDEO_FILTER);
+    if (!_hasVideoFilter)
+        qDebug() << "OPP video module not found: the picture settings go through the libvlc adjust filter"
+                 << "and the video fades are stepped by the GUI";
+
+    _hasAudioFilter = hasModule(libvlc_audio_filter_list_get(instance), OPP_AUDIO_FILTER);
+    if (!_hasAudioFilter)
+        qDebug() << "OPP audio module not found: the gain goes through the libvlc volume,"
+                 << "the audio fades are stepped by the GUI and there are no level meters";
+}
+
+QStringList FilterControl::mediaOptions() const
+{
+    QStringList options;
+
+    // the blocks outlive the media, the modules read their addresses as integers
+    if (_hasVideoFilter)
+        options << QString(":video-filter=") + OPP_VIDEO_FILTER
+                << QString(":%1=%2").arg(OPP_VIDEO_CONTROL_VAR).arg((qulonglong)(quintptr)&_control);
+
+    if (_hasAudioFilter)
+        options << QString(":audio-filter=") + OPP_AUDIO_FILTER
+                << QString(":%1=%2").arg(OPP_AUDIO_CONTROL_VAR).arg((qulonglong)(quintptr)&_control)
+                << QString(":%1=%2").arg(OPP_METER_VAR).arg((qulonglong)(quintptr)&_meter);
+
+    return options;
+}
+
+void FilterControl::setGamma(float gamma)
+{
+    opp_control_write_begin(&_control);
+    _control.gamma = gamma;
+    opp_control_write_end(&_control);
+}
+
+void FilterControl::setBrightness(float brightness)
+{
+    opp_control_write_begin(&_control);
+    _control.brightness = brightness;
+    opp_control_write_end(&_control);
+}
+
+void FilterControl::setContrast(float contrast)
+{
+    opp_control_write_begin(&_control);
+    _control.contrast = contrast;
+    opp_control_write_end(&_control);
+}
+
+void FilterControl::setSaturation(float saturation)
+{
+    opp_control_write_begin(&_control);
+    _control.saturation = saturation;
+    opp_control_write_end(&_control);
+}
+
+void FilterControl::setHue(int hue)
+{
+    opp_control_write_begin(&_control);
+    _control.hue = hue;
+    opp_control_write_end(&_control);
+}
+
+void FilterControl::setVideoFades(int inStart, int inLength, int outStart, int outLength)
+{
+    opp_control_write_begin(&_control);
+    _control.video_in_start = inStart;
+    _control.video_in_length = inLength > 0 ? inLength : 0;
+    _control.video_out_start = outStart;
+    _control.video_out_length = outLength > 0 ? outLength : 0;
+    opp_control_write_end(&_control);
+}
+
+void FilterControl::setGain(float gain)
+{
+    opp_control_write_begin(&_control);
+    _control.gain = gain;
+    opp_control_write_end(&_control);
+}
+
+void FilterControl::setAudioFades(int inStart, int inLength, int outStart, int outLength)
+{
+    opp_control_write_begin(&_control);
+    _control.audio_in_start = inStart;
+    _control.audio_in_length = inLength > 0 ? inLength : 0;
+    _control.audio_out_start = outStart;
+    _control.audio_out_length = outLength > 0 ? outLength : 0;
+    opp_control_write_end(&_control);
+}
+
+void FilterControl::goToBlack(int length)
+{
+    opp_control_write_begin(&_control);
+    _control.black_date = length > 0 ? libvlc_clock() : 0;
+    _control.black_length = length > 0 ? (int64_t)length * 1000 : 0;
+    opp_control_write_end(&_control);
+}
+
+void FilterControl::restartClock(int time)
+{
+    opp_control_write_begin(&_control);
+    _control.epoch++;
+    _control.epoch_time = time;
+    opp_control_write_end(&_control);
+}
+
+void FilterControl::pauseClock()
+{
+    if (_pauseDate == 0)
+        _pauseDate = libvlc_clock();
+}
+
+void FilterControl::resumeClock()
+{
+    if (_pauseDate == 0)
+        return;
+
+    // the pictures queued during the pause are dated later by the same amount
+    opp_control_write_begin(&_control);
+    _control.paused += libvlc_clock() - _pauseDate;
+    opp_control_write_end(&_control);
+
+    _pauseDate = 0;
+}
+
+int FilterControl::levels(float *peaks, float *rms, int count)
+{
+    uint64_t frames;
+    double squares[OPP_METER_CHANNELS];
+    float takenPeaks[OPP_METER_CHANNELS];
+    int channels;
+
+    if (!_hasAudioFilter)
+        return 0;
+
+    channels = opp_meter_take(&_meter, &frames, squares, takenPeaks);
+    if (channels > count)
+        channels = count;
+
+    // the sums only grow, the levels of the period are their differences
+    for (int c = 0; c < channels; c++) {
+        peaks[c] = takenPeaks[c];
+        rms[c] = frames > _meterFrames ? sqrt((squares[c] - _meterSquares[c]) / (frames - _meterFrames)) : 0.f;
+    }
+
+    _meterFrames = frames;
+    memcpy(_meterSquares, squares, sizeof(_meterSquares));
+
+    return channels;
+}
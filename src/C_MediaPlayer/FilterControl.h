@@ -0,0 +1,193 @@
+/**********************************************************************************
+ * This file is part of Open Projection Program (OPP).
+ *
+ * Copyright (C) 2013 Catalogue Ouvert du Cinéma <dev@cinemaouvert.fr>
+ *
+ * Authors: Jerome Blanchi <d.j.a.y@free.fr>
+ *
+ * Open Projection Program is an initiative of Catalogue Ouvert du Cinéma.
+ * The software was developed by four students of University of Poitiers
+ * as school project.
+ *
+ * Open Projection Program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Open Projection Program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Open Projection Program. If not, see <http://www.gnu.org/licenses/>.
+ **********************************************************************************/
+
+#ifndef FILTERCONTROL_H
+#define FILTERCONTROL_H
+
+#include <stdint.h>
+
+#include <QStringList>
+
+#include "opp_control.h"
+
+struct libvlc_instance_t;
+
+/**
+ * @brief Drive the OPP libvlc modules of a media player
+ *
+ * Holds the parameter block read by the modules for every picture and every
+ * audio block. The modules and the address of the block are given to each
+ * media as options, the block is read back by the modules as an integer. The
+ * modules compute the fades from the date of the frames, so nothing has to be
+ * done by the GUI while a fade runs. If a module is not installed, the player
+ * keeps the libvlc adjust filter, the libvlc volume and the stepped fades.
+ */
+class FilterControl
+{
+public:
+    FilterControl();
+
+    /**
+     * @brief Look for the modules among the filters loaded by libvlc
+     * @param instance The libvlc instance of the player
+     */
+    void attach(libvlc_instance_t *instance);
+
+    /**
+     * @brief Get the options giving the modules and the parameter block to a media
+     * @return The options to add to each media played, none without module
+     */
+    QStringList mediaOptions() const;
+
+    /**
+     * @brief Allow to know if the video module is used
+     * @return True if the pictures go through the module, false otherwise
+     */
+    inline bool hasVideoFilter() const { return _hasVideoFilter; }
+
+    /**
+     * @brief Allow to know if the audio module is used
+     * @return True if the samples go through the module, false otherwise
+     */
+    inline bool hasAudioFilter() const { return _hasAudioFilter; }
+
+    /**
+     * @brief Set the gamma (0.01 to 10, 1 is neutral)
+     */
+    void setGamma(float gamma);
+
+    /**
+     * @brief Set the brightness (0 to 2, 1 is neutral)
+     */
+    void setBrightness(float brightness);
+
+    /**
+     * @brief Set the contrast (0 to 2, 1 is neutral)
+     */
+    void setContrast(float contrast);
+
+    /**
+     * @brief Set the saturation (0 to 3, 1 is neutral)
+     */
+    void setSaturation(float saturation);
+
+    /**
+     * @brief Set the hue rotation in degrees
+     */
+    void setHue(int hue);
+
+    /**
+     * @brief Set the video fades on the media clock
+     * @param inStart The time where the fade-in starts (ms)
+     * @param inLength The fade-in length, 0 for none (ms)
+     * @param outStart The time where the fade-out starts (ms)
+     * @param outLength The fade-out length, 0 for none (ms)
+     */
+    void setVideoFades(int inStart, int inLength, int outStart, int outLength);
+
+    /**
+     * @brief Set the audio gain
+     * @param gain The gain in dB
+     */
+    void setGain(float gain);
+
+    /**
+     * @brief Set the audio fades on the media clock
+     * @param inStart The time where the fade-in starts (ms)
+     * @param inLength The fade-in length, 0 for none (ms)
+     * @param outStart The time where the fade-out starts (ms)
+     * @param outLength The fade-out length, 0 for none (ms)
+     */
+    void setAudioFades(int inStart, int inLength, int outStart, int outLength);
+
+    /**
+     * @brief Fade the pictures to black and the sound to silence from now on
+     * @param length The fade length (ms), 0 to cancel a running one
+     */
+    void goToBlack(int length);
+
+    /**
+     * @brief Tell the modules the next frame is at a new time (start or seek)
+     * @param time The media time of the next frame (ms)
+     */
+    void restartClock(int time);
+
+    /**
+     * @brief Hold the media clock of the modules during a pause
+     */
+    void pauseClock();
+
+    /**
+     * @brief Release the media clock of the modules after a pause
+     */
+    void resumeClock();
+
+    /**
+     * @brief Get the levels of the samples played since the last call
+     * @param peaks The highest absolute sample of each channel (full scale is 1)
+     * @param rms The RMS level of each channel (full scale is 1)
+     * @param count The size of the arrays
+     * @return The number of channels filled, 0 without audio module or audio
+     */
+    int levels(float *peaks, float *rms, int count);
+
+private:
+    /**
+     * @brief _control The block read by the modules
+     */
+    opp_control_t _control;
+
+    /**
+     * @brief _meter The levels written by the audio module
+     */
+    opp_meter_t _meter;
+
+    /**
+     * @brief _meterFrames The frames measured at the last call of levels
+     */
+    uint64_t _meterFrames;
+
+    /**
+     * @brief _meterSquares The sums of the squares at the last call of levels
+     */
+    double _meterSquares[OPP_METER_CHANNELS];
+
+    /**
+     * @brief _hasVideoFilter True if the video module is installed
+     */
+    bool _hasVideoFilter;
+
+    /**
+     * @brief _hasAudioFilter True if the audio module is installed
+     */
+    bool _hasAudioFilter;
+
+    /**
+     * @brief _pauseDate The libvlc clock when the pause started (us), 0 if not paused
+     */
+    int64_t _pauseDate;
+};
+
+#endif // FILTERCONTROL_H
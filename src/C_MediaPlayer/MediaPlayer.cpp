@@ -33,6 +33,7 @@
 #include <sstream>
 
 #include <QApplication>
+#include <QDebug>
 #include <QDesktopWidget>
 #include <QSettings>
 #include <QTime>
@@ -42,17 +43,22 @@
 #include <vlc/vlc.h>
 
 #include "VLCApplication.h"
+#include "FilterControl.h"
+#include "enginesupervisor.h"
 #include "media.h"
 #include "videoview.h"
 #include "mainwindow.h"
 #include "PlaylistPlayer.h"
 #include "mediasettings.h"
 #include "playback.h"
+#include "stagingcache.h"
+#include "thumbnailstore.h"
 #include "utils.h"
 
-MediaPlayer::MediaPlayer(libvlc_instance_t *vlcInstance, QObject *parent) :
+MediaPlayer::MediaPlayer(libvlc_instance_t *vlcInstance, QObject *parent, VLCApplication *playerPool) :
     QObject(parent),
     _inst(vlcInstance),
+    _playerPool(playerPool),
     _vlcMediaPlayer(NULL),
     _vlcBackMediaPlayer(NULL),
     _vlcEvents(NULL),
@@ -65,10 +71,15 @@ MediaPlayer::MediaPlayer(libvlc_instance_t *vlcInstance, QObject *parent) :
     _isPaused(false),
     _hasInitMedia(true),
     _timer(NULL),
-    _timerAudioFadeOut(NULL),
+    _audioFadeOutArmed(false),
     _timerAudioFadeIn(NULL),
-    _timerVideoFadeOut(NULL),
-    _timerVideoFadeIn(NULL)
+    _videoFadeOutArmed(false),
+    _timerVideoFadeIn(NULL),
+    _hasInitStream(false),
+    _filterControl(new FilterControl()),
+    _engine(NULL),
+    _vlcMedia(NULL),
+    _resumeTime(0)
 {
     QSettings settings("opp","opp");
     if(settings.value("VideoReturnMode").toString() == "none")
@@ -95,14 +106,22 @@ MediaPlayer::MediaPlayer(libvlc_instance_t *vlcInstance, QObject *parent) :
             ss << (QApplication::desktop()->screen()->width()-QApplication::desktop()->screenGeometry().width());
         _sizeScreen ="screen-width="+ ss.str();
     }
-    _vlcBackMediaPlayer = libvlc_media_player_new(_inst);
-    _vlcMediaPlayer = libvlc_media_player_new(_inst);
+    if(_playerPool != NULL){
+        _vlcBackMediaPlayer = _playerPool->acquirePlayer("MediaPlayer");
+        _vlcMediaPlayer = _playerPool->acquirePlayer("MediaPlayer");
+    }else{
+        _vlcBackMediaPlayer = libvlc_media_player_new(_inst);
+        _vlcMediaPlayer = libvlc_media_player_new(_inst);
+    }
     _vlcEvents = libvlc_media_player_event_manager(_vlcMediaPlayer);
 
     libvlc_video_set_key_input(_vlcMediaPlayer, false);
     libvlc_video_set_mouse_input(_vlcMediaPlayer, false);
 
+    _filterControl->attach(_inst);
+
     connect(this, SIGNAL(vout(int)), this, SLOT(applyCurrentPlaybackSettings()));
+    connect(this, SIGNAL(timeChanged(int)), this, SLOT(watchOutMark(int)));
 
     createCoreConnections();
 }
@@ -112,34 +131,104 @@ MediaPlayer::~MediaPlayer()
     disconnect(this, SIGNAL(vout(int)), this, SLOT(applyCurrentPlaybackSettings()));
 
     removeCoreConnections();
-    libvlc_media_player_release(_vlcMediaPlayer);
-    libvlc_media_player_release(_vlcBackMediaPlayer);
-    libvlc_vlm_release(_inst);
-
-    if(_timerAudioFadeOut != NULL){
-        delete(_timerAudioFadeOut);
+    if(_playerPool != NULL){
+        _playerPool->releasePlayer(_vlcMediaPlayer);
+        _playerPool->releasePlayer(_vlcBackMediaPlayer);
+    }else{
+        libvlc_media_player_release(_vlcMediaPlayer);
+        libvlc_media_player_release(_vlcBackMediaPlayer);
     }
+    if(_vlcMedia != NULL)
+        libvlc_media_release(_vlcMedia);
+
+    // the instance may be shared with other players, only drop what we added
+    if(_hasInitStream)
+        libvlc_vlm_release(_inst);
+
     if(_timerAudioFadeIn != NULL){
         delete(_timerAudioFadeIn);
     }
-    if(_timerVideoFadeOut != NULL){
-        delete(_timerVideoFadeOut);
-    }
     if(_timerVideoFadeIn != NULL){
         delete(_timerVideoFadeIn);
     }
     if(_timer != NULL){
         delete (_timer);
     }
+
+    // released after the player, the modules read it until their end
+    delete _filterControl;
+
+    // quits the engine process
+    delete _engine;
+}
+
+void MediaPlayer::setEngine(EngineSupervisor *engine)
+{
+    _engine = engine;
+
+    // the pictures would be taken from the local player, which decodes nothing
+    if(_bMode == SCREENSHOT)
+        _bMode = NONE;
+
+    // the supervisor gave up on the media, as if it could not be decoded
+    connect(_engine, SIGNAL(failed()), this, SIGNAL(error()));
+    connect(_engine, SIGNAL(stateChanged(int)), this, SLOT(engineStateChanged(int)));
+    connect(_engine, SIGNAL(timeChanged(int)), this, SLOT(engineTimeChanged(int)));
+    connect(_engine, SIGNAL(lengthChanged(int)), this, SIGNAL(lengthChanged(int)));
+
+    setVolume(_currentVolume);
+}
+
+void MediaPlayer::engineStateChanged(int state)
+{
+    switch(state)
+    {
+        case PlaybackEngine::PlayingState:
+            emit playing();
+            break;
+        case PlaybackEngine::PausedState:
+            emit paused();
+            break;
+        case PlaybackEngine::IdleState:
+            emit stopped();
+            break;
+        case PlaybackEngine::EndedState:
+            emit end();
+            break;
+        case PlaybackEngine::ErrorState:
+            emit error();
+            break;
+        case PlaybackEngine::BlackState:
+            emit stopped();
+            close(_currentPlayback);
+            emit endGoToBlack();
+            break;
+        default:
+            break;
+    }
+}
+
+void MediaPlayer::engineTimeChanged(int time)
+{
+    emit timeChanged(time);
+
+    if(_engine->length() > 0)
+        emit positionChanged((float)time / _engine->length());
 }
 
 int MediaPlayer::currentLength() const
 {
+    if(_engine != NULL)
+        return _engine->length();
+
     return libvlc_media_player_get_length(_vlcMediaPlayer);
 }
 
 bool MediaPlayer::isPlaying() const
 {
+    if(_engine != NULL)
+        return _engine->state() == PlaybackEngine::PlayingState;
+
     return libvlc_media_player_is_playing(_vlcMediaPlayer);
 }
 
@@ -212,6 +301,9 @@ void MediaPlayer::open(Playback *playback)
         if(_hasInitMedia)
             close(_currentPlayback);
 
+        if(playback != _currentPlayback)
+            _recoveryOptions.clear();
+
         _currentPlayback = playback;
         _hasInitMedia = true;
         stopFaderOut();
@@ -221,7 +313,10 @@ void MediaPlayer::open(Playback *playback)
         /** allows to send the new length even if the media player isn't playing */
         emit lengthChanged((int)libvlc_media_get_duration(playback->media()->core()));
 
-        libvlc_media_player_set_media(_vlcMediaPlayer, playback->media()->core());
+        // a local copy of a media stored on a network share, made before the show
+        playback->media()->setPlaybackLocation(StagingCache::stagedFile(playback->media()->location()));
+
+        loadMedia();
         MediaSettings* mediaSettings = _currentPlayback->mediaSettings();
 
         connect(mediaSettings, SIGNAL(gainChanged(float)), this, SLOT(setCurrentGain(float)));
@@ -293,6 +388,7 @@ void MediaPlayer::initStream()
         "screen:// --sout",
         "#transcode{vcodec=mp2v,acodec=none,ab=128}:standard{access=http,mux=ts,dst=127.0.0.1:8080/stream}",
         3, params, 1 , 0);
+    _hasInitStream = true;
 
     Media *m = new Media("http://127.0.0.1:8080/stream", _inst, 0, false);
     libvlc_media_player_set_media(_vlcBackMediaPlayer, m->core());
@@ -374,11 +470,36 @@ void MediaPlayer::play()
             break;
     }
 
+    // opened in the engine with the settings known when the playback starts
+    if(_engine != NULL){
+        if(_currentPlayback != NULL){
+            if(!isPaused() && !isPlaying())
+                _engine->open(_currentPlayback, _recoveryOptions, _resumeTime);
+            _engine->play();
+        }
+        _resumeTime = 0;
+        _isPaused = false;
+        return;
+    }
+
+    // the marks may have changed since the opening
+    if(!isPaused() && !isPlaying())
+        loadMedia();
+
+    if(isPaused()){
+        _filterControl->resumeClock();
+    }else if(_currentPlayback != NULL){
+        int inMark = qMax(_currentPlayback->mediaSettings()->inMark(), _resumeTime);
+        _filterControl->restartClock(inMark > 0 ? inMark : 0);
+    }
+    _filterControl->goToBlack(0);
+    _resumeTime = 0;
+
     libvlc_media_player_play(_vlcMediaPlayer);
     setVolume(_currentVolume);
-    startAudioFadeOut(0);
+    startAudioFadeOut();
     startAudioFadeIn();
-    startVideoFadeOut(0);
+    startVideoFadeOut();
     startVideoFadeIn();
     _isPaused = false;
 }
@@ -393,7 +514,14 @@ void MediaPlayer::pause()
     default:
         break;
     }
+    if(_engine != NULL){
+        _engine->pause();
+        _isPaused = true;
+        return;
+    }
+
     stopFaderOut();
+    _filterControl->pauseClock();
     libvlc_media_player_set_pause(_vlcMediaPlayer, true);
     _isPaused = true;
 }
@@ -412,10 +540,17 @@ void MediaPlayer::resume()
         break;
     }
 
+    if(_engine != NULL){
+        _engine->play();
+        _isPaused = false;
+        return;
+    }
+
+    _filterControl->resumeClock();
     libvlc_media_player_set_pause(_vlcMediaPlayer, false);
     setVolume(_currentVolume);
-    startAudioFadeOut(libvlc_media_player_get_time(_vlcMediaPlayer));
-    startVideoFadeOut(libvlc_media_player_get_time(_vlcMediaPlayer));
+    startAudioFadeOut();
+    startVideoFadeOut();
     _isPaused = false;
 }
 
@@ -427,17 +562,16 @@ void MediaPlayer::stop()
     _currentWId = 0;
 
     if(_currentPlayback != NULL){
-        QString screenPath = "./screenshot/";
-        screenPath = screenPath.replace("/",QDir::separator());
-        screenPath +=  _currentPlayback->media()->getLocation().replace(QDir::separator(),"_").remove(":");
-        screenPath += ".png";
-
         switch (_bMode)
         {
-            case SCREENSHOT:
+            case SCREENSHOT: {
+                // only the player of the interface has a back view, the one of an engine has no parent
+                MainWindow *mainWindow = (MainWindow *)((PlaylistPlayer *)this->parent())->parent();
                 stopScreen();
-                ((MainWindow *)((PlaylistPlayer *)this->parent())->parent())->setScreenshot(screenPath);
+                mainWindow->setScreenshotImage(ThumbnailStore::thumbnail(_currentPlayback->media()->getLocation(),
+                                                                         mainWindow->screenBack()->width()));
                 break;
+            }
             case STREAMING:
                 stopStream();
                 break;
@@ -447,6 +581,8 @@ void MediaPlayer::stop()
     }
 
     libvlc_media_player_stop(_vlcMediaPlayer);
+    if(_engine != NULL)
+        _engine->stop();
     stopFaderOut();
     stopFaderIn();
 
@@ -458,6 +594,9 @@ void MediaPlayer::stop()
 
 int MediaPlayer::currentTime() const
 {
+    if(_engine != NULL)
+        return _engine->time();
+
     return libvlc_media_player_get_time(_vlcMediaPlayer);
 }
 
@@ -472,9 +611,14 @@ void MediaPlayer::setCurrentTime(int time)
             time = 0;
         }
 
-        libvlc_media_player_set_time(_vlcMediaPlayer, time);
-        startAudioFadeOut(time);
-        startVideoFadeOut(time);
+        if(_engine != NULL){
+            _engine->setTime(time);
+        }else{
+            _filterControl->restartClock(time);
+            libvlc_media_player_set_time(_vlcMediaPlayer, time);
+            startAudioFadeOut();
+            startVideoFadeOut();
+        }
 
         /**
          * used because when the media player is in pause,
@@ -492,20 +636,55 @@ void MediaPlayer::setVolume(int volume)
 
     _currentVolume = volume;
 
-    libvlc_audio_set_volume(_vlcMediaPlayer, ((float) volume) * powf(10.f, _currentGain/10.f) );
+    // the player of the engine applies the gain of the playback
+    if(_engine != NULL){
+        _engine->setVolume(volume);
+        return;
+    }
+
+    // the OPP audio module applies the gain on the samples
+    if(_filterControl->hasAudioFilter())
+        libvlc_audio_set_volume(_vlcMediaPlayer, volume);
+    else
+        libvlc_audio_set_volume(_vlcMediaPlayer, gainedVolume(volume) );
 }
 
 float MediaPlayer::position() const
 {
+    if(_engine != NULL)
+        return _engine->length() > 0 ? (float)_engine->time() / _engine->length() : 0;
+
     return libvlc_media_player_get_position(_vlcMediaPlayer);
 }
 
 int MediaPlayer::volume() const {
+    if(_engine != NULL)
+        return _currentVolume;
+
     return libvlc_audio_get_volume(_vlcMediaPlayer);
 }
 
+bool MediaPlayer::hasAudioLevels() const
+{
+    return _filterControl->hasAudioFilter();
+}
+
+int MediaPlayer::audioLevels(float *peaks, float *rms, int count)
+{
+    if(_engine != NULL)
+        return _engine->levels(peaks, rms, count);
+
+    return _filterControl->levels(peaks, rms, count);
+}
+
 void MediaPlayer::setPosition(const float &position)
 {
+    if(_engine != NULL){
+        _engine->setTime((int)(position * currentLength()));
+        return;
+    }
+
+    _filterControl->restartClock((int)(position * currentLength()));
     libvlc_media_player_set_position(_vlcMediaPlayer, position);
 }
 
@@ -554,12 +733,26 @@ int MediaPlayer::jumpBack(int timeMs)
 
 void MediaPlayer::goToBlack()
 {
+    // faded by the player of the engine, which tells when it is over
+    if(_engine != NULL){
+        _engine->goToBlack();
+        return;
+    }
+
     // Disable the subtitle file
     removeCurrentSubtitlesFile();
 
     int nbEchantillon = 100;
     int timeLeft = 2500;
 
+    // the OPP modules fade every picture and every sample on their own
+    _filterControl->goToBlack(timeLeft);
+    if(_filterControl->hasVideoFilter() && _filterControl->hasAudioFilter()){
+        QTimer::singleShot(timeLeft, this, SLOT(finishGoToBlack()));
+        return;
+    }
+    qDebug() << "OPP modules missing, stepping the fade to black for" << timeLeft << "ms";
+
     // Audio
     float vol  = _currentVolume;
     float deltaA = vol / nbEchantillon;
@@ -575,18 +768,30 @@ void MediaPlayer::goToBlack()
             return;
         }else{
             // Audio
-            vol -= deltaA;
-            libvlc_audio_set_volume(_vlcMediaPlayer, ((float) vol) * powf(10.f, _currentGain/10.f) );
+            if(!_filterControl->hasAudioFilter()){
+                vol -= deltaA;
+                libvlc_audio_set_volume(_vlcMediaPlayer, gainedVolume(vol) );
+            }
 
             // Video
-            brightness -= deltaV;
-            setCurrentBrightness(brightness);
-            setCurrentSaturation(brightness);
-            setCurrentContrast(brightness);
+            if(!_filterControl->hasVideoFilter()){
+                brightness -= deltaV;
+                setCurrentBrightness(brightness);
+                setCurrentSaturation(brightness);
+                setCurrentContrast(brightness);
+            }
         }
         wait(timeToWait);
     }
 
+    finishGoToBlack();
+}
+
+void MediaPlayer::finishGoToBlack()
+{
+    if(!isPlaying())
+        return;
+
     stop();
     close(_currentPlayback);
     emit endGoToBlack();
@@ -637,25 +842,38 @@ void MediaPlayer::applyCurrentPlaybackSettings()
 void MediaPlayer::setCurrentGain(float gain)
 {
     _currentGain = gain;
+    _filterControl->setGain(gain);
     setVolume(_currentVolume);
 }
 
+int MediaPlayer::gainedVolume(float volume) const
+{
+    // the gain is in amplitude dB, as in the OPP audio module
+    int gained = qRound(volume * powf(10.f, _currentGain / 20.f));
+
+    // libvlc refuses the volumes out of its range instead of clipping them
+    return qBound(0, gained, MAX_VOLUME);
+}
+
 void MediaPlayer::setCurrentAudioFadeOut(int time)
 {
     _currentAudioFadeOut = time;
+    applyFades();
 }
 
 void MediaPlayer::setCurrentAudioFadeIn(int time){
     _currentAudioFadeIn = time;
-
+    applyFades();
 }
 
 void MediaPlayer::setCurrentVideoFadeIn(int time){
     _currentVideoFadeIn = time;
+    applyFades();
 }
 
 void MediaPlayer::setCurrentVideoFadeOut(int time){
     _currentVideoFadeOut = time;
+    applyFades();
 }
 
 void MediaPlayer::setCurrentAudioTrack(const int &track)
@@ -692,7 +910,17 @@ void MediaPlayer::setCurrentRatio(Ratio ratio)
 
 void MediaPlayer::setCurrentDeinterlacing(Deinterlacing deinterlacing)
 {
-    libvlc_video_set_deinterlace(_vlcMediaPlayer, MediaSettings::deinterlacingValues()[deinterlacing].toUtf8().data());
+    if(deinterlacing == AutoDeinterlacing)
+        deinterlacing = MediaSettings::autoDeinterlacing(_currentPlayback != NULL ? _currentPlayback->media()->scanType() : UnknownScan);
+
+    // no filter at all for progressive video
+    if(deinterlacing == NoDeinterlacing){
+        libvlc_video_set_deinterlace(_vlcMediaPlayer, NULL);
+        return;
+    }
+
+    // the libvlc modes are the names in lower case
+    libvlc_video_set_deinterlace(_vlcMediaPlayer, MediaSettings::deinterlacingValues()[deinterlacing].toLower().toUtf8().data());
 }
 
 void MediaPlayer::setCurrentSubtitlesSync(double sync)
@@ -702,30 +930,55 @@ void MediaPlayer::setCurrentSubtitlesSync(double sync)
 
 void MediaPlayer::setCurrentGamma(float gamma)
 {
+    if(_filterControl->hasVideoFilter()){
+        _filterControl->setGamma(gamma);
+        return;
+    }
+
     libvlc_video_set_adjust_int(_vlcMediaPlayer,libvlc_adjust_Enable,1);
     libvlc_video_set_adjust_float(_vlcMediaPlayer,libvlc_adjust_Gamma, gamma);
 }
 
 void MediaPlayer::setCurrentContrast(float contrast)
 {
+    if(_filterControl->hasVideoFilter()){
+        _filterControl->setContrast(contrast);
+        return;
+    }
+
     libvlc_video_set_adjust_int(_vlcMediaPlayer,libvlc_adjust_Enable,1);
     libvlc_video_set_adjust_float(_vlcMediaPlayer,libvlc_adjust_Contrast, contrast);
 }
 
 void MediaPlayer::setCurrentBrightness(float brightness)
 {
+    if(_filterControl->hasVideoFilter()){
+        _filterControl->setBrightness(brightness);
+        return;
+    }
+
     libvlc_video_set_adjust_int(_vlcMediaPlayer,libvlc_adjust_Enable,1);
     libvlc_video_set_adjust_float(_vlcMediaPlayer,libvlc_adjust_Brightness, brightness);
 }
 
 void MediaPlayer::setCurrentSaturation(float saturation)
 {
+    if(_filterControl->hasVideoFilter()){
+        _filterControl->setSaturation(saturation);
+        return;
+    }
+
     libvlc_video_set_adjust_int(_vlcMediaPlayer,libvlc_adjust_Enable,1);
     libvlc_video_set_adjust_float(_vlcMediaPlayer,libvlc_adjust_Saturation, saturation);
 }
 
 void MediaPlayer::setCurrentHue(int hue)
 {
+    if(_filterControl->hasVideoFilter()){
+        _filterControl->setHue(hue);
+        return;
+    }
+
     libvlc_video_set_adjust_int(_vlcMediaPlayer,libvlc_adjust_Enable,1);
     libvlc_video_set_adjust_int(_vlcMediaPlayer,libvlc_adjust_Hue, hue);
 }
@@ -736,13 +989,11 @@ void MediaPlayer::setCurrentAudioSync(double sync)
 }
 
 void MediaPlayer::setCurrentSubtitlesEncode(int encode){
-    if(encode > 0 && _currentPlayback != NULL){
-        QString enc = MediaSettings::encodeValues()[encode];
-
-        libvlc_media_add_option(_currentPlayback->media()->core(),
-                                QString(":subsdec-encoding=" + enc).toLocal8Bit().data());
+    Q_UNUSED(encode);
 
-    }
+    // read when the input starts, the media is loaded again on the next play
+    if(isStopped())
+        loadMedia();
 }
 
 /*****************************************************************************\
@@ -888,25 +1139,107 @@ void MediaPlayer::applyCrop(int cropTop,int cropLeft, int cropRight, int cropBot
     libvlc_video_set_crop_geometry(core(),val.toStdString().c_str());
 }
 
+void MediaPlayer::loadMedia(){
+    // the engine decodes with a media of its own
+    if(_currentPlayback == NULL || _engine != NULL)
+        return;
+
+    libvlc_media_t *media = libvlc_media_new_path(_inst, _currentPlayback->media()->playbackLocation().toStdString().data());
+
+    // the last options added win, the profile is refined by the recovery options
+    QStringList options = decoderOptions(_currentPlayback) + markOptions() + encodingOptions()
+                          + _filterControl->mediaOptions();
+    if(!_currentPlayback->media()->imageTime().isEmpty())
+        options << ":image-duration=" + _currentPlayback->media()->imageTime();
+    foreach(QString option, options)
+        libvlc_media_add_option(media, option.toLocal8Bit().constData());
+
+    libvlc_media_player_set_media(_vlcMediaPlayer, media);
+
+    if(_vlcMedia != NULL)
+        libvlc_media_release(_vlcMedia);
+    _vlcMedia = media;
+}
+
+QStringList MediaPlayer::decoderOptions(Playback *playback) const{
+    DecoderProfile profile = playback->mediaSettings()->decoderProfile();
+    if(profile == AutoProfile)
+        profile = MediaSettings::autoDecoderProfile(playback->media()->videoTracks());
+
+    return MediaSettings::decoderProfileOptions(profile) + _recoveryOptions;
+}
+
+QStringList MediaPlayer::markOptions() const{
+    if(_currentPlayback == NULL || _currentPlayback->media()->isImage())
+        return QStringList();
+
+    MediaSettings *settings = _currentPlayback->mediaSettings();
+
+    int inMark = qMax(settings->inMark(), _resumeTime);
+    if(inMark < 0)
+        inMark = 0;
+    int outMark = settings->outMark();
+    if(outMark <= inMark || outMark >= (int)_currentPlayback->media()->getOriginalDuration())
+        outMark = 0;
+
+    /**
+     * libvlc takes the bounds in seconds as floating values: the input seeks
+     * precisely to the start before the first picture is shown, and stops on
+     * the demux clock once the stop time is reached. The last options added win.
+     */
+    return QStringList() << QString(":start-time=") + QString::number(inMark / 1000.0, 'f', 3)
+                         << QString(":stop-time=") + QString::number(outMark / 1000.0, 'f', 3);
+}
+
+QStringList MediaPlayer::encodingOptions() const{
+    if(_currentPlayback == NULL || _currentPlayback->mediaSettings()->subtitlesEncode() <= 0)
+        return QStringList();
+
+    return QStringList() << ":subsdec-encoding=" + MediaSettings::encodeValues()[_currentPlayback->mediaSettings()->subtitlesEncode()];
+}
+
+void MediaPlayer::applyFades(){
+    if(_currentPlayback == NULL)
+        return;
+
+    MediaSettings *settings = _currentPlayback->mediaSettings();
+    int inMark = settings->inMark() > 0 ? settings->inMark() : 0;
+    int outMark = outMarkTime();
+
+    // on the media clock, the modules compute the level of each frame from its date
+    if(_filterControl->hasVideoFilter())
+        _filterControl->setVideoFades(inMark, settings->videoFadeIn(),
+                                      outMark - settings->videoFadeOut(),
+                                      outMark > 0 ? settings->videoFadeOut() : 0);
+
+    if(_filterControl->hasAudioFilter())
+        _filterControl->setAudioFades(inMark, settings->audioFadeIn(),
+                                      outMark - settings->audioFadeOut(),
+                                      outMark > 0 ? settings->audioFadeOut() : 0);
+}
+
 /****************************/
 /***      FADERS          ***/
 /****************************/
 
-void MediaPlayer::startAudioFadeOut(int time){
+void MediaPlayer::startAudioFadeOut(){
+    if(_filterControl->hasAudioFilter()){
+        applyFades();
+        return;
+    }
+
     if(_currentPlayback->mediaSettings()->audioFadeOut() > 0){
         setVolume(_currentVolume);
-        stopFader(_timerAudioFadeOut);
-        if(_timerAudioFadeOut == NULL){
-             _timerAudioFadeOut = new QTimer();
-             _timerAudioFadeOut->setSingleShot(true);
-             _timerAudioFadeOut->connect(_timerAudioFadeOut, SIGNAL(timeout()), this, SLOT(audioFadeOut()));
-        }
-
-        startFaderOut(_timerAudioFadeOut, time, _currentPlayback->mediaSettings()->audioFadeOut());
+        _audioFadeOutArmed = true;
     }
 }
 
 void MediaPlayer::startAudioFadeIn(){
+    if(_filterControl->hasAudioFilter()){
+        applyFades();
+        return;
+    }
+
     if(_currentPlayback->mediaSettings()->audioFadeIn() > 0){
         stopFader(_timerAudioFadeIn);
         if(_timerAudioFadeIn == NULL){
@@ -918,21 +1251,24 @@ void MediaPlayer::startAudioFadeIn(){
         startFaderIn(_timerAudioFadeIn);
     }
 }
-void MediaPlayer::startVideoFadeOut(int time){
+void MediaPlayer::startVideoFadeOut(){
+    if(_filterControl->hasVideoFilter()){
+        applyFades();
+        return;
+    }
+
     if(_currentPlayback->mediaSettings()->videoFadeOut() > 0){
         setCurrentBrightness(_currentPlayback->mediaSettings()->brightness());
-        stopFader(_timerVideoFadeOut);
-        if(_timerVideoFadeOut == NULL){
-             _timerVideoFadeOut = new QTimer();
-             _timerVideoFadeOut->setSingleShot(true);
-             _timerVideoFadeOut->connect(_timerVideoFadeOut, SIGNAL(timeout()), this, SLOT(videoFadeOut()));
-        }
-
-        startFaderOut(_timerVideoFadeOut, time, _currentPlayback->mediaSettings()->videoFadeOut());
+        _videoFadeOutArmed = true;
     }
 }
 
 void MediaPlayer::startVideoFadeIn(){
+    if(_filterControl->hasVideoFilter()){
+        applyFades();
+        return;
+    }
+
     if(_currentPlayback->mediaSettings()->videoFadeIn() > 0){
         stopFader(_timerVideoFadeIn);
         if(_timerVideoFadeIn == NULL){
@@ -946,8 +1282,8 @@ void MediaPlayer::startVideoFadeIn(){
 }
 
 void MediaPlayer::stopFaderOut(){
-    stopFader(_timerAudioFadeOut);
-    stopFader(_timerVideoFadeOut);
+    _audioFadeOutArmed = false;
+    _videoFadeOutArmed = false;
 }
 
 void MediaPlayer::stopFaderIn(){
@@ -955,17 +1291,31 @@ void MediaPlayer::stopFaderIn(){
     stopFader(_timerVideoFadeIn);
 }
 
-void MediaPlayer::startFaderOut(QTimer* timer, int time, int timeToFade){
-    int duration = _currentPlayback->mediaSettings()->outMark() - _currentPlayback->mediaSettings()->inMark();
-    duration = (duration <= 0) ? 0 : _currentPlayback->media()->duration();
+int MediaPlayer::outMarkTime() const{
+    int outMark = _currentPlayback->mediaSettings()->outMark();
+    if(outMark <= 0)
+        outMark = _currentPlayback->media()->duration();
+
+    return outMark;
+}
 
-    int launch = duration - timeToFade;
-    if(time > 0)
-        launch -= time - _currentPlayback->mediaSettings()->inMark() ;
+void MediaPlayer::watchOutMark(int time){
+    if(_currentPlayback == NULL || !isPlaying())
+        return;
 
-    launch = launch < 0 ? 0 : launch;
+    int outMark = outMarkTime();
+    if(outMark <= 0)
+        return;
 
-    timer->start(launch);
+    // the faders out leave on the media clock, not on a timer started at play
+    if(_audioFadeOutArmed && time >= outMark - _currentPlayback->mediaSettings()->audioFadeOut()){
+        _audioFadeOutArmed = false;
+        audioFadeOut();
+    }
+    if(_videoFadeOutArmed && time >= outMark - _currentPlayback->mediaSettings()->videoFadeOut()){
+        _videoFadeOutArmed = false;
+        videoFadeOut();
+    }
 }
 
 void MediaPlayer::startFaderIn(QTimer* timer){
@@ -976,13 +1326,9 @@ void MediaPlayer::audioFadeOut(){
     float vol  = _currentVolume;
     float delta = vol / 100;
 
-    int duration = _currentPlayback->mediaSettings()->outMark();
-    if(duration <= 0){
-        duration = _currentPlayback->media()->duration();
-
-        if(duration == 0)
-            return;
-    }
+    int duration = outMarkTime();
+    if(duration <= 0)
+        return;
 
     int timeLeft = (duration - currentTime() );
     int timeToWait =  timeLeft / 100;
@@ -992,14 +1338,14 @@ void MediaPlayer::audioFadeOut(){
             return;
         }else{
             vol -= delta;
-            libvlc_audio_set_volume(_vlcMediaPlayer, ((float) vol) * powf(10.f, _currentGain/10.f) );
+            libvlc_audio_set_volume(_vlcMediaPlayer, gainedVolume(vol) );
         }
         wait(timeToWait);
     }
 }
 
 void MediaPlayer::audioFadeIn(){
-    libvlc_audio_set_volume(_vlcMediaPlayer, ((float) 0) * powf(10.f, _currentGain/10.f) );
+    libvlc_audio_set_volume(_vlcMediaPlayer, 0);
     float vol  = 0;
     float delta = _currentVolume / 40;
 
@@ -1011,10 +1357,10 @@ void MediaPlayer::audioFadeIn(){
             return;
         }else{
             vol += delta;
-            libvlc_audio_set_volume(_vlcMediaPlayer, ((float) vol) * powf(10.f, _currentGain/10.f) );
+            libvlc_audio_set_volume(_vlcMediaPlayer, gainedVolume(vol) );
         }
     }
-    libvlc_audio_set_volume(_vlcMediaPlayer, ((float) _currentVolume) * powf(10.f, _currentGain/10.f) );
+    libvlc_audio_set_volume(_vlcMediaPlayer, gainedVolume(_currentVolume) );
 
 }
 void MediaPlayer::videoFadeOut(){
@@ -1022,11 +1368,8 @@ void MediaPlayer::videoFadeOut(){
     float brightness  = _currentPlayback->mediaSettings()->brightness();
     float delta = brightness / nbEchantillon;
 
-    int duration = _currentPlayback->mediaSettings()->outMark();
-    if(duration <=0)
-        duration = _currentPlayback->media()->duration();
-
-    if(duration == 0)
+    int duration = outMarkTime();
+    if(duration <= 0)
         return;
 
     int timeLeft = duration - currentTime();
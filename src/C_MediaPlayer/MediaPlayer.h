@@ -32,6 +32,7 @@
 #define MEDIAPLAYER_H
 
 #include <QObject>
+#include <QStringList>
 #include <QtGui/qwindowdefs.h>
 
 #include <string.h>
@@ -46,6 +47,9 @@ class Media;
 class Track;
 class VideoTrack;
 class AudioTrack;
+class FilterControl;
+class EngineSupervisor;
+class VLCApplication;
 
 struct libvlc_instance_t;
 struct libvlc_media_player_t;
@@ -82,7 +86,14 @@ public:
         NONE = 2
     };
 
-    explicit MediaPlayer(libvlc_instance_t *vlcInstance, QObject *parent = 0);
+    /**
+     * @brief Build a player on the libvlc instance
+     * @param vlcInstance The libvlc instance
+     * @param parent The parent object
+     * @param playerPool If not NULL, the libvlc players are taken from this pool
+     *        and given back on destruction instead of being created
+     */
+    explicit MediaPlayer(libvlc_instance_t *vlcInstance, QObject *parent = 0, VLCApplication *playerPool = NULL);
     virtual ~MediaPlayer();
 
     /**
@@ -101,6 +112,45 @@ public:
      */
     inline libvlc_media_player_t *core() const { return _vlcMediaPlayer; }
 
+    /**
+     * @brief Get the engine process showing the projection
+     * @return The supervisor of the engine, NULL if the projection is local
+     */
+    inline EngineSupervisor *engine() const { return _engine; }
+
+    /**
+     * @brief Show the projection in an engine process
+     *
+     * The engine decodes and shows the video and plays the sound with a
+     * player of its own, which applies the settings of the playback. The
+     * local player decodes nothing: the commands are sent to the engine, and
+     * the state, the clock and the audio levels are those of its status.
+     * The back view has no pictures to show.
+     *
+     * @param engine The supervisor of the engine, owned by the player
+     */
+    void setEngine(EngineSupervisor *engine);
+
+    /**
+     * @brief Add libvlc options to the decoder profile, to open a failing playback again
+     *
+     * The options are dropped when another playback is opened, they apply
+     * from the next play of a stopped player.
+     *
+     * @param options The options, added after those of the profile
+     */
+    inline void setRecoveryOptions(const QStringList &options) { _recoveryOptions = options; }
+
+    /**
+     * @brief Start the next play of a stopped player later than the in mark
+     *
+     * The time is given to libvlc as the start time of the input, it is
+     * dropped once the player has been played.
+     *
+     * @param time The time to start from (ms), 0 for the in mark
+     */
+    inline void setResumeTime(int time) { _resumeTime = time; }
+
     /**
      * @brief Media player is paused
      * @return True if media player is paused, false otherwise.
@@ -166,6 +216,25 @@ public:
      */
     int volume() const;
 
+    /**
+     * @brief Allow to know if the audio levels are measured
+     * @return True if the OPP audio module is used, false otherwise
+     */
+    bool hasAudioLevels() const;
+
+    /**
+     * @brief Get the levels of the audio played since the last call
+     *
+     * The levels are measured by the OPP audio module after the gain and the
+     * fades, before the software volume.
+     *
+     * @param peaks The highest absolute sample of each channel (full scale is 1)
+     * @param rms The RMS level of each channel (full scale is 1)
+     * @param count The size of the arrays
+     * @return The number of channels filled, 0 if nothing was played
+     */
+    int audioLevels(float *peaks, float *rms, int count);
+
     /**
      * @brief Set video view in which the media player will render the video
      * @param The video view
@@ -232,12 +301,11 @@ public:
     Media * media();
 
     /**
-     * @brief Start the audio FadeOut.
-     * @param the time of the current launch.
+     * @brief Arm the audio FadeOut, launched when the media clock reaches it.
      *
      * @author Thibaud Lamarche <thibaud.lamarche@gmail.com>
      */
-    void startAudioFadeOut(int time);
+    void startAudioFadeOut();
 
     /**
      * @brief Start the audio FadeIn.
@@ -254,12 +322,11 @@ public:
     void startVideoFadeIn();
 
     /**
-     * @brief Start the video FadeOut.
-     * @param the time of the current launch.
+     * @brief Arm the video FadeOut, launched when the media clock reaches it.
      *
      * @author Thibaud Lamarche <thibaud.lamarche@gmail.com>
      */
-    void startVideoFadeOut(int time);
+    void startVideoFadeOut();
 
     /**
      * @brief stopFaderIn
@@ -278,13 +345,25 @@ public:
     void stopFader(QTimer *timer);
 
     /**
-     * @brief Start a fader.
-     * @param the timer to launch.
-     * @param the time to fade
+     * @brief Get the time where the current playback ends
+     * @return The out mark, or the media duration if none (ms)
+     */
+    int outMarkTime() const;
+
+    /**
+     * @brief Give a new libvlc media of the current playback to the player
      *
-     * @author Thibaud Lamarche <thibaud.lamarche@gmail.com>
+     * The media of the bin is shared by every playback, so each opening
+     * gets its own libvlc media: the decoder profile, the recovery options,
+     * the in and out marks and the subtitles encoding are read by libvlc
+     * when the input starts.
      */
-    void startFaderOut(QTimer* timer,int time, int timeToFade);
+    void loadMedia();
+
+    /**
+     * @brief Give the fades of the current playback to the OPP modules
+     */
+    void applyFades();
 
     /**
      * @brief Start a fader.
@@ -360,6 +439,8 @@ public slots:
      * @brief Set current audio gain.
      * @param gain The new gain between 0.0(dB) and 3.01(dB)
      *
+     * Applied on the samples by the OPP audio module when installed.
+     *
      * @author Florian Mhun <florian.mhun@gmail.com>
      */
     void setCurrentGain(float gain);
@@ -382,7 +463,7 @@ public slots:
 
     /**
      * @brief Set current deinterlacing
-     * @param deinterlacing The new deinterlacing mode
+     * @param deinterlacing The new deinterlacing mode, AutoDeinterlacing follows the scan type of the media
      *
      * @author Florian Mhun <florian.mhun@gmail.com>
      */
@@ -570,6 +651,27 @@ private slots:
      */
     void takeScreen();
 
+    /**
+     * @brief Launch the faders out when the playback time reaches them
+     * @param time The current time of the media
+     */
+    void watchOutMark(int time);
+
+    /**
+     * @brief Stop the playback once the go to black is over
+     */
+    void finishGoToBlack();
+
+    /**
+     * @brief Emit the signal of a PlaybackEngine::State reached by the engine
+     */
+    void engineStateChanged(int state);
+
+    /**
+     * @brief Emit the time and the position published by the engine
+     */
+    void engineTimeChanged(int time);
+
 signals:
 
     /**
@@ -705,6 +807,33 @@ private:
      */
     static void libvlc_callback(const libvlc_event_t *event, void *data);
 
+    /**
+     * @brief Get the libvlc options of the in and out marks of the current playback
+     */
+    QStringList markOptions() const;
+
+    /**
+     * @brief Get the libvlc option of the subtitles encoding of the current playback
+     */
+    QStringList encodingOptions() const;
+
+    /**
+     * @brief Get the libvlc options of the decoder profile of a playback
+     */
+    QStringList decoderOptions(Playback *playback) const;
+
+    /**
+     * @brief Apply the gain of the current playback to a volume, without the OPP audio module
+     * @param volume The volume, from 0 to 100
+     * @return The libvlc volume
+     */
+    int gainedVolume(float volume) const;
+
+    /**
+     * @brief MAX_VOLUME Highest libvlc volume, twice the nominal one (+6.02 dB)
+     */
+    static const int MAX_VOLUME = 200;
+
     /**
      * @brief Taking periodically screenshots.
      *
@@ -724,6 +853,11 @@ private:
      */
     libvlc_instance_t * _inst;
 
+    /**
+     * @brief The pool the libvlc players were taken from, NULL if they are owned
+     */
+    VLCApplication *_playerPool;
+
     /**
      * @brief The libvlc media player core
      */
@@ -795,9 +929,9 @@ private:
     QTimer *_timer;
 
     /**
-     * @brief Timer audio fade-out
+     * @brief Audio fade-out waiting for the out mark on the media clock
      */
-    QTimer *_timerAudioFadeOut;
+    bool _audioFadeOutArmed;
 
     /**
      * @brief Timer audio fade-in
@@ -805,9 +939,9 @@ private:
     QTimer *_timerAudioFadeIn;
 
     /**
-     * @brief Timer video fade-out
+     * @brief Video fade-out waiting for the out mark on the media clock
      */
-    QTimer *_timerVideoFadeOut;
+    bool _videoFadeOutArmed;
 
     /**
      * @brief Timer video fade-in
@@ -833,6 +967,36 @@ private:
      * @brief Allow to know if a media is opened
      */
     bool _hasInitMedia;
+
+    /**
+     * @brief Allow to know if a broadcast was added to the instance by initStream()
+     */
+    bool _hasInitStream;
+
+    /**
+     * @brief The parameters of the OPP libvlc modules (picture settings and fades)
+     */
+    FilterControl *_filterControl;
+
+    /**
+     * @brief _engine The engine process showing the projection, NULL if local
+     */
+    EngineSupervisor *_engine;
+
+    /**
+     * @brief _vlcMedia The libvlc media of the current opening, NULL if none
+     */
+    libvlc_media_t *_vlcMedia;
+
+    /**
+     * @brief _recoveryOptions The options added to the decoder profile of the current playback
+     */
+    QStringList _recoveryOptions;
+
+    /**
+     * @brief _resumeTime The time the next play starts from when later than the in mark (ms)
+     */
+    int _resumeTime;
 };
 
 #endif // MEDIAPLAYER_H
@@ -31,9 +31,14 @@
 #include <vlc/vlc.h>
 
 #include "media.h"
+#include "loudnessmeter.h"
 
 int Playlist::s_instanceCount = 0;
 
+/* range of the audio gain setting (amplitude dB), libvlc amplifies up to twice */
+static const double MIN_GAIN = -20.0;
+static const double MAX_GAIN = 6.02;
+
 Playlist::Playlist(const QString &title, QObject *parent) :
     QObject(parent),
     _title(title)
@@ -110,3 +115,24 @@ uint Playlist::totalDuration() const
 
     return duration;
 }
+
+int Playlist::normalizeLoudness(double target)
+{
+    int skipped = 0;
+
+    foreach(Playback *playback, _playbackList) {
+        Media *media = playback->media();
+
+        if (!media->hasLoudness() || media->loudness() <= LoudnessMeter::LOUDNESS_FLOOR) {
+            skipped++;
+            continue;
+        }
+
+        double gain = qMin(target - media->loudness(), MAX_TRUE_PEAK - media->truePeak());
+        gain = qBound(MIN_GAIN, gain, MAX_GAIN);
+
+        playback->mediaSettings()->setGain(qRound(gain * 100) / 100.f);
+    }
+
+    return skipped;
+}
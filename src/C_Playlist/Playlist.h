@@ -142,6 +142,28 @@ public:
      */
     uint totalDuration() const;
 
+    /**
+     * @brief Set the gain of each playback to reach a loudness
+     *
+     * The gain keeps the true peak under MAX_TRUE_PEAK and stays in the range
+     * of the audio gain setting. A LU is an amplitude dB, the unit of the gain
+     * on every path of the player.
+     *
+     * @param target The loudness to reach (LUFS)
+     * @return The number of playbacks left as is, their media not analyzed or silent
+     */
+    int normalizeLoudness(double target);
+
+    /**
+     * @brief DEFAULT_LOUDNESS_TARGET Loudness of EBU R128 (LUFS)
+     */
+    static const int DEFAULT_LOUDNESS_TARGET = -23;
+
+    /**
+     * @brief MAX_TRUE_PEAK Highest true peak allowed by EBU R128 (dBTP)
+     */
+    static const int MAX_TRUE_PEAK = -1;
+
 signals:
 
     /**
@@ -26,6 +26,7 @@
  **********************************************************************************/
 
 #include <QTimer>
+#include <QSettings>
 #include <vlc/vlc.h>
 
 #include "mainwindow.h"
@@ -34,15 +35,27 @@
 #include "PlaylistPlayer.h"
 #include "media.h"
 #include "MediaPlayer.h"
+#include "enginesupervisor.h"
 
 
 PlaylistPlayer::PlaylistPlayer(libvlc_instance_t *vlcInstance, QObject *parent) :
     QObject(parent),
-    _currentIndex(-1)
+    _playlist(NULL),
+    _currentIndex(-1),
+    _queuedIndex(-1)
 {
     _mediaPlayer = new MediaPlayer(vlcInstance, this);
     _loop = NOLOOP;
 
+    QSettings settings("opp", "opp");
+    if(settings.value("engineProcess").toBool()){
+        _mediaPlayer->setEngine(new EngineSupervisor());
+
+        // the playlist goes on in the engine, the interface follows it
+        connect(_mediaPlayer->engine(), SIGNAL(advanced()), this, SLOT(engineAdvanced()));
+        connect(this, SIGNAL(itemChanged(int)), this, SLOT(queueNext()));
+    }
+
     connect(_mediaPlayer, SIGNAL(end()), this, SLOT(handlePlayerEnd()));
 }
 
@@ -216,17 +229,60 @@ int  PlaylistPlayer::getCurrentIndex()
     return _currentIndex;
 }
 
+int PlaylistPlayer::nextIndex() const
+{
+    if (_playlist == NULL)
+        return -1;
+
+    return nextIndex(_currentIndex, _playlist->count(), _loop);
+}
+
+int PlaylistPlayer::nextIndex(int currentIndex, int count, Loop loop)
+{
+    if (count == 0)
+        return -1;
+
+    // same choice as handlePlayerEnd
+    if (loop == SINGLELOOP)
+        return currentIndex;
+
+    if (currentIndex >= count - 1)
+        return loop == BIGLOOP ? 0 : -1;
+
+    return currentIndex + 1;
+}
+
 void  PlaylistPlayer::currentIndexUp()
 {
     _currentIndex++;
+    queueNext();
 }
 
 void  PlaylistPlayer::currentIndexDown()
 {
     _currentIndex--;
+    queueNext();
 }
 
 void PlaylistPlayer::setLoop(Loop newLoopState)
 {
     _loop = newLoopState;
+    queueNext();
+}
+
+void PlaylistPlayer::queueNext()
+{
+    EngineSupervisor *engine = _mediaPlayer->engine();
+    if (engine == NULL)
+        return;
+
+    _queuedIndex = nextIndex();
+    engine->queue(_queuedIndex >= 0 ? _playlist->at(_queuedIndex) : NULL);
+}
+
+void PlaylistPlayer::engineAdvanced()
+{
+    // already played by the engine, only opened here to follow it
+    if (_playlist != NULL && _queuedIndex >= 0 && _queuedIndex < _playlist->count())
+        initItemAt(_queuedIndex);
 }
@@ -148,6 +148,21 @@ public slots:
      */
     int getCurrentIndex();
 
+    /**
+     * @brief Get the index of the item played at the end of the current one
+     * @return The index, -1 if the playlist ends
+     */
+    int nextIndex() const;
+
+    /**
+     * @brief Get the index of the item played at the end of another one
+     * @param currentIndex The index of the item playing
+     * @param count The number of items of the playlist
+     * @param loop The loop mode
+     * @return The index, -1 if the playlist ends
+     */
+    static int nextIndex(int currentIndex, int count, Loop loop);
+
     /**
      * @brief Current index ++
      *
@@ -173,6 +188,19 @@ private slots:
      */
     void handlePlayerEnd();
 
+    /**
+     * @brief Queue the item of nextIndex() in the engine process, if any
+     *
+     * The engine plays it at the end of the current item, even when the
+     * interface does not respond.
+     */
+    void queueNext();
+
+    /**
+     * @brief Follow the engine process which has played the queued item
+     */
+    void engineAdvanced();
+
 signals:
 
     /**
@@ -202,6 +230,11 @@ private:
      */
     int _currentIndex;
 
+    /**
+     * @brief The index of the item queued in the engine process, -1 if none
+     */
+    int _queuedIndex;
+
     Loop _loop;
 };
 
@@ -46,7 +46,15 @@ HEADERS += src/mainwindow.h \
     src/screenshotselector.h \
     src/exportpdf.h \
     src/loggersingleton.h \
-    src/application.h
+    src/application.h \
+    src/frameextractor.h \
+    src/stagingcache.h \
+    src/cachewarmer.h \
+    src/mediaingest.h \
+    src/proxygenerator.h \
+    src/playbackengine.h \
+    src/enginesupervisor.h \
+    src/playbackrecovery.h
 
 SOURCES += src/main.cpp \
     src/mainwindow.cpp \
@@ -68,7 +76,15 @@ SOURCES += src/main.cpp \
     src/screenshotselector.cpp \
     src/exportpdf.cpp \
     src/loggersingleton.cpp \
-    src/application.cpp
+    src/application.cpp \
+    src/frameextractor.cpp \
+    src/stagingcache.cpp \
+    src/cachewarmer.cpp \
+    src/mediaingest.cpp \
+    src/proxygenerator.cpp \
+    src/playbackengine.cpp \
+    src/enginesupervisor.cpp \
+    src/playbackrecovery.cpp
 
 FORMS += src/mainwindow.ui \
     src/saturationwidget.ui \
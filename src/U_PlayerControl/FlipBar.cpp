@@ -1,16 +1,41 @@
+#include <QFile>
+#include <QLabel>
 #include <QMouseEvent>
+#include <QPainter>
+#include <QStyle>
 #include <QTimer>
 
+#include <math.h>
+
 #include "PlayerControlWidget.h"
+#include "ScrubEngine.h"
 #include "FlipBar.h"
+#include "frameextractor.h"
+#include "proxygenerator.h"
+#include "waveformextractor.h"
 
 FlipBar::FlipBar(QWidget *parent) :
     QSlider(parent),
     _mediaPlayer(0),
-    _oldState("")
+    _scrubEngine(new ScrubEngine(this)),
+    _oldState(""),
+    _waveformExtractor(NULL),
+    _previewExtractor(NULL),
+    _preview(new QLabel(this, Qt::ToolTip)),
+    _previewTimer(new QTimer(this)),
+    _previewTime(0),
+    _previewX(0),
+    _length(1)
 {
     _playerControlWidget = (PlayerControlWidget*)((SeekWidget*)parent)->parent();
 
+    _previewTimer->setSingleShot(true);
+    connect(_previewTimer, SIGNAL(timeout()), this, SLOT(extractPreview()));
+    _preview->setFrameStyle(QFrame::Box | QFrame::Plain);
+
+    // the preview follows the mouse even without a button pressed
+    setMouseTracking(true);
+
     setOrientation(Qt::Horizontal);
     setMaximum(1);
     setStyleSheet(QString(
@@ -47,12 +72,20 @@ FlipBar::FlipBar(QWidget *parent) :
         "  background: qlineargradient(x1:0, y1:0, x2:0, y2:1, stop:0 rgb(176,176,176), stop:1 rgb(157,157,157));"
         "  border: 1px solid rgb(143,143,143);"
         "}"
+        /* the waveform is seen through the groove */
+        "QSlider[waveform=\"true\"]::groove:horizontal {"
+        "  background: rgba(196,196,196,80);"
+        "}"
+        "QSlider[waveform=\"true\"]::sub-page:horizontal {"
+        "  background: rgba(127,127,127,120);"
+        "}"
     ));
 }
 
 void FlipBar::setPlaylistPlayer(PlaylistPlayer* playlistPlayer){
     _playlistPlayer = playlistPlayer;
     _mediaPlayer = playlistPlayer->mediaPlayer();
+    _scrubEngine->setMediaPlayer(_mediaPlayer);
 }
 
 
@@ -81,7 +114,7 @@ void FlipBar::mousePressEvent(QMouseEvent *event)
     if(_mediaPlayer->volume() != 0)
         _mediaPlayer->setVolume(0);
 
-    updatePosition(event->x());
+    updatePosition(event->x(), false);
 
     QSlider::mousePressEvent(event);
 }
@@ -90,12 +123,20 @@ void FlipBar::mouseMoveEvent(QMouseEvent *event)
 {
     event->ignore();
 
+    schedulePreview(event->x());
+
+    // hovering, not a seek
+    if(event->buttons() == Qt::NoButton){
+        QSlider::mouseMoveEvent(event);
+        return;
+    }
+
     if(_mediaPlayer->media() == NULL ){
         QSlider::mouseMoveEvent(event);
         return;
     }
 
-    updatePosition(event->x());
+    updatePosition(event->x(), false);
 
     QSlider::mouseMoveEvent(event);
 }
@@ -109,7 +150,7 @@ void FlipBar::mouseReleaseEvent(QMouseEvent *event)
         return;
     }
 
-    updatePosition(event->x());
+    updatePosition(event->x(), true);
 
     if(_oldState == "playing"){
         _mediaPlayer->play();
@@ -122,17 +163,28 @@ void FlipBar::mouseReleaseEvent(QMouseEvent *event)
     QSlider::mouseReleaseEvent(event);
 }
 
-void FlipBar::updatePosition(int posX)
+int FlipBar::valueAt(int posX) const
 {
     int grooveWidth = width() - 2 - 16; // The global width less 2 (2 borders) - 16 (2 margins)
-    float unit = maximum() / grooveWidth;
-    float newValue = (posX - 9) * unit; // 9 = 1 margin + 1 border
+    if(grooveWidth <= 0)
+        return minimum();
 
-    setValue(newValue);
+    float unit = (float) (maximum() - minimum()) / grooveWidth;
+    int value = minimum() + (posX - 9) * unit; // 9 = 1 margin + 1 border
+
+    return qBound(minimum(), value, maximum());
+}
+
+void FlipBar::updatePosition(int posX, bool precise)
+{
+    int newValue = valueAt(posX);
 
-    // Change to percentage
-    newValue = newValue/maximum();
-    _mediaPlayer->setPosition(newValue);
+    // only the latest position is sent, one seek at a time
+    if(!precise && newValue == value() && _scrubEngine->isBusy())
+        return;
+
+    setValue(newValue);
+    _scrubEngine->seek(newValue, precise);
 
     // Stop the faders out
     _mediaPlayer->stopFaderOut(); // TEST DEBUG FIN SEEK BAR LECTURE
@@ -147,3 +199,252 @@ void FlipBar::pauseAfterAWhile()
 
     _mediaPlayer->pause();
 }
+
+void FlipBar::setWaveformExtractor(WaveformExtractor *extractor)
+{
+    if(_waveformExtractor != NULL)
+        disconnect(_waveformExtractor, SIGNAL(analyzed(Media*)), this, SLOT(waveformExtracted(Media*)));
+
+    _waveformExtractor = extractor;
+
+    if(_waveformExtractor != NULL)
+        connect(_waveformExtractor, SIGNAL(analyzed(Media*)), this, SLOT(waveformExtracted(Media*)));
+}
+
+void FlipBar::setPreviewExtractor(FrameExtractor *extractor)
+{
+    if(_previewExtractor != NULL)
+        disconnect(_previewExtractor, SIGNAL(frameExtracted(int,int,QImage)), this, SLOT(previewExtracted(int,int,QImage)));
+
+    _previewExtractor = extractor;
+
+    if(_previewExtractor != NULL)
+        connect(_previewExtractor, SIGNAL(frameExtracted(int,int,QImage)), this, SLOT(previewExtracted(int,int,QImage)));
+}
+
+void FlipBar::leaveEvent(QEvent *event)
+{
+    _previewTimer->stop();
+    _preview->hide();
+
+    if(_previewExtractor != NULL)
+        _previewExtractor->cancel();
+
+    QSlider::leaveEvent(event);
+}
+
+void FlipBar::schedulePreview(int posX)
+{
+    if(_previewExtractor == NULL || !_mediaPlayer || _mediaPlayer->currentPlayback() == NULL)
+        return;
+
+    _previewTime = valueAt(posX);
+    _previewX = posX;
+
+    if(!_previewTimer->isActive())
+        _previewTimer->start(PREVIEW_DELAY);
+}
+
+void FlipBar::extractPreview()
+{
+    if(_previewExtractor == NULL || !_mediaPlayer || _mediaPlayer->currentPlayback() == NULL)
+        return;
+
+    // one frame at a time, the latest position is asked next
+    if(_previewExtractor->isRunning()){
+        _previewTimer->start(PREVIEW_DELAY);
+        return;
+    }
+
+    Media *media = _mediaPlayer->currentPlayback()->media();
+    if(media->isAudio() || media->isImage() || !QFile::exists(ProxyGenerator::proxyFile(media->location())))
+        return;
+
+    QList<int> times;
+    times << _previewTime;
+    _previewExtractor->extract(media->location(), times, FrameExtractor::frameSize(media, PREVIEW_WIDTH));
+}
+
+void FlipBar::previewExtracted(int index, int time, const QImage &image)
+{
+    Q_UNUSED(index);
+    Q_UNUSED(time);
+
+    if(!underMouse())
+        return;
+
+    _preview->setPixmap(QPixmap::fromImage(image));
+    _preview->adjustSize();
+
+    int x = qBound(0, _previewX - _preview->width() / 2, width() - _preview->width());
+    _preview->move(mapToGlobal(QPoint(x, -_preview->height() - 4)));
+    _preview->show();
+}
+
+void FlipBar::setLength(int length)
+{
+    _length = length;
+    setRange(0, length);
+
+    loadWaveform();
+    _waveformPixmap = QPixmap();
+    update();
+}
+
+void FlipBar::setTime(int time)
+{
+    // a zoomed view jumps forward when the bar leaves it
+    if(time < minimum() || time > maximum()){
+        int span = maximum() - minimum();
+        int start = qBound(0, time - span / 10, _length - span);
+
+        blockSignals(true);
+        setRange(start, start + span);
+        blockSignals(false);
+
+        _waveformPixmap = QPixmap();
+    }
+
+    setValue(time);
+}
+
+void FlipBar::wheelEvent(QWheelEvent *event)
+{
+    if(event->modifiers() & Qt::ControlModifier){
+        zoom(event->delta() > 0 ? 1 : -1, event->x());
+        event->accept();
+        return;
+    }
+
+    QSlider::wheelEvent(event);
+}
+
+void FlipBar::zoom(int steps, int posX)
+{
+    if(_length <= 1)
+        return;
+
+    int span = maximum() - minimum();
+    int newSpan = qBound(qMin(MIN_ZOOM_LENGTH, _length), (int) (span * pow(2.0, -steps)), _length);
+    if(newSpan == span)
+        return;
+
+    int anchor = valueAt(posX);
+    int start = anchor - (int) ((double) (anchor - minimum()) * newSpan / span);
+    start = qBound(0, start, _length - newSpan);
+
+    // the value may be out of the view for a while, it is not a seek
+    int time = value();
+    blockSignals(true);
+    setRange(start, start + newSpan);
+    blockSignals(false);
+    if(time >= minimum() && time <= maximum())
+        setValue(time);
+
+    _waveformPixmap = QPixmap();
+    update();
+}
+
+void FlipBar::loadWaveform()
+{
+    Media *media = NULL;
+    if(_mediaPlayer && _length > 1 && _mediaPlayer->currentPlayback() != NULL)
+        media = _mediaPlayer->currentPlayback()->media();
+
+    QString location = media != NULL ? media->location() : QString();
+    if(location == _waveformLocation)
+        return;
+
+    _waveformLocation = location;
+    _waveform = Waveform();
+
+    // built in background the first time, the bar stays plain meanwhile
+    if(media != NULL && !_waveform.load(Waveform::cacheFile(location)) && _waveformExtractor != NULL)
+        _waveformExtractor->analyze(media);
+
+    showWaveform(!_waveform.isEmpty());
+}
+
+void FlipBar::waveformExtracted(Media *media)
+{
+    if(media->location() != _waveformLocation || !_waveform.isEmpty())
+        return;
+
+    _waveform.load(Waveform::cacheFile(_waveformLocation));
+    showWaveform(!_waveform.isEmpty());
+}
+
+void FlipBar::showWaveform(bool show)
+{
+    if(property("waveform").toBool() != show){
+        setProperty("waveform", show);
+        style()->unpolish(this);
+        style()->polish(this);
+    }
+
+    _waveformPixmap = QPixmap();
+    update();
+}
+
+void FlipBar::resizeEvent(QResizeEvent *event)
+{
+    _waveformPixmap = QPixmap();
+
+    QSlider::resizeEvent(event);
+}
+
+void FlipBar::paintEvent(QPaintEvent *event)
+{
+    if(!_waveform.isEmpty()){
+        if(_waveformPixmap.isNull())
+            renderWaveform();
+
+        QPainter painter(this);
+        painter.drawPixmap(0, 0, _waveformPixmap);
+    }
+
+    QSlider::paintEvent(event);
+}
+
+void FlipBar::renderWaveform()
+{
+    _waveformPixmap = QPixmap(size());
+    _waveformPixmap.fill(Qt::transparent);
+
+    int grooveWidth = width() - 2 - 16;
+    int span = maximum() - minimum();
+    if(grooveWidth <= 0 || span <= 0)
+        return;
+
+    // the level with about one bucket per pixel
+    double pixelDuration = (double) span / grooveWidth;
+    int index = _waveform.levelFor(pixelDuration);
+    const QVector<Waveform::Peak> &peaks = _waveform.level(index);
+    double bucketDuration = _waveform.bucketDuration(index);
+
+    int middle = height() / 2;
+    double scale = (height() / 2 - 1) / 127.0;
+
+    QPainter painter(&_waveformPixmap);
+
+    for(int x = 0; x < grooveWidth; ++x){
+        int first = (int) ((minimum() + x * pixelDuration) / bucketDuration);
+        int last = (int) ((minimum() + (x + 1) * pixelDuration) / bucketDuration);
+        if(first >= peaks.count())
+            break;
+        last = qBound(first + 1, last, peaks.count());
+
+        int min = 0, max = 0, squares = 0;
+        for(int i = first; i < last; ++i){
+            min = qMin(min, (int) peaks.at(i).min);
+            max = qMax(max, (int) peaks.at(i).max);
+            squares += peaks.at(i).rms * peaks.at(i).rms;
+        }
+        double rms = sqrt((double) squares / (last - first)) * 127.0 / 255.0;
+
+        painter.setPen(QColor(150, 150, 150));
+        painter.drawLine(9 + x, middle - qRound(max * scale), 9 + x, middle - qRound(min * scale));
+        painter.setPen(QColor(95, 95, 95));
+        painter.drawLine(9 + x, middle - qRound(rms * scale), 9 + x, middle + qRound(rms * scale));
+    }
+}
@@ -3,11 +3,18 @@
 
 #include <QSlider>
 #include <QTimer>
+#include <QPixmap>
+#include <QImage>
 
 #include "MediaPlayer.h"
 #include "PlayerControlWidget.h"
+#include "waveform.h"
 
 class PlayerControlWidget;
+class FrameExtractor;
+class QLabel;
+class ScrubEngine;
+class WaveformExtractor;
 
 class FlipBar : public QSlider
 {
@@ -17,6 +24,36 @@ public:
 
     void setPlaylistPlayer(PlaylistPlayer* mediaPlayer);
 
+    /**
+     * @brief get the scrub engine used to seek
+     */
+    ScrubEngine* scrubEngine() const { return _scrubEngine; }
+
+    /**
+     * @brief Set the length of the media, show all of it and load its waveform
+     * @param length The length in ms
+     */
+    void setLength(int length);
+
+    /**
+     * @brief Move the bar to a time, the zoomed view follows it
+     * @param time The time in ms
+     */
+    void setTime(int time);
+
+    /**
+     * @brief Give the extractor of the waveforms which are not in cache
+     */
+    void setWaveformExtractor(WaveformExtractor *extractor);
+
+    /**
+     * @brief Give the extractor of the frames shown over the bar
+     *
+     * The frame under the mouse is shown while hovering or dragging, only
+     * for the media which have a proxy: the master is left to the projection.
+     */
+    void setPreviewExtractor(FrameExtractor *extractor);
+
 signals:
     void positionManuallyChanged();
 
@@ -39,13 +76,85 @@ protected:
     void mousePressEvent(QMouseEvent *event);
 
     /**
-     * @brief updatePosition
+     * @brief Hide the frame preview
+     */
+    void leaveEvent(QEvent *event);
+
+    /**
+     * @brief Ask for the frame under the mouse, at most one every PREVIEW_DELAY
+     * @param posX The mouse position
+     */
+    void schedulePreview(int posX);
+
+    /**
+     * @brief Move the bar under the mouse and ask the scrub engine to seek there
+     * @param posX The mouse position
+     * @param precise False while dragging, true for the final position
+     */
+    void updatePosition(int posX, bool precise);
+
+    /**
+     * @brief Draw the waveform behind the groove
+     */
+    void paintEvent(QPaintEvent *event);
+
+    /**
+     * @brief Draw the waveform again at the new size
+     */
+    void resizeEvent(QResizeEvent *event);
+
+    /**
+     * @brief Zoom around the mouse with Ctrl, default slider behaviour otherwise
+     */
+    void wheelEvent(QWheelEvent *event);
+
+    /**
+     * @brief Get the time under a mouse position
+     * @param posX The mouse position
+     * @return The time in ms, in the visible range
      */
-    void updatePosition(int posX);
+    int valueAt(int posX) const;
+
+    /**
+     * @brief Show a shorter or longer part of the media
+     * @param steps The number of times the view is halved, doubled if negative
+     * @param posX The mouse position, whose time stays in place
+     */
+    void zoom(int steps, int posX);
+
+    /**
+     * @brief Load the waveform of the current media, or ask for it
+     */
+    void loadWaveform();
+
+    /**
+     * @brief Show or hide the waveform, the groove is translucent over it
+     */
+    void showWaveform(bool show);
+
+    /**
+     * @brief Draw the waveform of the visible range into the cached pixmap
+     */
+    void renderWaveform();
 
 private slots:
     void pauseAfterAWhile();
 
+    /**
+     * @brief Show the waveform of the current media once extracted
+     */
+    void waveformExtracted(Media *media);
+
+    /**
+     * @brief Extract the frame of the latest previewed time, once the last one is shown
+     */
+    void extractPreview();
+
+    /**
+     * @brief Show the extracted frame over the previewed position
+     */
+    void previewExtracted(int index, int time, const QImage &image);
+
 private:
 
     PlaylistPlayer* _playlistPlayer;
@@ -54,10 +163,67 @@ private:
 
     PlayerControlWidget* _playerControlWidget;
 
+    /**
+     * @brief Coalesce the seeks sent to the media player
+     */
+    ScrubEngine* _scrubEngine;
+
     /**
      * @brief Allow to know if the madia player was stopped during a seek widget action.
      */
     QString _oldState;
+
+    WaveformExtractor *_waveformExtractor;
+
+    FrameExtractor *_previewExtractor;
+
+    /**
+     * @brief The popup showing the frame under the mouse
+     */
+    QLabel *_preview;
+
+    /**
+     * @brief Throttle the frame extractions while the mouse moves
+     */
+    QTimer *_previewTimer;
+
+    /**
+     * @brief The time (ms) and the mouse position of the latest preview asked
+     */
+    int _previewTime;
+    int _previewX;
+
+    /**
+     * @brief The length of the media, the visible range is a part of it when zoomed
+     */
+    int _length;
+
+    /**
+     * @brief The location of the media of the waveform
+     */
+    QString _waveformLocation;
+
+    Waveform _waveform;
+
+    /**
+     * @brief The waveform drawn for the current size and visible range
+     */
+    QPixmap _waveformPixmap;
+
+    /**
+     * @brief The shortest visible range when zoomed (ms)
+     */
+    static const int MIN_ZOOM_LENGTH = 10000;
+
+    /**
+     * @brief The width of the frame preview
+     */
+    static const int PREVIEW_WIDTH = 160;
+
+    /**
+     * @brief The shortest time between two frame extractions of the preview (ms)
+     */
+    static const int PREVIEW_DELAY = 40;
 };
 
 #endif // FLIPBAR_H
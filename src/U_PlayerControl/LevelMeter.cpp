@@ -0,0 +1,201 @@
+/**********************************************************************************
+ * This file is part of Open Projection Program (OPP).
+ *
+ * Copyright (C) 2013 Catalogue Ouvert du Cinéma <dev@cinemaouvert.fr>
+ *
+ * Authors: Jerome Blanchi <d.j.a.y@free.fr>
+ *
+ * Open Projection Program is an initiative of Catalogue Ouvert du Cinéma.
+ * The software was developed by four students of University of Poitiers
+ * as school project.
+ *
+ * Open Projection Program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Open Projection Program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Open Projection Program. If not, see <http://www.gnu.org/licenses/>.
+ **********************************************************************************/
+
+#include "LevelMeter.h"
+
+#include <math.h>
+
+#include <QTimer>
+#include <QPainter>
+
+#include "MediaPlayer.h"
+
+// a sample at full scale, the OPP gain can go above
+#define CLIP_LEVEL 0.999f
+
+LevelMeter::LevelMeter(MediaPlayer *mediaPlayer, QWidget *parent) :
+    QWidget(parent),
+    _mediaPlayer(mediaPlayer),
+    _timer(new QTimer(this)),
+    _available(mediaPlayer->hasAudioLevels())
+{
+    setSizePolicy(QSizePolicy::Preferred, QSizePolicy::Fixed);
+    if (_available)
+        setToolTip(tr("Audio levels, click to clear the clip indicators"));
+    else
+        setToolTip(tr("Audio levels unavailable: the OPP audio module is not installed"));
+
+    // stereo until the first levels come
+    _peaks.fill(FLOOR, 2);
+    _rms.fill(FLOOR, 2);
+    _holds.fill(FLOOR, 2);
+    _holdReadings.fill(0, 2);
+    _clips.fill(false, 2);
+
+    connect(_timer, SIGNAL(timeout()), this, SLOT(updateLevels()));
+    if (_available)
+        _timer->start(REFRESH_INTERVAL);
+}
+
+QSize LevelMeter::sizeHint() const
+{
+    return QSize(120, 18);
+}
+
+void LevelMeter::reset()
+{
+    _peaks.fill(FLOOR);
+    _rms.fill(FLOOR);
+    _holds.fill(FLOOR);
+    _holdReadings.fill(0);
+    _clips.fill(false);
+
+    update();
+}
+
+void LevelMeter::updateLevels()
+{
+    float peaks[MAX_CHANNELS];
+    float rms[MAX_CHANNELS];
+    int channels = _mediaPlayer->audioLevels(peaks, rms, MAX_CHANNELS);
+    bool changed = false;
+
+    if (channels > 0 && channels != _peaks.count()) {
+        _peaks.fill(FLOOR, channels);
+        _rms.fill(FLOOR, channels);
+        _holds.fill(FLOOR, channels);
+        _holdReadings.fill(0, channels);
+        _clips.fill(false, channels);
+        changed = true;
+    }
+
+    for (int c = 0; c < _peaks.count(); c++) {
+        float peak = c < channels ? decibels(peaks[c]) : FLOOR;
+        float power = c < channels ? decibels(rms[c]) : FLOOR;
+        float value;
+
+        // instant rise, slow fall
+        value = qMax(peak, _peaks[c] - FALL);
+        changed |= value != _peaks[c];
+        _peaks[c] = value;
+
+        value = qMax(power, _rms[c] - FALL);
+        changed |= value != _rms[c];
+        _rms[c] = value;
+
+        if (peak >= _holds[c]) {
+            changed |= peak != _holds[c];
+            _holds[c] = peak;
+            _holdReadings[c] = HOLD_READINGS;
+        } else if (_holdReadings[c] > 0) {
+            _holdReadings[c]--;
+        } else if (_holds[c] > FLOOR) {
+            _holds[c] = qMax((float)FLOOR, _holds[c] - FALL);
+            changed = true;
+        }
+
+        if (c < channels && peaks[c] >= CLIP_LEVEL && !_clips[c]) {
+            _clips[c] = true;
+            changed = true;
+        }
+    }
+
+    // nothing to draw while silent
+    if (changed)
+        update();
+}
+
+void LevelMeter::paintEvent(QPaintEvent *event)
+{
+    Q_UNUSED(event);
+
+    QPainter painter(this);
+
+    if (!_available) {
+        painter.fillRect(rect(), QColor(40, 40, 40));
+        painter.setPen(QColor(160, 160, 160));
+        painter.drawText(rect(), Qt::AlignCenter, tr("Meter unavailable"));
+        return;
+    }
+
+    int channels = _peaks.count();
+    int clipWidth = 6;
+    int length = width() - clipWidth - 1;
+    int barHeight = (height() - (channels - 1)) / channels;
+
+    if (barHeight < 1)
+        return;
+
+    for (int c = 0; c < channels; c++) {
+        QRect bar(0, c * (barHeight + 1), length, barHeight);
+        int rms = position(_rms[c], length);
+        int peak = position(_peaks[c], length);
+        int hold = position(_holds[c], length);
+
+        painter.fillRect(bar, QColor(40, 40, 40));
+        painter.fillRect(bar.x(), bar.y(), rms, barHeight, color(_rms[c]));
+        if (peak > rms)
+            painter.fillRect(bar.x() + rms, bar.y(), peak - rms, barHeight, color(_peaks[c]).darker(160));
+        if (hold > 0)
+            painter.fillRect(bar.x() + hold - 1, bar.y(), 2, barHeight, color(_holds[c]).lighter(130));
+
+        painter.fillRect(length + 1, bar.y(), clipWidth, barHeight,
+                         _clips[c] ? QColor(230, 30, 30) : QColor(70, 70, 70));
+    }
+
+    if (!isEnabled())
+        painter.fillRect(rect(), QColor(255, 255, 255, 128));
+}
+
+void LevelMeter::mousePressEvent(QMouseEvent *event)
+{
+    Q_UNUSED(event);
+
+    _clips.fill(false);
+    update();
+}
+
+float LevelMeter::decibels(float level)
+{
+    if (level <= 0.f)
+        return FLOOR;
+
+    return qMax((float)FLOOR, 20.f * log10f(level));
+}
+
+int LevelMeter::position(float decibels, int length)
+{
+    return qBound(0, qRound((decibels - FLOOR) * length / -FLOOR), length);
+}
+
+QColor LevelMeter::color(float decibels)
+{
+    if (decibels >= -1.f)
+        return QColor(230, 30, 30);
+    if (decibels >= -9.f)
+        return QColor(230, 200, 40);
+
+    return QColor(60, 190, 70);
+}
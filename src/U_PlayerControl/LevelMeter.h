@@ -0,0 +1,146 @@
+/**********************************************************************************
+ * This file is part of Open Projection Program (OPP).
+ *
+ * Copyright (C) 2013 Catalogue Ouvert du Cinéma <dev@cinemaouvert.fr>
+ *
+ * Authors: Jerome Blanchi <d.j.a.y@free.fr>
+ *
+ * Open Projection Program is an initiative of Catalogue Ouvert du Cinéma.
+ * The software was developed by four students of University of Poitiers
+ * as school project.
+ *
+ * Open Projection Program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Open Projection Program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Open Projection Program. If not, see <http://www.gnu.org/licenses/>.
+ **********************************************************************************/
+
+#ifndef LEVELMETER_H
+#define LEVELMETER_H
+
+#include <QWidget>
+#include <QVector>
+#include <QColor>
+
+class QTimer;
+class MediaPlayer;
+
+/**
+ * @brief Peak and RMS meters of the channels played by a media player
+ *
+ * The levels are measured by the OPP audio module on the samples it outputs
+ * and polled at display rate. Each channel has a bar for the RMS level, a
+ * lighter bar up to the peak level, a peak hold line and a clip indicator
+ * latched until the meter is clicked. Without the audio module, the meter
+ * stays in an "unavailable" state.
+ */
+class LevelMeter : public QWidget
+{
+    Q_OBJECT
+public:
+    explicit LevelMeter(MediaPlayer *mediaPlayer, QWidget *parent = 0);
+
+    QSize sizeHint() const;
+
+    /**
+     * @brief REFRESH_INTERVAL Time between two readings of the levels (ms)
+     */
+    static const int REFRESH_INTERVAL = 40;
+
+    /**
+     * @brief FLOOR Lowest level shown (dBFS)
+     */
+    static const int FLOOR = -60;
+
+    /**
+     * @brief FALL Fall of the bars and the hold lines at each reading (dB)
+     */
+    static const int FALL = 1;
+
+    /**
+     * @brief HOLD_READINGS Readings a peak hold line stays before falling
+     */
+    static const int HOLD_READINGS = 50;
+
+    /**
+     * @brief MAX_CHANNELS Channels shown at most
+     */
+    static const int MAX_CHANNELS = 8;
+
+public slots:
+    /**
+     * @brief Drop the levels shown and the clip indicators
+     */
+    void reset();
+
+protected:
+    void paintEvent(QPaintEvent *event);
+
+    void mousePressEvent(QMouseEvent *event);
+
+private slots:
+    /**
+     * @brief Read the levels played since the last reading
+     */
+    void updateLevels();
+
+private:
+    /**
+     * @brief Convert a level to dBFS, not under FLOOR
+     */
+    static float decibels(float level);
+
+    /**
+     * @brief Get the position of a level on a bar
+     */
+    static int position(float decibels, int length);
+
+    /**
+     * @brief Get the color of a level
+     */
+    static QColor color(float decibels);
+
+    MediaPlayer *_mediaPlayer;
+
+    QTimer *_timer;
+
+    /**
+     * @brief _available True if the player measures its levels
+     */
+    bool _available;
+
+    /**
+     * @brief _peaks The peak level shown of each channel (dBFS)
+     */
+    QVector<float> _peaks;
+
+    /**
+     * @brief _rms The RMS level shown of each channel (dBFS)
+     */
+    QVector<float> _rms;
+
+    /**
+     * @brief _holds The peak hold of each channel (dBFS)
+     */
+    QVector<float> _holds;
+
+    /**
+     * @brief _holdReadings The readings left before each hold falls
+     */
+    QVector<int> _holdReadings;
+
+    /**
+     * @brief _clips True for the channels which reached full scale
+     */
+    QVector<bool> _clips;
+};
+
+#endif // LEVELMETER_H
@@ -233,6 +233,12 @@ void PlayerControlWidget::createWidgets()
 
     _horizontalLayout->addWidget(_volumeLabel);
 
+    // LEVEL METER
+    _levelMeter = new LevelMeter(_playlistPlayer->mediaPlayer(), this);
+    _levelMeter->setMaximumWidth(160);
+
+    _horizontalLayout->addWidget(_levelMeter);
+
     // BUTTON BAR
     _buttonBar = new QWidget(this);
     _buttonBar->setLayout(_horizontalLayout);
@@ -260,6 +266,7 @@ void PlayerControlWidget::createConnections()
 
     connect(mediaPlayer, SIGNAL(stopped()), this, SLOT(togglePlayPauseButton()));
     connect(mediaPlayer, SIGNAL(end()), this, SLOT(togglePlayPauseButton()));
+    connect(mediaPlayer, SIGNAL(stopped()), _levelMeter, SLOT(reset()));
 
     // Connect the lock button
     connect(_lockButton, SIGNAL(toggled(bool)), this, SLOT(disableControlWidgets(bool)));
@@ -336,6 +343,7 @@ void PlayerControlWidget::disableControlWidgets(bool disable){
     _labelVolumeUp->setEnabled(!disable);
     _volumeSlider->setEnabled(!disable);
     _volumeLabel->setEnabled(!disable);
+    _levelMeter->setEnabled(!disable);
 
     if(_playlistPlayer->mediaPlayer()->isStopped())
         disableRewindForwardBtn();
@@ -14,6 +14,7 @@
 #include "RewindButton.h"
 #include "SeekWidget.h"
 #include "LoopButton.h"
+#include "LevelMeter.h"
 
 class SeekWidget;
 
@@ -31,6 +32,7 @@ public:
     QPushButton* nextButton(){ return _nextButton; }
     QPushButton* rewindButton(){ return _rewindButton; }
     QPushButton* forwardButton(){ return _forwardButton; }
+    SeekWidget* seekWidget(){ return _seekWidget; }
 
     inline int currentVolume() const { return _volumeSlider->value(); }
 
@@ -112,6 +114,7 @@ private:
     QLabel* _labelVolumeUp;
     QSlider* _volumeSlider;
     QLabel* _volumeLabel;
+    LevelMeter* _levelMeter;
 
     QShortcut* _playPause_shortcut;
     QShortcut* _previous_shortcut;
@@ -0,0 +1,117 @@
+/**********************************************************************************
+ * This file is part of Open Projection Program (OPP).
+ *
+ * Copyright (C) 2013 Catalogue Ouvert du Cinéma <dev@cinemaouvert.fr>
+ *
+ * Authors: Jerome Blanchi <d.j.a.y@free.fr>
+ *
+ * Open Projection Program is an initiative of Catalogue Ouvert du Cinéma.
+ * The software was developed by four students of University of Poitiers
+ * as school project.
+ *
+ * Open Projection Program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Open Projection Program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Open Projection Program. If not, see <http://www.gnu.org/licenses/>.
+ **********************************************************************************/
+
+#include "ScrubEngine.h"
+
+#include <QTimer>
+
+#include "MediaPlayer.h"
+
+ScrubEngine::ScrubEngine(QObject *parent) :
+    QObject(parent),
+    _mediaPlayer(0),
+    _settle(new QTimer(this)),
+    _inFlight(false),
+    _pending(false),
+    _target(0),
+    _issued(0),
+    _precise(false)
+{
+    _settle->setSingleShot(true);
+    connect(_settle, SIGNAL(timeout()), this, SLOT(seekDone()));
+}
+
+void ScrubEngine::setMediaPlayer(MediaPlayer *mediaPlayer)
+{
+    if (_mediaPlayer)
+        disconnect(_mediaPlayer, SIGNAL(timeChanged(int)), this, SLOT(timeReached(int)));
+
+    _mediaPlayer = mediaPlayer;
+    _inFlight = false;
+    _pending = false;
+    _settle->stop();
+
+    // the time changes all along the playback, only a time near the seek sent counts
+    if (_mediaPlayer)
+        connect(_mediaPlayer, SIGNAL(timeChanged(int)), this, SLOT(timeReached(int)));
+}
+
+void ScrubEngine::seek(int time, bool precise)
+{
+    if (!_mediaPlayer)
+        return;
+
+    int length = _mediaPlayer->currentLength();
+    if (time < 0)
+        time = 0;
+    else if (length > 0 && time > length)
+        time = length;
+
+    _target = time;
+    _precise = precise;
+    _pending = true;
+
+    if (!_inFlight)
+        issue();
+}
+
+int ScrubEngine::targetTime() const
+{
+    if (isBusy() || !_mediaPlayer)
+        return _target;
+
+    return _mediaPlayer->currentTime();
+}
+
+void ScrubEngine::issue()
+{
+    _pending = false;
+    _inFlight = true;
+    _issued = _target;
+
+    _mediaPlayer->setCurrentTime(_issued);
+
+    _settle->start(_precise ? PRECISE_SEEK_DELAY : FAST_SEEK_DELAY);
+}
+
+void ScrubEngine::timeReached(int time)
+{
+    if (_inFlight && qAbs(time - _issued) <= SEEK_TOLERANCE)
+        seekDone();
+}
+
+void ScrubEngine::seekDone()
+{
+    if (!_inFlight)
+        return;
+
+    _settle->stop();
+    _inFlight = false;
+
+    if (_pending)
+        issue();
+    else
+        emit settled(_target);
+}
@@ -0,0 +1,149 @@
+/**********************************************************************************
+ * This file is part of Open Projection Program (OPP).
+ *
+ * Copyright (C) 2013 Catalogue Ouvert du Cinéma <dev@cinemaouvert.fr>
+ *
+ * Authors: Jerome Blanchi <d.j.a.y@free.fr>
+ *
+ * Open Projection Program is an initiative of Catalogue Ouvert du Cinéma.
+ * The software was developed by four students of University of Poitiers
+ * as school project.
+ *
+ * Open Projection Program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Open Projection Program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Open Projection Program. If not, see <http://www.gnu.org/licenses/>.
+ **********************************************************************************/
+
+#ifndef SCRUBENGINE_H
+#define SCRUBENGINE_H
+
+#include <QObject>
+
+class QTimer;
+class MediaPlayer;
+
+/**
+ * @brief Coalesce the seeks asked by the seek bar and the mouse wheel
+ *
+ * Only the latest target is kept and at most one seek is sent to libvlc at a
+ * time: the next one leaves once the player reported a time near the one
+ * sent, or after a short delay if it never does (keyframe seeks may land
+ * further).
+ */
+class ScrubEngine : public QObject
+{
+    Q_OBJECT
+public:
+    explicit ScrubEngine(QObject *parent = 0);
+
+    /**
+     * @brief Set the media player to drive
+     * @param mediaPlayer The media player
+     */
+    void setMediaPlayer(MediaPlayer *mediaPlayer);
+
+    /**
+     * @brief Ask for a seek, replacing any seek not yet sent
+     * @param time The target time in ms
+     * @param precise False while dragging, true for the final position
+     */
+    void seek(int time, bool precise);
+
+    /**
+     * @brief Get the last asked target, or the current time if idle
+     * @return The time in ms
+     */
+    int targetTime() const;
+
+    /**
+     * @brief Allow to know if a seek is sent or waiting
+     * @return True if busy, false otherwise
+     */
+    inline bool isBusy() const { return _inFlight || _pending; }
+
+signals:
+    /**
+     * @brief Emitted when the last asked seek was done
+     * @param time The time reached in ms
+     */
+    void settled(int time);
+
+private slots:
+    /**
+     * @brief Count the seek sent as done if the player reached its time
+     * @param time The current time of the player in ms
+     */
+    void timeReached(int time);
+
+    /**
+     * @brief Called when the seek sent is done (or supposed so)
+     */
+    void seekDone();
+
+private:
+    /**
+     * @brief Send the pending seek to the media player
+     */
+    void issue();
+
+    /**
+     * @brief FAST_SEEK_DELAY Longest wait for a seek done while dragging (ms)
+     */
+    static const int FAST_SEEK_DELAY = 80;
+
+    /**
+     * @brief PRECISE_SEEK_DELAY Longest wait for the final seek (ms)
+     */
+    static const int PRECISE_SEEK_DELAY = 250;
+
+    /**
+     * @brief SEEK_TOLERANCE Distance from the time sent to count a seek as done (ms)
+     */
+    static const int SEEK_TOLERANCE = 500;
+
+    /**
+     * @brief _mediaPlayer The media player
+     */
+    MediaPlayer *_mediaPlayer;
+
+    /**
+     * @brief _settle Release the in flight seek if the player stays silent
+     */
+    QTimer *_settle;
+
+    /**
+     * @brief _inFlight True while a seek is sent and not done
+     */
+    bool _inFlight;
+
+    /**
+     * @brief _pending True if a target waits to be sent
+     */
+    bool _pending;
+
+    /**
+     * @brief _target The latest asked target (ms)
+     */
+    int _target;
+
+    /**
+     * @brief _issued The time of the seek in flight (ms)
+     */
+    int _issued;
+
+    /**
+     * @brief _precise True if the latest target asked a precise seek
+     */
+    bool _precise;
+};
+
+#endif // SCRUBENGINE_H
@@ -38,6 +38,7 @@
 #include "playback.h"
 #include "MediaPlayer.h"
 #include "SeekWidget.h"
+#include "ScrubEngine.h"
 
 SeekWidget::SeekWidget(QWidget *parent)
     : QWidget(parent),
@@ -95,15 +96,18 @@ void SeekWidget::initSeekWidget()
 void SeekWidget::wheelEvent(QWheelEvent *event)
 {
     event->ignore();
-    initSeekWidget();
 
     if (!_mediaPlayer)
         return;
 
+    // start from the target still pending so that quick ticks add up
+    ScrubEngine *scrubEngine = _seek->scrubEngine();
+    int step = _mediaPlayer->currentLength() * 0.01;
+
     if (event->delta() > 0)
-        _mediaPlayer->setCurrentTime(_mediaPlayer->currentTime() + _mediaPlayer->currentLength() * 0.01);
+        scrubEngine->seek(scrubEngine->targetTime() + step, true);
     else
-        _mediaPlayer->setCurrentTime(_mediaPlayer->currentTime() - _mediaPlayer->currentLength() * 0.01);
+        scrubEngine->seek(scrubEngine->targetTime() - step, true);
 }
 
 
@@ -152,7 +156,7 @@ void SeekWidget::end()
 
     _labelElapsed->setText(time.toString(elapsed));
     _labelRemaining->setText(time.toString(remaining));
-    _seek->setMaximum(1);
+    _seek->setLength(1);
     _seek->setValue(0);
 }
 
@@ -167,7 +171,7 @@ void SeekWidget::updateTime(const int &time)
 
     QString display = "hh:mm:ss";
     _labelElapsed->setText(currentTime.toString(display));
-    _seek->setValue(time);
+    _seek->setTime(time);
 
     /** Update the remaining time */
     int t = _mediaPlayer->currentPlayback()->media()->duration() - time + _mediaPlayer->currentPlayback()->mediaSettings()->inMark();
@@ -188,10 +192,10 @@ void SeekWidget::updateLength(const int &time){
 
     /** set the maximum time */
     if (!time) {
-        _seek->setMaximum(1);
+        _seek->setLength(1);
         setVisible(!_autoHide);
     } else {
-        _seek->setMaximum(time);
+        _seek->setLength(time);
         setVisible(true);
     }
 }
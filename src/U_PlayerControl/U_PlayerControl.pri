@@ -4,7 +4,9 @@ HEADERS += \
     src/U_PlayerControl/PlayerControlWidget.h \
     src/U_PlayerControl/SeekWidget.h \
     src/U_PlayerControl/FlipBar.h \
-    src/U_PlayerControl/LoopButton.h
+    src/U_PlayerControl/LoopButton.h \
+    src/U_PlayerControl/ScrubEngine.h \
+    src/U_PlayerControl/LevelMeter.h
 
 SOURCES += \
     src/U_PlayerControl/ForwardButton.cpp \
@@ -12,7 +14,9 @@ SOURCES += \
     src/U_PlayerControl/PlayerControlWidget.cpp \
     src/U_PlayerControl/SeekWidget.cpp \
     src/U_PlayerControl/FlipBar.cpp \
-    src/U_PlayerControl/LoopButton.cpp
+    src/U_PlayerControl/LoopButton.cpp \
+    src/U_PlayerControl/ScrubEngine.cpp \
+    src/U_PlayerControl/LevelMeter.cpp
 
 DEPENDPATH += ./src/U_PlayerControl
 INCLUDEPATH += ./src/U_PlayerControl
@@ -131,9 +131,32 @@ QVariant PlaylistModel::data(const QModelIndex &index, int role) const
                 break;
             }
         }
+        /*Health found by the verification*/
+        if (index.column() == Status) {
+            switch(media->health())
+            {
+            case Healthy:
+                return QIcon(QString::fromUtf8(":/icons/resources/glyphicons/glyphicons_193_circle_ok.png"));
+                break;
+            case Damaged:
+                return QIcon(QString::fromUtf8(":/icons/resources/glyphicons/glyphicons_196_circle_exclamation_mark.png"));
+                break;
+            case Unreadable:
+                return QIcon(QString::fromUtf8(":/icons/resources/glyphicons/glyphicons_192_circle_remove.png"));
+                break;
+            default :
+                break;
+            }
+        }
         break;
     case Qt::ToolTipRole:
         switch (index.column()) {
+        case Status:
+            if (media->health() == Healthy)
+                return trUtf8("Verified");
+            else if (media->health() != UnknownHealth)
+                return media->healthReport();
+            break;
         case Title:
             return media->name();
             break;
@@ -27,10 +27,15 @@
 
 #include <QStringList>
 #include <QSettings>
+#include <QCoreApplication>
+#include <QDir>
 #include <QDebug>
+#include <QMutexLocker>
 
 #include <vlc/vlc.h>
 
+#include "jobscheduler.h"
+
 VLCApplication::VLCApplication()
 {
     QSettings settings("opp", "opp");
@@ -43,7 +48,6 @@ VLCApplication::VLCApplication()
     #endif
                 << "--ignore-config" // Don't use VLC's config files
                 << "--no-plugins-cache"
-                << "--no-stats" // We don't want statistics
                 << "--no-osd"
                 << "--no-loop"
                 << "--no-video-title-show" // N'incruste pas le titre de la video dans la video
@@ -58,11 +62,16 @@ VLCApplication::VLCApplication()
                 << "--freetype-color=" + subtitleColor(settings.value("subtitleColor").toInt());
     }
 
+    addModulesPath();
     initVlcInstanceFromArgs(vlcargs);
+
+    _jobScheduler = new JobScheduler();
 }
 
 VLCApplication::~VLCApplication()
 {
+    delete _jobScheduler;
+    this->closePlayerPool();
     this->closeLibvlc();
 }
 
@@ -84,6 +93,26 @@ void VLCApplication::initVlcInstanceFromArgs(const QStringList &args)
     }
 }
 
+void VLCApplication::addModulesPath()
+{
+    QDir modules(QCoreApplication::applicationDirPath() + "/modules");
+    if (!modules.exists())
+        return;
+
+    // libvlc looks in VLC_PLUGIN_PATH after its own plugins directory
+    QByteArray path = qgetenv("VLC_PLUGIN_PATH");
+    if (!path.isEmpty()) {
+    #if defined(Q_OS_WIN)
+        path += ';';
+    #else
+        path += ':';
+    #endif
+    }
+    path += QDir::toNativeSeparators(modules.absolutePath()).toLocal8Bit();
+
+    qputenv("VLC_PLUGIN_PATH", path);
+}
+
 void VLCApplication::closeLibvlc()
 {
     libvlc_release(_vlcInstance);
@@ -94,3 +123,108 @@ QString VLCApplication::subtitleColor(int index){
     sl <<"16777215" << "16776960";
     return sl.at(index);
 }
+
+/*****************************************************************************\
+                                PLAYER POOL
+\*****************************************************************************/
+
+libvlc_media_player_t* VLCApplication::createPlayer()
+{
+    libvlc_media_player_t *player = libvlc_media_player_new(_vlcInstance);
+
+    libvlc_video_set_key_input(player, false);
+    libvlc_video_set_mouse_input(player, false);
+
+    return player;
+}
+
+libvlc_media_player_t* VLCApplication::acquirePlayer(const QString &owner, bool memoryOutput)
+{
+    QMutexLocker locker(&_poolMutex);
+
+    QList<libvlc_media_player_t*> &idlePlayers = memoryOutput ? _idleMemoryPlayers : _idlePlayers;
+
+    libvlc_media_player_t *player;
+    if (idlePlayers.isEmpty())
+        player = createPlayer();
+    else
+        player = idlePlayers.takeFirst();
+
+    if (memoryOutput)
+        _memoryPlayers.insert(player);
+
+    _leasedPlayers.insert(player, owner);
+
+    return player;
+}
+
+void VLCApplication::releasePlayer(libvlc_media_player_t *player)
+{
+    if (player == NULL)
+        return;
+
+    QMutexLocker locker(&_poolMutex);
+
+    if (!_leasedPlayers.contains(player)) {
+        qDebug() << "OPP error: released a player which does not belong to the pool";
+        return;
+    }
+    _leasedPlayers.remove(player);
+
+    libvlc_media_player_stop(player);
+    libvlc_media_player_set_media(player, NULL);
+
+    // stopped, the callbacks of the borrower are not called anymore
+    if (_memoryPlayers.contains(player)) {
+        if (_idleMemoryPlayers.count() < PLAYER_POOL_SIZE) {
+            _idleMemoryPlayers.append(player);
+        } else {
+            _memoryPlayers.remove(player);
+            libvlc_media_player_release(player);
+        }
+        return;
+    }
+
+#if defined(Q_OS_WIN)
+    libvlc_media_player_set_hwnd(player, NULL);
+#elif defined(Q_OS_MAC)
+    libvlc_media_player_set_nsobject(player, NULL);
+#elif defined(Q_OS_UNIX)
+    libvlc_media_player_set_xwindow(player, 0);
+#endif
+    libvlc_video_set_adjust_int(player, libvlc_adjust_Enable, 0);
+
+    if (_idlePlayers.count() < PLAYER_POOL_SIZE)
+        _idlePlayers.append(player);
+    else
+        libvlc_media_player_release(player);
+}
+
+int VLCApplication::leasedPlayerCount() const
+{
+    QMutexLocker locker(&_poolMutex);
+    return _leasedPlayers.count();
+}
+
+void VLCApplication::closePlayerPool()
+{
+    QMutexLocker locker(&_poolMutex);
+
+    QHashIterator<libvlc_media_player_t*, QString> it(_leasedPlayers);
+    while (it.hasNext()) {
+        it.next();
+        qDebug() << "OPP warning: player lent to" << it.value() << "was never given back";
+        libvlc_media_player_stop(it.key());
+        libvlc_media_player_release(it.key());
+    }
+    _leasedPlayers.clear();
+
+    foreach (libvlc_media_player_t *player, _idlePlayers)
+        libvlc_media_player_release(player);
+    _idlePlayers.clear();
+
+    foreach (libvlc_media_player_t *player, _idleMemoryPlayers)
+        libvlc_media_player_release(player);
+    _idleMemoryPlayers.clear();
+    _memoryPlayers.clear();
+}
@@ -27,8 +27,14 @@
 #define VLCINSTANCE_H
 
 #include <QObject>
+#include <QHash>
+#include <QList>
+#include <QMutex>
+#include <QSet>
 
 struct libvlc_instance_t;
+struct libvlc_media_player_t;
+class JobScheduler;
 
 /**
  * @brief Manage the libvlc instance used by the software
@@ -55,13 +61,102 @@ public:
      */
     inline libvlc_instance_t* vlcInstance() const { return _vlcInstance; }
 
+    /**
+     * @brief Take a secondary media player from the pool of the shared instance
+     *
+     * Used for previews, test patterns and thumbnailing so that no new libvlc
+     * instance is created. The player must be given back with releasePlayer().
+     *
+     * A player rendering into memory (libvlc_video_set_callbacks) can not be
+     * turned back into a windowed one, those are kept in their own pool and
+     * the borrower sets its callbacks and format again.
+     *
+     * @param owner A name identifying the user of the player (used for leak reports)
+     * @param memoryOutput True for a player rendering into memory
+     * @return A ready to use libvlc media player
+     */
+    libvlc_media_player_t* acquirePlayer(const QString &owner, bool memoryOutput = false);
+
+    /**
+     * @brief Give back a player taken with acquirePlayer()
+     *
+     * The player is stopped, detached from its media and its video output
+     * before being put back in the pool.
+     *
+     * @param player The player to give back
+     */
+    void releasePlayer(libvlc_media_player_t *player);
+
+    /**
+     * @brief Get the number of players currently lent
+     * @return The number of players not yet given back
+     */
+    int leasedPlayerCount() const;
+
+    /**
+     * @brief Get the scheduler of the background jobs using the instance
+     * @return The scheduler
+     */
+    inline JobScheduler* jobScheduler() const { return _jobScheduler; }
+
 private:
 
+    /**
+     * @brief PLAYER_POOL_SIZE Number of idle players kept of each kind, created on demand
+     */
+    static const int PLAYER_POOL_SIZE = 2;
+
+    /**
+     * @brief _idlePlayers Players ready to be lent
+     */
+    QList<libvlc_media_player_t*> _idlePlayers;
+
+    /**
+     * @brief _idleMemoryPlayers Players rendering into memory ready to be lent
+     */
+    QList<libvlc_media_player_t*> _idleMemoryPlayers;
+
+    /**
+     * @brief _memoryPlayers Every player rendering into memory, idle or lent
+     */
+    QSet<libvlc_media_player_t*> _memoryPlayers;
+
+    /**
+     * @brief _leasedPlayers Players currently lent with their owner
+     */
+    QHash<libvlc_media_player_t*, QString> _leasedPlayers;
+
+    /**
+     * @brief _poolMutex Protect the player pool
+     */
+    mutable QMutex _poolMutex;
+
+    /**
+     * @brief Let libvlc load the OPP modules installed next to the binary
+     */
+    void addModulesPath();
+
+    /**
+     * @brief Create a new secondary player on the shared instance
+     * @return The new player
+     */
+    libvlc_media_player_t* createPlayer();
+
+    /**
+     * @brief Release every player of the pool
+     */
+    void closePlayerPool();
+
     /**
      * @brief _vlcInstance The libvlc instance
      */
     libvlc_instance_t *_vlcInstance;
 
+    /**
+     * @brief _jobScheduler Share the cores and the disks between the background jobs
+     */
+    JobScheduler *_jobScheduler;
+
     /**
      * @brief Free libvlc instance
      *
@@ -41,7 +41,8 @@
 AdvancedPictureSettingsWindow::AdvancedPictureSettingsWindow(QWidget *parent) :
     QDialog(parent),
     ui(new Ui::AdvancedPictureSettingsWindow),
-    _playback(0)
+    _playback(0),
+    _useDetectedRatio(false)
 {
     ui->setupUi(this);
 
@@ -61,11 +62,34 @@ void AdvancedPictureSettingsWindow::on_comboBox_deinterlace_currentIndexChanged(
 void AdvancedPictureSettingsWindow::setPlayback(Playback* playback)
 {
     _playback=playback;
+
+    /*Automatic deinterlacing follows the scan type of the media*/
+    ScanType scanType = _playback->media()->scanType();
+    QStringList deinterlacingValues = MediaSettings::deinterlacingValues();
+    deinterlacingValues[AutoDeinterlacing] += QString(" - %1 (%2)")
+            .arg(deinterlacingValues.at(MediaSettings::autoDeinterlacing(scanType)))
+            .arg(MediaSettings::scanTypeValues().at(scanType));
+    ui->comboBox_deinterlace->clear();
+    ui->comboBox_deinterlace->addItems(deinterlacingValues);
     ui->comboBox_deinterlace->setCurrentIndex(_playback->mediaSettings()->deinterlacing());
     ui->spinBox_up->setValue(_playback->mediaSettings()->cropTop());
     ui->spinBox_left->setValue(_playback->mediaSettings()->cropLeft());
     ui->spinBox_right->setValue(_playback->mediaSettings()->cropRight());
     ui->spinBox_down->setValue(_playback->mediaSettings()->cropBot());
+
+    /*Black bars*/
+    _useDetectedRatio = false;
+    Media *media = _playback->media();
+    if (media->hasDetectedCrop()) {
+        QMargins crop = media->detectedCrop();
+        ui->label_detectedCrop->setText(tr("Detected: up %1, down %2, left %3, right %4 px, ratio %5")
+                                        .arg(crop.top()).arg(crop.bottom()).arg(crop.left()).arg(crop.right())
+                                        .arg(MediaSettings::ratioValues().at(media->detectedRatio())));
+        ui->applyDetectedCropButton->setEnabled(true);
+    } else {
+        ui->label_detectedCrop->setText(tr("Not detected (Edit > Detect black bars)"));
+        ui->applyDetectedCropButton->setEnabled(false);
+    }
 }
 
 void AdvancedPictureSettingsWindow::on_buttonBox_OKCancel_accepted()
@@ -83,6 +107,11 @@ void AdvancedPictureSettingsWindow::on_buttonBox_OKCancel_accepted()
                                         ui->spinBox_down->value()
                                         );
 
+    if (_useDetectedRatio) {
+        _playback->mediaSettings()->setRatio((Ratio) _playback->media()->detectedRatio());
+        ((MainWindow *)parent())->updateSettings();
+    }
+
     this->hide();
 }
 
@@ -118,3 +147,20 @@ void AdvancedPictureSettingsWindow::on_spinBox_left_valueChanged(int arg1)
         ui->spinBox_right->setValue(arg1);
     }
 }
+
+void AdvancedPictureSettingsWindow::on_applyDetectedCropButton_clicked()
+{
+    QMargins crop = _playback->media()->detectedCrop();
+
+    // the bars are not always symmetric
+    ui->checkBox_upDownSync->setChecked(false);
+    ui->checkBox_leftRightSync->setChecked(false);
+
+    ui->spinBox_up->setValue(crop.top());
+    ui->spinBox_down->setValue(crop.bottom());
+    ui->spinBox_left->setValue(crop.left());
+    ui->spinBox_right->setValue(crop.right());
+
+    // applied with the other settings when the window is accepted
+    _useDetectedRatio = true;
+}
@@ -111,6 +111,11 @@ private slots:
      */
     void on_spinBox_left_valueChanged(int arg1);
 
+    /**
+     * @brief Set the crop and the ratio proposed by the black bar detection
+     */
+    void on_applyDetectedCropButton_clicked();
+
 private:
     /**
      * @brief ui The UI
@@ -121,6 +126,11 @@ private:
      * @brief _playback The playback modified by the window
      */
     Playback* _playback;
+
+    /**
+     * @brief _useDetectedRatio True if the detected ratio is applied with the crop
+     */
+    bool _useDetectedRatio;
 };
 
 #endif // ADVANCEDPICTURESETTINGSWINDOW_H
@@ -34,6 +34,7 @@
 #include "ui_advancedsettingswindow.h"
 #include "playback.h"
 #include "mainwindow.h"
+#include "thumbnailstore.h"
 #include "utils.h"
 
 #include <QDebug>
@@ -93,6 +94,27 @@ void AdvancedSettings::setPlayback(Playback* playback)
     ui->timeEdit_VideoFadeOut->setTime(msecToQTime(_playback->mediaSettings()->videoFadeOut()));
     ui->timeEdit_VideoFadeIN->setTime(msecToQTime(_playback->mediaSettings()->videoFadeIn()));  
 
+    /*Black frames*/
+    Media *media = _playback->media();
+    if (media->hasBlackMarks()) {
+        ui->label_blackFramesValue->setText(tr("In %1, out %2")
+                                            .arg(msecToQTime(media->blackInMark()).toString("hh:mm:ss.zzz"))
+                                            .arg(msecToQTime(media->blackOutMark()).toString("hh:mm:ss.zzz")));
+        ui->applyBlackMarksButton->setEnabled(media->blackInMark() != _playback->mediaSettings()->inMark()
+                                              || media->blackOutMark() != _playback->mediaSettings()->outMark());
+    } else {
+        ui->label_blackFramesValue->setText(tr("Not detected (Edit > Detect black frames)"));
+        ui->applyBlackMarksButton->setEnabled(false);
+    }
+
+    /*Decoder profile*/
+    QStringList profiles = MediaSettings::decoderProfileValues();
+    DecoderProfile autoProfile = MediaSettings::autoDecoderProfile(_playback->media()->videoTracks());
+    profiles[AutoProfile] += " - " + profiles.at(autoProfile);
+    ui->comboBox_decoderProfile->clear();
+    ui->comboBox_decoderProfile->addItems(profiles);
+    ui->comboBox_decoderProfile->setCurrentIndex(_playback->mediaSettings()->decoderProfile());
+
     /*Original length*/
     QTime original =  msecToQTime(_playback->media()->duration());
     ui->label_originalLengthValue->setText(original.toString("hh:mm:ss"));
@@ -155,6 +177,9 @@ void AdvancedSettings::setPlayback(Playback* playback)
         ui->timeEdit_outMark->setVisible(false);
         ui->label_inMark->setVisible(false);
         ui->label_outMark->setVisible(false);
+        ui->label_blackFrames->setVisible(false);
+        ui->label_blackFramesValue->setVisible(false);
+        ui->applyBlackMarksButton->setVisible(false);
         ui->label_CrossFading->setVisible(false);
         ui->timeEdit_CrossFading->setVisible(false);
         ui->label_CrossFading_2->setVisible(false);
@@ -173,6 +198,9 @@ void AdvancedSettings::setPlayback(Playback* playback)
         ui->timeEdit_outMark->setVisible(true);
         ui->label_inMark->setVisible(true);
         ui->label_outMark->setVisible(true);
+        ui->label_blackFrames->setVisible(!_playback->media()->isAudio());
+        ui->label_blackFramesValue->setVisible(!_playback->media()->isAudio());
+        ui->applyBlackMarksButton->setVisible(!_playback->media()->isAudio());
         ui->label_CrossFading->setVisible(true);
         ui->timeEdit_CrossFading->setVisible(true);
         ui->label_CrossFading_2->setVisible(true);
@@ -193,12 +221,7 @@ void AdvancedSettings::setPlayback(Playback* playback)
 
     ui->changeScreenshotButton->setVisible(false);
     if(!_playback->media()->isAudio() && !_playback->media()->isImage()){
-        QPixmap pixmap;
-        QString path = qApp->applicationDirPath() + "/screenshot/";
-        path = path.replace("/",QDir::separator());
-        path +=  _playback->media()->getLocation().replace(QDir::separator(),"_").replace(":", "");
-        path += ".png";
-        pixmap.load((path.toStdString().c_str()));
+        QPixmap pixmap = QPixmap::fromImage(ThumbnailStore::thumbnail(_playback->media()->getLocation(), 400));
 
         ui->changeScreenshotButton->setVisible(true);
         ui->label_picture->setPixmap(pixmap.scaled( QSize(400,400), Qt::KeepAspectRatio, Qt::FastTransformation));
@@ -215,6 +238,9 @@ void AdvancedSettings::on_buttonBox_OKCancel_accepted()
     //    return;
     //_playback->mediaSettings()->setTestPattern(index==0);
 
+    /*Decoder profile*/
+    _playback->mediaSettings()->setDecoderProfile((DecoderProfile) ui->comboBox_decoderProfile->currentIndex());
+
     /*In mark and out mark*/
     uint timeIn = qTimeToMsec(ui->timeEdit_inMark->time());
     uint timeOut = qTimeToMsec(ui->timeEdit_outMark->time());
@@ -245,16 +271,7 @@ void AdvancedSettings::on_buttonBox_OKCancel_accepted()
     }else{
         diff = timeOut - timeIn;
         if(diff > 0){
-            _playback->mediaSettings()->setInMark(qTimeToMsec(ui->timeEdit_inMark->time()));
-            _playback->mediaSettings()->setOutMark(qTimeToMsec(ui->timeEdit_outMark->time()));
-
-
-            char* optionIn = (QString(":start-time=") + QString::number(timeIn / 1000)).toLocal8Bit().data();
-            libvlc_media_add_option(_playback->media()->core(),optionIn);
-            char* optionOut = (QString(":stop-time=") + QString::number(timeOut / 1000)).toLocal8Bit().data();
-            libvlc_media_add_option(_playback->media()->core(),optionOut);
-
-
+            // the media player gives the marks to libvlc when the playback starts
             _playback->mediaSettings()->setInMark(timeIn);
             _playback->mediaSettings()->setOutMark(timeOut);
         }
@@ -281,11 +298,9 @@ void AdvancedSettings::on_buttonBox_OKCancel_rejected()
 
 void AdvancedSettings::updateLength()
 {
-    int secIn = ui->timeEdit_inMark->time().second()+60*ui->timeEdit_inMark->time().minute()+3600*ui->timeEdit_inMark->time().hour();
-    int secOut = ui->timeEdit_outMark->time().second()+60*ui->timeEdit_outMark->time().minute()+3600*ui->timeEdit_outMark->time().hour();
-    int diff = 1000*(secOut-secIn);
-    QTime modified =  msecToQTime(diff);
-    ui->label_modifiedLengthValue->setText(modified.toString("hh:mm:ss"));
+    int diff = qTimeToMsec(ui->timeEdit_outMark->time()) - qTimeToMsec(ui->timeEdit_inMark->time());
+    QTime modified =  msecToQTime(diff > 0 ? diff : 0);
+    ui->label_modifiedLengthValue->setText(modified.toString("hh:mm:ss.zzz"));
 }
 
 void AdvancedSettings::on_imageDurationTimeEdit_timeChanged(const QTime &date)
@@ -301,3 +316,11 @@ void AdvancedSettings::on_changeScreenshotButton_clicked()
     selectorWindow->show();
     selectorWindow->setMedia(_playback->media());
 }
+
+void AdvancedSettings::on_applyBlackMarksButton_clicked()
+{
+    // applied with the other settings when the window is accepted
+    ui->timeEdit_inMark->setTime(msecToQTime(_playback->media()->blackInMark()));
+    ui->timeEdit_outMark->setTime(msecToQTime(_playback->media()->blackOutMark()));
+    ui->applyBlackMarksButton->setEnabled(false);
+}
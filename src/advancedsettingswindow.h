@@ -93,6 +93,11 @@ private slots:
      */
     void on_changeScreenshotButton_clicked();
 
+    /**
+     * @brief Set the marks proposed by the black frame detection
+     */
+    void on_applyBlackMarksButton_clicked();
+
 private:
     /**
      * @brief ui The UI
@@ -43,6 +43,55 @@ Application::Application(int & argc, char **argv):
     if(!settings.contains("updatePath"))
         settings.setValue("updatePath", config_opp::URL);
 
+    if(!settings.contains("stagingEnabled"))
+        settings.setValue("stagingEnabled", true);
+
+    if(!settings.contains("stagingPath"))
+        settings.setValue("stagingPath", QApplication::applicationDirPath() + "/staging");
+
+    /** GB */
+    if(!settings.contains("stagingSize"))
+        settings.setValue("stagingSize", 200);
+
+    /** MB/s, 0 for no limit */
+    if(!settings.contains("stagingRate"))
+        settings.setValue("stagingRate", 50);
+
+    /** hours before a show */
+    if(!settings.contains("stagingHorizon"))
+        settings.setValue("stagingHorizon", 24);
+
+    /** seconds before a launch or the next item */
+    if(!settings.contains("warmingLead"))
+        settings.setValue("warmingLead", 120);
+
+    /** MB read ahead from the in-mark */
+    if(!settings.contains("warmingSize"))
+        settings.setValue("warmingSize", 64);
+
+    /** directories searched for the moved media, besides moviesPath */
+    if(!settings.contains("relinkRoots"))
+        settings.setValue("relinkRoots", QStringList());
+
+    /** folders whose new media are added to the bin */
+    if(!settings.contains("watchFolders"))
+        settings.setValue("watchFolders", QStringList());
+
+    /** low resolution copies decoded by the previews */
+    if(!settings.contains("proxyEnabled"))
+        settings.setValue("proxyEnabled", false);
+
+    if(!settings.contains("proxyPath"))
+        settings.setValue("proxyPath", QApplication::applicationDirPath() + "/proxy");
+
+    /** the projection decoded by another process, restarted when it fails */
+    if(!settings.contains("engineProcess"))
+        settings.setValue("engineProcess", false);
+
+    /** attempts to resume a failing playback before the next item, 0 to disable */
+    if(!settings.contains("recoveryAttempts"))
+        settings.setValue("recoveryAttempts", 3);
+
     if(!settings.contains("lang"))
     {
         /*Check if OS language is available, if not English is set as default language*/
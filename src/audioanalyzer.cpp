@@ -0,0 +1,260 @@
+/**********************************************************************************
+ * This file is part of Open Projection Program (OPP).
+ *
+ * Copyright (C) 2013 Catalogue Ouvert du Cinéma <dev@cinemaouvert.fr>
+ *
+ * Authors: Jerome Blanchi <d.j.a.y@free.fr>
+ *
+ * Open Projection Program is an initiative of Catalogue Ouvert du Cinéma.
+ * The software was developed by four students of University of Poitiers
+ * as school project.
+ *
+ * Open Projection Program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Open Projection Program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Open Projection Program. If not, see <http://www.gnu.org/licenses/>.
+ **********************************************************************************/
+
+#include "audioanalyzer.h"
+
+#include <QDebug>
+
+#include "VLCApplication.h"
+#include "jobscheduler.h"
+
+AudioAnalyzer::AudioAnalyzer(VLCApplication *vlcApp, QObject *parent) :
+    QObject(parent),
+    _vlcApp(vlcApp),
+    _done(0),
+    _total(0)
+{
+    _vlcApp->jobScheduler()->addClient(this, JobScheduler::DecodeResource, JobScheduler::LowPriority);
+}
+
+AudioAnalyzer::~AudioAnalyzer()
+{
+    cancel();
+    _vlcApp->jobScheduler()->removeClient(this);
+}
+
+void AudioAnalyzer::analyze(Media *media)
+{
+    if (media == NULL || _queue.contains(media))
+        return;
+
+    foreach (Job *job, _jobs)
+        if (job->media == media)
+            return;
+
+    _queue.append(media);
+    _total++;
+    startJobs();
+}
+
+void AudioAnalyzer::cancel()
+{
+    _queue.clear();
+    _vlcApp->jobScheduler()->withdraw(this);
+
+    foreach (Job *job, _jobs) {
+        releaseJob(job);
+        delete job->measure;
+        delete job;
+        _vlcApp->jobScheduler()->release(this);
+    }
+    _jobs.clear();
+
+    _done = 0;
+    _total = 0;
+}
+
+void AudioAnalyzer::startJobs()
+{
+    while (!_queue.isEmpty()) {
+        Media *media = _queue.first();
+
+        if (media == NULL) {
+            _queue.removeFirst();
+            continue;
+        }
+
+        if (media->audioTracks().isEmpty()) {
+            _queue.removeFirst();
+            _done++;
+            emit progress(_done, _total);
+            continue;
+        }
+
+        // the scheduler calls again when a slot is free
+        if (!_vlcApp->jobScheduler()->acquire(this))
+            break;
+
+        _queue.removeFirst();
+
+        Job *job = new Job;
+        job->media = media;
+        job->measure = createMeasure(media);
+        job->decoded = false;
+
+        // decode to float samples in memory, without waiting for the clock
+        const QString output = QString(":sout=#transcode{vcodec=none,scodec=none,acodec=fl32,samplerate=%1,channels=%2}"
+                                       ":smem{audio-prerender-callback=%3,audio-postrender-callback=%4,audio-data=%5,time-sync=false}")
+                .arg(RATE)
+                .arg(CHANNELS)
+                .arg((long long)(intptr_t)&AudioAnalyzer::prerenderCallback)
+                .arg((long long)(intptr_t)&AudioAnalyzer::postrenderCallback)
+                .arg((long long)(intptr_t)job);
+
+        job->vlcMedia = libvlc_media_new_path(_vlcApp->vlcInstance(), media->location().toStdString().data());
+        libvlc_media_add_option(job->vlcMedia, output.toLocal8Bit().data());
+        libvlc_media_add_option(job->vlcMedia, ":no-sout-video");
+        libvlc_media_add_option(job->vlcMedia, ":no-sout-spu");
+        libvlc_media_add_option(job->vlcMedia, ":no-sout-all");
+
+        job->player = libvlc_media_player_new_from_media(job->vlcMedia);
+
+        libvlc_event_manager_t *events = libvlc_media_player_event_manager(job->player);
+        libvlc_event_attach(events, libvlc_MediaPlayerEndReached, eventCallback, this);
+        libvlc_event_attach(events, libvlc_MediaPlayerEncounteredError, eventCallback, this);
+
+        _jobs.append(job);
+        _vlcApp->jobScheduler()->startPlayer(this, job->player);
+    }
+
+    if (_jobs.isEmpty() && _queue.isEmpty() && _total > 0) {
+        _done = 0;
+        _total = 0;
+        emit finished();
+    }
+}
+
+AudioAnalyzer::Job *AudioAnalyzer::job(void *player) const
+{
+    foreach (Job *job, _jobs)
+        if (job->player == player)
+            return job;
+
+    return NULL;
+}
+
+void AudioAnalyzer::jobEnded(void *player)
+{
+    Job *job = this->job(player);
+
+    if (job == NULL)
+        return;
+
+    // stopping joins the decoder, the measure is complete afterwards
+    releaseJob(job);
+
+    if (job->media == NULL) {
+        // removed from the bin meanwhile
+    } else if (!job->decoded) {
+        qDebug() << "Audio analysis: no audio decoded from" << job->media->location();
+    } else if (storeMeasure(job->media, job->measure)) {
+        emit analyzed(job->media);
+    }
+
+    finishJob(job);
+}
+
+void AudioAnalyzer::jobFailed(void *player)
+{
+    Job *job = this->job(player);
+
+    if (job == NULL)
+        return;
+
+    releaseJob(job);
+
+    if (job->media != NULL)
+        qDebug() << "Audio analysis: can not decode" << job->media->location();
+
+    finishJob(job);
+}
+
+void AudioAnalyzer::finishJob(Job *job)
+{
+    _jobs.removeOne(job);
+    delete job->measure;
+    delete job;
+    _vlcApp->jobScheduler()->release(this);
+
+    _done++;
+    emit progress(_done, _total);
+
+    startJobs();
+}
+
+void AudioAnalyzer::releaseJob(Job *job)
+{
+    if (job->player == NULL)
+        return;
+
+    _vlcApp->jobScheduler()->removePlayer(job->player);
+
+    libvlc_event_manager_t *events = libvlc_media_player_event_manager(job->player);
+    libvlc_event_detach(events, libvlc_MediaPlayerEndReached, eventCallback, this);
+    libvlc_event_detach(events, libvlc_MediaPlayerEncounteredError, eventCallback, this);
+
+    libvlc_media_player_stop(job->player);
+    libvlc_media_player_release(job->player);
+    libvlc_media_release(job->vlcMedia);
+    job->player = NULL;
+    job->vlcMedia = NULL;
+}
+
+/***********************************************************************\
+                          LIBVLC CALLBACKS
+\***********************************************************************/
+
+void AudioAnalyzer::prerenderCallback(void *data, uint8_t **buffer, size_t size)
+{
+    Job *job = (Job *)data;
+
+    if ((size_t)job->buffer.size() < size)
+        job->buffer.resize(size);
+
+    *buffer = (uint8_t *)job->buffer.data();
+}
+
+void AudioAnalyzer::postrenderCallback(void *data, uint8_t *buffer, unsigned channels, unsigned rate,
+                                          unsigned frames, unsigned bits, size_t size, int64_t pts)
+{
+    Q_UNUSED(size);
+    Q_UNUSED(pts);
+    Job *job = (Job *)data;
+
+    // the transcoder could not convert this track
+    if (bits != 32 || channels != (unsigned)CHANNELS || rate != (unsigned)RATE)
+        return;
+
+    // the measure lives in the decoder thread until the player is stopped
+    job->measure->process((const float *)buffer, frames);
+    job->decoded = true;
+}
+
+void AudioAnalyzer::eventCallback(const libvlc_event_t *event, void *data)
+{
+    AudioAnalyzer *analyzer = (AudioAnalyzer *)data;
+    void *player = event->p_obj;
+
+    switch (event->type) {
+    case libvlc_MediaPlayerEndReached:
+        QMetaObject::invokeMethod(analyzer, "jobEnded", Qt::QueuedConnection, Q_ARG(void *, player));
+        break;
+    case libvlc_MediaPlayerEncounteredError:
+        QMetaObject::invokeMethod(analyzer, "jobFailed", Qt::QueuedConnection, Q_ARG(void *, player));
+        break;
+    default:
+        break;
+    }
+}
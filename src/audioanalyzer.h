@@ -0,0 +1,221 @@
+/**********************************************************************************
+ * This file is part of Open Projection Program (OPP).
+ *
+ * Copyright (C) 2013 Catalogue Ouvert du Cinéma <dev@cinemaouvert.fr>
+ *
+ * Authors: Jerome Blanchi <d.j.a.y@free.fr>
+ *
+ * Open Projection Program is an initiative of Catalogue Ouvert du Cinéma.
+ * The software was developed by four students of University of Poitiers
+ * as school project.
+ *
+ * Open Projection Program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Open Projection Program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Open Projection Program. If not, see <http://www.gnu.org/licenses/>.
+ **********************************************************************************/
+
+#ifndef AUDIOANALYZER_H
+#define AUDIOANALYZER_H
+
+#include <QObject>
+#include <QList>
+#include <QPointer>
+#include <QByteArray>
+
+#include <vlc/vlc.h>
+
+#include "media.h"
+
+class VLCApplication;
+
+/**
+ * @brief Decode the audio of media in background to measure it
+ *
+ * The audio track of each media is decoded by its own libvlc player into
+ * memory, as fast as the decoder goes (no clock, no video), so several media
+ * are analyzed at once on several cores. The samples are interleaved floats,
+ * CHANNELS channels at RATE Hz. A subclass creates the measure of each media
+ * and stores it when the media is decoded.
+ */
+class AudioAnalyzer : public QObject
+{
+    Q_OBJECT
+public:
+    /**
+     * @brief Measure of the samples of one media
+     */
+    class Measure
+    {
+    public:
+        virtual ~Measure() {}
+
+        /**
+         * @brief Measure decoded samples, called in the decoder thread
+         * @param samples The interleaved samples, full scale is 1
+         * @param frames The number of frames (samples per channel)
+         */
+        virtual void process(const float *samples, unsigned frames) = 0;
+    };
+
+    explicit AudioAnalyzer(VLCApplication *vlcApp, QObject *parent = 0);
+    virtual ~AudioAnalyzer();
+
+    /**
+     * @brief Add a media to the analysis queue
+     * @param media The media, skipped if already queued
+     */
+    void analyze(Media *media);
+
+
+    /**
+     * @brief Allow to know if an analysis is running
+     * @return True if running, false otherwise
+     */
+    inline bool isRunning() const { return !_jobs.isEmpty(); }
+
+    /**
+     * @brief CHANNELS Channels of the decoded samples
+     */
+    static const int CHANNELS = 2;
+
+    /**
+     * @brief RATE Sample rate of the decoded samples (Hz)
+     */
+    static const int RATE = 48000;
+
+public slots:
+    /**
+     * @brief Stop the running analyses and clear the queue
+     */
+    void cancel();
+
+signals:
+    /**
+     * @brief Emitted when the measure of a media is stored
+     * @param media The media
+     */
+    void analyzed(Media *media);
+
+    /**
+     * @brief Emitted each time a media is done
+     * @param done The number of media done since the queue was empty
+     * @param total The number of media queued since the queue was empty
+     */
+    void progress(int done, int total);
+
+    /**
+     * @brief Emitted when the queue is empty
+     */
+    void finished();
+
+protected:
+    /**
+     * @brief Create the measure of a media
+     * @param media The media
+     * @return The measure, owned by the analyzer
+     */
+    virtual Measure *createMeasure(Media *media) = 0;
+
+    /**
+     * @brief Store the measure of a media completely decoded
+     * @param media The media
+     * @param measure The measure, deleted afterwards
+     * @return True if stored, false otherwise
+     */
+    virtual bool storeMeasure(Media *media, Measure *measure) = 0;
+
+private slots:
+    /**
+     * @brief Start jobs from the queue when the scheduler gives a slot
+     */
+    void startJobs();
+
+    /**
+     * @brief Store the measure of a player at the end of its media
+     * @param player The libvlc player of the job
+     */
+    void jobEnded(void *player);
+
+    /**
+     * @brief Drop the job of a player which could not decode its media
+     * @param player The libvlc player of the job
+     */
+    void jobFailed(void *player);
+
+private:
+    /**
+     * @brief Analysis of one media
+     */
+    struct Job {
+        QPointer<Media> media;
+        libvlc_media_t *vlcMedia;
+        libvlc_media_player_t *player;
+        Measure *measure;
+        bool decoded;
+        QByteArray buffer;
+    };
+
+    /**
+     * @brief Find the job of a player
+     */
+    Job *job(void *player) const;
+
+    /**
+     * @brief Delete a released job and start the next ones
+     */
+    void finishJob(Job *job);
+
+    /**
+     * @brief Stop and release the player and the media of a job, keep its measure
+     */
+    void releaseJob(Job *job);
+
+    /**
+     * @brief libvlc stream output callback, give the buffer to decode into
+     */
+    static void prerenderCallback(void *data, uint8_t **buffer, size_t size);
+
+    /**
+     * @brief libvlc stream output callback, measure the decoded samples
+     */
+    static void postrenderCallback(void *data, uint8_t *buffer, unsigned channels, unsigned rate,
+                                   unsigned frames, unsigned bits, size_t size, int64_t pts);
+
+    /**
+     * @brief libvlc event callback
+     */
+    static void eventCallback(const libvlc_event_t *event, void *data);
+
+    VLCApplication *_vlcApp;
+
+    /**
+     * @brief _queue The media waiting for a free job
+     */
+    QList<QPointer<Media> > _queue;
+
+    /**
+     * @brief _jobs The running jobs
+     */
+    QList<Job*> _jobs;
+
+    /**
+     * @brief _done The number of media done since the queue was empty
+     */
+    int _done;
+
+    /**
+     * @brief _total The number of media queued since the queue was empty
+     */
+    int _total;
+};
+
+#endif // AUDIOANALYZER_H
@@ -0,0 +1,145 @@
+/**********************************************************************************
+ * This file is part of Open Projection Program (OPP).
+ *
+ * Copyright (C) 2013 Catalogue Ouvert du Cinéma <dev@cinemaouvert.fr>
+ *
+ * Authors: Jerome Blanchi <d.j.a.y@free.fr>
+ *
+ * Open Projection Program is an initiative of Catalogue Ouvert du Cinéma.
+ * The software was developed by four students of University of Poitiers
+ * as school project.
+ *
+ * Open Projection Program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Open Projection Program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Open Projection Program. If not, see <http://www.gnu.org/licenses/>.
+ **********************************************************************************/
+
+#include "blackdetector.h"
+
+#include <QVector>
+#include <QtAlgorithms>
+
+/**
+ * @brief Blackness of the pictures of each segment
+ */
+class BlackMeasure : public VideoAnalyzer::Measure
+{
+public:
+    struct Picture {
+        qint64 pts;
+        bool black;
+
+        bool operator<(const Picture &other) const { return pts < other.pts; }
+    };
+
+    BlackMeasure() : segment(0) {}
+
+    void startSegment(int index)
+    {
+        segment = index;
+        if (pictures.count() <= index)
+            pictures.resize(index + 1);
+    }
+
+    void process(const uchar *luma, int width, int height, qint64 pts)
+    {
+        double mean, deviation;
+        VideoAnalyzer::statistics(luma, width * height, &mean, &deviation);
+
+        Picture picture = { pts, mean <= BlackDetector::BLACK_LUMA && deviation <= BlackDetector::BLACK_DEVIATION };
+        pictures[segment].append(picture);
+    }
+
+    int segment;
+    QVector<QVector<Picture> > pictures;
+};
+
+BlackDetector::BlackDetector(VLCApplication *vlcApp, QObject *parent) :
+    VideoAnalyzer(vlcApp, WIDTH, HEIGHT, parent)
+{
+}
+
+QList<VideoAnalyzer::Segment> BlackDetector::segments(Media *media)
+{
+    int duration = media->getOriginalDuration();
+
+    if (duration <= 2 * SEGMENT_LENGTH)
+        return VideoAnalyzer::segments(media);
+
+    Segment head = { 0, SEGMENT_LENGTH };
+    Segment tail = { duration - SEGMENT_LENGTH, 0 };
+
+    return QList<Segment>() << head << tail;
+}
+
+VideoAnalyzer::Measure *BlackDetector::createMeasure(Media *media)
+{
+    Q_UNUSED(media);
+
+    return new BlackMeasure;
+}
+
+bool BlackDetector::storeMeasure(Media *media, Measure *measure)
+{
+    QVector<QVector<BlackMeasure::Picture> > &pictures = ((BlackMeasure *)measure)->pictures;
+    int duration = media->getOriginalDuration();
+
+    if (pictures.isEmpty() || pictures.first().isEmpty() || pictures.last().isEmpty())
+        return false;
+
+    QVector<BlackMeasure::Picture> &head = pictures.first();
+    QVector<BlackMeasure::Picture> &tail = pictures.last();
+    qSort(head);
+    qSort(tail);
+
+    // the dates of the stream start anywhere: the head is dated from its first
+    // picture, the tail from the end of the media
+    qint64 origin = head.first().pts;
+    qint64 end = tail.last().pts;
+    if (tail.count() > 1)
+        end += (tail.last().pts - tail.first().pts) / (tail.count() - 1);
+
+    int first = 0;
+    while (first < head.count() && head.at(first).black)
+        first++;
+
+    int last = tail.count() - 1;
+    while (last >= 0 && tail.at(last).black)
+        last--;
+
+    // no picture to show
+    if (first == head.count() && pictures.count() == 1)
+        return false;
+
+    // a head black all along: the pictures start at the earliest after it
+    int inMark;
+    if (first < head.count()) {
+        inMark = (head.at(first).pts - origin) / 1000;
+    } else {
+        qint64 headEnd = head.last().pts;
+        if (head.count() > 1)
+            headEnd += (head.last().pts - head.first().pts) / (head.count() - 1);
+        inMark = (headEnd - origin) / 1000;
+    }
+    int outMark = duration;
+    if (last < tail.count() - 1) {
+        qint64 start = tail.at(last + 1).pts;
+        outMark = pictures.count() == 1 ? (start - origin) / 1000 : duration - (end - start) / 1000;
+    }
+
+    if (outMark <= inMark)
+        return false;
+
+    media->setBlackMarks(inMark, outMark);
+
+    return true;
+}
@@ -0,0 +1,87 @@
+/**********************************************************************************
+ * This file is part of Open Projection Program (OPP).
+ *
+ * Copyright (C) 2013 Catalogue Ouvert du Cinéma <dev@cinemaouvert.fr>
+ *
+ * Authors: Jerome Blanchi <d.j.a.y@free.fr>
+ *
+ * Open Projection Program is an initiative of Catalogue Ouvert du Cinéma.
+ * The software was developed by four students of University of Poitiers
+ * as school project.
+ *
+ * Open Projection Program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Open Projection Program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Open Projection Program. If not, see <http://www.gnu.org/licenses/>.
+ **********************************************************************************/
+
+#ifndef BLACKDETECTOR_H
+#define BLACKDETECTOR_H
+
+#include "videoanalyzer.h"
+
+/**
+ * @brief Detect the black leader and the black tail of media in background
+ *
+ * Only the head and the tail of each media are decoded, at a low resolution.
+ * A picture is black when its luma is dark and uniform. The end of the black
+ * frames at the start and the start of the black frames at the end are stored
+ * in the media as proposed in and out marks.
+ */
+class BlackDetector : public VideoAnalyzer
+{
+    Q_OBJECT
+public:
+    explicit BlackDetector(VLCApplication *vlcApp, QObject *parent = 0);
+
+    /**
+     * @brief WIDTH Width of the pictures measured
+     */
+    static const int WIDTH = 128;
+
+    /**
+     * @brief HEIGHT Height of the pictures measured
+     */
+    static const int HEIGHT = 72;
+
+    /**
+     * @brief SEGMENT_LENGTH Length of the head and of the tail decoded (ms)
+     */
+    static const int SEGMENT_LENGTH = 30000;
+
+    /**
+     * @brief BLACK_LUMA Highest mean luma of a black picture (video black is 16)
+     */
+    static const int BLACK_LUMA = 32;
+
+    /**
+     * @brief BLACK_DEVIATION Highest standard deviation of the luma of a black picture
+     */
+    static const int BLACK_DEVIATION = 8;
+
+protected:
+    /**
+     * @brief Decode the head and the tail, the whole media if short
+     */
+    QList<Segment> segments(Media *media);
+
+    /**
+     * @brief Create a measure keeping the date and the blackness of each picture
+     */
+    Measure *createMeasure(Media *media);
+
+    /**
+     * @brief Store the marks around the black frames in the media
+     */
+    bool storeMeasure(Media *media, Measure *measure);
+};
+
+#endif // BLACKDETECTOR_H
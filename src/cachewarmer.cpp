@@ -0,0 +1,202 @@
+/**********************************************************************************
+ * This file is part of Open Projection Program (OPP).
+ *
+ * Copyright (C) 2013 Catalogue Ouvert du Cinéma <dev@cinemaouvert.fr>
+ *
+ * Authors: Jerome Blanchi <d.j.a.y@free.fr>
+ *
+ * Open Projection Program is an initiative of Catalogue Ouvert du Cinéma.
+ * The software was developed by four students of University of Poitiers
+ * as school project.
+ *
+ * Open Projection Program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Open Projection Program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Open Projection Program. If not, see <http://www.gnu.org/licenses/>.
+ **********************************************************************************/
+
+#include "cachewarmer.h"
+
+#include <QDateTime>
+#include <QFile>
+#include <QFileInfo>
+#include <QSettings>
+#include <QThread>
+#include <QTimer>
+
+#include <climits>
+
+#if defined(Q_OS_UNIX)
+# include <fcntl.h>
+# include <unistd.h>
+#endif
+
+#include "MediaPlayer.h"
+#include "PlaylistPlayer.h"
+#include "playback.h"
+#include "schedulelistmodel.h"
+#include "stagingcache.h"
+
+/**
+ * @brief Read parts of files to fill the system cache
+ */
+class WarmingReader : public QThread
+{
+public:
+    struct Range {
+        QString file;
+        qint64 offset;
+        qint64 length;
+    };
+
+    explicit WarmingReader(QObject *parent) : QThread(parent) {}
+
+    QList<Range> ranges;
+
+protected:
+    void run()
+    {
+        foreach (const Range &range, ranges) {
+            QFile file(range.file);
+            if (!file.open(QIODevice::ReadOnly) || !file.seek(range.offset))
+                continue;
+
+            const qint64 block = 1024 * 1024;
+            qint64 left = range.length;
+            while (left > 0 && !file.read(qMin(left, block)).isEmpty())
+                left -= block;
+        }
+        ranges.clear();
+    }
+};
+
+CacheWarmer::CacheWarmer(ScheduleListModel *scheduleListModel, PlaylistPlayer *playlistPlayer, QObject *parent) :
+    QObject(parent),
+    _scheduleListModel(scheduleListModel),
+    _playlistPlayer(playlistPlayer),
+    _timer(new QTimer(this)),
+    _reader(new WarmingReader(this))
+{
+    connect(_scheduleListModel, SIGNAL(scheduleListChanged()), this, SLOT(check()));
+    connect(_playlistPlayer, SIGNAL(itemChanged(int)), this, SLOT(check()));
+    connect(_timer, SIGNAL(timeout()), this, SLOT(check()));
+    _timer->start(CHECK_INTERVAL);
+}
+
+CacheWarmer::~CacheWarmer()
+{
+    _reader->wait();
+}
+
+void CacheWarmer::check()
+{
+    QSettings settings("opp", "opp");
+    const qint64 lead = settings.value("warmingLead").toLongLong() * 1000;
+    const qint64 size = settings.value("warmingSize").toLongLong() * 1024 * 1024;
+
+    if (size <= 0)
+        return;
+
+    QList<Playback*> upcoming;
+
+    // the next item of the playlist on air
+    MediaPlayer *mediaPlayer = _playlistPlayer->mediaPlayer();
+    Playback *current = mediaPlayer->currentPlayback();
+    int next = _playlistPlayer->nextIndex();
+
+    if (current != NULL && mediaPlayer->isPlaying() && next >= 0) {
+        qint64 outMark = current->mediaSettings()->outMark();
+        if (outMark <= 0)
+            outMark = current->media()->duration();
+
+        if (outMark - mediaPlayer->currentTime() <= lead)
+            upcoming << _playlistPlayer->currentPlaylist()->at(next);
+    }
+
+    // the first item of the schedules about to launch
+    QDateTime now = QDateTime::currentDateTime();
+
+    foreach (Schedule *schedule, _scheduleListModel->scheduleList()) {
+        qint64 wait = now.msecsTo(schedule->launchAt());
+        if (wait < 0 || wait > lead || schedule->playlist()->count() == 0)
+            continue;
+
+        upcoming << schedule->playlist()->at(0);
+    }
+
+    for (int i = 0; i < upcoming.count() && i < MAX_MEDIA; ++i)
+        warm(upcoming.at(i), size);
+
+    if (!_reader->isRunning() && !_reader->ranges.isEmpty())
+        _reader->start(QThread::LowPriority);
+}
+
+void CacheWarmer::warm(Playback *playback, qint64 size)
+{
+    if (playback == NULL)
+        return;
+
+    Media *media = playback->media();
+
+    QString file = StagingCache::stagedFile(media->location());
+    if (file.isEmpty())
+        file = media->location();
+
+    qint64 fileSize = QFileInfo(file).size();
+    if (fileSize <= 0)
+        return;
+
+    // the offset of the in-mark, as if the bitrate was constant
+    qint64 offset = 0;
+    qint64 duration = media->getOriginalDuration();
+    int inMark = playback->mediaSettings()->inMark();
+
+    if (inMark > 0 && duration > 0)
+        offset = fileSize * inMark / duration;
+
+    // the containers keep their index at the head or at the tail
+    advise(file, 0, INDEX_SIZE);
+    advise(file, qMax((qint64)0, fileSize - INDEX_SIZE), INDEX_SIZE);
+    advise(file, offset, size);
+}
+
+void CacheWarmer::advise(const QString &file, qint64 offset, qint64 length)
+{
+#if defined(Q_OS_MAC)
+    int fd = open(QFile::encodeName(file).constData(), O_RDONLY);
+    if (fd < 0)
+        return;
+
+    struct radvisory advisory;
+    advisory.ra_offset = offset;
+    advisory.ra_count = (int)qMin(length, (qint64)INT_MAX);
+    fcntl(fd, F_RDADVISE, &advisory);
+    close(fd);
+#elif defined(Q_OS_UNIX)
+    // the system reads in background, nothing is read again when cached
+    int fd = open(QFile::encodeName(file).constData(), O_RDONLY);
+    if (fd < 0)
+        return;
+
+    posix_fadvise(fd, offset, length, POSIX_FADV_WILLNEED);
+    close(fd);
+#else
+    // read by hand, once the previous parts are read
+    if (_reader->isRunning())
+        return;
+
+    WarmingReader::Range range;
+    range.file = file;
+    range.offset = offset;
+    range.length = length;
+    _reader->ranges << range;
+#endif
+}
@@ -0,0 +1,102 @@
+/**********************************************************************************
+ * This file is part of Open Projection Program (OPP).
+ *
+ * Copyright (C) 2013 Catalogue Ouvert du Cinéma <dev@cinemaouvert.fr>
+ *
+ * Authors: Jerome Blanchi <d.j.a.y@free.fr>
+ *
+ * Open Projection Program is an initiative of Catalogue Ouvert du Cinéma.
+ * The software was developed by four students of University of Poitiers
+ * as school project.
+ *
+ * Open Projection Program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Open Projection Program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Open Projection Program. If not, see <http://www.gnu.org/licenses/>.
+ **********************************************************************************/
+
+#ifndef CACHEWARMER_H
+#define CACHEWARMER_H
+
+#include <QObject>
+#include <QList>
+#include <QString>
+
+class QTimer;
+class Playback;
+class PlaylistPlayer;
+class ScheduleListModel;
+class WarmingReader;
+
+/**
+ * @brief Bring the start of the upcoming media into the system cache
+ *
+ * warmingLead seconds before a schedule launches its playlist, and before the
+ * player goes on with the next item, the system is asked to read ahead the
+ * first warmingSize MB of the media from their in-mark, and the head and the
+ * tail of the file where the containers keep their index. The upcoming media
+ * are advised again at each check while they wait, at most MAX_MEDIA of them,
+ * so the launch does not wait for the disk.
+ */
+class CacheWarmer : public QObject
+{
+    Q_OBJECT
+public:
+    explicit CacheWarmer(ScheduleListModel *scheduleListModel, PlaylistPlayer *playlistPlayer, QObject *parent = 0);
+    ~CacheWarmer();
+
+    /**
+     * @brief CHECK_INTERVAL Time between two checks of the upcoming media (ms)
+     */
+    static const int CHECK_INTERVAL = 5000;
+
+    /**
+     * @brief MAX_MEDIA Media kept warm at once
+     */
+    static const int MAX_MEDIA = 4;
+
+    /**
+     * @brief INDEX_SIZE Bytes read ahead at the head and at the tail of a file
+     */
+    static const int INDEX_SIZE = 1024 * 1024;
+
+public slots:
+    /**
+     * @brief Read ahead the media about to be played
+     */
+    void check();
+
+private:
+    /**
+     * @brief Read ahead the start of a playback
+     * @param playback The playback
+     * @param size The bytes to read from the in-mark
+     */
+    void warm(Playback *playback, qint64 size);
+
+    /**
+     * @brief Ask the system to read a part of a file into its cache
+     */
+    void advise(const QString &file, qint64 offset, qint64 length);
+
+    ScheduleListModel *_scheduleListModel;
+
+    PlaylistPlayer *_playlistPlayer;
+
+    QTimer *_timer;
+
+    /**
+     * @brief _reader Reads the parts in background where the system can not be advised
+     */
+    WarmingReader *_reader;
+};
+
+#endif // CACHEWARMER_H
@@ -0,0 +1,188 @@
+/**********************************************************************************
+ * This file is part of Open Projection Program (OPP).
+ *
+ * Copyright (C) 2013 Catalogue Ouvert du Cinéma <dev@cinemaouvert.fr>
+ *
+ * Authors: Jerome Blanchi <d.j.a.y@free.fr>
+ *
+ * Open Projection Program is an initiative of Catalogue Ouvert du Cinéma.
+ * The software was developed by four students of University of Poitiers
+ * as school project.
+ *
+ * Open Projection Program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Open Projection Program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Open Projection Program. If not, see <http://www.gnu.org/licenses/>.
+ **********************************************************************************/
+
+#include "cropdetector.h"
+
+#include <QVector>
+#include <QtAlgorithms>
+
+#include "mediasettings.h"
+
+/**
+ * @brief Bars of each picture, in lines and columns of the measured pictures
+ */
+class CropMeasure : public VideoAnalyzer::Measure
+{
+public:
+    CropMeasure() : width(0), height(0) {}
+
+    void process(const uchar *luma, int width, int height, qint64 pts)
+    {
+        Q_UNUSED(pts);
+
+        if (width != this->width || height != this->height) {
+            this->width = width;
+            this->height = height;
+            top.clear();
+            bottom.clear();
+            left.clear();
+            right.clear();
+        }
+
+        int first = 0;
+        while (first < height && isBlack(luma + first * width, width))
+            first++;
+
+        // black picture, nothing to learn
+        if (first == height)
+            return;
+
+        int last = height - 1;
+        while (last > first && isBlack(luma + last * width, width))
+            last--;
+
+        // the columns of the lines inside the letterbox bars
+        sums.fill(0, width);
+        squares.fill(0, width);
+        VideoAnalyzer::addColumns(luma + first * width, width, last - first + 1, sums.data(), squares.data());
+
+        int count = last - first + 1;
+        int begin = 0;
+        while (begin < width && isBlack(sums.at(begin), squares.at(begin), count))
+            begin++;
+
+        int end = width - 1;
+        while (end > begin && isBlack(sums.at(end), squares.at(end), count))
+            end--;
+
+        top.append(first);
+        bottom.append(height - 1 - last);
+        left.append(begin);
+        right.append(width - 1 - end);
+    }
+
+    static bool isBlack(const uchar *line, int count)
+    {
+        double mean, deviation;
+        VideoAnalyzer::statistics(line, count, &mean, &deviation);
+
+        return mean <= CropDetector::BLACK_LUMA && deviation <= CropDetector::BLACK_DEVIATION;
+    }
+
+    static bool isBlack(quint32 sum, quint32 square, int count)
+    {
+        double mean = (double)sum / count;
+        double variance = (double)square / count - mean * mean;
+
+        return mean <= CropDetector::BLACK_LUMA
+                && variance <= CropDetector::BLACK_DEVIATION * CropDetector::BLACK_DEVIATION;
+    }
+
+    int width;
+    int height;
+    QVector<int> top;
+    QVector<int> bottom;
+    QVector<int> left;
+    QVector<int> right;
+
+    QVector<quint32> sums;
+    QVector<quint32> squares;
+};
+
+/**
+ * @brief Get the bar kept for a side, the widest but on PERCENTILE percent of the pictures
+ */
+static int stableBar(QVector<int> bars)
+{
+    qSort(bars);
+
+    return bars.at(bars.count() * CropDetector::PERCENTILE / 100);
+}
+
+CropDetector::CropDetector(VLCApplication *vlcApp, QObject *parent) :
+    VideoAnalyzer(vlcApp, WIDTH, HEIGHT, parent)
+{
+}
+
+QList<VideoAnalyzer::Segment> CropDetector::segments(Media *media)
+{
+    int duration = media->getOriginalDuration();
+
+    if (duration <= 2 * SAMPLES * SAMPLE_LENGTH)
+        return VideoAnalyzer::segments(media);
+
+    QList<Segment> segments;
+    for (int i = 0; i < SAMPLES; i++) {
+        Segment segment;
+        segment.start = (qint64)duration * (2 * i + 1) / (2 * SAMPLES);
+        segment.stop = segment.start + SAMPLE_LENGTH;
+        segments.append(segment);
+    }
+
+    return segments;
+}
+
+VideoAnalyzer::Measure *CropDetector::createMeasure(Media *media)
+{
+    Q_UNUSED(media);
+
+    return new CropMeasure;
+}
+
+bool CropDetector::storeMeasure(Media *media, Measure *measure)
+{
+    const CropMeasure *crop = (const CropMeasure *)measure;
+
+    if (crop->top.count() < MIN_PICTURES || media->videoTracks().isEmpty())
+        return false;
+
+    const VideoTrack track = media->videoTracks().first();
+    int width = track.width();
+    int height = track.height();
+
+    if (width <= 0 || height <= 0)
+        return false;
+
+    // a bar partly in a measured line is kept: better a thin line than a cut picture
+    QMargins margins(stableBar(crop->left) * width / crop->width,
+                     stableBar(crop->top) * height / crop->height,
+                     stableBar(crop->right) * width / crop->width,
+                     stableBar(crop->bottom) * height / crop->height);
+
+    // the pixels of the track are taken as square
+    double ratio = (double)(width - margins.left() - margins.right())
+            / (height - margins.top() - margins.bottom());
+    static const double ratios[] = { 0.0, 16.0 / 9, 16.0 / 10, 1.85, 2.21, 2.35, 2.39, 4.0 / 3, 5.0 / 4, 5.0 / 3, 1.0 };
+    int nearest = Original;
+
+    for (int r = R_16_9; r <= R_1_1; r++)
+        if (qAbs(ratio / ratios[r] - 1) * 100 <= RATIO_TOLERANCE
+                && (nearest == Original || qAbs(ratio - ratios[r]) < qAbs(ratio - ratios[nearest])))
+            nearest = r;
+
+    media->setDetectedCrop(margins, nearest);
+
+    return true;
+}
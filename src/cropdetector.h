@@ -0,0 +1,108 @@
+/**********************************************************************************
+ * This file is part of Open Projection Program (OPP).
+ *
+ * Copyright (C) 2013 Catalogue Ouvert du Cinéma <dev@cinemaouvert.fr>
+ *
+ * Authors: Jerome Blanchi <d.j.a.y@free.fr>
+ *
+ * Open Projection Program is an initiative of Catalogue Ouvert du Cinéma.
+ * The software was developed by four students of University of Poitiers
+ * as school project.
+ *
+ * Open Projection Program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Open Projection Program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Open Projection Program. If not, see <http://www.gnu.org/licenses/>.
+ **********************************************************************************/
+
+#ifndef CROPDETECTOR_H
+#define CROPDETECTOR_H
+
+#include "videoanalyzer.h"
+
+/**
+ * @brief Detect the letterbox and pillarbox bars of media in background
+ *
+ * Short segments spread over each media are decoded at a low resolution. The
+ * black lines and columns at the edges of each picture are counted from the
+ * luma statistics of each line and column, and the bars kept are the ones
+ * found on nearly every picture, so dark scenes do not widen them. The crop
+ * and the ratio of the picture inside the bars are stored in the media.
+ */
+class CropDetector : public VideoAnalyzer
+{
+    Q_OBJECT
+public:
+    explicit CropDetector(VLCApplication *vlcApp, QObject *parent = 0);
+
+    /**
+     * @brief WIDTH Width of the pictures measured
+     */
+    static const int WIDTH = 320;
+
+    /**
+     * @brief HEIGHT Height of the pictures measured
+     */
+    static const int HEIGHT = 180;
+
+    /**
+     * @brief SAMPLES Number of segments decoded over a media
+     */
+    static const int SAMPLES = 12;
+
+    /**
+     * @brief SAMPLE_LENGTH Length of a segment (ms)
+     */
+    static const int SAMPLE_LENGTH = 1000;
+
+    /**
+     * @brief MIN_PICTURES Pictures needed to propose a crop
+     */
+    static const int MIN_PICTURES = 10;
+
+    /**
+     * @brief PERCENTILE Percentage of the pictures allowed to show a narrower bar
+     */
+    static const int PERCENTILE = 10;
+
+    /**
+     * @brief BLACK_LUMA Highest mean luma of a black line or column (video black is 16)
+     */
+    static const int BLACK_LUMA = 28;
+
+    /**
+     * @brief BLACK_DEVIATION Highest standard deviation of the luma of a black line or column
+     */
+    static const int BLACK_DEVIATION = 6;
+
+    /**
+     * @brief RATIO_TOLERANCE Largest difference with a known ratio (percent)
+     */
+    static const int RATIO_TOLERANCE = 2;
+
+protected:
+    /**
+     * @brief Decode SAMPLES segments spread over the media, the whole media if short
+     */
+    QList<Segment> segments(Media *media);
+
+    /**
+     * @brief Create a measure keeping the bars of each picture
+     */
+    Measure *createMeasure(Media *media);
+
+    /**
+     * @brief Store the crop and the ratio in the media
+     */
+    bool storeMeasure(Media *media, Measure *measure);
+};
+
+#endif // CROPDETECTOR_H
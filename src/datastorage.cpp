@@ -33,6 +33,11 @@
 #include <QDebug>
 #include <QtXml>
 #include <QMessageBox>
+#include <QProgressDialog>
+#include <QSettings>
+#include <QThread>
+#include "fingerprint.h"
+#include "jobscheduler.h"
 #include "media.h"
 #include "medialistmodel.h"
 #include "playlistmodel.h"
@@ -47,13 +52,66 @@
 
 #include "mainwindow.h"
 
+/**
+ * @brief Compute the fingerprint of one media in its own thread
+ *
+ * The file is only read when it changed since its last fingerprint, the
+ * result is left empty otherwise.
+ */
+class FingerprintJob : public QThread
+{
+public:
+    FingerprintJob(const QString &location, const QString &fingerprint, const QDateTime &modified, QObject *parent) :
+        QThread(parent),
+        location(location),
+        fingerprint(fingerprint),
+        modified(modified)
+    {
+    }
+
+    QString location;
+    QString fingerprint;
+    QDateTime modified;
+
+protected:
+    void run()
+    {
+        JobScheduler::lowerIoPriority();
+
+        // the media may be on a network share, not even checked from the GUI thread
+        if (Fingerprint::isCurrent(fingerprint, modified, location)) {
+            fingerprint.clear();
+            return;
+        }
+
+        // the date first, a file changed meanwhile is computed again at the next save
+        modified = QFileInfo(location).lastModified();
+        fingerprint = Fingerprint::compute(location);
+    }
+};
+
 DataStorage::DataStorage(VLCApplication *app, MainWindow *win, QObject *parent) :
     QObject(parent),
     _mediaListModel(0),
     _scheduleListModel(0),
     _app(app),
-    _win(win)
+    _win(win),
+    _searcher(new FingerprintSearcher(this)),
+    _searchDialog(NULL),
+    _oldPlaylistCount(0),
+    _fingerprintJob(NULL)
+{
+    connect(_searcher, SIGNAL(finished()), this, SLOT(searchFinished()));
+    connect(_searcher, SIGNAL(progress(int)), this, SLOT(searchProgress(int)));
+
+    // only needed by the next save
+    _app->jobScheduler()->addClient(this, JobScheduler::IoResource, JobScheduler::LowPriority);
+}
+
+DataStorage::~DataStorage()
 {
+    cancel();
+    _app->jobScheduler()->removeClient(this);
 }
 
 void DataStorage::setMediaListModel(MediaListModel* model)
@@ -98,11 +156,42 @@ void DataStorage::save(QFile &file)
     /*List of medias*/
     QDomElement media;
     const QList<Media*>& mediaList = _mediaListModel->mediaList();
+
+    // the fingerprints computed so far, the missing ones are written by the next save
+    updateFingerprints();
+
     foreach(Media* mediaElement, mediaList)
     {
         media= doc.createElement("media");
         media.setAttribute("id",mediaElement->id());
         media.setAttribute("location",mediaElement->location());
+        if (mediaElement->hasLoudness()) {
+            media.setAttribute("loudness", mediaElement->loudness());
+            media.setAttribute("loudnessRange", mediaElement->loudnessRange());
+            media.setAttribute("truePeak", mediaElement->truePeak());
+        }
+        if (mediaElement->hasBlackMarks()) {
+            media.setAttribute("blackIn", mediaElement->blackInMark());
+            media.setAttribute("blackOut", mediaElement->blackOutMark());
+        }
+        if (mediaElement->hasDetectedCrop()) {
+            media.setAttribute("detectedCropTop", mediaElement->detectedCrop().top());
+            media.setAttribute("detectedCropLeft", mediaElement->detectedCrop().left());
+            media.setAttribute("detectedCropRight", mediaElement->detectedCrop().right());
+            media.setAttribute("detectedCropBot", mediaElement->detectedCrop().bottom());
+            media.setAttribute("detectedRatio", mediaElement->detectedRatio());
+        }
+        if (mediaElement->scanType() != UnknownScan)
+            media.setAttribute("scanType", mediaElement->scanType());
+        if (mediaElement->health() != UnknownHealth) {
+            media.setAttribute("health", mediaElement->health());
+            media.setAttribute("healthReport", mediaElement->healthReport());
+        }
+        if (!mediaElement->fingerprint().isEmpty()) {
+            media.setAttribute("fingerprint", mediaElement->fingerprint());
+            if (mediaElement->fingerprintDate().isValid())
+                media.setAttribute("fingerprintDate", mediaElement->fingerprintDate().toTime_t());
+        }
         medias.appendChild(media);
     }
 
@@ -152,6 +241,7 @@ void DataStorage::save(QFile &file)
             playback.setAttribute("videoFadeOut", playbackElement->mediaSettings()->videoFadeOut());
             playback.setAttribute("videoFadeIn", playbackElement->mediaSettings()->videoFadeIn());
             playback.setAttribute("subtitlesFile", playbackElement->mediaSettings()->subtitlesFile());
+            playback.setAttribute("decoderProfile", playbackElement->mediaSettings()->decoderProfile());
 
             playlist.appendChild(playback);
         }
@@ -184,41 +274,128 @@ void DataStorage::save(QFile &file)
 
 void DataStorage::load(QFile &file)
 {
-    int oldPlaylistCount = _win->playlistTabWidget()->count();
+    _oldPlaylistCount = _win->playlistTabWidget()->count();
 
     // Remove all data from models
     clear();
 
     // open xml document
-    QDomDocument doc;
+    _document.clear();
 
-    if (!doc.setContent(&file)) {
+    if (!_document.setContent(&file)) {
         qDebug()<< "load error";
+        // the cleared project
+        emit loaded();
         return;
     }
 
-    QDomElement root = doc.documentElement();
+    QDomElement root = _document.documentElement();
 
     setProjectTitle(root.attribute("title"));
     setProjectNotes(root.attribute("notes"));
 
+    // find the moved media by their fingerprint
+    QDomNodeList mediaNodeList = root.elementsByTagName("media");
+    QStringList missingFingerprints;
+    for (uint i = 0; i < mediaNodeList.length(); i++) {
+        QDomNamedNodeMap mediaAttributes = mediaNodeList.at(i).attributes();
+
+        if (!QFile::exists(mediaAttributes.namedItem("location").nodeValue()) && !mediaAttributes.namedItem("fingerprint").isNull())
+            missingFingerprints << mediaAttributes.namedItem("fingerprint").nodeValue();
+    }
+
+    if (missingFingerprints.isEmpty()) {
+        loadDocument(QHash<QString, QString>());
+        return;
+    }
+
+    QSettings settings("opp", "opp");
+    QStringList roots = settings.value("relinkRoots").toStringList();
+    roots << settings.value("moviesPath").toString();
+    roots << QFileInfo(file).absolutePath();
+
+    // the walk may take minutes on network shares, the interface keeps answering
+    if (_searchDialog != NULL)
+        _searchDialog->deleteLater();
+    _searchDialog = new QProgressDialog(tr("Searching the moved media..."), tr("Skip"), 0, 0, _win);
+    _searchDialog->setWindowModality(Qt::WindowModal);
+    _searchDialog->setMinimumDuration(SEARCH_DIALOG_DELAY);
+    connect(_searchDialog, SIGNAL(canceled()), _searcher, SLOT(cancel()));
+
+    _searcher->start(missingFingerprints, roots);
+}
+
+void DataStorage::searchFinished()
+{
+    if (_searchDialog != NULL) {
+        _searchDialog->deleteLater();
+        _searchDialog = NULL;
+    }
+
+    loadDocument(_searcher->found());
+}
+
+void DataStorage::loadDocument(const QHash<QString, QString> &relinked)
+{
+    QDomElement root = _document.documentElement();
+
     QDomNodeList mediaNodeList = root.elementsByTagName("media");
     QDomNodeList playlistNodeList = root.elementsByTagName("playlist");
     QDomNodeList scheduleNodeList = root.elementsByTagName("schedule");
 
+    QStringList missingLocations;
+
     // load media
     for (uint i = 0; i < mediaNodeList.length(); i++) {
         QDomNamedNodeMap mediaAttributes = mediaNodeList.at(i).attributes();
+        const QString savedLocation = mediaAttributes.namedItem("location").nodeValue();
+        QString location = savedLocation;
+        QString fingerprint = mediaAttributes.namedItem("fingerprint").nodeValue();
 
-        Media *media = new Media(mediaAttributes.namedItem("location").nodeValue(), _app->vlcInstance());
-        media->setId(mediaAttributes.namedItem("id").nodeValue().toInt());
+        if (!QFile::exists(location) && relinked.contains(fingerprint)) {
+            qDebug() << "Relink" << location << "to" << relinked.value(fingerprint);
+            location = relinked.value(fingerprint);
+        }
 
-        if (media->exists())
+        Media *media = new Media(location, _app->vlcInstance());
+        media->setId(mediaAttributes.namedItem("id").nodeValue().toInt());
+        if (!mediaAttributes.namedItem("loudness").isNull())
+            media->setLoudness(mediaAttributes.namedItem("loudness").nodeValue().toDouble(),
+                               mediaAttributes.namedItem("loudnessRange").nodeValue().toDouble(),
+                               mediaAttributes.namedItem("truePeak").nodeValue().toDouble());
+        if (!mediaAttributes.namedItem("blackIn").isNull())
+            media->setBlackMarks(mediaAttributes.namedItem("blackIn").nodeValue().toInt(),
+                                 mediaAttributes.namedItem("blackOut").nodeValue().toInt());
+        if (!mediaAttributes.namedItem("detectedCropTop").isNull())
+            media->setDetectedCrop(QMargins(mediaAttributes.namedItem("detectedCropLeft").nodeValue().toInt(),
+                                            mediaAttributes.namedItem("detectedCropTop").nodeValue().toInt(),
+                                            mediaAttributes.namedItem("detectedCropRight").nodeValue().toInt(),
+                                            mediaAttributes.namedItem("detectedCropBot").nodeValue().toInt()),
+                                   mediaAttributes.namedItem("detectedRatio").nodeValue().toInt());
+        if (!mediaAttributes.namedItem("scanType").isNull())
+            media->setScanType((ScanType) mediaAttributes.namedItem("scanType").nodeValue().toInt());
+        if (!mediaAttributes.namedItem("health").isNull())
+            media->setHealth((MediaHealth) mediaAttributes.namedItem("health").nodeValue().toInt(),
+                             mediaAttributes.namedItem("healthReport").nodeValue());
+        // the date is only kept for the file it was computed on
+        QDateTime fingerprintDate;
+        if (location == savedLocation && !mediaAttributes.namedItem("fingerprintDate").isNull())
+            fingerprintDate = QDateTime::fromTime_t(mediaAttributes.namedItem("fingerprintDate").nodeValue().toUInt());
+        media->setFingerprint(fingerprint, fingerprintDate);
+
+        if (media->exists()) {
             _mediaListModel->addMedia(media);
-        else
+        } else {
+            missingLocations << location;
             delete media;
+        }
     }
 
+    if (!missingLocations.isEmpty())
+        QMessageBox::warning(_win, tr("Missing media"),
+                             tr("These media were not found, their playbacks are removed:\n%1")
+                             .arg(missingLocations.join("\n")));
+
     // load playlist
     for (uint i = 0; i < playlistNodeList.length(); i++) {
         QDomNode playlistNode = playlistNodeList.at(i);
@@ -272,6 +449,7 @@ void DataStorage::load(QFile &file)
             settings->setVideoFadeOut(playbackAttributes.namedItem("videoFadeOut").nodeValue().toInt());
             settings->setVideoFadeIn(playbackAttributes.namedItem("videoFadeIn").nodeValue().toInt());
             settings->setSubtitlesFile(playbackAttributes.namedItem("subtitlesFile").nodeValue());
+            settings->setDecoderProfile( (DecoderProfile) playbackAttributes.namedItem("decoderProfile").nodeValue().toInt() );
 
 
             int cropTop, cropLeft, cropRight, cropBot;
@@ -287,21 +465,13 @@ void DataStorage::load(QFile &file)
 
             QString duration =  QString::number( (settings->outMark()-settings->inMark())) ;
             playback->media()->setDuration(duration);
-
-            QString enc = MediaSettings::encodeValues()[settings->subtitlesEncode()];
-
-            libvlc_media_add_option(playback->media()->core(), QString(":subsdec-encoding=" + enc).toLocal8Bit().data());
-            char* optionIn = (QString(":start-time=") + QString::number(settings->inMark() / 1000)).toLocal8Bit().data();
-            libvlc_media_add_option(playback->media()->core(),optionIn);
-            char* optionOut = (QString(":stop-time=") + QString::number(settings->outMark() / 1000)).toLocal8Bit().data();
-            libvlc_media_add_option(playback->media()->core(),optionOut);
         }
     }
 
     // remove old tabs
-    while(oldPlaylistCount > 0) {
+    while(_oldPlaylistCount > 0) {
         _win->playlistTabWidget()->removeTab(0);
-        oldPlaylistCount--;
+        _oldPlaylistCount--;
     }
 
     // load schedule
@@ -323,8 +493,12 @@ void DataStorage::load(QFile &file)
     }
 
     _playlistModelList.clear();
+    _document.clear();
 
+    // ready for the next save
+    updateFingerprints();
 
+    emit loaded();
 }
 
 void DataStorage::clear()
@@ -359,3 +533,77 @@ Media* DataStorage::findMediaById(int id) const
     return 0;
 }
 
+void DataStorage::searchProgress(int scanned)
+{
+    if (_searchDialog != NULL)
+        _searchDialog->setLabelText(tr("Searching the moved media... %1 files scanned").arg(scanned));
+}
+
+void DataStorage::updateFingerprints()
+{
+    foreach (Media *media, _mediaListModel->mediaList()) {
+        if (!media->exists() || _fingerprintQueue.contains(media) || (_fingerprintMedia == media && _fingerprintJob != NULL))
+            continue;
+
+        _fingerprintQueue << media;
+    }
+
+    startJobs();
+}
+
+void DataStorage::startJobs()
+{
+    if (_fingerprintJob != NULL)
+        return;
+
+    // the media removed meanwhile
+    while (!_fingerprintQueue.isEmpty() && _fingerprintQueue.first().isNull())
+        _fingerprintQueue.removeFirst();
+
+    if (_fingerprintQueue.isEmpty())
+        return;
+
+    // the scheduler calls again when a slot is free
+    if (!_app->jobScheduler()->acquire(this))
+        return;
+
+    _fingerprintMedia = _fingerprintQueue.takeFirst();
+    _fingerprintJob = new FingerprintJob(_fingerprintMedia->location(), _fingerprintMedia->fingerprint(),
+                                         _fingerprintMedia->fingerprintDate(), this);
+    connect(_fingerprintJob, SIGNAL(finished()), this, SLOT(fingerprintFinished()));
+    _fingerprintJob->start(QThread::LowestPriority);
+}
+
+void DataStorage::cancel()
+{
+    _fingerprintQueue.clear();
+    _app->jobScheduler()->withdraw(this);
+
+    if (_fingerprintJob != NULL) {
+        disconnect(_fingerprintJob, SIGNAL(finished()), this, SLOT(fingerprintFinished()));
+        _fingerprintJob->wait();
+        delete _fingerprintJob;
+        _fingerprintJob = NULL;
+        _fingerprintMedia = NULL;
+        _app->jobScheduler()->release(this);
+    }
+}
+
+void DataStorage::fingerprintFinished()
+{
+    FingerprintJob *job = _fingerprintJob;
+    _fingerprintJob = NULL;
+
+    if (job == NULL)
+        return;
+
+    // the media may have been removed or relinked meanwhile
+    if (!_fingerprintMedia.isNull() && _fingerprintMedia->location() == job->location && !job->fingerprint.isEmpty())
+        _fingerprintMedia->setFingerprint(job->fingerprint, job->modified);
+    _fingerprintMedia = NULL;
+
+    job->deleteLater();
+    _app->jobScheduler()->release(this);
+
+    startJobs();
+}
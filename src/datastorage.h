@@ -34,6 +34,10 @@
 #include <QObject>
 #include <QString>
 #include <QFile>
+#include <QHash>
+#include <QList>
+#include <QPointer>
+#include <QDomDocument>
 
 class MediaListModel;
 class PlaylistModel;
@@ -42,12 +46,16 @@ class VLCApplication;
 class Media;
 class Playlist;
 class MainWindow;
+class QProgressDialog;
+class FingerprintSearcher;
+class FingerprintJob;
 
 class DataStorage : public QObject
 {
     Q_OBJECT
 public:
     explicit DataStorage(VLCApplication *app, MainWindow *win/*FIX : ref 0000001*/, QObject *parent = 0);
+    ~DataStorage();
 
     /**
      * @brief Get project title
@@ -103,7 +111,11 @@ public:
     void save(QFile &file);
 
     /**
-     * @brief Load a project from file
+     * @brief Load a project from file, loaded() is emitted when done
+     *
+     * The moved media are searched first by their fingerprint in background,
+     * the project is loaded when the search is finished or skipped.
+     *
      * @param file The file to load. It must be a file named *.opp
      *
      * @author Florian Mhun <florian.mhun@gmail.com>
@@ -149,6 +161,16 @@ public slots:
      */
     void setProjectNotes(const QString &notes);
 
+    /**
+     * @brief Compute the next fingerprint of the queue when the scheduler gives a slot
+     */
+    void startJobs();
+
+    /**
+     * @brief Stop the running fingerprint and clear the queue
+     */
+    void cancel();
+
 protected:
 
     /**
@@ -169,6 +191,35 @@ protected:
      */
     Media* findMediaById(int id) const;
 
+    /**
+     * @brief Load the media, playlists and schedules of the parsed project
+     * @param relinked The file found for each fingerprint of a moved media
+     */
+    void loadDocument(const QHash<QString, QString> &relinked);
+
+    /**
+     * @brief Queue the media to check, those changed since their fingerprint are read again
+     */
+    void updateFingerprints();
+
+private slots:
+    /**
+     * @brief Load the project once the moved media are searched
+     */
+    void searchFinished();
+
+
+    /**
+     * @brief Show the progress of the search of moved media
+     * @param scanned The number of files walked
+     */
+    void searchProgress(int scanned);
+
+    /**
+     * @brief Store the fingerprint just computed and start the next one
+     */
+    void fingerprintFinished();
+
 private:
 
     /**
@@ -203,6 +254,46 @@ private:
 
     // FIX : ref 0000001
     MainWindow *_win;
+
+    /**
+     * @brief Search the moved media of the project being loaded
+     */
+    FingerprintSearcher *_searcher;
+
+    /**
+     * @brief The progress dialog of the running search of moved media, NULL if none
+     */
+    QProgressDialog *_searchDialog;
+
+    /**
+     * @brief The project being loaded, waiting for the search of its moved media
+     */
+    QDomDocument _document;
+
+    /**
+     * @brief The playlist tabs to remove once the project is loaded
+     */
+    int _oldPlaylistCount;
+
+    /**
+     * @brief The media waiting for their fingerprint
+     */
+    QList<QPointer<Media> > _fingerprintQueue;
+
+    /**
+     * @brief The running fingerprint, NULL if none
+     */
+    FingerprintJob *_fingerprintJob;
+
+    /**
+     * @brief The media of the running fingerprint
+     */
+    QPointer<Media> _fingerprintMedia;
+
+    /**
+     * @brief SEARCH_DIALOG_DELAY Time before showing the progress of a search (ms)
+     */
+    static const int SEARCH_DIALOG_DELAY = 500;
 };
 
 #endif // DATASTORAGE_H
@@ -0,0 +1,546 @@
+/**********************************************************************************
+ * This file is part of Open Projection Program (OPP).
+ *
+ * Copyright (C) 2013 Catalogue Ouvert du Cinéma <dev@cinemaouvert.fr>
+ *
+ * Authors: Jerome Blanchi <d.j.a.y@free.fr>
+ *
+ * Open Projection Program is an initiative of Catalogue Ouvert du Cinéma.
+ * The software was developed by four students of University of Poitiers
+ * as school project.
+ *
+ * Open Projection Program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Open Projection Program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Open Projection Program. If not, see <http://www.gnu.org/licenses/>.
+ **********************************************************************************/
+
+#include "enginesupervisor.h"
+
+#include <QCoreApplication>
+#include <QDataStream>
+#include <QLocalServer>
+#include <QLocalSocket>
+#include <QSharedMemory>
+#include <QTimer>
+#include <QDebug>
+
+#include <string.h>
+
+#include "media.h"
+#include "mediasettings.h"
+#include "playback.h"
+#include "stagingcache.h"
+#include "videowindow.h"
+
+EngineSupervisor::EngineSupervisor(QObject *parent) :
+    QObject(parent),
+    _name(QString("opp-engine-%1").arg(QCoreApplication::applicationPid())),
+    _server(new QLocalServer(this)),
+    _socket(NULL),
+    _process(new QProcess(this)),
+    _status(NULL),
+    _watchdog(new QTimer(this)),
+    _settingsTimer(new QTimer(this)),
+    _queueTimer(new QTimer(this)),
+    _heartbeat(0),
+    _sent(0),
+    _item(0),
+    _restarts(0),
+    _quitting(false),
+    _relaunch(false),
+    _displayMode(VideoWindow::WINDOW),
+    _volume(100),
+    _playback(NULL),
+    _next(NULL),
+    _state(PlaybackEngine::IdleState),
+    _published(PlaybackEngine::IdleState),
+    _time(0),
+    _length(0)
+{
+    memset(&_last, 0, sizeof(_last));
+
+    // left by a crashed interface with the same pid, reused
+    _status = new QSharedMemory(_name, this);
+    if (!_status->create(sizeof(PlaybackEngine::Status)) && !_status->attach())
+        qDebug() << "Playback engine: can not share the status" << _status->errorString();
+
+    QLocalServer::removeServer(_name);
+    connect(_server, SIGNAL(newConnection()), this, SLOT(engineConnected()));
+    if (!_server->listen(_name))
+        qDebug() << "Playback engine: can not listen on" << _name << _server->errorString();
+
+    _process->setProcessChannelMode(QProcess::ForwardedChannels);
+    connect(_process, SIGNAL(finished(int,QProcess::ExitStatus)), this, SLOT(engineFinished(int,QProcess::ExitStatus)));
+
+    connect(_watchdog, SIGNAL(timeout()), this, SLOT(watch()));
+
+    _settingsTimer->setSingleShot(true);
+    connect(_settingsTimer, SIGNAL(timeout()), this, SLOT(sendSettings()));
+    _queueTimer->setSingleShot(true);
+    connect(_queueTimer, SIGNAL(timeout()), this, SLOT(sendQueue()));
+
+    // ready before the first media, libvlc takes a while to load
+    launch();
+}
+
+EngineSupervisor::~EngineSupervisor()
+{
+    _watchdog->stop();
+    _quitting = true;
+
+    // nothing to save in the engine, a killed process is reaped at once by ~QProcess
+    if (_process->state() != QProcess::NotRunning)
+        _process->kill();
+}
+
+void EngineSupervisor::open(Playback *playback, const QStringList &options, int time)
+{
+    watchSettings(_playback, _settingsTimer, false);
+    if (_playback != NULL && _playback != _next)
+        disconnect(_playback, SIGNAL(destroyed(QObject*)), this, SLOT(playbackDestroyed(QObject*)));
+
+    _playback = playback;
+    _options = options;
+    _state = PlaybackEngine::IdleState;
+    _published = -1;
+    _time = time;
+    _timeRead.start();
+
+    if (_playback != NULL)
+        connect(_playback, SIGNAL(destroyed(QObject*)), this, SLOT(playbackDestroyed(QObject*)), Qt::UniqueConnection);
+    watchSettings(_playback, _settingsTimer, true);
+
+    // a new playback gets new chances, the engine given up on is started again
+    _restarts = 0;
+    if (_process->state() == QProcess::NotRunning && !_relaunch)
+        launch();
+
+    send(openCommand(time));
+}
+
+void EngineSupervisor::queue(Playback *playback)
+{
+    watchSettings(_next, _queueTimer, false);
+    if (_next != NULL && _next != _playback)
+        disconnect(_next, SIGNAL(destroyed(QObject*)), this, SLOT(playbackDestroyed(QObject*)));
+
+    _next = playback;
+
+    if (_next != NULL)
+        connect(_next, SIGNAL(destroyed(QObject*)), this, SLOT(playbackDestroyed(QObject*)), Qt::UniqueConnection);
+    watchSettings(_next, _queueTimer, true);
+
+    send(queueCommand());
+}
+
+void EngineSupervisor::play()
+{
+    _time = time();
+    _timeRead.start();
+    _state = PlaybackEngine::PlayingState;
+
+    send(command(PlaybackEngine::PlayCommand));
+}
+
+void EngineSupervisor::pause()
+{
+    _time = time();
+    _timeRead.start();
+    _state = PlaybackEngine::PausedState;
+
+    send(command(PlaybackEngine::PauseCommand));
+}
+
+void EngineSupervisor::stop()
+{
+    _state = PlaybackEngine::IdleState;
+    _time = 0;
+
+    send(command(PlaybackEngine::StopCommand));
+}
+
+void EngineSupervisor::setTime(int time)
+{
+    _time = time;
+    _timeRead.start();
+    _seeked.start();
+
+    send(command(PlaybackEngine::SeekCommand, time));
+}
+
+void EngineSupervisor::setVolume(int volume)
+{
+    if (volume == _volume)
+        return;
+
+    _volume = volume;
+
+    send(command(PlaybackEngine::VolumeCommand, volume));
+}
+
+void EngineSupervisor::setDisplayMode(int mode)
+{
+    _displayMode = mode;
+
+    send(command(PlaybackEngine::DisplayCommand, mode));
+}
+
+void EngineSupervisor::goToBlack()
+{
+    send(command(PlaybackEngine::GoToBlackCommand));
+}
+
+int EngineSupervisor::time() const
+{
+    if (_state == PlaybackEngine::PlayingState && !_timeRead.isNull())
+        return _time + _timeRead.elapsed();
+
+    return _time;
+}
+
+int EngineSupervisor::levels(float *peaks, float *rms, int count) const
+{
+    const int channels = qMin(count, (int)_last.channels);
+
+    for (int i = 0; i < channels; i++) {
+        peaks[i] = _last.peaks[i];
+        rms[i] = _last.rms[i];
+    }
+
+    return channels;
+}
+
+void EngineSupervisor::engineConnected()
+{
+    QLocalSocket *socket = _server->nextPendingConnection();
+
+    // the connection of a killed engine
+    if (_socket != NULL) {
+        _socket->abort();
+        _socket->deleteLater();
+    }
+
+    _socket = socket;
+    _started.start();
+
+    // counted by the engine from its connection
+    _sent = 0;
+
+    send(command(PlaybackEngine::DisplayCommand, _displayMode));
+    send(command(PlaybackEngine::VolumeCommand, _volume));
+
+    if (_playback == NULL)
+        return;
+
+    const bool playing = _state == PlaybackEngine::PlayingState;
+    const bool paused = _state == PlaybackEngine::PausedState;
+    const int resumeTime = playing || paused ? time() : 0;
+
+    send(openCommand(resumeTime));
+
+    if (playing || paused)
+        send(command(PlaybackEngine::PlayCommand));
+
+    if (paused)
+        send(command(PlaybackEngine::PauseCommand));
+
+    send(queueCommand());
+
+    if (_restarts > 0) {
+        _time = resumeTime;
+        _timeRead.start();
+        _seeked.start();
+        emit restarted(resumeTime);
+    }
+}
+
+void EngineSupervisor::watch()
+{
+    if (_socket == NULL) {
+        if (_started.elapsed() > START_TIMEOUT)
+            restart("not connected");
+        return;
+    }
+
+    if (!_status->isAttached() || !_status->lock())
+        return;
+
+    PlaybackEngine::Status status;
+    memcpy(&status, _status->constData(), sizeof(status));
+    _status->unlock();
+
+    if (status.heartbeat == _heartbeat) {
+        if (_started.elapsed() > HEARTBEAT_TIMEOUT)
+            restart("no heartbeat");
+        return;
+    }
+
+    _heartbeat = status.heartbeat;
+    _last = status;
+    _started.start();
+
+    // the engine has played the queued playback on its own
+    if (status.item != _item) {
+        _item = status.item;
+
+        watchSettings(_playback, _settingsTimer, false);
+        watchSettings(_next, _queueTimer, false);
+        if (_playback != NULL && _playback != _next)
+            disconnect(_playback, SIGNAL(destroyed(QObject*)), this, SLOT(playbackDestroyed(QObject*)));
+
+        _playback = _next;
+        _next = NULL;
+        _options.clear();
+        _restarts = 0;
+        watchSettings(_playback, _settingsTimer, true);
+
+        emit advanced();
+    }
+
+    if (status.length != _length) {
+        _length = status.length;
+        emit lengthChanged(_length);
+    }
+
+    // the state of a command not executed yet
+    if (status.commands != _sent)
+        return;
+
+    _state = status.state;
+    if (_state != _published) {
+        _published = _state;
+        emit stateChanged(_state);
+    }
+
+    if (!_seeked.isNull() && _seeked.elapsed() < SEEK_DELAY)
+        return;
+
+    if (_state == PlaybackEngine::PlayingState || _state == PlaybackEngine::PausedState) {
+        _timeRead.start();
+        if (status.time != _time) {
+            _time = status.time;
+            emit timeChanged(_time);
+        }
+    }
+}
+
+void EngineSupervisor::engineFinished(int exitCode, QProcess::ExitStatus exitStatus)
+{
+    Q_UNUSED(exitStatus);
+
+    // stopped on purpose, or killed after too many restarts
+    if (_quitting || _restarts > MAX_RESTARTS)
+        return;
+
+    if (_relaunch) {
+        _relaunch = false;
+        launch();
+        return;
+    }
+
+    restart(QString("ended with code %1").arg(exitCode));
+}
+
+void EngineSupervisor::sendSettings()
+{
+    if (_playback == NULL)
+        return;
+
+    QByteArray data;
+    QDataStream out(&data, QIODevice::WriteOnly);
+    out.setVersion(QDataStream::Qt_4_6);
+    out << (qint32)PlaybackEngine::SettingsCommand << _playback->mediaSettings()->toMap();
+
+    send(data);
+}
+
+void EngineSupervisor::sendQueue()
+{
+    send(queueCommand());
+}
+
+void EngineSupervisor::playbackDestroyed(QObject *playback)
+{
+    if (playback == _next) {
+        _next = NULL;
+        send(queueCommand());
+    }
+
+    if (playback == _playback) {
+        _playback = NULL;
+        _options.clear();
+    }
+}
+
+void EngineSupervisor::launch()
+{
+    if (_process->state() != QProcess::NotRunning || _restarts > MAX_RESTARTS)
+        return;
+
+    // the new engine counts its heartbeats and its items from 1
+    if (_status->isAttached() && _status->lock()) {
+        memset(_status->data(), 0, sizeof(PlaybackEngine::Status));
+        _status->unlock();
+    }
+    _heartbeat = 0;
+    _item = 0;
+
+    _process->start(QCoreApplication::applicationFilePath(), QStringList() << PlaybackEngine::option() << _name);
+    _started.start();
+    _watchdog->start(WATCHDOG_INTERVAL);
+}
+
+void EngineSupervisor::restart(const QString &reason)
+{
+    qDebug() << "Playback engine:" << reason;
+
+    // no more checks until the new engine is launched
+    _watchdog->stop();
+
+    if (_socket != NULL) {
+        _socket->abort();
+        _socket->deleteLater();
+        _socket = NULL;
+    }
+
+    if (++_restarts > MAX_RESTARTS) {
+        qDebug() << "Playback engine: too many restarts, given up";
+        _process->kill();
+        emit failed();
+        return;
+    }
+
+    // the new engine resumes the playback when it connects
+    if (_process->state() == QProcess::NotRunning) {
+        launch();
+    } else {
+        _relaunch = true;
+        _process->kill();
+    }
+}
+
+void EngineSupervisor::watchSettings(Playback *playback, QTimer *timer, bool watch)
+{
+    if (playback == NULL)
+        return;
+
+    MediaSettings *settings = playback->mediaSettings();
+
+    if (!watch) {
+        timer->stop();
+        disconnect(settings, 0, timer, 0);
+        return;
+    }
+
+    connect(settings, SIGNAL(ratioChanged(Ratio)), timer, SLOT(start()));
+    connect(settings, SIGNAL(scaleChanged(Scale)), timer, SLOT(start()));
+    connect(settings, SIGNAL(deinterlacingChanged(Deinterlacing)), timer, SLOT(start()));
+    connect(settings, SIGNAL(subtitlesSyncChanged(double)), timer, SLOT(start()));
+    connect(settings, SIGNAL(subtitlesFileChanged(QString)), timer, SLOT(start()));
+    connect(settings, SIGNAL(gammaChanged(float)), timer, SLOT(start()));
+    connect(settings, SIGNAL(contrastChanged(float)), timer, SLOT(start()));
+    connect(settings, SIGNAL(brightnessChanged(float)), timer, SLOT(start()));
+    connect(settings, SIGNAL(saturationChanged(float)), timer, SLOT(start()));
+    connect(settings, SIGNAL(hueChanged(int)), timer, SLOT(start()));
+    connect(settings, SIGNAL(audioSyncChanged(double)), timer, SLOT(start()));
+    connect(settings, SIGNAL(audioTrackChanged(int)), timer, SLOT(start()));
+    connect(settings, SIGNAL(videoTrackChanged(int)), timer, SLOT(start()));
+    connect(settings, SIGNAL(subtitlesTrackChanged(int)), timer, SLOT(start()));
+    connect(settings, SIGNAL(testPatternChanged(bool)), timer, SLOT(start()));
+    connect(settings, SIGNAL(inMarkChanged(int)), timer, SLOT(start()));
+    connect(settings, SIGNAL(outMarkChanged(int)), timer, SLOT(start()));
+    connect(settings, SIGNAL(gainChanged(float)), timer, SLOT(start()));
+    connect(settings, SIGNAL(subtitlesEncodeChanged(int)), timer, SLOT(start()));
+    connect(settings, SIGNAL(decoderProfileChanged(DecoderProfile)), timer, SLOT(start()));
+    connect(settings, SIGNAL(cropChanged(int,int,int,int)), timer, SLOT(start()));
+    connect(settings, SIGNAL(audioFadeOutChanged(int)), timer, SLOT(start()));
+    connect(settings, SIGNAL(audioFadeInChanged(int)), timer, SLOT(start()));
+    connect(settings, SIGNAL(videoFadeOutChanged(int)), timer, SLOT(start()));
+    connect(settings, SIGNAL(videoFadeInChanged(int)), timer, SLOT(start()));
+}
+
+void EngineSupervisor::send(const QByteArray &command)
+{
+    launch();
+
+    if (_socket == NULL || _socket->state() != QLocalSocket::ConnectedState)
+        return;
+
+    QByteArray block;
+    QDataStream out(&block, QIODevice::WriteOnly);
+    out.setVersion(QDataStream::Qt_4_6);
+    out << (quint32)command.size();
+    out.writeRawData(command.constData(), command.size());
+
+    _socket->write(block);
+    _sent++;
+}
+
+QByteArray EngineSupervisor::openCommand(int time) const
+{
+    QByteArray data;
+    QDataStream out(&data, QIODevice::WriteOnly);
+    out.setVersion(QDataStream::Qt_4_6);
+    out << (qint32)PlaybackEngine::OpenCommand;
+    writePlayback(out, _playback);
+    out << _options << (qint32)time;
+
+    return data;
+}
+
+QByteArray EngineSupervisor::queueCommand() const
+{
+    QByteArray data;
+    QDataStream out(&data, QIODevice::WriteOnly);
+    out.setVersion(QDataStream::Qt_4_6);
+    out << (qint32)PlaybackEngine::QueueCommand;
+    writePlayback(out, _next);
+
+    return data;
+}
+
+void EngineSupervisor::writePlayback(QDataStream &out, Playback *playback)
+{
+    if (playback == NULL) {
+        out << QString() << (qint32)UnknownScan << QString() << QVariantMap();
+        return;
+    }
+
+    Media *media = playback->media();
+
+    // the local copy of a media of a network share, as the interface would read it
+    QString location = StagingCache::stagedFile(media->location());
+    if (location.isEmpty())
+        location = media->location();
+
+    out << location << (qint32)media->scanType() << media->imageTime() << playback->mediaSettings()->toMap();
+}
+
+QByteArray EngineSupervisor::command(int command)
+{
+    QByteArray data;
+    QDataStream out(&data, QIODevice::WriteOnly);
+    out.setVersion(QDataStream::Qt_4_6);
+    out << (qint32)command;
+
+    return data;
+}
+
+QByteArray EngineSupervisor::command(int command, int value)
+{
+    QByteArray data;
+    QDataStream out(&data, QIODevice::WriteOnly);
+    out.setVersion(QDataStream::Qt_4_6);
+    out << (qint32)command << (qint32)value;
+
+    return data;
+}
@@ -0,0 +1,398 @@
+/**********************************************************************************
+ * This file is part of Open Projection Program (OPP).
+ *
+ * Copyright (C) 2013 Catalogue Ouvert du Cinéma <dev@cinemaouvert.fr>
+ *
+ * Authors: Jerome Blanchi <d.j.a.y@free.fr>
+ *
+ * Open Projection Program is an initiative of Catalogue Ouvert du Cinéma.
+ * The software was developed by four students of University of Poitiers
+ * as school project.
+ *
+ * Open Projection Program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Open Projection Program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Open Projection Program. If not, see <http://www.gnu.org/licenses/>.
+ **********************************************************************************/
+
+#ifndef ENGINESUPERVISOR_H
+#define ENGINESUPERVISOR_H
+
+#include <QObject>
+#include <QProcess>
+#include <QString>
+#include <QStringList>
+#include <QTime>
+
+#include "playbackengine.h"
+
+class QDataStream;
+class QLocalServer;
+class QLocalSocket;
+class QSharedMemory;
+class QTimer;
+class Playback;
+
+/**
+ * @brief Run the projection in a PlaybackEngine process and restart it when it fails
+ *
+ * The supervisor keeps what the engine should be doing: the display mode,
+ * the volume, the playback with its settings, the queued playback and
+ * whether it is playing. The settings are sent again each time they change.
+ * The state, the clock and the audio levels of the interface are read from
+ * the status, a state only once the engine has executed every command sent,
+ * so a late status does not undo a command.
+ *
+ * The watchdog restarts the engine when the process ends, when it does not
+ * connect within START_TIMEOUT ms or when its heartbeat stops for
+ * HEARTBEAT_TIMEOUT ms. The new engine opens the playback again at the last
+ * time it published, plus the time elapsed since when it was playing. After
+ * MAX_RESTARTS restarts on the same playback, the supervisor gives up until
+ * the next playback.
+ */
+class EngineSupervisor : public QObject
+{
+    Q_OBJECT
+public:
+    /**
+     * @brief Start an engine process, shown in VideoWindow::WINDOW mode
+     */
+    explicit EngineSupervisor(QObject *parent = 0);
+    ~EngineSupervisor();
+
+    /**
+     * @brief Open a playback in the engine, its settings are followed until another one is opened
+     * @param playback The playback
+     * @param options The recovery options of the decoder
+     * @param time The start time (ms), 0 for the in mark
+     */
+    void open(Playback *playback, const QStringList &options, int time);
+
+    /**
+     * @brief Queue the playback played by the engine at the end of the current one
+     * @param playback The playback, NULL for none
+     */
+    void queue(Playback *playback);
+
+    /**
+     * @brief Play or resume the playback
+     */
+    void play();
+
+    /**
+     * @brief Pause the playback
+     */
+    void pause();
+
+    /**
+     * @brief Stop the playback
+     */
+    void stop();
+
+    /**
+     * @brief Seek the playback
+     * @param time The time (ms)
+     */
+    void setTime(int time);
+
+    /**
+     * @brief Set the volume of the engine, before the gain of the playback
+     * @param volume The volume, from 0 to 100
+     */
+    void setVolume(int volume);
+
+    /**
+     * @brief Show the projection window in a VideoWindow::DisplayMode
+     */
+    void setDisplayMode(int mode);
+
+    /**
+     * @brief Fade the playback to black then stop it
+     */
+    void goToBlack();
+
+    /**
+     * @brief Get the state of the engine
+     * @return The PlaybackEngine::State of the last command, then of the status
+     */
+    inline int state() const { return _state; }
+
+    /**
+     * @brief Get the estimated time of the engine
+     * @return The last time published, plus the time elapsed since when playing (ms)
+     */
+    int time() const;
+
+    /**
+     * @brief Get the length of the playback of the engine
+     * @return The last length published (ms)
+     */
+    inline int length() const { return _length; }
+
+    /**
+     * @brief Get the last audio levels published by the engine
+     * @param peaks The highest absolute sample of each channel (full scale is 1)
+     * @param rms The RMS level of each channel (full scale is 1)
+     * @param count The size of the arrays
+     * @return The number of channels filled
+     */
+    int levels(float *peaks, float *rms, int count) const;
+
+    /**
+     * @brief WATCHDOG_INTERVAL Interval between two reads of the status (ms)
+     */
+    static const int WATCHDOG_INTERVAL = 100;
+
+    /**
+     * @brief HEARTBEAT_TIMEOUT The engine is restarted after this time without heartbeat (ms)
+     */
+    static const int HEARTBEAT_TIMEOUT = 1500;
+
+    /**
+     * @brief START_TIMEOUT The engine is restarted if not connected after this time (ms)
+     */
+    static const int START_TIMEOUT = 5000;
+
+    /**
+     * @brief MAX_RESTARTS Restarts in a row before giving up
+     */
+    static const int MAX_RESTARTS = 5;
+
+    /**
+     * @brief SEEK_DELAY Time for a seek to show in the status (ms)
+     */
+    static const int SEEK_DELAY = 2000;
+
+signals:
+    /**
+     * @brief Emitted when the engine reaches another PlaybackEngine::State
+     */
+    void stateChanged(int state);
+
+    /**
+     * @brief Emitted when the time published by the engine changes
+     */
+    void timeChanged(int time);
+
+    /**
+     * @brief Emitted when the length published by the engine changes
+     */
+    void lengthChanged(int length);
+
+    /**
+     * @brief Emitted when the engine has started the queued playback, which is now the current one
+     */
+    void advanced();
+
+    /**
+     * @brief Emitted when a new engine resumes the projection
+     * @param time The time it resumes at (ms)
+     */
+    void restarted(int time);
+
+    /**
+     * @brief Emitted when the engine can not be restarted, the supervisor is stopped
+     */
+    void failed();
+
+private slots:
+    /**
+     * @brief Accept the connection of the engine and send it the current state
+     */
+    void engineConnected();
+
+    /**
+     * @brief Read the status and restart the engine when it is frozen
+     */
+    void watch();
+
+    /**
+     * @brief Start the engine killed by restart(), or restart the engine ended without QuitCommand
+     */
+    void engineFinished(int exitCode, QProcess::ExitStatus exitStatus);
+
+    /**
+     * @brief Send the settings of the current playback, once for the changes of an event
+     */
+    void sendSettings();
+
+    /**
+     * @brief Send the queued playback again, once for the changes of its settings during an event
+     */
+    void sendQueue();
+
+    /**
+     * @brief Forget a playback deleted by the interface
+     */
+    void playbackDestroyed(QObject *playback);
+
+private:
+    /**
+     * @brief Start the engine process if it does not run
+     */
+    void launch();
+
+    /**
+     * @brief Kill the engine, the new one is started once the process has ended
+     */
+    void restart(const QString &reason);
+
+    /**
+     * @brief Follow the settings of a playback, or stop following them
+     * @param playback The playback, nothing is done for NULL
+     * @param timer The timer started by the changes
+     * @param watch False to stop following them
+     */
+    void watchSettings(Playback *playback, QTimer *timer, bool watch);
+
+    /**
+     * @brief Send a PlaybackEngine::Command with its arguments
+     * @param command The serialized command, without its size
+     */
+    void send(const QByteArray &command);
+
+    /**
+     * @brief Serialize the OpenCommand of the current playback
+     * @param time The start time (ms)
+     */
+    QByteArray openCommand(int time) const;
+
+    /**
+     * @brief Serialize the QueueCommand of the queued playback
+     */
+    QByteArray queueCommand() const;
+
+    /**
+     * @brief Serialize a playback as the engine reads it
+     * @param playback The playback, NULL for none
+     */
+    static void writePlayback(QDataStream &out, Playback *playback);
+
+    /**
+     * @brief Serialize a command without argument
+     */
+    static QByteArray command(int command);
+
+    /**
+     * @brief Serialize a command with an integer argument
+     */
+    static QByteArray command(int command, int value);
+
+    /**
+     * @brief _name The name of the local socket and of the shared status
+     */
+    QString _name;
+
+    QLocalServer *_server;
+
+    /**
+     * @brief _socket The connection of the engine, NULL until connected
+     */
+    QLocalSocket *_socket;
+
+    QProcess *_process;
+
+    QSharedMemory *_status;
+
+    QTimer *_watchdog;
+
+    /**
+     * @brief _settingsTimer Sends the settings changed during an event at once
+     */
+    QTimer *_settingsTimer;
+
+    /**
+     * @brief _queueTimer Sends the queued playback changed during an event at once
+     */
+    QTimer *_queueTimer;
+
+    /**
+     * @brief _started Time since the engine was started or since its last heartbeat
+     */
+    QTime _started;
+
+    quint32 _heartbeat;
+
+    /**
+     * @brief _sent The commands sent since the engine is connected
+     */
+    quint32 _sent;
+
+    /**
+     * @brief _item The queued playbacks started by the engine
+     */
+    quint32 _item;
+
+    int _restarts;
+
+    /**
+     * @brief _quitting True when the engine is stopped on purpose
+     */
+    bool _quitting;
+
+    /**
+     * @brief _relaunch True when the engine was killed by restart() and is replaced once ended
+     */
+    bool _relaunch;
+
+    int _displayMode;
+
+    int _volume;
+
+    /**
+     * @brief _playback The playback of the engine, NULL if none
+     */
+    Playback *_playback;
+
+    /**
+     * @brief _options The recovery options the playback was opened with
+     */
+    QStringList _options;
+
+    /**
+     * @brief _next The playback queued in the engine, NULL if none
+     */
+    Playback *_next;
+
+    /**
+     * @brief _state The PlaybackEngine::State
+     */
+    int _state;
+
+    /**
+     * @brief _published The last state emitted, -1 after an opening to emit the next one
+     */
+    int _published;
+
+    /**
+     * @brief _time The last time published by the engine (ms)
+     */
+    int _time;
+
+    /**
+     * @brief _timeRead When _time was read
+     */
+    QTime _timeRead;
+
+    int _length;
+
+    /**
+     * @brief _seeked When the engine was seeked, the status shows the old time meanwhile
+     */
+    QTime _seeked;
+
+    /**
+     * @brief _last The last status read
+     */
+    PlaybackEngine::Status _last;
+};
+
+#endif // ENGINESUPERVISOR_H
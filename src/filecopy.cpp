@@ -0,0 +1,144 @@
+/**********************************************************************************
+ * This file is part of Open Projection Program (OPP).
+ *
+ * Copyright (C) 2013 Catalogue Ouvert du Cinéma <dev@cinemaouvert.fr>
+ *
+ * Authors: Jerome Blanchi <d.j.a.y@free.fr>
+ *
+ * Open Projection Program is an initiative of Catalogue Ouvert du Cinéma.
+ * The software was developed by four students of University of Poitiers
+ * as school project.
+ *
+ * Open Projection Program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Open Projection Program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Open Projection Program. If not, see <http://www.gnu.org/licenses/>.
+ **********************************************************************************/
+
+#include "filecopy.h"
+
+#include <QElapsedTimer>
+#include <QFile>
+#include <QThread>
+
+#include "jobscheduler.h"
+
+#if defined(Q_OS_LINUX)
+# include <sys/sendfile.h>
+# include <sys/syscall.h>
+# include <unistd.h>
+#endif
+
+/**
+ * @brief Give access to the sleep of QThread, protected in Qt 4
+ */
+class CopySleep : public QThread
+{
+public:
+    static void msleep(unsigned long msecs) { QThread::msleep(msecs); }
+};
+
+bool FileCopy::copy(const QString &source, const QString &destination,
+                    QAtomicInt *rate, QAtomicInt *cancelled, QString *error,
+                    JobScheduler *scheduler)
+{
+    QFile in(source);
+    QFile out(destination);
+    QString reason;
+
+    if (!in.open(QIODevice::ReadOnly | QIODevice::Unbuffered)) {
+        if (error != NULL)
+            *error = in.errorString();
+        return false;
+    }
+
+    const qint64 size = in.size();
+    qint64 copied = out.exists() && out.size() <= size ? out.size() : 0;
+
+    QIODevice::OpenMode mode = QIODevice::Unbuffered | (copied > 0 ? QIODevice::ReadWrite : QIODevice::WriteOnly | QIODevice::Truncate);
+    if (!out.open(mode) || !in.seek(copied) || !out.seek(copied)) {
+        if (error != NULL)
+            *error = out.errorString();
+        return false;
+    }
+
+    QByteArray buffer;
+#if defined(Q_OS_LINUX)
+    bool kernelCopy = true;
+    bool rangeCopy = true;
+#endif
+
+    while (copied < size) {
+        if (cancelled != NULL && cancelled->fetchAndAddOrdered(0)) {
+            reason = "cancelled";
+            break;
+        }
+
+        // the projection reads first, the budget is refilled by the scheduler
+        if (scheduler != NULL && !scheduler->mayRead()) {
+            CopySleep::msleep(BUDGET_WAIT);
+            continue;
+        }
+
+        QElapsedTimer clock;
+        clock.start();
+
+        qint64 chunk = qMin((qint64)CHUNK_SIZE, size - copied);
+        qint64 written = -1;
+
+#if defined(Q_OS_LINUX)
+        // the data stays in the kernel, some network shares even copy on the server
+# ifdef SYS_copy_file_range
+        if (kernelCopy && rangeCopy) {
+            written = syscall(SYS_copy_file_range, in.handle(), NULL, out.handle(), NULL, (size_t)chunk, 0);
+            if (written <= 0)
+                rangeCopy = false;
+        }
+# endif
+        if (kernelCopy && written <= 0) {
+            written = sendfile(out.handle(), in.handle(), NULL, (size_t)chunk);
+            if (written <= 0) {
+                // back to read and write from where the kernel stopped
+                kernelCopy = false;
+                in.seek(copied);
+                out.seek(copied);
+            }
+        }
+#endif
+        if (written <= 0) {
+            buffer = in.read(chunk);
+            written = buffer.isEmpty() ? -1 : out.write(buffer);
+        }
+
+        if (written <= 0) {
+            reason = in.error() != QFile::NoError ? in.errorString() : out.errorString();
+            break;
+        }
+
+        copied += written;
+
+        if (scheduler != NULL)
+            scheduler->addReadBytes(written);
+
+        // bandwidth limit, the rate may change during the copy
+        int limit = rate != NULL ? rate->fetchAndAddOrdered(0) : 0;
+        if (limit > 0) {
+            qint64 ahead = written * 1000 / limit - clock.elapsed();
+            if (ahead > 0)
+                CopySleep::msleep(ahead);
+        }
+    }
+
+    if (error != NULL)
+        *error = reason;
+
+    return copied == size && reason.isEmpty();
+}
@@ -0,0 +1,71 @@
+/**********************************************************************************
+ * This file is part of Open Projection Program (OPP).
+ *
+ * Copyright (C) 2013 Catalogue Ouvert du Cinéma <dev@cinemaouvert.fr>
+ *
+ * Authors: Jerome Blanchi <d.j.a.y@free.fr>
+ *
+ * Open Projection Program is an initiative of Catalogue Ouvert du Cinéma.
+ * The software was developed by four students of University of Poitiers
+ * as school project.
+ *
+ * Open Projection Program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Open Projection Program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Open Projection Program. If not, see <http://www.gnu.org/licenses/>.
+ **********************************************************************************/
+
+#ifndef FILECOPY_H
+#define FILECOPY_H
+
+#include <QAtomicInt>
+#include <QString>
+
+class JobScheduler;
+
+/**
+ * @brief Copy of large files with the kernel copies of the system
+ *
+ * The data is copied by copy_file_range where available (server side on
+ * some network shares), then sendfile, then read and write. A copy left
+ * unfinished is resumed from where it stopped.
+ */
+class FileCopy
+{
+public:
+    /**
+     * @brief Copy a file, resume the copy if the destination is shorter
+     * @param source The file to copy
+     * @param destination The copy
+     * @param rate The bandwidth limit in bytes per second, 0 or NULL for no limit,
+     *             read at each chunk so another thread may change it
+     * @param cancelled Stops the copy when set by another thread, may be NULL
+     * @param error Set to the reason of a failure, may be NULL
+     * @param scheduler Charged with the bytes read, the copy waits while its read budget
+     *                  is spent, may be NULL
+     * @return True if the destination has the size of the source, false otherwise
+     */
+    static bool copy(const QString &source, const QString &destination,
+                     QAtomicInt *rate = NULL, QAtomicInt *cancelled = NULL, QString *error = NULL,
+                     JobScheduler *scheduler = NULL);
+
+    /**
+     * @brief CHUNK_SIZE Bytes copied at once
+     */
+    static const int CHUNK_SIZE = 4 * 1024 * 1024;
+
+    /**
+     * @brief BUDGET_WAIT Time to wait for the read budget of the scheduler (ms)
+     */
+    static const int BUDGET_WAIT = 50;
+};
+
+#endif // FILECOPY_H
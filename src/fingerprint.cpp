@@ -0,0 +1,408 @@
+/**********************************************************************************
+ * This file is part of Open Projection Program (OPP).
+ *
+ * Copyright (C) 2013 Catalogue Ouvert du Cinéma <dev@cinemaouvert.fr>
+ *
+ * Authors: Jerome Blanchi <d.j.a.y@free.fr>
+ *
+ * Open Projection Program is an initiative of Catalogue Ouvert du Cinéma.
+ * The software was developed by four students of University of Poitiers
+ * as school project.
+ *
+ * Open Projection Program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Open Projection Program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Open Projection Program. If not, see <http://www.gnu.org/licenses/>.
+ **********************************************************************************/
+
+#include "fingerprint.h"
+
+#include <string.h>
+
+#include <QAtomicInt>
+#include <QDir>
+#include <QDirIterator>
+#include <QFile>
+#include <QFileInfo>
+#include <QMutex>
+#include <QMutexLocker>
+#include <QRunnable>
+#include <QSet>
+#include <QThread>
+#include <QThreadPool>
+#include <QTimer>
+#include <QtEndian>
+
+/***********************************************************************\
+                                XXHASH64
+\***********************************************************************/
+
+static const quint64 PRIME1 = Q_UINT64_C(11400714785074694791);
+static const quint64 PRIME2 = Q_UINT64_C(14029467366897019727);
+static const quint64 PRIME3 = Q_UINT64_C(1609587929392839161);
+static const quint64 PRIME4 = Q_UINT64_C(9650029242287828579);
+static const quint64 PRIME5 = Q_UINT64_C(2870177450012600261);
+
+static inline quint64 rotate(quint64 value, int bits)
+{
+    return (value << bits) | (value >> (64 - bits));
+}
+
+static inline quint64 read64(const uchar *data)
+{
+    return qFromLittleEndian<quint64>(data);
+}
+
+static inline quint64 read32(const uchar *data)
+{
+    return qFromLittleEndian<quint32>(data);
+}
+
+static inline quint64 accumulate(quint64 acc, quint64 input)
+{
+    return rotate(acc + input * PRIME2, 31) * PRIME1;
+}
+
+static inline quint64 merge(quint64 acc, quint64 value)
+{
+    return (acc ^ accumulate(0, value)) * PRIME1 + PRIME4;
+}
+
+static quint64 xxh64(const uchar *data, qint64 length, quint64 seed)
+{
+    const uchar *end = data + length;
+    quint64 hash;
+
+    if (length >= 32) {
+        quint64 v1 = seed + PRIME1 + PRIME2;
+        quint64 v2 = seed + PRIME2;
+        quint64 v3 = seed;
+        quint64 v4 = seed - PRIME1;
+
+        do {
+            v1 = accumulate(v1, read64(data));
+            v2 = accumulate(v2, read64(data + 8));
+            v3 = accumulate(v3, read64(data + 16));
+            v4 = accumulate(v4, read64(data + 24));
+            data += 32;
+        } while (data + 32 <= end);
+
+        hash = rotate(v1, 1) + rotate(v2, 7) + rotate(v3, 12) + rotate(v4, 18);
+        hash = merge(hash, v1);
+        hash = merge(hash, v2);
+        hash = merge(hash, v3);
+        hash = merge(hash, v4);
+    } else {
+        hash = seed + PRIME5;
+    }
+
+    hash += (quint64)length;
+
+    for (; data + 8 <= end; data += 8)
+        hash = rotate(hash ^ accumulate(0, read64(data)), 27) * PRIME1 + PRIME4;
+
+    if (data + 4 <= end) {
+        hash = rotate(hash ^ (read32(data) * PRIME1), 23) * PRIME2 + PRIME3;
+        data += 4;
+    }
+
+    for (; data < end; ++data)
+        hash = rotate(hash ^ (*data * PRIME5), 11) * PRIME1;
+
+    hash ^= hash >> 33;
+    hash *= PRIME2;
+    hash ^= hash >> 29;
+    hash *= PRIME3;
+    hash ^= hash >> 32;
+
+    return hash;
+}
+
+/***********************************************************************\
+                              PARALLEL WORK
+\***********************************************************************/
+
+/**
+ * @brief Fingerprint of one file of a list
+ */
+class FingerprintTask : public QRunnable
+{
+public:
+    FingerprintTask(const QString &file, QString *result) : file(file), result(result) {}
+
+    void run() { *result = Fingerprint::compute(file); }
+
+    QString file;
+    QString *result;
+};
+
+/**
+ * @brief State shared by the walkers of a search
+ */
+struct FingerprintSearch
+{
+    QSet<qint64> sizes;
+    QSet<QString> fingerprints;
+    QHash<QString, QString> found;
+    QMutex mutex;
+    QAtomicInt remaining;
+    QAtomicInt *scanned;
+    QAtomicInt *cancelled;
+};
+
+/**
+ * @brief Walk a directory for the files of a search
+ */
+class FingerprintWalk : public QRunnable
+{
+public:
+    FingerprintWalk(const QString &directory, bool recursive, FingerprintSearch *search) :
+        directory(directory), recursive(recursive), search(search) {}
+
+    void run()
+    {
+        QDirIterator it(directory, QDir::Files | QDir::Readable | QDir::NoDotAndDotDot,
+                        recursive ? QDirIterator::Subdirectories : QDirIterator::NoIteratorFlags);
+
+        while (it.hasNext() && search->remaining.fetchAndAddOrdered(0) > 0) {
+            if (search->cancelled != NULL && search->cancelled->fetchAndAddOrdered(0))
+                return;
+
+            it.next();
+            if (search->scanned != NULL)
+                search->scanned->fetchAndAddOrdered(1);
+
+            // most files are left out without reading them
+            if (!search->sizes.contains(it.fileInfo().size()))
+                continue;
+
+            QString fingerprint = Fingerprint::compute(it.filePath());
+            if (!search->fingerprints.contains(fingerprint))
+                continue;
+
+            QMutexLocker locker(&search->mutex);
+            if (!search->found.contains(fingerprint)) {
+                search->found.insert(fingerprint, it.filePath());
+                search->remaining.fetchAndAddOrdered(-1);
+            }
+        }
+    }
+
+    QString directory;
+    bool recursive;
+    FingerprintSearch *search;
+};
+
+/**
+ * @brief Search of a FingerprintSearcher
+ */
+class FingerprintThread : public QThread
+{
+public:
+    FingerprintThread(const QStringList &fingerprints, const QStringList &roots,
+                      QAtomicInt *scanned, QAtomicInt *cancelled, QObject *parent) :
+        QThread(parent), fingerprints(fingerprints), roots(roots), scanned(scanned), cancelled(cancelled) {}
+
+    void run() { found = Fingerprint::search(fingerprints, roots, scanned, cancelled); }
+
+    QStringList fingerprints;
+    QStringList roots;
+    QAtomicInt *scanned;
+    QAtomicInt *cancelled;
+    QHash<QString, QString> found;
+};
+
+/***********************************************************************\
+                               FINGERPRINT
+\***********************************************************************/
+
+QString Fingerprint::compute(const QString &file)
+{
+    QFile input(file);
+
+    if (!input.open(QIODevice::ReadOnly))
+        return QString();
+
+    // every empty file would match
+    const qint64 size = input.size();
+    if (size <= 0)
+        return QString();
+
+    const qint64 block = qMin((qint64)BLOCK_SIZE, size);
+    quint64 hash = (quint64)size;
+
+    for (int i = 0; i < SAMPLES; ++i) {
+        qint64 offset = (size - block) * i / (SAMPLES - 1);
+
+        uchar *data = input.map(offset, block);
+        if (data != NULL) {
+            hash = xxh64(data, block, hash);
+            input.unmap(data);
+        } else {
+            // not mappable, read it
+            input.seek(offset);
+            QByteArray bytes = input.read(block);
+            if (bytes.size() != block)
+                return QString();
+            hash = xxh64((const uchar *)bytes.constData(), block, hash);
+        }
+    }
+
+    return QString("%1-%2").arg(size).arg(hash, 16, 16, QChar('0'));
+}
+
+QStringList Fingerprint::compute(const QStringList &files)
+{
+    QVector<QString> results(files.count());
+    QThreadPool pool;
+
+    for (int i = 0; i < files.count(); ++i)
+        pool.start(new FingerprintTask(files.at(i), &results[i]));
+    pool.waitForDone();
+
+    return results.toList();
+}
+
+quint64 Fingerprint::hash(const QByteArray &data, quint64 seed)
+{
+    return xxh64((const uchar *)data.constData(), data.size(), seed);
+}
+
+qint64 Fingerprint::size(const QString &fingerprint)
+{
+    bool ok = false;
+    qint64 size = fingerprint.section('-', 0, 0).toLongLong(&ok);
+
+    return ok ? size : -1;
+}
+
+bool Fingerprint::isCurrent(const QString &fingerprint, const QDateTime &modified, const QString &file)
+{
+    QFileInfo info(file);
+
+    return !fingerprint.isEmpty() && modified.isValid() && info.exists()
+            && size(fingerprint) == info.size() && modified.toTime_t() == info.lastModified().toTime_t();
+}
+
+QHash<QString, QString> Fingerprint::search(const QStringList &fingerprints, const QStringList &roots,
+                                            QAtomicInt *scanned, QAtomicInt *cancelled)
+{
+    FingerprintSearch search;
+    search.scanned = scanned;
+    search.cancelled = cancelled;
+
+    foreach (const QString &fingerprint, fingerprints) {
+        if (size(fingerprint) <= 0 || search.fingerprints.contains(fingerprint))
+            continue;
+        search.fingerprints.insert(fingerprint);
+        search.sizes.insert(size(fingerprint));
+    }
+
+    search.remaining.fetchAndStoreOrdered(search.fingerprints.count());
+    if (search.fingerprints.isEmpty())
+        return search.found;
+
+    // a root inside another one is walked by the other one
+    QStringList directories;
+    foreach (const QString &root, roots) {
+        QString directory = QDir(root).absolutePath();
+        if (root.isEmpty() || !QDir(directory).exists() || directories.contains(directory))
+            continue;
+
+        bool inside = false;
+        foreach (const QString &other, roots)
+            if (!other.isEmpty() && directory.startsWith(QDir(other).absolutePath() + "/"))
+                inside = true;
+
+        if (!inside)
+            directories << directory;
+    }
+
+    // one walker per subdirectory, and one for the files of the root
+    QThreadPool pool;
+
+    foreach (const QString &directory, directories) {
+        pool.start(new FingerprintWalk(directory, false, &search));
+
+        QDir root(directory);
+        foreach (const QString &child, root.entryList(QDir::Dirs | QDir::Readable | QDir::NoDotAndDotDot))
+            pool.start(new FingerprintWalk(root.filePath(child), true, &search));
+    }
+    pool.waitForDone();
+
+    return search.found;
+}
+
+/***********************************************************************\
+                             SEARCH THREAD
+\***********************************************************************/
+
+FingerprintSearcher::FingerprintSearcher(QObject *parent) :
+    QObject(parent),
+    _thread(NULL),
+    _timer(new QTimer(this))
+{
+    connect(_timer, SIGNAL(timeout()), this, SLOT(updateProgress()));
+}
+
+FingerprintSearcher::~FingerprintSearcher()
+{
+    if (_thread != NULL) {
+        disconnect(_thread, SIGNAL(finished()), this, SLOT(searchFinished()));
+        _cancelled.fetchAndStoreOrdered(1);
+        _thread->wait();
+    }
+}
+
+void FingerprintSearcher::start(const QStringList &fingerprints, const QStringList &roots)
+{
+    // a search cancelled but not ended yet
+    if (_thread != NULL) {
+        disconnect(_thread, SIGNAL(finished()), this, SLOT(searchFinished()));
+        _cancelled.fetchAndStoreOrdered(1);
+        _thread->wait();
+        delete _thread;
+        _thread = NULL;
+    }
+
+    _found.clear();
+    _scanned.fetchAndStoreOrdered(0);
+    _cancelled.fetchAndStoreOrdered(0);
+
+    _thread = new FingerprintThread(fingerprints, roots, &_scanned, &_cancelled, this);
+    connect(_thread, SIGNAL(finished()), this, SLOT(searchFinished()));
+    _thread->start(QThread::LowPriority);
+    _timer->start(PROGRESS_INTERVAL);
+}
+
+void FingerprintSearcher::cancel()
+{
+    if (_thread != NULL)
+        _cancelled.fetchAndStoreOrdered(1);
+}
+
+void FingerprintSearcher::updateProgress()
+{
+    emit progress(_scanned.fetchAndAddOrdered(0));
+}
+
+void FingerprintSearcher::searchFinished()
+{
+    if (_thread == NULL)
+        return;
+
+    _timer->stop();
+    _found = _thread->found;
+    _thread->deleteLater();
+    _thread = NULL;
+
+    emit finished();
+}
@@ -0,0 +1,199 @@
+/**********************************************************************************
+ * This file is part of Open Projection Program (OPP).
+ *
+ * Copyright (C) 2013 Catalogue Ouvert du Cinéma <dev@cinemaouvert.fr>
+ *
+ * Authors: Jerome Blanchi <d.j.a.y@free.fr>
+ *
+ * Open Projection Program is an initiative of Catalogue Ouvert du Cinéma.
+ * The software was developed by four students of University of Poitiers
+ * as school project.
+ *
+ * Open Projection Program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Open Projection Program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Open Projection Program. If not, see <http://www.gnu.org/licenses/>.
+ **********************************************************************************/
+
+#ifndef FINGERPRINT_H
+#define FINGERPRINT_H
+
+#include <QObject>
+#include <QAtomicInt>
+#include <QByteArray>
+#include <QDateTime>
+#include <QHash>
+#include <QString>
+#include <QStringList>
+
+class QTimer;
+class FingerprintThread;
+
+/**
+ * @brief Fast fingerprint of the content of a media file, to find it again when moved
+ *
+ * The fingerprint is the size of the file and a 64 bits xxHash of SAMPLES
+ * blocks of BLOCK_SIZE spread from the head to the tail, read through a
+ * mapping of the file. It reads a few hundred KB whatever the size, so
+ * thousands of files are compared in seconds, several at once.
+ */
+class Fingerprint
+{
+public:
+    /**
+     * @brief Compute the fingerprint of a file
+     * @param file The file
+     * @return The fingerprint, empty if the file can not be read or is empty
+     */
+    static QString compute(const QString &file);
+
+    /**
+     * @brief Compute the fingerprints of files in parallel
+     * @param files The files
+     * @return The fingerprints, in the order of the files
+     */
+    static QStringList compute(const QStringList &files);
+
+    /**
+     * @brief Compute the 64 bits xxHash of bytes, as chained over the blocks of a file
+     * @param data The bytes
+     * @param seed The seed, the hash of the previous block
+     * @return The hash
+     */
+    static quint64 hash(const QByteArray &data, quint64 seed = 0);
+
+    /**
+     * @brief Get the size of the file of a fingerprint
+     * @return The size, -1 if the fingerprint is not valid
+     */
+    static qint64 size(const QString &fingerprint);
+
+    /**
+     * @brief Allow to know if a fingerprint still matches a file without reading it
+     * @param fingerprint The fingerprint
+     * @param modified The modification date of the file when the fingerprint was computed
+     * @param file The file
+     * @return True if the size and the modification date (to the second) did not change
+     */
+    static bool isCurrent(const QString &fingerprint, const QDateTime &modified, const QString &file);
+
+    /**
+     * @brief Search files by fingerprint under directories
+     *
+     * The directories are walked in parallel, only the files of the size of
+     * a fingerprint are read. The walk stops when every fingerprint is found.
+     * The fingerprints of empty files are ignored.
+     *
+     * @param fingerprints The fingerprints to find
+     * @param roots The directories to walk
+     * @param scanned Counts the files walked, may be NULL
+     * @param cancelled Stops the walk when set by another thread, may be NULL
+     * @return The file found for each fingerprint found
+     */
+    static QHash<QString, QString> search(const QStringList &fingerprints, const QStringList &roots,
+                                          QAtomicInt *scanned = NULL, QAtomicInt *cancelled = NULL);
+
+    /**
+     * @brief SAMPLES Blocks hashed, the first at the head and the last at the tail
+     */
+    static const int SAMPLES = 3;
+
+    /**
+     * @brief BLOCK_SIZE Bytes of a block
+     */
+    static const int BLOCK_SIZE = 64 * 1024;
+};
+
+/**
+ * @brief Run Fingerprint::search in its own thread, with progress and cancel
+ */
+class FingerprintSearcher : public QObject
+{
+    Q_OBJECT
+public:
+    explicit FingerprintSearcher(QObject *parent = 0);
+    ~FingerprintSearcher();
+
+    /**
+     * @brief Start a search, finished() is emitted when done
+     * @param fingerprints The fingerprints to find
+     * @param roots The directories to walk
+     */
+    void start(const QStringList &fingerprints, const QStringList &roots);
+
+    /**
+     * @brief Allow to know if a search is running
+     * @return True if running, false otherwise
+     */
+    inline bool isRunning() const { return _thread != NULL; }
+
+    /**
+     * @brief Get the result of the last search
+     * @return The file found for each fingerprint found, partial if cancelled
+     */
+    inline QHash<QString, QString> found() const { return _found; }
+
+    /**
+     * @brief PROGRESS_INTERVAL Period of the progress signal (ms)
+     */
+    static const int PROGRESS_INTERVAL = 250;
+
+public slots:
+    /**
+     * @brief Stop the running search, finished() is still emitted
+     */
+    void cancel();
+
+signals:
+    /**
+     * @brief Emitted periodically during the search
+     * @param scanned The number of files walked
+     */
+    void progress(int scanned);
+
+    /**
+     * @brief Emitted when the search is done or cancelled
+     */
+    void finished();
+
+private slots:
+    /**
+     * @brief Emit the progress of the running search
+     */
+    void updateProgress();
+
+    /**
+     * @brief Keep the result of the search which just ended
+     */
+    void searchFinished();
+
+private:
+    /**
+     * @brief _thread The running search, NULL if none
+     */
+    FingerprintThread *_thread;
+
+    /**
+     * @brief _timer Emit the progress periodically
+     */
+    QTimer *_timer;
+
+    /**
+     * @brief _scanned The files walked by the running search
+     */
+    QAtomicInt _scanned;
+
+    QAtomicInt _cancelled;
+
+    QHash<QString, QString> _found;
+};
+
+#endif // FINGERPRINT_H
@@ -0,0 +1,463 @@
+/**********************************************************************************
+ * This file is part of Open Projection Program (OPP).
+ *
+ * Copyright (C) 2013 Catalogue Ouvert du Cinéma <dev@cinemaouvert.fr>
+ *
+ * Authors: Jerome Blanchi <d.j.a.y@free.fr>
+ *
+ * Open Projection Program is an initiative of Catalogue Ouvert du Cinéma.
+ * The software was developed by four students of University of Poitiers
+ * as school project.
+ *
+ * Open Projection Program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Open Projection Program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Open Projection Program. If not, see <http://www.gnu.org/licenses/>.
+ **********************************************************************************/
+
+#include "frameextractor.h"
+
+#include <QTimer>
+#include <QFileInfo>
+#include <QDebug>
+#include <QMutexLocker>
+
+#include "jobscheduler.h"
+#include "media.h"
+#include "videotrack.h"
+#include "proxygenerator.h"
+#include "videoanalyzer.h"
+#include "VLCApplication.h"
+
+QCache<QString, QList<FrameExtractor::Frame> > FrameExtractor::s_filmstripCache(FILMSTRIP_CACHE_SIZE);
+
+FrameExtractor::FrameExtractor(VLCApplication *vlcApp, QObject *parent) :
+    QObject(parent),
+    _vlcApp(vlcApp),
+    _player(NULL),
+    _media(NULL),
+    _fastSeek(false),
+    _pending(false),
+    _isPoster(false),
+    _index(0),
+    _timeout(new QTimer(this)),
+    _generation(0),
+    _wanted(false),
+    _target(0),
+    _skipped(0)
+{
+    _timeout->setSingleShot(true);
+    connect(_timeout, SIGNAL(timeout()), this, SLOT(frameTimeout()));
+
+    _vlcApp->jobScheduler()->addClient(this, JobScheduler::DecodeResource, JobScheduler::NormalPriority);
+}
+
+FrameExtractor::~FrameExtractor()
+{
+    cancel();
+    _vlcApp->jobScheduler()->removeClient(this);
+}
+
+QSize FrameExtractor::frameSize(Media *media, int width)
+{
+    QSize size(width, width * 9 / 16);
+
+    QList<VideoTrack> tracks = media->videoTracks();
+    if (!tracks.isEmpty() && tracks.first().width() > 0 && tracks.first().height() > 0)
+        size.setHeight(width * tracks.first().height() / tracks.first().width());
+
+    // libvlc chromas want even dimensions
+    size.setHeight(size.height() & ~1);
+
+    return size;
+}
+
+void FrameExtractor::extractFilmstrip(Media *media, int count, const QSize &size)
+{
+    cancel();
+
+    if (count <= 0)
+        return;
+
+    // a file replaced since has another key
+    const QString key = filmstripKey(media->location());
+    QList<Frame> *cached = s_filmstripCache.object(key);
+    if (cached != NULL && cached->count() == count) {
+        QList<Frame> frames = *cached;
+        for (int i = 0; i < frames.count(); ++i)
+            emit frameExtracted(i, frames.at(i).time, frames.at(i).image);
+        emit finished();
+        return;
+    }
+
+    QList<int> times;
+    int step = media->duration() / count;
+    for (int i = 0; i < count; ++i)
+        times << step / 2 + i * step;
+
+    start(media->location(), times, size, true, key);
+}
+
+void FrameExtractor::extractPoster(Media *media, const QSize &size)
+{
+    cancel();
+
+    // keyframes, away from the leaders and the credits
+    QList<int> times;
+    if (media->duration() > 0)
+        for (int i = 1; i <= POSTER_CANDIDATES; ++i)
+            times << (qint64)media->duration() * i / (POSTER_CANDIDATES + 1);
+
+    start(media->location(), times, size, true, QString());
+    _isPoster = isRunning();
+}
+
+double FrameExtractor::posterScore(const QImage &image)
+{
+    if (image.isNull())
+        return 0;
+
+    QImage small = image.width() > POSTER_SCORE_WIDTH
+            ? image.scaledToWidth(POSTER_SCORE_WIDTH, Qt::FastTransformation)
+            : image;
+    small = small.convertToFormat(QImage::Format_RGB32);
+
+    int width = small.width();
+    int height = small.height();
+    if (height < 3)
+        return 0;
+
+    // luma of the RGB pixels, BT.601 weights
+    QByteArray luma(width * height, 0);
+    uchar *y = (uchar *)luma.data();
+    for (int row = 0; row < height; ++row) {
+        const QRgb *pixels = (const QRgb *)small.constScanLine(row);
+        for (int column = 0; column < width; ++column)
+            *y++ = (77 * qRed(pixels[column]) + 150 * qGreen(pixels[column]) + 29 * qBlue(pixels[column])) >> 8;
+    }
+
+    double mean, deviation;
+    const uchar *samples = (const uchar *)luma.constData();
+    VideoAnalyzer::statistics(samples, width * height, &mean, &deviation);
+
+    quint64 detail = 0;
+    for (int row = 1; row < height - 1; ++row)
+        detail += VideoAnalyzer::curvature(samples + (row - 1) * width, samples + row * width,
+                                           samples + (row + 1) * width, width);
+    double sharpness = (double)detail / (width * (height - 2));
+
+    return deviation + 2 * sharpness - qAbs(mean - 128) / 2;
+}
+
+void FrameExtractor::extract(const QString &location, const QList<int> &times, const QSize &size, bool fastSeek)
+{
+    start(location, times, size, fastSeek, QString());
+}
+
+void FrameExtractor::removeFilmstrips(const QString &location)
+{
+    foreach (const QString &key, s_filmstripCache.keys())
+        if (key.startsWith(location + '|'))
+            s_filmstripCache.remove(key);
+}
+
+QString FrameExtractor::filmstripKey(const QString &location)
+{
+    QFileInfo info(location);
+
+    return location + '|' + QString::number(info.size()) + '|' + info.lastModified().toString(Qt::ISODate);
+}
+
+void FrameExtractor::start(const QString &location, const QList<int> &times, const QSize &size, bool fastSeek,
+                           const QString &filmstripKey)
+{
+    cancel();
+
+    if (times.isEmpty() || size.isEmpty())
+        return;
+
+    _location = location;
+    _times = times;
+    _frames.clear();
+    _fastSeek = fastSeek;
+    _filmstripKey = filmstripKey;
+    _index = 0;
+
+    _buffer = QImage(size, QImage::Format_RGB32);
+    _buffer.fill(0);
+
+    // the notifications still queued for the previous extraction are dropped
+    {
+        QMutexLocker locker(&_mutex);
+        _generation++;
+    }
+
+    _pending = true;
+    startJobs();
+}
+
+void FrameExtractor::startJobs()
+{
+    if (!_pending || _player != NULL)
+        return;
+
+    // the scheduler calls again when a slot is free
+    if (!_vlcApp->jobScheduler()->acquire(this))
+        return;
+
+    _pending = false;
+
+    // the cached frames keep the master location, the proxy is only decoded
+    QString decoded = ProxyGenerator::previewLocation(_location, _buffer.size());
+
+    _media = libvlc_media_new_path(_vlcApp->vlcInstance(), decoded.toStdString().data());
+    libvlc_media_add_option(_media, ":noaudio");
+    libvlc_media_add_option(_media, ":no-spu");
+    if (_fastSeek)
+        libvlc_media_add_option(_media, ":input-fast-seek");
+
+    // from the pool of the players rendering into memory, the callbacks are set again
+    _player = _vlcApp->acquirePlayer("FrameExtractor", true);
+    libvlc_media_player_set_media(_player, _media);
+    libvlc_video_set_callbacks(_player, lockCallback, NULL, displayCallback, this);
+    libvlc_video_set_format(_player, "RV32", _buffer.width(), _buffer.height(), _buffer.width() * 4);
+
+    libvlc_event_manager_t *events = libvlc_media_player_event_manager(_player);
+    libvlc_event_attach(events, libvlc_MediaPlayerPlaying, eventCallback, this);
+    libvlc_event_attach(events, libvlc_MediaPlayerEncounteredError, eventCallback, this);
+
+    _vlcApp->jobScheduler()->addPlayer(this, _player);
+
+    libvlc_media_player_play(_player);
+    _timeout->start(FRAME_TIMEOUT);
+}
+
+void FrameExtractor::cancel()
+{
+    if (_pending) {
+        _pending = false;
+        _vlcApp->jobScheduler()->withdraw(this);
+        _times.clear();
+        _filmstripKey.clear();
+        _isPoster = false;
+        emit finished();
+        return;
+    }
+
+    if (_player == NULL)
+        return;
+
+    _times.clear();
+    _filmstripKey.clear();
+    _isPoster = false;
+    finish();
+}
+
+void FrameExtractor::startSeeking(int generation)
+{
+    if (_player == NULL || _index != 0 || generation != _generation)
+        return;
+
+    seekNext();
+}
+
+void FrameExtractor::seekNext()
+{
+    if (_player == NULL)
+        return;
+
+    if (_index >= _times.count()) {
+        finish();
+        return;
+    }
+
+    {
+        QMutexLocker locker(&_mutex);
+        _target = _times.at(_index);
+        _skipped = 0;
+        _captured = QImage();
+        _wanted = true;
+    }
+
+    libvlc_media_player_set_time(_player, _target);
+    _timeout->start(FRAME_TIMEOUT);
+}
+
+void FrameExtractor::frameCaptured(int generation)
+{
+    if (_player == NULL || generation != _generation)
+        return;
+
+    QImage image;
+    {
+        QMutexLocker locker(&_mutex);
+        image = _captured;
+        _captured = QImage();
+    }
+
+    // notification left over from a previous seek
+    if (image.isNull())
+        return;
+
+    _timeout->stop();
+
+    Frame frame;
+    frame.time = _times.at(_index);
+    frame.image = image;
+    _frames << frame;
+
+    emit frameExtracted(_index, frame.time, image);
+
+    _index++;
+    seekNext();
+}
+
+void FrameExtractor::frameTimeout()
+{
+    if (_player == NULL)
+        return;
+
+    {
+        QMutexLocker locker(&_mutex);
+        _wanted = false;
+    }
+
+    // paused by the scheduler during the projection, wait for the resume
+    if (libvlc_media_player_get_state(_player) == libvlc_Paused) {
+        {
+            QMutexLocker locker(&_mutex);
+            _wanted = true;
+        }
+        _timeout->start(FRAME_TIMEOUT);
+        return;
+    }
+
+    qDebug() << "Frame extraction: no frame at" << (_index < _times.count() ? _times.at(_index) : -1) << "ms in" << _location;
+
+    // the player never started, give up
+    if (!libvlc_media_player_is_playing(_player)) {
+        _filmstripKey.clear();
+        finish();
+        return;
+    }
+
+    _index++;
+    seekNext();
+}
+
+void FrameExtractor::finish()
+{
+    _timeout->stop();
+
+    if (_player != NULL) {
+        libvlc_event_manager_t *events = libvlc_media_player_event_manager(_player);
+        libvlc_event_detach(events, libvlc_MediaPlayerPlaying, eventCallback, this);
+        libvlc_event_detach(events, libvlc_MediaPlayerEncounteredError, eventCallback, this);
+
+        // a frame caught before the player stopped is not taken by the next extraction
+        {
+            QMutexLocker locker(&_mutex);
+            _wanted = false;
+            _captured = QImage();
+        }
+
+        _vlcApp->jobScheduler()->removePlayer(_player);
+
+        _vlcApp->releasePlayer(_player);
+        libvlc_media_release(_media);
+        _player = NULL;
+        _media = NULL;
+
+        _vlcApp->jobScheduler()->release(this);
+    }
+
+    if (!_filmstripKey.isEmpty() && _frames.count() == _times.count()) {
+        int cost = 0;
+        foreach (const Frame &frame, _frames)
+            cost += frame.image.byteCount() / 1024;
+        s_filmstripCache.insert(_filmstripKey, new QList<Frame>(_frames), cost);
+    }
+
+    _filmstripKey.clear();
+
+    // the best of the candidates decoded, black frames, fades and title cards lose
+    if (_isPoster) {
+        _isPoster = false;
+        QImage poster;
+        double bestScore = 0;
+        foreach (const Frame &frame, _frames) {
+            double score = posterScore(frame.image);
+            if (poster.isNull() || score > bestScore) {
+                poster = frame.image;
+                bestScore = score;
+            }
+        }
+        _frames.clear();
+
+        emit posterExtracted(_location, poster);
+    }
+
+    emit finished();
+}
+
+/***********************************************************************\
+                          LIBVLC CALLBACKS
+\***********************************************************************/
+
+void *FrameExtractor::lockCallback(void *opaque, void **planes)
+{
+    FrameExtractor *extractor = (FrameExtractor *)opaque;
+
+    *planes = extractor->_buffer.bits();
+
+    return NULL;
+}
+
+void FrameExtractor::displayCallback(void *opaque, void *picture)
+{
+    Q_UNUSED(picture);
+    FrameExtractor *extractor = (FrameExtractor *)opaque;
+
+    QMutexLocker locker(&extractor->_mutex);
+
+    if (!extractor->_wanted)
+        return;
+
+    // frames still in the pipe from before the seek, or before the target with a keyframe seek
+    libvlc_time_t time = libvlc_media_player_get_time(extractor->_player);
+    if (qAbs(time - extractor->_target) > FRAME_TOLERANCE && ++extractor->_skipped < MAX_SKIPPED_FRAMES)
+        return;
+
+    extractor->_captured = extractor->_buffer.copy();
+    extractor->_wanted = false;
+
+    QMetaObject::invokeMethod(extractor, "frameCaptured", Qt::QueuedConnection,
+                              Q_ARG(int, extractor->_generation));
+}
+
+void FrameExtractor::eventCallback(const libvlc_event_t *event, void *data)
+{
+    FrameExtractor *extractor = (FrameExtractor *)data;
+
+    switch (event->type) {
+    case libvlc_MediaPlayerPlaying: {
+        QMutexLocker locker(&extractor->_mutex);
+        QMetaObject::invokeMethod(extractor, "startSeeking", Qt::QueuedConnection,
+                                  Q_ARG(int, extractor->_generation));
+        break;
+    }
+    case libvlc_MediaPlayerEncounteredError:
+        QMetaObject::invokeMethod(extractor, "frameTimeout", Qt::QueuedConnection);
+        break;
+    default:
+        break;
+    }
+}
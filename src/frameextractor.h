@@ -0,0 +1,344 @@
+/**********************************************************************************
+ * This file is part of Open Projection Program (OPP).
+ *
+ * Copyright (C) 2013 Catalogue Ouvert du Cinéma <dev@cinemaouvert.fr>
+ *
+ * Authors: Jerome Blanchi <d.j.a.y@free.fr>
+ *
+ * Open Projection Program is an initiative of Catalogue Ouvert du Cinéma.
+ * The software was developed by four students of University of Poitiers
+ * as school project.
+ *
+ * Open Projection Program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Open Projection Program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Open Projection Program. If not, see <http://www.gnu.org/licenses/>.
+ **********************************************************************************/
+
+#ifndef FRAMEEXTRACTOR_H
+#define FRAMEEXTRACTOR_H
+
+#include <QObject>
+#include <QCache>
+#include <QImage>
+#include <QList>
+#include <QHash>
+#include <QMutex>
+#include <QSize>
+
+#include <vlc/vlc.h>
+
+class QTimer;
+class Media;
+class VLCApplication;
+
+/**
+ * @brief Decode frames of a media at given times into small images, in background
+ *
+ * The frames are rendered by libvlc into memory (no window), one seek per
+ * requested time. Filmstrips are kept in a cache, least recently used out,
+ * per media file version (location, size and date). Small
+ * images are decoded from the proxy of the media when it has one.
+ *
+ * The extractor is a client of the JobScheduler: an extraction waits for a
+ * decode slot and its player is throttled while projecting.
+ */
+class FrameExtractor : public QObject
+{
+    Q_OBJECT
+public:
+    explicit FrameExtractor(VLCApplication *vlcApp, QObject *parent = 0);
+    ~FrameExtractor();
+
+    /**
+     * @brief Start the extraction of the frames at the given times
+     * @param location The media location
+     * @param times The times of the frames in ms
+     * @param size The size of the extracted images
+     * @param fastSeek True to seek on keyframes (fast but approximative)
+     */
+    void extract(const QString &location, const QList<int> &times, const QSize &size, bool fastSeek = false);
+
+    /**
+     * @brief Start the extraction of count frames evenly spaced over the media
+     *
+     * If the filmstrip is already in cache, the frames are sent at once.
+     *
+     * @param media The media
+     * @param count The number of frames
+     * @param size The size of the extracted images
+     */
+    void extractFilmstrip(Media *media, int count, const QSize &size);
+
+    /**
+     * @brief Start the extraction of the best poster frame of a media
+     *
+     * POSTER_CANDIDATES keyframes spread over the media are extracted in
+     * background and scored by posterScore, the best one is sent by
+     * posterExtracted before finished, unless cancelled.
+     *
+     * @param media The media
+     * @param size The size of the image
+     */
+    void extractPoster(Media *media, const QSize &size);
+
+    /**
+     * @brief Allow to know if an extraction is running or waiting for a slot
+     * @return True if running, false otherwise
+     */
+    inline bool isRunning() const { return _player != NULL || _pending; }
+
+    /**
+     * @brief Drop the cached filmstrips of every version of a media file
+     * @param location The media location
+     */
+    static void removeFilmstrips(const QString &location);
+
+    /**
+     * @brief Compute the size of an image for a media keeping its aspect ratio
+     * @param media The media
+     * @param width The wanted width
+     * @return The size
+     */
+    static QSize frameSize(Media *media, int width);
+
+    /**
+     * @brief Score an image as a poster frame
+     *
+     * The image is downscaled to POSTER_SCORE_WIDTH, the score adds its
+     * contrast and its sharpness and subtracts its distance to mid grey, so
+     * black frames, fades and flat title cards lose.
+     *
+     * @param image The image
+     * @return The score, the higher the better
+     */
+    static double posterScore(const QImage &image);
+
+    /**
+     * @brief POSTER_CANDIDATES Frames compared to choose a poster frame
+     */
+    static const int POSTER_CANDIDATES = 5;
+
+    /**
+     * @brief POSTER_SCORE_WIDTH Width of the images scored
+     */
+    static const int POSTER_SCORE_WIDTH = 160;
+
+public slots:
+    /**
+     * @brief Stop the running extraction
+     */
+    void cancel();
+
+signals:
+    /**
+     * @brief Emitted each time a frame is decoded
+     * @param index The index of the frame in the requested times
+     * @param time The time of the frame in ms
+     * @param image The image
+     */
+    void frameExtracted(int index, int time, const QImage &image);
+
+    /**
+     * @brief Emitted at the end of a poster extraction, before finished
+     * @param location The media location
+     * @param poster The best candidate, null if no frame could be decoded
+     */
+    void posterExtracted(const QString &location, const QImage &poster);
+
+    /**
+     * @brief Emitted when every frame was handled or the extraction cancelled
+     */
+    void finished();
+
+private slots:
+    /**
+     * @brief Start the pending extraction when the scheduler gives a slot
+     */
+    void startJobs();
+
+    /**
+     * @brief Seek to the first frame once the player is playing
+     * @param generation The extraction the player started for
+     */
+    void startSeeking(int generation);
+
+    /**
+     * @brief Handle a frame caught by the display callback
+     * @param generation The extraction the frame was caught for
+     */
+    void frameCaptured(int generation);
+
+    /**
+     * @brief Skip a frame that never came
+     */
+    void frameTimeout();
+
+private:
+    /**
+     * @brief Frame extracted for a filmstrip
+     */
+    struct Frame {
+        int time;
+        QImage image;
+    };
+
+    /**
+     * @brief Seek to the next requested time or finish
+     */
+    void seekNext();
+
+    /**
+     * @brief Release the player and the media, fill the cache
+     */
+    void finish();
+
+    /**
+     * @brief libvlc video lock callback, give the buffer to decode into
+     */
+    static void *lockCallback(void *opaque, void **planes);
+
+    /**
+     * @brief libvlc video display callback, catch the wanted frame
+     */
+    static void displayCallback(void *opaque, void *picture);
+
+    /**
+     * @brief libvlc event callback
+     */
+    static void eventCallback(const libvlc_event_t *event, void *data);
+
+    /**
+     * @brief FRAME_TIMEOUT Time to wait for a frame before skipping it (ms)
+     */
+    static const int FRAME_TIMEOUT = 2000;
+
+    /**
+     * @brief FRAME_TOLERANCE Distance from the target to accept a frame (ms)
+     */
+    static const int FRAME_TOLERANCE = 250;
+
+    /**
+     * @brief MAX_SKIPPED_FRAMES Frames decoded after a seek before taking one anyway
+     */
+    static const int MAX_SKIPPED_FRAMES = 50;
+
+    /**
+     * @brief Start an extraction, waiting for a slot of the scheduler
+     * @param filmstripKey The key of the filmstrip cache, empty if the result is not cached
+     */
+    void start(const QString &location, const QList<int> &times, const QSize &size, bool fastSeek,
+               const QString &filmstripKey);
+
+    /**
+     * @brief Get the key of the filmstrips of a media file in the cache
+     * @return The location, the size and the date of the file
+     */
+    static QString filmstripKey(const QString &location);
+
+    /**
+     * @brief FILMSTRIP_CACHE_SIZE Size of the images of the filmstrip cache (KB)
+     */
+    static const int FILMSTRIP_CACHE_SIZE = 64 * 1024;
+
+    /**
+     * @brief s_filmstripCache Filmstrips already extracted, by filmstripKey, the cost in KB
+     */
+    static QCache<QString, QList<Frame> > s_filmstripCache;
+
+    VLCApplication *_vlcApp;
+
+    libvlc_media_player_t *_player;
+
+    libvlc_media_t *_media;
+
+    /**
+     * @brief _location The location of the media being extracted
+     */
+    QString _location;
+
+    /**
+     * @brief _fastSeek True to seek on keyframes
+     */
+    bool _fastSeek;
+
+    /**
+     * @brief _pending True while waiting for a slot of the scheduler
+     */
+    bool _pending;
+
+    /**
+     * @brief _times The requested times (ms)
+     */
+    QList<int> _times;
+
+    /**
+     * @brief _frames The extracted frames
+     */
+    QList<Frame> _frames;
+
+    /**
+     * @brief _isPoster True if the best frame must be sent by posterExtracted
+     */
+    bool _isPoster;
+
+    /**
+     * @brief _filmstripKey The key of the result in the filmstrip cache, empty if not cached
+     */
+    QString _filmstripKey;
+
+    /**
+     * @brief _index The index of the frame being extracted
+     */
+    int _index;
+
+    /**
+     * @brief _timeout Skip a frame if it is not decoded in time
+     */
+    QTimer *_timeout;
+
+    /**
+     * @brief _mutex Protect the fields shared with the decoding thread
+     */
+    QMutex _mutex;
+
+    /**
+     * @brief _buffer The image libvlc decodes into
+     */
+    QImage _buffer;
+
+    /**
+     * @brief _captured The last frame caught
+     */
+    QImage _captured;
+
+    /**
+     * @brief _generation The number of the extraction, notifications of the previous ones are ignored
+     */
+    int _generation;
+
+    /**
+     * @brief _wanted True while waiting for the frame at _target
+     */
+    bool _wanted;
+
+    /**
+     * @brief _target The time of the wanted frame (ms)
+     */
+    int _target;
+
+    /**
+     * @brief _skipped Number of frames decoded since the seek
+     */
+    int _skipped;
+};
+
+#endif // FRAMEEXTRACTOR_H
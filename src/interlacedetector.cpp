@@ -0,0 +1,147 @@
+/**********************************************************************************
+ * This file is part of Open Projection Program (OPP).
+ *
+ * Copyright (C) 2013 Catalogue Ouvert du Cinéma <dev@cinemaouvert.fr>
+ *
+ * Authors: Jerome Blanchi <d.j.a.y@free.fr>
+ *
+ * Open Projection Program is an initiative of Catalogue Ouvert du Cinéma.
+ * The software was developed by four students of University of Poitiers
+ * as school project.
+ *
+ * Open Projection Program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Open Projection Program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Open Projection Program. If not, see <http://www.gnu.org/licenses/>.
+ **********************************************************************************/
+
+#include "interlacedetector.h"
+
+#include <string.h>
+
+/**
+ * @brief Number of pictures of each kind
+ */
+class InterlaceMeasure : public VideoAnalyzer::Measure
+{
+public:
+    InterlaceMeasure() : progressive(0), topFirst(0), bottomFirst(0) {}
+
+    void startSegment(int index)
+    {
+        Q_UNUSED(index);
+
+        // the first picture of a segment has no previous picture
+        previous.clear();
+    }
+
+    void process(const uchar *luma, int width, int height, qint64 pts)
+    {
+        Q_UNUSED(pts);
+
+        if (previous.size() == width * height)
+            classify(luma, (const uchar *)previous.constData(), width, height);
+
+        previous.resize(width * height);
+        memcpy(previous.data(), luma, width * height);
+    }
+
+    void classify(const uchar *current, const uchar *last, int width, int height)
+    {
+        quint64 picture = 0;
+        quint64 top = 0;
+        quint64 bottom = 0;
+
+        for (int y = 1; y < height - 1; y++) {
+            const uchar *c = current + y * width;
+            const uchar *l = last + y * width;
+
+            picture += VideoAnalyzer::curvature(c - width, c, c + width, width);
+
+            // top: even lines of the picture and odd lines of the previous one, bottom: the opposite
+            if (y & 1) {
+                top += VideoAnalyzer::curvature(c - width, l, c + width, width);
+                bottom += VideoAnalyzer::curvature(l - width, c, l + width, width);
+            } else {
+                top += VideoAnalyzer::curvature(l - width, c, l + width, width);
+                bottom += VideoAnalyzer::curvature(c - width, l, c + width, width);
+            }
+        }
+
+        // the fields next in time weave with less detail
+        if (bottom * 100 > top * InterlaceDetector::FIELD_THRESHOLD)
+            topFirst++;
+        else if (top * 100 > bottom * InterlaceDetector::FIELD_THRESHOLD)
+            bottomFirst++;
+        else if (qMin(top, bottom) * 100 > picture * InterlaceDetector::PROGRESSIVE_THRESHOLD)
+            progressive++;
+        // else still picture, nothing to learn
+    }
+
+    int progressive;
+    int topFirst;
+    int bottomFirst;
+
+    QByteArray previous;
+};
+
+InterlaceDetector::InterlaceDetector(VLCApplication *vlcApp, QObject *parent) :
+    VideoAnalyzer(vlcApp, 0, 0, parent)
+{
+}
+
+QList<VideoAnalyzer::Segment> InterlaceDetector::segments(Media *media)
+{
+    int duration = media->getOriginalDuration();
+
+    if (duration <= 2 * SAMPLES * SAMPLE_LENGTH)
+        return VideoAnalyzer::segments(media);
+
+    QList<Segment> segments;
+    for (int i = 0; i < SAMPLES; i++) {
+        Segment segment;
+        segment.start = (qint64)duration * (2 * i + 1) / (2 * SAMPLES);
+        segment.stop = segment.start + SAMPLE_LENGTH;
+        segments.append(segment);
+    }
+
+    return segments;
+}
+
+VideoAnalyzer::Measure *InterlaceDetector::createMeasure(Media *media)
+{
+    Q_UNUSED(media);
+
+    return new InterlaceMeasure;
+}
+
+bool InterlaceDetector::storeMeasure(Media *media, Measure *measure)
+{
+    const InterlaceMeasure *counts = (const InterlaceMeasure *)measure;
+    int interlaced = counts->topFirst + counts->bottomFirst;
+    int total = counts->progressive + interlaced;
+
+    if (total < MIN_PICTURES)
+        return false;
+
+    int share = interlaced * 100 / total;
+    ScanType fieldOrder = counts->topFirst >= counts->bottomFirst ? InterlacedTff : InterlacedBff;
+
+    // 3:2 pulldown combs 2 pictures out of 5
+    if (share <= 10)
+        media->setScanType(Progressive);
+    else if (share >= 25 && share <= 55)
+        media->setScanType(Telecined);
+    else
+        media->setScanType(fieldOrder);
+
+    return true;
+}
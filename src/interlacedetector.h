@@ -0,0 +1,88 @@
+/**********************************************************************************
+ * This file is part of Open Projection Program (OPP).
+ *
+ * Copyright (C) 2013 Catalogue Ouvert du Cinéma <dev@cinemaouvert.fr>
+ *
+ * Authors: Jerome Blanchi <d.j.a.y@free.fr>
+ *
+ * Open Projection Program is an initiative of Catalogue Ouvert du Cinéma.
+ * The software was developed by four students of University of Poitiers
+ * as school project.
+ *
+ * Open Projection Program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Open Projection Program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Open Projection Program. If not, see <http://www.gnu.org/licenses/>.
+ **********************************************************************************/
+
+#ifndef INTERLACEDETECTOR_H
+#define INTERLACEDETECTOR_H
+
+#include "videoanalyzer.h"
+
+/**
+ * @brief Detect the scan type of media in background
+ *
+ * Short segments spread over each media are decoded at full height, the
+ * combing needs every line. Each picture is compared with three frames: as
+ * is, and woven with the other field of the previous picture in each field
+ * order. The frame with the least vertical detail tells how the picture was
+ * shot. Telecined video mixes progressive and combed pictures.
+ */
+class InterlaceDetector : public VideoAnalyzer
+{
+    Q_OBJECT
+public:
+    explicit InterlaceDetector(VLCApplication *vlcApp, QObject *parent = 0);
+
+    /**
+     * @brief SAMPLES Number of segments decoded over a media
+     */
+    static const int SAMPLES = 8;
+
+    /**
+     * @brief SAMPLE_LENGTH Length of a segment (ms)
+     */
+    static const int SAMPLE_LENGTH = 2000;
+
+    /**
+     * @brief MIN_PICTURES Classified pictures needed to decide
+     */
+    static const int MIN_PICTURES = 20;
+
+    /**
+     * @brief FIELD_THRESHOLD Detail of the wrong field order over the right one (percent)
+     */
+    static const int FIELD_THRESHOLD = 110;
+
+    /**
+     * @brief PROGRESSIVE_THRESHOLD Detail of the woven frames over the picture (percent)
+     */
+    static const int PROGRESSIVE_THRESHOLD = 150;
+
+protected:
+    /**
+     * @brief Decode SAMPLES segments spread over the media, the whole media if short
+     */
+    QList<Segment> segments(Media *media);
+
+    /**
+     * @brief Create a measure counting the pictures of each kind
+     */
+    Measure *createMeasure(Media *media);
+
+    /**
+     * @brief Store the scan type in the media
+     */
+    bool storeMeasure(Media *media, Measure *measure);
+};
+
+#endif // INTERLACEDETECTOR_H
@@ -0,0 +1,365 @@
+/**********************************************************************************
+ * This file is part of Open Projection Program (OPP).
+ *
+ * Copyright (C) 2013 Catalogue Ouvert du Cinéma <dev@cinemaouvert.fr>
+ *
+ * Authors: Jerome Blanchi <d.j.a.y@free.fr>
+ *
+ * Open Projection Program is an initiative of Catalogue Ouvert du Cinéma.
+ * The software was developed by four students of University of Poitiers
+ * as school project.
+ *
+ * Open Projection Program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Open Projection Program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Open Projection Program. If not, see <http://www.gnu.org/licenses/>.
+ **********************************************************************************/
+
+#include "jobscheduler.h"
+
+#include <QMutexLocker>
+#include <QThread>
+#include <QTimer>
+
+#if defined(Q_OS_LINUX)
+# include <sys/syscall.h>
+# include <unistd.h>
+#endif
+
+#include "MediaPlayer.h"
+
+#if defined(Q_OS_LINUX) && defined(SYS_ioprio_set)
+/**
+ * @brief IOPRIO_WHO_PROCESS The calling thread when the id is 0
+ */
+static const int IOPRIO_WHO_PROCESS = 1;
+
+/**
+ * @brief IOPRIO_LOWEST Best effort class, lowest level
+ */
+static const int IOPRIO_LOWEST = (2 << 13) | 7;
+#endif
+
+JobScheduler::JobScheduler(QObject *parent) :
+    QObject(parent),
+    _playing(false),
+    _readTokens(READ_BURST),
+    _timer(new QTimer(this))
+{
+    _running[DecodeResource] = 0;
+    _running[IoResource] = 0;
+
+    connect(_timer, SIGNAL(timeout()), this, SLOT(tick()));
+}
+
+void JobScheduler::addClient(QObject *client, ResourceClass resource, Priority priority)
+{
+    Client entry;
+    entry.resource = resource;
+    entry.priority = priority;
+    entry.running = 0;
+    entry.waiting = false;
+
+    _clients.insert(client, entry);
+}
+
+void JobScheduler::removeClient(QObject *client)
+{
+    if (!_clients.contains(client))
+        return;
+
+    Client entry = _clients.take(client);
+
+    foreach (libvlc_media_player_t *player, _players.keys())
+        if (_players.value(player).client == client)
+            _players.remove(player);
+
+    _running[entry.resource] -= entry.running;
+    wake(entry.resource);
+    notifyActivity();
+}
+
+void JobScheduler::setPriority(QObject *client, Priority priority)
+{
+    if (_clients.contains(client))
+        _clients[client].priority = priority;
+}
+
+bool JobScheduler::acquire(QObject *client)
+{
+    if (!_clients.contains(client))
+        return false;
+
+    Client &entry = _clients[client];
+    bool free = _running[entry.resource] < maxJobs(entry.resource);
+
+    // the clients of higher priority waiting for the same resource go first
+    QHash<QObject*, Client>::const_iterator it;
+    for (it = _clients.constBegin(); free && it != _clients.constEnd(); ++it)
+        if (it.key() != client && it.value().waiting
+                && it.value().resource == entry.resource && it.value().priority > entry.priority)
+            free = false;
+
+    if (!free) {
+        entry.waiting = true;
+        notifyActivity();
+        return false;
+    }
+
+    entry.waiting = false;
+    entry.running++;
+    _running[entry.resource]++;
+    notifyActivity();
+
+    return true;
+}
+
+void JobScheduler::release(QObject *client)
+{
+    if (!_clients.contains(client) || _clients.value(client).running == 0)
+        return;
+
+    Client &entry = _clients[client];
+    entry.running--;
+    _running[entry.resource]--;
+
+    wake(entry.resource);
+    notifyActivity();
+}
+
+void JobScheduler::withdraw(QObject *client)
+{
+    if (!_clients.contains(client))
+        return;
+
+    // the clients of lower priority were waiting behind it, or the slot it was woken for is free
+    _clients[client].waiting = false;
+    wake(_clients.value(client).resource);
+    notifyActivity();
+}
+
+void JobScheduler::addPlayer(QObject *client, libvlc_media_player_t *player)
+{
+    Player entry;
+    entry.client = client;
+    entry.readBytes = 0;
+    entry.paused = false;
+
+    _players.insert(player, entry);
+}
+
+void JobScheduler::removePlayer(libvlc_media_player_t *player)
+{
+    _players.remove(player);
+}
+
+void JobScheduler::startPlayer(QObject *client, libvlc_media_player_t *player)
+{
+    // libvlc starts its input thread from the calling thread
+    int priority = lowerIoPriority();
+    libvlc_media_player_play(player);
+    restoreIoPriority(priority);
+
+    addPlayer(client, player);
+}
+
+int JobScheduler::lowerIoPriority()
+{
+#if defined(Q_OS_LINUX) && defined(SYS_ioprio_set)
+    int priority = syscall(SYS_ioprio_get, IOPRIO_WHO_PROCESS, 0);
+    syscall(SYS_ioprio_set, IOPRIO_WHO_PROCESS, 0, IOPRIO_LOWEST);
+    return priority;
+#else
+    return -1;
+#endif
+}
+
+void JobScheduler::restoreIoPriority(int priority)
+{
+#if defined(Q_OS_LINUX) && defined(SYS_ioprio_set)
+    if (priority >= 0)
+        syscall(SYS_ioprio_set, IOPRIO_WHO_PROCESS, 0, priority);
+#else
+    Q_UNUSED(priority);
+#endif
+}
+
+void JobScheduler::addReadBytes(qint64 bytes)
+{
+    QMutexLocker locker(&_readMutex);
+
+    if (_playing)
+        _readTokens -= bytes;
+}
+
+bool JobScheduler::mayRead() const
+{
+    QMutexLocker locker(&_readMutex);
+
+    return !_playing || _readTokens > 0;
+}
+
+void JobScheduler::watchPlayer(MediaPlayer *player)
+{
+    _watched.append(player);
+
+    connect(player, SIGNAL(playing(bool)), this, SLOT(updatePlaying()));
+    connect(player, SIGNAL(paused()), this, SLOT(updatePlaying()));
+    connect(player, SIGNAL(stopped()), this, SLOT(updatePlaying()));
+    connect(player, SIGNAL(end()), this, SLOT(updatePlaying()));
+}
+
+void JobScheduler::cancelAll()
+{
+    foreach (QObject *client, _clients.keys())
+        QMetaObject::invokeMethod(client, "cancel");
+}
+
+void JobScheduler::updatePlaying()
+{
+    bool playing = false;
+
+    foreach (MediaPlayer *player, _watched)
+        if (player != NULL && player->isPlaying())
+            playing = true;
+
+    if (playing == _playing)
+        return;
+
+    {
+        QMutexLocker locker(&_readMutex);
+        _playing = playing;
+        if (_playing)
+            _readTokens = READ_BURST;
+    }
+
+    if (_playing) {
+        // what was read before the projection is free
+        readBytes();
+        _timer->start(TICK);
+    } else {
+        _timer->stop();
+    }
+
+    updateThrottle();
+
+    // the number of slots changed
+    wake(DecodeResource);
+    wake(IoResource);
+    notifyActivity();
+}
+
+void JobScheduler::tick()
+{
+    qint64 read = readBytes();
+
+    {
+        QMutexLocker locker(&_readMutex);
+        _readTokens = qMin((qint64)READ_BURST, _readTokens + (qint64)PLAYING_READ_RATE * TICK / 1000 - read);
+    }
+
+    updateThrottle();
+}
+
+int JobScheduler::maxJobs(ResourceClass resource) const
+{
+    if (resource == IoResource)
+        return _playing ? PLAYING_IO_JOBS : IO_JOBS;
+
+    // a decoder is about one core, keep one for the GUI and the playback
+    return _playing ? PLAYING_DECODE_JOBS : qMax(1, QThread::idealThreadCount() - 1);
+}
+
+void JobScheduler::wake(ResourceClass resource)
+{
+    // one client per free slot, the others are woken by the next release
+    int free = maxJobs(resource) - _running[resource];
+
+    // queued calls run in order, the highest priorities take the slots first
+    for (int priority = HighPriority; priority >= LowPriority; priority--) {
+        foreach (QObject *client, _clients.keys()) {
+            if (free <= 0)
+                return;
+
+            Client &entry = _clients[client];
+            if (entry.waiting && entry.resource == resource && entry.priority == priority) {
+                entry.waiting = false;
+                QMetaObject::invokeMethod(client, "startJobs", Qt::QueuedConnection);
+                free--;
+            }
+        }
+    }
+}
+
+qint64 JobScheduler::readBytes()
+{
+    qint64 read = 0;
+
+    QHash<libvlc_media_player_t*, Player>::iterator it;
+    for (it = _players.begin(); it != _players.end(); ++it) {
+        libvlc_media_t *media = libvlc_media_player_get_media(it.key());
+        if (media == NULL)
+            continue;
+
+        libvlc_media_stats_t stats;
+        if (libvlc_media_get_stats(media, &stats)) {
+            if (stats.i_read_bytes > it.value().readBytes)
+                read += stats.i_read_bytes - it.value().readBytes;
+            it.value().readBytes = stats.i_read_bytes;
+        }
+
+        libvlc_media_release(media);
+    }
+
+    return read;
+}
+
+void JobScheduler::updateThrottle()
+{
+    int running = 0;
+    bool spent = !mayRead();
+
+    // the players of the highest priorities keep running
+    for (int priority = HighPriority; priority >= LowPriority; priority--) {
+        QHash<libvlc_media_player_t*, Player>::iterator it;
+        for (it = _players.begin(); it != _players.end(); ++it) {
+            if (!_clients.contains(it.value().client) || _clients.value(it.value().client).priority != priority)
+                continue;
+
+            bool pause = false;
+            if (_playing) {
+                if (spent || running >= PLAYING_DECODE_JOBS)
+                    pause = true;
+                else
+                    running++;
+            }
+
+            // a player still opening ignores the pause, try again at the next tick
+            libvlc_state_t state = libvlc_media_player_get_state(it.key());
+            if (pause == it.value().paused || (state != libvlc_Playing && state != libvlc_Paused))
+                continue;
+
+            libvlc_media_player_set_pause(it.key(), pause ? 1 : 0);
+            it.value().paused = pause;
+        }
+    }
+}
+
+void JobScheduler::notifyActivity()
+{
+    int waiting = 0;
+
+    foreach (const Client &entry, _clients)
+        if (entry.waiting)
+            waiting++;
+
+    emit activityChanged(_running[DecodeResource] + _running[IoResource], waiting, _playing);
+}
@@ -0,0 +1,306 @@
+/**********************************************************************************
+ * This file is part of Open Projection Program (OPP).
+ *
+ * Copyright (C) 2013 Catalogue Ouvert du Cinéma <dev@cinemaouvert.fr>
+ *
+ * Authors: Jerome Blanchi <d.j.a.y@free.fr>
+ *
+ * Open Projection Program is an initiative of Catalogue Ouvert du Cinéma.
+ * The software was developed by four students of University of Poitiers
+ * as school project.
+ *
+ * Open Projection Program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Open Projection Program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Open Projection Program. If not, see <http://www.gnu.org/licenses/>.
+ **********************************************************************************/
+
+#ifndef JOBSCHEDULER_H
+#define JOBSCHEDULER_H
+
+#include <QObject>
+#include <QHash>
+#include <QList>
+#include <QMutex>
+#include <QPointer>
+
+#include <vlc/vlc.h>
+
+class QTimer;
+class MediaPlayer;
+
+/**
+ * @brief Share the cores and the disks between the background jobs
+ *
+ * Every background worker (analyses, verification, copies) is a client with
+ * a resource class and a priority. A client asks a slot before starting a
+ * job and gives it back when done; a client refused is woken up later by a
+ * queued call of its startJobs() slot, the clients of higher priority first.
+ *
+ * While a watched player projects, fewer slots are given and the libvlc
+ * players of the jobs are paused beyond PLAYING_DECODE_JOBS or when they
+ * read more than PLAYING_READ_RATE (token bucket on the bytes read), so the
+ * projection keeps the disk and the cores it needs.
+ */
+class JobScheduler : public QObject
+{
+    Q_OBJECT
+public:
+    /**
+     * @enum ResourceClass
+     * @brief What a job mostly uses
+     */
+    enum ResourceClass { DecodeResource = 0, IoResource = 1 };
+
+    /**
+     * @enum Priority
+     * @brief Order in which the waiting clients get a slot
+     */
+    enum Priority { LowPriority = 0, NormalPriority = 1, HighPriority = 2 };
+
+    explicit JobScheduler(QObject *parent = 0);
+
+    /**
+     * @brief Register a client, its startJobs() and cancel() slots are invoked by the scheduler
+     * @param client The client
+     * @param resource The resource class of its jobs
+     * @param priority The priority of its jobs
+     */
+    void addClient(QObject *client, ResourceClass resource, Priority priority = NormalPriority);
+
+    /**
+     * @brief Unregister a client, its slots are given back
+     */
+    void removeClient(QObject *client);
+
+    /**
+     * @brief Change the priority of a client
+     */
+    void setPriority(QObject *client, Priority priority);
+
+    /**
+     * @brief Take a slot to start a job
+     * @param client The client
+     * @return True if granted, false if the client must wait for its startJobs() slot
+     */
+    bool acquire(QObject *client);
+
+    /**
+     * @brief Give back the slot of a finished job
+     */
+    void release(QObject *client);
+
+    /**
+     * @brief Stop waiting for a slot, when the queue of a client is cleared
+     */
+    void withdraw(QObject *client);
+
+    /**
+     * @brief Throttle the libvlc player of a job while projecting
+     * @param client The client running the job
+     * @param player The player, removed before being released
+     */
+    void addPlayer(QObject *client, libvlc_media_player_t *player);
+
+    /**
+     * @brief Stop throttling a player
+     */
+    void removePlayer(libvlc_media_player_t *player);
+
+    /**
+     * @brief Play the player of a job and throttle it
+     *
+     * The input and decoder threads libvlc starts inherit the lowest IO
+     * priority, so they read after the projection.
+     *
+     * @param client The client running the job
+     * @param player The player
+     */
+    void startPlayer(QObject *client, libvlc_media_player_t *player);
+
+    /**
+     * @brief Give the calling thread, and the threads it starts, the lowest best effort IO priority
+     * @return The previous priority, for restoreIoPriority()
+     */
+    static int lowerIoPriority();
+
+    /**
+     * @brief Give back the IO priority of the calling thread
+     * @param priority The priority returned by lowerIoPriority()
+     */
+    static void restoreIoPriority(int priority);
+
+    /**
+     * @brief Count bytes read by a job outside of libvlc (copies), thread safe
+     */
+    void addReadBytes(qint64 bytes);
+
+    /**
+     * @brief Allow to know if a job may read now, thread safe
+     * @return False while the read budget of the projection is spent
+     */
+    bool mayRead() const;
+
+    /**
+     * @brief Throttle the background jobs while a player projects
+     */
+    void watchPlayer(MediaPlayer *player);
+
+    /**
+     * @brief Allow to know if the background jobs are throttled
+     * @return True while a watched player projects
+     */
+    inline bool isThrottled() const { return _playing; }
+
+    /**
+     * @brief TICK Period of the read budget update (ms)
+     */
+    static const int TICK = 250;
+
+    /**
+     * @brief IO_JOBS Copies running at once
+     */
+    static const int IO_JOBS = 2;
+
+    /**
+     * @brief PLAYING_DECODE_JOBS Decoders running at once while projecting
+     */
+    static const int PLAYING_DECODE_JOBS = 1;
+
+    /**
+     * @brief PLAYING_IO_JOBS Copies running at once while projecting
+     */
+    static const int PLAYING_IO_JOBS = 1;
+
+    /**
+     * @brief PLAYING_READ_RATE Bytes per second the jobs may read while projecting
+     */
+    static const int PLAYING_READ_RATE = 4 * 1024 * 1024;
+
+    /**
+     * @brief READ_BURST Bytes the jobs may read at once while projecting
+     */
+    static const int READ_BURST = 8 * 1024 * 1024;
+
+public slots:
+    /**
+     * @brief Cancel the jobs of every client
+     */
+    void cancelAll();
+
+signals:
+    /**
+     * @brief Emitted when jobs start or end, or the throttling changes
+     * @param running The number of running jobs
+     * @param waiting The number of clients waiting for a slot
+     * @param throttled True while a watched player projects
+     */
+    void activityChanged(int running, int waiting, bool throttled);
+
+private slots:
+    /**
+     * @brief Follow the state of the watched players
+     */
+    void updatePlaying();
+
+    /**
+     * @brief Refill the read budget and pause or resume the players
+     */
+    void tick();
+
+private:
+    /**
+     * @brief A registered client
+     */
+    struct Client {
+        ResourceClass resource;
+        Priority priority;
+        int running;
+        bool waiting;
+    };
+
+    /**
+     * @brief A throttled player
+     */
+    struct Player {
+        QObject *client;
+        qint64 readBytes;
+        bool paused;
+    };
+
+    /**
+     * @brief Get the number of slots of a resource class
+     */
+    int maxJobs(ResourceClass resource) const;
+
+    /**
+     * @brief Invoke the waiting clients of a resource class, the highest priorities first,
+     * no more than the free slots
+     */
+    void wake(ResourceClass resource);
+
+    /**
+     * @brief Get the bytes read by the players since the last call
+     */
+    qint64 readBytes();
+
+    /**
+     * @brief Pause the players beyond the limits, resume the others
+     */
+    void updateThrottle();
+
+    /**
+     * @brief Emit activityChanged
+     */
+    void notifyActivity();
+
+    /**
+     * @brief _clients The registered clients
+     */
+    QHash<QObject*, Client> _clients;
+
+    /**
+     * @brief _players The players of the running jobs
+     */
+    QHash<libvlc_media_player_t*, Player> _players;
+
+    /**
+     * @brief _watched The players of the projection
+     */
+    QList<QPointer<MediaPlayer> > _watched;
+
+    /**
+     * @brief _running The running jobs of each resource class
+     */
+    int _running[2];
+
+    /**
+     * @brief _playing True while a watched player projects
+     */
+    bool _playing;
+
+    /**
+     * @brief _readTokens The bytes the jobs may still read while projecting
+     */
+    qint64 _readTokens;
+
+    /**
+     * @brief _readMutex Protect _readTokens, spent by the copy threads
+     */
+    mutable QMutex _readMutex;
+
+    /**
+     * @brief _timer Update the read budget while projecting
+     */
+    QTimer *_timer;
+};
+
+#endif // JOBSCHEDULER_H
@@ -0,0 +1,62 @@
+/**********************************************************************************
+ * This file is part of Open Projection Program (OPP).
+ *
+ * Copyright (C) 2013 Catalogue Ouvert du Cinéma <dev@cinemaouvert.fr>
+ *
+ * Authors: Jerome Blanchi <d.j.a.y@free.fr>
+ *
+ * Open Projection Program is an initiative of Catalogue Ouvert du Cinéma.
+ * The software was developed by four students of University of Poitiers
+ * as school project.
+ *
+ * Open Projection Program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Open Projection Program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Open Projection Program. If not, see <http://www.gnu.org/licenses/>.
+ **********************************************************************************/
+
+#include "loudnessanalyzer.h"
+
+#include "loudnessmeter.h"
+
+/**
+ * @brief Loudness meter fed by the analyzer
+ */
+class LoudnessMeasure : public AudioAnalyzer::Measure
+{
+public:
+    LoudnessMeasure() : meter(AudioAnalyzer::CHANNELS, AudioAnalyzer::RATE) {}
+
+    void process(const float *samples, unsigned frames) { meter.process(samples, frames); }
+
+    LoudnessMeter meter;
+};
+
+LoudnessAnalyzer::LoudnessAnalyzer(VLCApplication *vlcApp, QObject *parent) :
+    AudioAnalyzer(vlcApp, parent)
+{
+}
+
+AudioAnalyzer::Measure *LoudnessAnalyzer::createMeasure(Media *media)
+{
+    Q_UNUSED(media);
+
+    return new LoudnessMeasure;
+}
+
+bool LoudnessAnalyzer::storeMeasure(Media *media, Measure *measure)
+{
+    const LoudnessMeter &meter = ((LoudnessMeasure *)measure)->meter;
+
+    media->setLoudness(meter.integratedLoudness(), meter.loudnessRange(), meter.truePeak());
+
+    return true;
+}
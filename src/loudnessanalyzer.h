@@ -0,0 +1,52 @@
+/**********************************************************************************
+ * This file is part of Open Projection Program (OPP).
+ *
+ * Copyright (C) 2013 Catalogue Ouvert du Cinéma <dev@cinemaouvert.fr>
+ *
+ * Authors: Jerome Blanchi <d.j.a.y@free.fr>
+ *
+ * Open Projection Program is an initiative of Catalogue Ouvert du Cinéma.
+ * The software was developed by four students of University of Poitiers
+ * as school project.
+ *
+ * Open Projection Program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Open Projection Program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Open Projection Program. If not, see <http://www.gnu.org/licenses/>.
+ **********************************************************************************/
+
+#ifndef LOUDNESSANALYZER_H
+#define LOUDNESSANALYZER_H
+
+#include "audioanalyzer.h"
+
+/**
+ * @brief Measure the loudness of media in background, the result is stored in the media
+ */
+class LoudnessAnalyzer : public AudioAnalyzer
+{
+    Q_OBJECT
+public:
+    explicit LoudnessAnalyzer(VLCApplication *vlcApp, QObject *parent = 0);
+
+protected:
+    /**
+     * @brief Create a loudness meter
+     */
+    Measure *createMeasure(Media *media);
+
+    /**
+     * @brief Store the loudness in the media
+     */
+    bool storeMeasure(Media *media, Measure *measure);
+};
+
+#endif // LOUDNESSANALYZER_H
@@ -0,0 +1,326 @@
+/**********************************************************************************
+ * This file is part of Open Projection Program (OPP).
+ *
+ * Copyright (C) 2013 Catalogue Ouvert du Cinéma <dev@cinemaouvert.fr>
+ *
+ * Authors: Jerome Blanchi <d.j.a.y@free.fr>
+ *
+ * Open Projection Program is an initiative of Catalogue Ouvert du Cinéma.
+ * The software was developed by four students of University of Poitiers
+ * as school project.
+ *
+ * Open Projection Program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Open Projection Program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Open Projection Program. If not, see <http://www.gnu.org/licenses/>.
+ **********************************************************************************/
+
+#include "loudnessmeter.h"
+
+#include <math.h>
+
+#include <QtAlgorithms>
+
+#ifdef __SSE2__
+# include <emmintrin.h>
+#endif
+
+/* 4 times oversampling of BS.1770-4 annex 2, by tap then by phase */
+static const float TRUE_PEAK_TAPS[12][4] = {
+    {  0.0017089843750f, -0.0291748046875f, -0.0189208984375f, -0.0083007812500f },
+    {  0.0109863281250f,  0.0292968750000f,  0.0330810546875f,  0.0148925781250f },
+    { -0.0196533203125f, -0.0517578125000f, -0.0582275390625f, -0.0266113281250f },
+    {  0.0332031250000f,  0.0891113281250f,  0.1015625000000f,  0.0476074218750f },
+    { -0.0594482421875f, -0.1665039062500f, -0.2003173828125f, -0.1022949218750f },
+    {  0.1373291015625f,  0.4650878906250f,  0.7797851562500f,  0.9721679687500f },
+    {  0.9721679687500f,  0.7797851562500f,  0.4650878906250f,  0.1373291015625f },
+    { -0.1022949218750f, -0.2003173828125f, -0.1665039062500f, -0.0594482421875f },
+    {  0.0476074218750f,  0.1015625000000f,  0.0891113281250f,  0.0332031250000f },
+    { -0.0266113281250f, -0.0582275390625f, -0.0517578125000f, -0.0196533203125f },
+    {  0.0148925781250f,  0.0330810546875f,  0.0292968750000f,  0.0109863281250f },
+    { -0.0083007812500f, -0.0189208984375f, -0.0291748046875f,  0.0017089843750f }
+};
+
+/* below, the filter states are flushed to 0 to stay out of the slow denormals */
+static const double STATE_FLOOR = 1e-20;
+
+LoudnessMeter::LoudnessMeter(unsigned channels, unsigned rate) :
+    _channels(channels),
+    _blockFrames(rate / 10),
+    _frames(0),
+    _state(channels * 6, 0.0),
+    _energy(channels, 0.0),
+    _history(channels * 24, 0.f),
+    _historyPosition(0),
+    _peak(0.f)
+{
+    // K-weighting for any rate: high shelf of the head then RLB high-pass (BS.1770)
+    double f0 = 1681.974450955533;
+    double q = 0.7071752369554196;
+    double k = tan(M_PI * f0 / rate);
+    double vh = pow(10.0, 3.999843853973347 / 20.0);
+    double vb = pow(vh, 0.4996667741545416);
+    double a0 = 1.0 + k / q + k * k;
+
+    _coefficients[0] = (vh + vb * k / q + k * k) / a0;
+    _coefficients[1] = 2.0 * (k * k - vh) / a0;
+    _coefficients[2] = (vh - vb * k / q + k * k) / a0;
+    _coefficients[3] = 2.0 * (k * k - 1.0) / a0;
+    _coefficients[4] = (1.0 - k / q + k * k) / a0;
+
+    f0 = 38.13547087602444;
+    q = 0.5003270373238773;
+    k = tan(M_PI * f0 / rate);
+    a0 = 1.0 + k / q + k * k;
+
+    _coefficients[5] = 1.0;
+    _coefficients[6] = -2.0;
+    _coefficients[7] = 1.0;
+    _coefficients[8] = 2.0 * (k * k - 1.0) / a0;
+    _coefficients[9] = (1.0 - k / q + k * k) / a0;
+}
+
+void LoudnessMeter::process(const float *samples, unsigned frames)
+{
+    if (_channels == 0 || _blockFrames == 0)
+        return;
+
+    peak(samples, frames);
+
+    while (frames > 0) {
+        unsigned count = qMin(frames, _blockFrames - _frames);
+
+        filter(samples, count);
+        samples += count * _channels;
+        frames -= count;
+        _frames += count;
+
+        if (_frames == _blockFrames) {
+            double energy = 0.0;
+            for (unsigned c = 0; c < _channels; ++c) {
+                energy += _energy[c] / _blockFrames;
+                _energy[c] = 0.0;
+            }
+            _blocks.append(energy);
+            _frames = 0;
+        }
+    }
+}
+
+void LoudnessMeter::filter(const float *samples, unsigned frames)
+{
+    const double *b = _coefficients;
+    double *state = _state.data();
+    unsigned c = 0;
+
+#ifdef __SSE2__
+    // a pair of channels per vector, one lane each
+    const __m128d b0 = _mm_set1_pd(b[0]), b1 = _mm_set1_pd(b[1]), b2 = _mm_set1_pd(b[2]);
+    const __m128d a1 = _mm_set1_pd(b[3]), a2 = _mm_set1_pd(b[4]);
+    const __m128d d1 = _mm_set1_pd(b[8]), d2 = _mm_set1_pd(b[9]);
+
+    for (; c + 1 < _channels; c += 2) {
+        __m128d x1 = _mm_loadu_pd(state + c);
+        __m128d x2 = _mm_loadu_pd(state + _channels + c);
+        __m128d y1 = _mm_loadu_pd(state + 2 * _channels + c);
+        __m128d y2 = _mm_loadu_pd(state + 3 * _channels + c);
+        __m128d z1 = _mm_loadu_pd(state + 4 * _channels + c);
+        __m128d z2 = _mm_loadu_pd(state + 5 * _channels + c);
+        __m128d sum = _mm_setzero_pd();
+        const float *sample = samples + c;
+
+        for (unsigned n = 0; n < frames; ++n, sample += _channels) {
+            __m128d x = _mm_set_pd(sample[1], sample[0]);
+            __m128d y = _mm_sub_pd(_mm_add_pd(_mm_add_pd(_mm_mul_pd(b0, x), _mm_mul_pd(b1, x1)), _mm_mul_pd(b2, x2)),
+                                   _mm_add_pd(_mm_mul_pd(a1, y1), _mm_mul_pd(a2, y2)));
+            // the high-pass numerator is 1 -2 1
+            __m128d z = _mm_sub_pd(_mm_add_pd(_mm_sub_pd(y, _mm_add_pd(y1, y1)), y2),
+                                   _mm_add_pd(_mm_mul_pd(d1, z1), _mm_mul_pd(d2, z2)));
+            x2 = x1; x1 = x;
+            y2 = y1; y1 = y;
+            z2 = z1; z1 = z;
+            sum = _mm_add_pd(sum, _mm_mul_pd(z, z));
+        }
+
+        _mm_storeu_pd(state + c, x1);
+        _mm_storeu_pd(state + _channels + c, x2);
+        _mm_storeu_pd(state + 2 * _channels + c, y1);
+        _mm_storeu_pd(state + 3 * _channels + c, y2);
+        _mm_storeu_pd(state + 4 * _channels + c, z1);
+        _mm_storeu_pd(state + 5 * _channels + c, z2);
+
+        double energy[2];
+        _mm_storeu_pd(energy, sum);
+        _energy[c] += energy[0];
+        _energy[c + 1] += energy[1];
+    }
+#endif
+
+    for (; c < _channels; ++c) {
+        double x1 = state[c], x2 = state[_channels + c];
+        double y1 = state[2 * _channels + c], y2 = state[3 * _channels + c];
+        double z1 = state[4 * _channels + c], z2 = state[5 * _channels + c];
+        double sum = 0.0;
+        const float *sample = samples + c;
+
+        for (unsigned n = 0; n < frames; ++n, sample += _channels) {
+            double x = *sample;
+            double y = b[0] * x + b[1] * x1 + b[2] * x2 - b[3] * y1 - b[4] * y2;
+            double z = y - 2.0 * y1 + y2 - b[8] * z1 - b[9] * z2;
+            x2 = x1; x1 = x;
+            y2 = y1; y1 = y;
+            z2 = z1; z1 = z;
+            sum += z * z;
+        }
+
+        state[c] = x1; state[_channels + c] = x2;
+        state[2 * _channels + c] = y1; state[3 * _channels + c] = y2;
+        state[4 * _channels + c] = z1; state[5 * _channels + c] = z2;
+        _energy[c] += sum;
+    }
+
+    for (int i = 0; i < _state.count(); ++i)
+        if (fabs(state[i]) < STATE_FLOOR)
+            state[i] = 0.0;
+}
+
+void LoudnessMeter::peak(const float *samples, unsigned frames)
+{
+    int position = _historyPosition;
+    float top = _peak;
+
+    for (unsigned c = 0; c < _channels; ++c) {
+        float *history = _history.data() + c * 24;
+        const float *sample = samples + c;
+        position = _historyPosition;
+
+#ifdef __SSE2__
+        const __m128 absolute = _mm_castsi128_ps(_mm_set1_epi32(0x7fffffff));
+        __m128 taps[12];
+        __m128 max = _mm_setzero_ps();
+        float values[4];
+
+        for (int k = 0; k < 12; ++k)
+            taps[k] = _mm_loadu_ps(TRUE_PEAK_TAPS[k]);
+
+        // the 4 phases at once: each tap row is weighted by one past sample
+        for (unsigned n = 0; n < frames; ++n, sample += _channels) {
+            position = position == 0 ? 11 : position - 1;
+            history[position] = history[position + 12] = *sample;
+
+            const float *h = history + position;
+            __m128 sum = _mm_mul_ps(_mm_set1_ps(h[0]), taps[0]);
+            for (int k = 1; k < 12; ++k)
+                sum = _mm_add_ps(sum, _mm_mul_ps(_mm_set1_ps(h[k]), taps[k]));
+
+            max = _mm_max_ps(max, _mm_and_ps(sum, absolute));
+        }
+
+        _mm_storeu_ps(values, max);
+        for (int p = 0; p < 4; ++p)
+            top = qMax(top, values[p]);
+#else
+        for (unsigned n = 0; n < frames; ++n, sample += _channels) {
+            position = position == 0 ? 11 : position - 1;
+            history[position] = history[position + 12] = *sample;
+
+            const float *h = history + position;
+            for (int p = 0; p < 4; ++p) {
+                float sum = 0.f;
+                for (int k = 0; k < 12; ++k)
+                    sum += h[k] * TRUE_PEAK_TAPS[k][p];
+                top = qMax(top, (float)fabs(sum));
+            }
+        }
+#endif
+    }
+
+    _historyPosition = position;
+    _peak = top;
+}
+
+double LoudnessMeter::gatedLoudness(int window, double relativeGate, QVector<double> *loudness) const
+{
+    const double absoluteGate = pow(10.0, (LOUDNESS_FLOOR + 0.691) / 10.0);
+    QVector<double> energies;
+    double sum = 0.0;
+    double total = 0.0;
+
+    if (_blocks.count() < window)
+        return LOUDNESS_FLOOR;
+
+    energies.reserve(_blocks.count() - window + 1);
+
+    // windows overlap, one 100 ms block apart
+    for (int i = 0; i < _blocks.count(); ++i) {
+        sum += _blocks.at(i);
+        if (i >= window)
+            sum = qMax(0.0, sum - _blocks.at(i - window));
+        if (i < window - 1)
+            continue;
+
+        double energy = sum / window;
+        if (energy > absoluteGate) {
+            energies.append(energy);
+            total += energy;
+        }
+    }
+
+    if (energies.isEmpty())
+        return LOUDNESS_FLOOR;
+
+    const double gate = total / energies.count() * pow(10.0, relativeGate / 10.0);
+    double gatedTotal = 0.0;
+    int gatedCount = 0;
+
+    foreach (double energy, energies) {
+        if (energy <= gate)
+            continue;
+        gatedTotal += energy;
+        gatedCount++;
+        if (loudness != NULL)
+            loudness->append(-0.691 + 10.0 * log10(energy));
+    }
+
+    if (gatedCount == 0)
+        return LOUDNESS_FLOOR;
+
+    return -0.691 + 10.0 * log10(gatedTotal / gatedCount);
+}
+
+double LoudnessMeter::integratedLoudness() const
+{
+    // 400 ms blocks, relative gate at -10 LU
+    return gatedLoudness(4, -10.0, NULL);
+}
+
+double LoudnessMeter::loudnessRange() const
+{
+    // 3 s short-term loudness, relative gate at -20 LU, from the 10th to the 95th percentile
+    QVector<double> loudness;
+    gatedLoudness(30, -20.0, &loudness);
+
+    if (loudness.count() < 2)
+        return 0.0;
+
+    qSort(loudness);
+
+    return loudness.at(qRound((loudness.count() - 1) * 0.95))
+           - loudness.at(qRound((loudness.count() - 1) * 0.10));
+}
+
+double LoudnessMeter::truePeak() const
+{
+    if (_peak <= 0.f)
+        return LOUDNESS_FLOOR;
+
+    return 20.0 * log10(_peak);
+}
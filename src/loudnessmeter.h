@@ -0,0 +1,153 @@
+/**********************************************************************************
+ * This file is part of Open Projection Program (OPP).
+ *
+ * Copyright (C) 2013 Catalogue Ouvert du Cinéma <dev@cinemaouvert.fr>
+ *
+ * Authors: Jerome Blanchi <d.j.a.y@free.fr>
+ *
+ * Open Projection Program is an initiative of Catalogue Ouvert du Cinéma.
+ * The software was developed by four students of University of Poitiers
+ * as school project.
+ *
+ * Open Projection Program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Open Projection Program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Open Projection Program. If not, see <http://www.gnu.org/licenses/>.
+ **********************************************************************************/
+
+#ifndef LOUDNESSMETER_H
+#define LOUDNESSMETER_H
+
+#include <QVector>
+
+/**
+ * @brief Measure the loudness of interleaved float samples (ITU-R BS.1770, EBU R128)
+ *
+ * The samples are K-weighted and their energy is kept per 100 ms. The gated
+ * integrated loudness and the loudness range are computed from these energies
+ * when asked. The true peak is measured on a 4 times oversampled signal.
+ * Channel pairs are filtered together in SSE2 vectors.
+ */
+class LoudnessMeter
+{
+public:
+    /**
+     * @brief Create a meter
+     * @param channels The number of interleaved channels, all weighted 1
+     * @param rate The sample rate (Hz)
+     */
+    LoudnessMeter(unsigned channels, unsigned rate);
+
+    /**
+     * @brief Measure samples
+     * @param samples The interleaved samples, full scale is 1
+     * @param frames The number of frames (samples per channel)
+     */
+    void process(const float *samples, unsigned frames);
+
+    /**
+     * @brief Get the gated integrated loudness
+     * @return The loudness in LUFS, LOUDNESS_FLOOR for silence
+     */
+    double integratedLoudness() const;
+
+    /**
+     * @brief Get the loudness range (EBU Tech 3342)
+     * @return The range in LU
+     */
+    double loudnessRange() const;
+
+    /**
+     * @brief Get the true peak
+     * @return The peak in dBTP, LOUDNESS_FLOOR for silence
+     */
+    double truePeak() const;
+
+    /**
+     * @brief Get the duration measured
+     * @return The duration in ms
+     */
+    inline int duration() const { return _blocks.count() * 100; }
+
+    /**
+     * @brief LOUDNESS_FLOOR Absolute gate, returned for silence (LUFS)
+     */
+    static const int LOUDNESS_FLOOR = -70;
+
+private:
+    /**
+     * @brief Filter the samples of one 100 ms block at most
+     */
+    void filter(const float *samples, unsigned frames);
+
+    /**
+     * @brief Measure the true peak of the samples
+     */
+    void peak(const float *samples, unsigned frames);
+
+    /**
+     * @brief Compute the gated loudness of windows of 100 ms blocks
+     * @param window The number of blocks of a window
+     * @param relativeGate The relative gate (LU)
+     * @param loudness Filled with the loudness of the windows above the gates, if not NULL
+     * @return The loudness of the energy above the gates (LUFS)
+     */
+    double gatedLoudness(int window, double relativeGate, QVector<double> *loudness) const;
+
+    unsigned _channels;
+
+    /**
+     * @brief _blockFrames The frames of a 100 ms block
+     */
+    unsigned _blockFrames;
+
+    /**
+     * @brief _frames The frames already in the current block
+     */
+    unsigned _frames;
+
+    /**
+     * @brief _coefficients The K-weighting cascade: b0 b1 b2 a1 a2 of the shelf then of the high-pass
+     */
+    double _coefficients[10];
+
+    /**
+     * @brief _state The filter states x1 x2 y1 y2 z1 z2, each one for all the channels
+     */
+    QVector<double> _state;
+
+    /**
+     * @brief _energy The sum of the squares of the current block by channel
+     */
+    QVector<double> _energy;
+
+    /**
+     * @brief _blocks The mean square of every 100 ms block, summed over the channels
+     */
+    QVector<double> _blocks;
+
+    /**
+     * @brief _history The last 12 samples by channel, twice to read them without wrapping
+     */
+    QVector<float> _history;
+
+    /**
+     * @brief _historyPosition The position of the newest sample in the history
+     */
+    int _historyPosition;
+
+    /**
+     * @brief _peak The highest absolute oversampled value
+     */
+    float _peak;
+};
+
+#endif // LOUDNESSMETER_H
@@ -25,9 +25,18 @@
  **********************************************************************************/
 
 #include "application.h"
+#include "playbackengine.h"
 
 int main(int argc, char *argv[])
 {
+    // started by the EngineSupervisor of the interface, without interface
+    if(argc > 2 && QString(argv[1]) == PlaybackEngine::option()){
+        QApplication a(argc, argv);
+        PlaybackEngine engine(argv[2]);
+
+        return a.exec();
+    }
+
    Application a(argc, argv);
 
     return a.exec();
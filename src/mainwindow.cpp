@@ -45,6 +45,8 @@
 #include <QPrinter>
 #include <QPainter>
 #include <QSignalMapper>
+#include <QTemporaryFile>
+#include <QTimer>
 
 #include <iostream>
 
@@ -71,6 +73,22 @@
 #include "datastorage.h"
 #include "aboutdialog.h"
 #include "exportpdf.h"
+#include "loudnessanalyzer.h"
+#include "waveformextractor.h"
+#include "blackdetector.h"
+#include "cropdetector.h"
+#include "interlacedetector.h"
+#include "frameextractor.h"
+#include "mediaverifier.h"
+#include "stagingcache.h"
+#include "cachewarmer.h"
+#include "showpackage.h"
+#include "mediaingest.h"
+#include "proxygenerator.h"
+#include "thumbnailstore.h"
+#include "jobscheduler.h"
+#include "enginesupervisor.h"
+#include "playbackrecovery.h"
 
 #include "plugins.h"
 #include <QPluginLoader>
@@ -97,6 +115,22 @@ MainWindow::MainWindow(QWidget *parent) :
     _selectedMediaName(NULL),
     _ocpmPlugin(NULL),
     _exportPDF(NULL),
+    _loudnessAnalyzer(NULL),
+    _waveformExtractor(NULL),
+    _blackDetector(NULL),
+    _cropDetector(NULL),
+    _interlaceDetector(NULL),
+    _mediaVerifier(NULL),
+    _stagingCache(NULL),
+    _cacheWarmer(NULL),
+    _showPackage(NULL),
+    _importingPackage(false),
+    _mediaIngest(NULL),
+    _proxyGenerator(NULL),
+    _previewExtractor(NULL),
+    _posterExtractor(NULL),
+    _screensIndex(-1),
+    _playbackRecovery(NULL),
     _vlcMire(NULL),
     _mpMire(NULL),
     _mireMire(NULL),
@@ -109,6 +143,29 @@ MainWindow::MainWindow(QWidget *parent) :
     /****************** internal core initalization *********************/
     _app = new VLCApplication();
     _playlistPlayer = new PlaylistPlayer(_app->vlcInstance(), this);
+    _app->jobScheduler()->watchPlayer(_playlistPlayer->mediaPlayer());
+
+    _loudnessAnalyzer = new LoudnessAnalyzer(_app, this);
+    connect(_loudnessAnalyzer, SIGNAL(progress(int,int)), this, SLOT(loudnessProgress(int,int)));
+    connect(_loudnessAnalyzer, SIGNAL(finished()), this, SLOT(loudnessFinished()));
+
+    _waveformExtractor = new WaveformExtractor(_app, this);
+
+    _blackDetector = new BlackDetector(_app, this);
+    connect(_blackDetector, SIGNAL(progress(int,int)), this, SLOT(blackFramesProgress(int,int)));
+    connect(_blackDetector, SIGNAL(finished()), this, SLOT(blackFramesFinished()));
+
+    _cropDetector = new CropDetector(_app, this);
+    connect(_cropDetector, SIGNAL(progress(int,int)), this, SLOT(blackBarsProgress(int,int)));
+    connect(_cropDetector, SIGNAL(finished()), this, SLOT(blackBarsFinished()));
+
+    _interlaceDetector = new InterlaceDetector(_app, this);
+    connect(_interlaceDetector, SIGNAL(progress(int,int)), this, SLOT(interlacingProgress(int,int)));
+    connect(_interlaceDetector, SIGNAL(finished()), this, SLOT(interlacingFinished()));
+
+    _mediaVerifier = new MediaVerifier(_app, this);
+    connect(_mediaVerifier, SIGNAL(progress(int,int)), this, SLOT(verificationProgress(int,int)));
+    connect(_mediaVerifier, SIGNAL(finished()), this, SLOT(verificationFinished()));
 
     _timerOut = new QTimer();
     _timerOut->connect(_timerOut, SIGNAL(timeout()), this, SLOT(showTimeOut()));
@@ -124,13 +181,31 @@ MainWindow::MainWindow(QWidget *parent) :
     mediaPlayer->setVideoBackView( (VideoView*) ui->backWidget );
     mediaPlayer->initStream();
 
+    // the engine process shows the projection in its own window
+    if(mediaPlayer->engine() != NULL)
+        _videoWindow->hide();
+
     connect(mediaPlayer, SIGNAL(stopped()), this, SLOT(stop()));
 
+    _playbackRecovery = new PlaybackRecovery(_playlistPlayer, this);
+    connect(_playbackRecovery, SIGNAL(retried(int,int)), this, SLOT(playbackRetried(int,int)));
+    connect(_playbackRecovery, SIGNAL(skipped()), this, SLOT(playbackSkipped()));
+
     /**
      * Create the widget which handle the playlist player.
      * It have to be created before the locker.
      */
     _playerControlWidget = new PlayerControlWidget(_playlistPlayer, this);
+    _playerControlWidget->seekWidget()->flipBar()->setWaveformExtractor(_waveformExtractor);
+
+    _previewExtractor = new FrameExtractor(_app, this);
+    // the previews are waited for on screen
+    _app->jobScheduler()->setPriority(_previewExtractor, JobScheduler::HighPriority);
+    _playerControlWidget->seekWidget()->flipBar()->setPreviewExtractor(_previewExtractor);
+
+    _posterExtractor = new FrameExtractor(_app, this);
+    connect(_posterExtractor, SIGNAL(posterExtracted(QString,QImage)), this, SLOT(posterExtracted(QString,QImage)));
+    connect(_posterExtractor, SIGNAL(finished()), this, SLOT(takeNextScreenshot()));
 
     // connect playercontrolwidget shortcut to videowindow.
     // Important : Must be done after _playerControlWidget creation
@@ -140,6 +215,26 @@ MainWindow::MainWindow(QWidget *parent) :
     _mediaListModel = new MediaListModel();
     _scheduleListModel = new ScheduleListModel();
 
+    _stagingCache = new StagingCache(_app, _scheduleListModel, this);
+    connect(_stagingCache, SIGNAL(progress(int,int)), this, SLOT(stagingProgress(int,int)));
+
+    _cacheWarmer = new CacheWarmer(_scheduleListModel, _playlistPlayer, this);
+
+    _showPackage = new ShowPackage(this);
+    connect(_showPackage, SIGNAL(progress(int,int)), this, SLOT(packageProgress(int,int)));
+    connect(_showPackage, SIGNAL(searchProgress(int)), this, SLOT(packageSearchProgress(int)));
+    connect(_showPackage, SIGNAL(finished(bool,QString,QString)), this, SLOT(packageFinished(bool,QString,QString)));
+
+    _mediaIngest = new MediaIngest(_app, _mediaListModel, this);
+    connect(_mediaIngest, SIGNAL(ingested(Media*)), this, SLOT(mediaIngested(Media*)));
+
+    _proxyGenerator = new ProxyGenerator(_app, _mediaListModel, this);
+    connect(_proxyGenerator, SIGNAL(progress(int,int)), this, SLOT(proxyProgress(int,int)));
+    connect(_proxyGenerator, SIGNAL(finished()), this, SLOT(proxyFinished()));
+
+    // once the project is loaded, its media are kept
+    QTimer::singleShot(60000, this, SLOT(collectThumbnails()));
+
     connect(ui->scheduleToggleEnabledButton, SIGNAL(toggled(bool)), _scheduleListModel, SLOT(toggleAutomation(bool)));
 
     ui->binTableView->setModel(_mediaListModel);
@@ -154,6 +249,7 @@ MainWindow::MainWindow(QWidget *parent) :
 
     ui->statusBar->addPermanentWidget(_statusWidget);
     connect(_mediaListModel, SIGNAL(mediaListChanged(int)), _statusWidget, SLOT(setMediaCount(int)));
+    connect(_app->jobScheduler(), SIGNAL(activityChanged(int,int,bool)), _statusWidget, SLOT(setBackgroundJobs(int,int,bool)));
 
     connect(_locker, SIGNAL(toggled(bool)), _statusWidget->lockButton(), SLOT(setChecked(bool)));
     connect(_statusWidget->lockButton(), SIGNAL(clicked(bool)), _locker, SLOT(toggle(bool)));
@@ -194,6 +290,7 @@ MainWindow::MainWindow(QWidget *parent) :
     _dataStorage->setScheduleListModel(_scheduleListModel);
 
     connect(ui->progEdit,SIGNAL(textChanged(QString)), _dataStorage, SLOT(setProjectTitle(QString)));
+    connect(_dataStorage, SIGNAL(loaded()), this, SLOT(listingLoaded()));
 
     /************* Set the default schedule information ***********/
     ui->scheduleLaunchAtDateEdit->setDate(QDate::currentDate());
@@ -394,6 +491,35 @@ MainWindow::~MainWindow()
         delete _playlistPlayer;
     if(_dataStorage != NULL)
         delete _dataStorage;
+    // their players belong to the libvlc instance of _app
+    if(_loudnessAnalyzer != NULL)
+        delete _loudnessAnalyzer;
+    if(_waveformExtractor != NULL)
+        delete _waveformExtractor;
+    if(_blackDetector != NULL)
+        delete _blackDetector;
+    if(_cropDetector != NULL)
+        delete _cropDetector;
+    if(_interlaceDetector != NULL)
+        delete _interlaceDetector;
+    if(_mediaVerifier != NULL)
+        delete _mediaVerifier;
+    if(_stagingCache != NULL)
+        delete _stagingCache;
+    if(_cacheWarmer != NULL)
+        delete _cacheWarmer;
+    if(_showPackage != NULL)
+        delete _showPackage;
+    if(_mediaIngest != NULL)
+        delete _mediaIngest;
+    if(_proxyGenerator != NULL)
+        delete _proxyGenerator;
+    if(_previewExtractor != NULL)
+        delete _previewExtractor;
+    if(_posterExtractor != NULL)
+        delete _posterExtractor;
+    if(_playbackRecovery != NULL)
+        delete _playbackRecovery;
     if(_app != NULL)
         delete _app;
     if(_advancedSettingsWindow != NULL)
@@ -428,15 +554,20 @@ void MainWindow::openListing(QString fileName) {
 
         _fileName = fileName;
 
+        // shown by listingLoaded, once the moved media are searched
         _dataStorage->load(file);
-        updatePlaylistListCombox();
         file.close();
-
-        ui->progEdit->setText(_dataStorage->projectTitle());
-        ui->notesEdit->setText(_dataStorage->projectNotes());
     }
 }
 
+void MainWindow::listingLoaded()
+{
+    updatePlaylistListCombox();
+
+    ui->progEdit->setText(_dataStorage->projectTitle());
+    ui->notesEdit->setText(_dataStorage->projectNotes());
+}
+
 QLabel* MainWindow::screenBefore() const
 {
     return ui->screenBefore;
@@ -535,77 +666,42 @@ void MainWindow::takeScreenshot(QString fileName)
 
 void MainWindow::takeScreenshot(QStringList fileNames)
 {
-    VideoWindow win(this);
-    VideoWidget *vw = win.videoWidget();
-    libvlc_instance_t *vlc = libvlc_new(0, NULL);
-    libvlc_media_player_t *vlcMP = libvlc_media_player_new(vlc);
+    foreach (QString fileName, fileNames)
+        if (!_screenshotQueue.contains(fileName))
+            _screenshotQueue.append(fileName);
 
-    WId wid = vw->request();
-
-    if (wid) {
-        #if defined(Q_OS_WIN)
-                libvlc_media_player_set_hwnd(vlcMP, (void *)wid);
-        #elif defined(Q_OS_MAC)
-                libvlc_media_player_set_nsobject(vlcMP, (void *)wid);
-        #elif defined(Q_OS_UNIX)
-                libvlc_media_player_set_xwindow(vlcMP, wid);
-        #endif
-    }
-    QDir appPath = QDir(qApp->applicationDirPath());
-
-    if(!QDir(appPath.path() + "/screenshot").exists())
-    {
-        QDir().mkdir(appPath.path() + "/screenshot");
-    }
-
-    foreach (QString fileName, fileNames) {
-        Media *media = new Media(fileName, _app->vlcInstance());
+    if (!_posterExtractor->isRunning())
+        takeNextScreenshot();
+}
 
-        QString screenPath = appPath.path() + "/screenshot/";
-        screenPath = screenPath.replace("/",QDir::separator());
-        screenPath +=  media->getLocation().replace(QDir::separator(),"_").remove(":");
-        screenPath += ".png";
+void MainWindow::takeNextScreenshot()
+{
+    while (!_screenshotQueue.isEmpty() && !_posterExtractor->isRunning()) {
+        Media *media = new Media(_screenshotQueue.takeFirst(), _app->vlcInstance());
 
-        if(!QFile(screenPath).exists() && !media->isAudio() && !media->isImage())
+        if(!media->isAudio() && !media->isImage() && !ThumbnailStore::contains(media->location()))
         {
-            libvlc_media_player_set_media(vlcMP, media->core());
-            libvlc_media_add_option(media->core(),":noaudio");
-            libvlc_media_player_play(vlcMP);
-            libvlc_media_player_set_position(vlcMP, 0.5f);
-            unsigned* width = new unsigned(0);
-            unsigned* height = new unsigned(0);
-            libvlc_video_get_size(vlcMP, 0, width, height);
-
-            // reduce the size to a suitable size
-            unsigned denom;
-            unsigned denomH = *height / (unsigned)ui->screen_none->height();
-            unsigned denomW = *width / (unsigned)ui->screen_none->width();
-            if(denomH < denomW)
-                denom = denomH;
-            else
-                denom = denomW;
-
-            if(denom > 1){
-                *width = *width/denom;
-                *height = *height/denom;
-            }
+            // the store keeps the smaller sizes, scaled from the largest
+            QSize size = FrameExtractor::frameSize(media, ThumbnailStore::LARGE_WIDTH);
 
-            wait(60);
-            libvlc_video_take_snapshot(vlcMP, 0, screenPath.toStdString().c_str(), *width, *height);
+            // the best of several candidate frames, rather than whatever is at the middle
+            _posterExtractor->extractPoster(media, size);
+        }
 
-            /*** Wait the screenshot creation to release the function ****/
-            while(!QFile::exists(screenPath)){
-                wait(3);
-            }
+        delete media;
+    }
+}
 
-            delete width;
-            delete height;
-        }
-        libvlc_media_player_stop(vlcMP);
+void MainWindow::posterExtracted(const QString &location, const QImage &poster)
+{
+    if (poster.isNull() || !ThumbnailStore::store(location, poster)) {
+        qDebug() << "Screenshot: no frame extracted from" << location;
+        return;
     }
 
-    libvlc_media_player_release(vlcMP);
-    libvlc_vlm_release(vlc);
+    if (_screensIndex >= 0 && currentPlaylistModel() != NULL
+            && _screensIndex < currentPlaylistModel()->playlist()->count())
+        setSelectedMediaTimeByIndex(_screensIndex);
 }
 
 void MainWindow::on_binDeleteMediaButton_clicked()
@@ -897,7 +993,10 @@ void MainWindow::on_menuVideoMode_triggered(QAction *action)
             action->setEnabled(false);
             action->setChecked(true);
             _projectionMode =  (VideoWindow::DisplayMode) action->data().toInt() ;
-            _videoWindow->setDisplayMode(_projectionMode);
+            if(_playlistPlayer->mediaPlayer()->engine() != NULL)
+                _playlistPlayer->mediaPlayer()->engine()->setDisplayMode(_projectionMode);
+            else
+                _videoWindow->setDisplayMode(_projectionMode);
         }
     }
 }
@@ -1099,6 +1198,9 @@ void MainWindow::on_scheduleAddButton_clicked()
 }
 
 void MainWindow::needVideoWindow(){
+    if(_playlistPlayer->mediaPlayer()->engine() != NULL)
+        return;
+
     if(!_videoWindow->isVisible()){
         _videoWindow->show();
     }
@@ -1222,6 +1324,300 @@ void MainWindow::on_updateAction_triggered(){
     up.checkVersion();
 }
 
+void MainWindow::on_analyzeLoudnessAction_triggered()
+{
+    int count = 0;
+
+    foreach(Media *media, _mediaListModel->mediaList()) {
+        if (media->hasLoudness())
+            continue;
+        _loudnessAnalyzer->analyze(media);
+        count++;
+    }
+
+    if (count == 0)
+        ui->statusBar->showMessage(tr("The loudness of every media is already analyzed"), 5000);
+}
+
+void MainWindow::on_normalizeLoudnessAction_triggered()
+{
+    PlaylistModel *model = currentPlaylistModel();
+    if (model == NULL)
+        return;
+
+    QSettings settings("opp", "opp");
+    bool ok;
+    double target = QInputDialog::getDouble(this, tr("Normalize playlist loudness"), tr("Target loudness (LUFS):"),
+                                            settings.value("loudnessTarget", Playlist::DEFAULT_LOUDNESS_TARGET).toDouble(),
+                                            -40, -5, 1, &ok);
+    if (!ok)
+        return;
+
+    settings.setValue("loudnessTarget", target);
+
+    int skipped = model->playlist()->normalizeLoudness(target);
+    updateSettings();
+
+    if (skipped > 0)
+        QMessageBox::information(this, tr("Normalize playlist loudness"),
+                                 tr("%1 item(s) kept their gain: their media is silent or not analyzed yet (Edit > Analyze loudness).").arg(skipped));
+}
+
+void MainWindow::loudnessProgress(int done, int total)
+{
+    ui->statusBar->showMessage(tr("Loudness analysis: %1 / %2 media").arg(done).arg(total));
+}
+
+void MainWindow::loudnessFinished()
+{
+    ui->statusBar->showMessage(tr("Loudness analysis done"), 5000);
+}
+
+void MainWindow::on_detectBlackFramesAction_triggered()
+{
+    int count = 0;
+
+    foreach(Media *media, _mediaListModel->mediaList()) {
+        if (media->hasBlackMarks() || media->isAudio() || media->isImage())
+            continue;
+        _blackDetector->analyze(media);
+        count++;
+    }
+
+    if (count == 0)
+        ui->statusBar->showMessage(tr("The black frames of every video are already detected"), 5000);
+}
+
+void MainWindow::blackFramesProgress(int done, int total)
+{
+    ui->statusBar->showMessage(tr("Black frame detection: %1 / %2 media").arg(done).arg(total));
+}
+
+void MainWindow::blackFramesFinished()
+{
+    ui->statusBar->showMessage(tr("Black frame detection done, see the advanced settings of the playlist items"), 5000);
+}
+
+void MainWindow::on_detectBlackBarsAction_triggered()
+{
+    int count = 0;
+
+    foreach(Media *media, _mediaListModel->mediaList()) {
+        if (media->hasDetectedCrop() || media->isAudio() || media->isImage())
+            continue;
+        _cropDetector->analyze(media);
+        count++;
+    }
+
+    if (count == 0)
+        ui->statusBar->showMessage(tr("The black bars of every video are already detected"), 5000);
+}
+
+void MainWindow::blackBarsProgress(int done, int total)
+{
+    ui->statusBar->showMessage(tr("Black bar detection: %1 / %2 media").arg(done).arg(total));
+}
+
+void MainWindow::blackBarsFinished()
+{
+    ui->statusBar->showMessage(tr("Black bar detection done, see the advanced picture settings of the playlist items"), 5000);
+}
+
+void MainWindow::on_detectInterlacingAction_triggered()
+{
+    int count = 0;
+
+    foreach(Media *media, _mediaListModel->mediaList()) {
+        if (media->scanType() != UnknownScan || media->isAudio() || media->isImage())
+            continue;
+        _interlaceDetector->analyze(media);
+        count++;
+    }
+
+    if (count == 0)
+        ui->statusBar->showMessage(tr("The scan type of every video is already detected"), 5000);
+}
+
+void MainWindow::interlacingProgress(int done, int total)
+{
+    ui->statusBar->showMessage(tr("Interlacing detection: %1 / %2 media").arg(done).arg(total));
+}
+
+void MainWindow::interlacingFinished()
+{
+    ui->statusBar->showMessage(tr("Interlacing detection done, the automatic deinterlacing follows it"), 5000);
+}
+
+void MainWindow::on_cancelBackgroundJobsAction_triggered()
+{
+    _app->jobScheduler()->cancelAll();
+    ui->statusBar->showMessage(tr("Background jobs cancelled"), 5000);
+}
+
+void MainWindow::on_verifyMediaAction_triggered()
+{
+    QList<Playlist*> playlists;
+
+    foreach(Schedule *schedule, _scheduleListModel->scheduleList())
+        if (!playlists.contains(schedule->playlist()))
+            playlists << schedule->playlist();
+
+    if (playlists.isEmpty())
+        playlists << currentPlaylistModel()->playlist();
+
+    int count = 0;
+
+    foreach(Playlist *playlist, playlists) {
+        foreach(Playback *playback, playlist->playbackList()) {
+            if (playback->media()->isImage())
+                continue;
+            _mediaVerifier->verify(playback->media());
+            count++;
+        }
+    }
+
+    if (count == 0)
+        ui->statusBar->showMessage(tr("No media to verify"), 5000);
+}
+
+void MainWindow::verificationProgress(int done, int total)
+{
+    ui->statusBar->showMessage(tr("Media verification: %1 / %2 media").arg(done).arg(total));
+    currentPlaylistModel()->updateLayout();
+}
+
+void MainWindow::verificationFinished()
+{
+    ui->statusBar->showMessage(tr("Media verification done, see the status of the playlist items"), 5000);
+}
+
+void MainWindow::stagingProgress(int done, int total)
+{
+    if (done < total)
+        ui->statusBar->showMessage(tr("Local copy of the scheduled media: %1 / %2 media").arg(done).arg(total));
+    else
+        ui->statusBar->showMessage(tr("Scheduled media copied locally"), 5000);
+}
+
+void MainWindow::on_exportPackageAction_triggered()
+{
+    if (_showPackage->isRunning()) {
+        QMessageBox::information(this, tr("Show package"), tr("A package is already being copied."));
+        return;
+    }
+
+    QString directory = QFileDialog::getExistingDirectory(this, tr("Export show package"), QDir::homePath());
+    if (directory.isEmpty())
+        return;
+
+    // the listing as it is now, saved or not
+    QTemporaryFile file(QDir::tempPath() + "/opp-XXXXXX.opp");
+    if (!file.open()) {
+        QMessageBox::information(this, tr("Unable to open file."), file.errorString());
+        return;
+    }
+
+    for (int i = 0; i < _playlistTabWidget->count(); i++)
+        _dataStorage->addPlaylistModel((PlaylistModel*) ( (PlaylistTableView*) _playlistTabWidget->widget(i) )->model());
+    _dataStorage->save(file);
+    file.close();
+
+    _importingPackage = false;
+    if (!_showPackage->exportTo(file.fileName(), directory))
+        QMessageBox::warning(this, tr("Show package"), tr("The package can not be written in %1.").arg(directory));
+}
+
+void MainWindow::on_importPackageAction_triggered()
+{
+    if (_showPackage->isRunning()) {
+        QMessageBox::information(this, tr("Show package"), tr("A package is already being copied."));
+        return;
+    }
+
+    QString directory = QFileDialog::getExistingDirectory(this, tr("Import show package"), QDir::homePath());
+    if (directory.isEmpty())
+        return;
+
+    QSettings settings("opp", "opp");
+    QString destination = QFileDialog::getExistingDirectory(this, tr("Copy the media into"), settings.value("moviesPath").toString());
+    if (destination.isEmpty())
+        return;
+
+    _importingPackage = true;
+    if (!_showPackage->importFrom(directory, destination))
+        QMessageBox::warning(this, tr("Show package"), tr("%1 is not a show package.").arg(directory));
+}
+
+void MainWindow::mediaIngested(Media *media)
+{
+    ui->statusBar->showMessage(tr("%1 added to the bin").arg(media->location()), 5000);
+}
+
+void MainWindow::on_generateProxiesAction_triggered()
+{
+    if (_proxyGenerator->generateAll() == 0)
+        ui->statusBar->showMessage(tr("Every video of the bin already has its proxy"), 5000);
+}
+
+void MainWindow::proxyProgress(int done, int total)
+{
+    ui->statusBar->showMessage(tr("Preview proxies: %1 / %2 media").arg(done).arg(total));
+}
+
+void MainWindow::proxyFinished()
+{
+    ui->statusBar->showMessage(tr("Preview proxies done"), 5000);
+}
+
+void MainWindow::playbackRetried(int attempt, int attempts)
+{
+    ui->statusBar->showMessage(tr("Playback failed, resuming (%1/%2)").arg(attempt).arg(attempts), 5000);
+}
+
+void MainWindow::playbackSkipped()
+{
+    ui->statusBar->showMessage(tr("Playback failed, skipped"), 5000);
+}
+
+void MainWindow::collectThumbnails()
+{
+    QStringList locations;
+    foreach(Media *media, _mediaListModel->mediaList())
+        locations << media->location();
+
+    ThumbnailStore::collectInBackground(locations);
+}
+
+void MainWindow::packageProgress(int done, int total)
+{
+    ui->statusBar->showMessage(tr("Show package: %1 / %2 files").arg(done).arg(total));
+}
+
+void MainWindow::packageSearchProgress(int scanned)
+{
+    ui->statusBar->showMessage(tr("Show package: %1 files scanned for the media already here").arg(scanned));
+}
+
+void MainWindow::packageFinished(bool succeeded, const QString &listing, const QString &report)
+{
+    if (!succeeded) {
+        ui->statusBar->clearMessage();
+        QMessageBox::warning(this, tr("Show package"),
+                             tr("Some files could not be copied, start again to resume the copy:\n%1").arg(report));
+        return;
+    }
+
+    if (!_importingPackage) {
+        ui->statusBar->showMessage(tr("Show package exported"), 5000);
+        return;
+    }
+
+    ui->statusBar->showMessage(tr("Show package imported in %1").arg(listing), 5000);
+
+    if (!_playlistPlayer->mediaPlayer()->isPlaying() && !_playlistPlayer->mediaPlayer()->isPaused() && verifSave() != 0)
+        openListing(listing);
+}
+
 QList<QWidget*> MainWindow::getLockedWidget()
 {
     QList<QWidget*> lockedWidget;
@@ -1242,6 +1638,17 @@ void MainWindow::setScreenshot(QString url)
     ui->screenBack->setPixmap(pixmap.scaled(ui->screenBack->size(), Qt::KeepAspectRatio, Qt::FastTransformation));
 }
 
+void MainWindow::setScreenshotImage(const QImage &image)
+{
+    if (image.isNull()) {
+        ui->screenBack->clear();
+        return;
+    }
+
+    QPixmap pixmap = QPixmap::fromImage(image);
+    ui->screenBack->setPixmap(pixmap.scaled(ui->screenBack->size(), Qt::KeepAspectRatio, Qt::FastTransformation));
+}
+
 QLabel* MainWindow::screenBack() const
 {
     return ui->screenBack;
@@ -1303,7 +1710,8 @@ void MainWindow::setSelectedMediaNameByIndex(int idx){
 
 void MainWindow::setSelectedMediaTimeByIndex(int idx)
 {
-    QDir appPath = QDir(qApp->applicationDirPath());
+    _screensIndex = idx;
+
     if(idx == -1)
     {
         ui->titleBefore->setText("");
@@ -1349,18 +1757,11 @@ void MainWindow::setSelectedMediaTimeByIndex(int idx)
         }
         else
         {
-            QString path = appPath.path()  + "/screenshot/";
-            path = path.replace("/",QDir::separator());
-            path +=  m->getLocation().replace(QDir::separator(),"_").remove(":");
-            path += ".png";
-
-            /*** If we can't load the screenshot, we retake it ***/
-            if(!pixmap.load((path.toStdString().c_str()))){
+            /*** If there is no screenshot, we take it, the screens are refreshed once it is stored ***/
+            QImage image = ThumbnailStore::thumbnail(m->getLocation(), qMax(ui->screen_none->width(), ui->screenBack->width()));
+            if(image.isNull())
                 takeScreenshot(m->getLocation());
-
-                /*** Retry ****/
-                pixmap.load((path.toStdString().c_str()));
-            }
+            pixmap = QPixmap::fromImage(image);
         }
         ui->screen_none->setPixmap(pixmap.scaled(ui->screen_none->size(), Qt::KeepAspectRatio, Qt::FastTransformation));
         ui->screenBack->setPixmap(pixmap.scaled(ui->screenBack->size(), Qt::KeepAspectRatio, Qt::FastTransformation));
@@ -1382,18 +1783,11 @@ void MainWindow::setSelectedMediaTimeByIndex(int idx)
             }
             else
             {
-                QString path = appPath.path() + "/screenshot/";
-                path = path.replace("/",QDir::separator());
-                path +=  mB->getLocation().replace(QDir::separator(),"_").remove(":");
-                path += ".png";
-
-                /*** If we can't load the screenshot, we retake it ***/
-                if(!pixmapB.load((path.toStdString().c_str()))){
+                /*** If there is no screenshot, we take it, the screens are refreshed once it is stored ***/
+                QImage imageB = ThumbnailStore::thumbnail(mB->getLocation(), ui->screenBefore->width());
+                if(imageB.isNull())
                     takeScreenshot(mB->getLocation());
-
-                    /*** Retry ****/
-                    pixmapB.load((path.toStdString().c_str()));
-                }
+                pixmapB = QPixmap::fromImage(imageB);
             }
             ui->screenBefore->setPixmap(pixmapB.scaled(ui->screenBefore->size(), Qt::KeepAspectRatio, Qt::FastTransformation));
             ui->labelBefore->setText(timeB.toString(display));
@@ -1427,18 +1821,11 @@ void MainWindow::setSelectedMediaTimeByIndex(int idx)
             }
             else
             {
-                QString path = appPath.path() + "/screenshot/";
-                path = path.replace("/",QDir::separator());
-                path +=  mA->getLocation().replace(QDir::separator(),"_").remove(":");
-                path += ".png";
-
-                /*** If we can't load the screenshot, we retake it ***/
-                if(!pixmapA.load((path.toStdString().c_str()))){
+                /*** If there is no screenshot, we take it, the screens are refreshed once it is stored ***/
+                QImage imageA = ThumbnailStore::thumbnail(mA->getLocation(), ui->screenAfter->width());
+                if(imageA.isNull())
                     takeScreenshot(mA->getLocation());
-
-                    /*** Retry ****/
-                    pixmapA.load((path.toStdString().c_str()));
-                }
+                pixmapA = QPixmap::fromImage(imageA);
             }
             ui->screenAfter->setPixmap(pixmapA.scaled(ui->screenAfter->size(), Qt::KeepAspectRatio, Qt::FastTransformation));
             ui->labelAfter->setText(timeA.toString(display));
@@ -1569,10 +1956,8 @@ QString MainWindow::scheduleToHml(){
                 int dure = (int)playback->media()->duration();
                 timeMedia += dure;
 
-                QString screenPath = qApp->applicationDirPath() + "/screenshot/";
-                screenPath = screenPath.replace("/",QDir::separator());
-                screenPath +=  playback->media()->getLocation().replace(QDir::separator(),"_").remove(":");
-                screenPath += ".png";
+                // the document refers to image files
+                QString screenPath = ThumbnailStore::exportFile(playback->media()->getLocation());
 
                 if(playback->media()->isAudio())
                     screenPath = "";
@@ -1691,11 +2076,6 @@ QString MainWindow::scheduleToHmlForPDF(){
                 int dure = (int)playback->media()->duration();
                 timeMedia += dure;
 
-                QString screenPath = qApp->applicationDirPath() + "/screenshot/";
-                screenPath = screenPath.replace("/",QDir::separator());
-                screenPath +=  playback->media()->getLocation().replace(QDir::separator(),"_").remove(":");
-                screenPath += ".png";
-
                 out += "<tr>"
                 + QString("<td class=\"droit titre\">%1</td>").arg(
                     playback->media()->name()
@@ -1784,8 +2164,8 @@ void MainWindow::on_viewExportPDFButton_clicked()
 
 void MainWindow::playMire(QString fileName){
     if(_vlcMire == NULL){
-        _vlcMire = libvlc_new(0, NULL);
-        _mpMire = new MediaPlayer(_vlcMire,this);
+        _vlcMire = _app->vlcInstance();
+        _mpMire = new MediaPlayer(_vlcMire,this,_app);
         QString path = QString("mires")+QDir::separator()+fileName;
         _mireMire = new Media(path,_vlcMire);
         _pbMire = new Playback(_mireMire);
@@ -1799,6 +2179,8 @@ void MainWindow::playMire(QString fileName){
     }else{
         _mpMire->stop();
         _mpMire->close(_pbMire);
+        // the playback owns the previous pattern media
+        delete(_pbMire);
         QString path = QString("mires")+QDir::separator()+fileName;
         _mireMire = new Media(path,_vlcMire);
         _pbMire = new Playback(_mireMire);
@@ -1819,7 +2201,7 @@ void MainWindow::closeWindowTestPattern(){
 void MainWindow::closeMirePlayer(){
     _mpMire->stop();
     if(_vlcMire != NULL){
-        libvlc_release(_vlcMire);
+        // shared instance, owned by _app
         _vlcMire=NULL;
     }
     if(_mpMire != NULL){
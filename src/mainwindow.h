@@ -36,6 +36,7 @@
 #include <QMainWindow>
 
 #include <QDataWidgetMapper>
+#include <QImage>
 #include <QLabel>
 #include <QModelIndexList>
 #include <QTime>
@@ -77,6 +78,19 @@ class Playlist;
 class Locker;
 class DataStorage;
 class ExportPDF;
+class LoudnessAnalyzer;
+class WaveformExtractor;
+class BlackDetector;
+class CropDetector;
+class InterlaceDetector;
+class MediaVerifier;
+class StagingCache;
+class CacheWarmer;
+class ShowPackage;
+class MediaIngest;
+class ProxyGenerator;
+class FrameExtractor;
+class PlaybackRecovery;
 class MediaPlayer;
 class Media;
 
@@ -94,6 +108,11 @@ public:
      */
     inline PlaylistPlayer* playlistPlayer() const { return _playlistPlayer; }
 
+    /**
+     * @brief return the application owning the shared libvlc instance and its player pool
+     */
+    inline VLCApplication* vlcApplication() const { return _app; }
+
     /**
      * @brief Getlocker
      *
@@ -149,6 +168,14 @@ public:
      */
     void openListing(QString fileName);
 
+    /**
+     * @brief Save the poster frame of the media without screenshot yet, in background
+     *
+     * The frame is chosen among several candidates by FrameExtractor::extractPoster,
+     * the screens of the selected playback are refreshed once it is stored.
+     *
+     * @param fileNames The media locations
+     */
     void takeScreenshot(QStringList fileNames);
 
     void takeScreenshot(QString fileName);
@@ -247,6 +274,12 @@ public slots:
      */
     void setScreenshot(QString url);
 
+    /**
+     * @brief Set a new screenshot in the screenBack
+     * @param image The screenshot, the screenBack is cleared if null
+     */
+    void setScreenshotImage(const QImage &image);
+
     /**
       *@brief Method used to set the previous and following selected medium back
       *
@@ -312,6 +345,11 @@ public slots:
 
 private slots:
 
+    /**
+     * @brief Show the project loaded by openListing
+     */
+    void listingLoaded();
+
     /**
      * @brief Show timeout before the end of the current playlist
      *
@@ -536,6 +574,188 @@ private slots:
      */
     void on_updateAction_triggered();
 
+    /**
+     * @brief Analyze the loudness of the media of the bin not analyzed yet
+     */
+    void on_analyzeLoudnessAction_triggered();
+
+    /**
+     * @brief Set the gain of the current playlist items to a target loudness
+     */
+    void on_normalizeLoudnessAction_triggered();
+
+    /**
+     * @brief Show the progress of the loudness analysis in the status bar
+     * @param done The number of media done
+     * @param total The number of media to analyze
+     */
+    void loudnessProgress(int done, int total);
+
+    /**
+     * @brief Tell the loudness analysis is over in the status bar
+     */
+    void loudnessFinished();
+
+    /**
+     * @brief Detect the black frames of the media of the bin not analyzed yet
+     */
+    void on_detectBlackFramesAction_triggered();
+
+    /**
+     * @brief Show the progress of the black frame detection in the status bar
+     * @param done The number of media done
+     * @param total The number of media to analyze
+     */
+    void blackFramesProgress(int done, int total);
+
+    /**
+     * @brief Tell the black frame detection is over in the status bar
+     */
+    void blackFramesFinished();
+
+    /**
+     * @brief Detect the black bars of the media of the bin not analyzed yet
+     */
+    void on_detectBlackBarsAction_triggered();
+
+    /**
+     * @brief Show the progress of the black bar detection in the status bar
+     * @param done The number of media done
+     * @param total The number of media to analyze
+     */
+    void blackBarsProgress(int done, int total);
+
+    /**
+     * @brief Tell the black bar detection is over in the status bar
+     */
+    void blackBarsFinished();
+
+    /**
+     * @brief Detect the scan type of the media of the bin not analyzed yet
+     */
+    void on_detectInterlacingAction_triggered();
+
+    /**
+     * @brief Show the progress of the interlacing detection in the status bar
+     * @param done The number of media done
+     * @param total The number of media to analyze
+     */
+    void interlacingProgress(int done, int total);
+
+    /**
+     * @brief Tell the interlacing detection is over in the status bar
+     */
+    void interlacingFinished();
+
+    /**
+     * @brief Verify the media of the scheduled playlists, of the current playlist if none is scheduled
+     */
+    void on_verifyMediaAction_triggered();
+
+    /**
+     * @brief Cancel the analyses and verifications running in background
+     */
+    void on_cancelBackgroundJobsAction_triggered();
+
+    /**
+     * @brief Show the progress of the verification in the status bar and the playlist
+     * @param done The number of media done
+     * @param total The number of media to verify
+     */
+    void verificationProgress(int done, int total);
+
+    /**
+     * @brief Tell the verification is over in the status bar
+     */
+    void verificationFinished();
+
+    /**
+     * @brief Show the progress of the local copies in the status bar
+     * @param done The number of media done
+     * @param total The number of media to copy
+     */
+    void stagingProgress(int done, int total);
+
+    /**
+     * @brief Export the listing and all its files to a package directory
+     */
+    void on_exportPackageAction_triggered();
+
+    /**
+     * @brief Copy the files of a package to this computer and open its listing
+     */
+    void on_importPackageAction_triggered();
+
+    /**
+     * @brief Show the progress of the package copy in the status bar
+     * @param done The number of files done
+     * @param total The number of files to copy
+     */
+    void packageProgress(int done, int total);
+
+    /**
+     * @brief Show the progress of the search of the files of an import already here
+     * @param scanned The number of files walked
+     */
+    void packageSearchProgress(int scanned);
+
+    /**
+     * @brief Tell the result of the package copy, open an imported listing
+     * @param succeeded True if every file is copied
+     * @param listing The listing written
+     * @param report The files which could not be copied
+     */
+    void packageFinished(bool succeeded, const QString &listing, const QString &report);
+
+    /**
+     * @brief Tell a media of a watch folder was added to the bin
+     */
+    void mediaIngested(Media *media);
+
+    /**
+     * @brief Transcode the proxies of the videos of the bin which have none
+     */
+    void on_generateProxiesAction_triggered();
+
+    /**
+     * @brief Show the progress of the proxy transcodes in the status bar
+     * @param done The number of media done
+     * @param total The number of media queued
+     */
+    void proxyProgress(int done, int total);
+
+    /**
+     * @brief Tell the proxy transcodes are over in the status bar
+     */
+    void proxyFinished();
+
+    /**
+     * @brief Tell a failing playback is opened again in the status bar
+     * @param attempt The attempt, from 1
+     * @param attempts The number of attempts before the next item
+     */
+    void playbackRetried(int attempt, int attempts);
+
+    /**
+     * @brief Tell a failing playback is skipped in the status bar
+     */
+    void playbackSkipped();
+
+    /**
+     * @brief Store a poster frame of takeScreenshot and refresh the screens
+     */
+    void posterExtracted(const QString &location, const QImage &poster);
+
+    /**
+     * @brief Start the extraction of the next poster frame queued by takeScreenshot
+     */
+    void takeNextScreenshot();
+
+    /**
+     * @brief Drop the orphan thumbnails in background, the media of the bin are kept
+     */
+    void collectThumbnails();
+
     /**
      * @brief Get Locked Widget
      *
@@ -725,13 +945,98 @@ private:
       */
     ExportPDF* _exportPDF;
 
+    /**
+     * @brief _loudnessAnalyzer Background loudness analysis of the media
+     */
+    LoudnessAnalyzer *_loudnessAnalyzer;
+
+    /**
+     * @brief _waveformExtractor Background extraction of the waveforms of the seek bar
+     */
+    WaveformExtractor *_waveformExtractor;
+
+    /**
+     * @brief _blackDetector Background detection of the black leader and tail of the media
+     */
+    BlackDetector *_blackDetector;
+
+    /**
+     * @brief _cropDetector Background detection of the black bars of the media
+     */
+    CropDetector *_cropDetector;
+
+    /**
+     * @brief _interlaceDetector Background detection of the scan type of the media
+     */
+    InterlaceDetector *_interlaceDetector;
+
+    /**
+     * @brief _mediaVerifier Background full decode of the media before a show
+     */
+    MediaVerifier *_mediaVerifier;
+
+    /**
+     * @brief _stagingCache Local copies of the scheduled media stored on network shares
+     */
+    StagingCache *_stagingCache;
+
+    /**
+     * @brief _cacheWarmer Read ahead of the media about to be played
+     */
+    CacheWarmer *_cacheWarmer;
+
+    /**
+     * @brief _showPackage Export and import of show packages
+     */
+    ShowPackage *_showPackage;
+
+    /**
+     * @brief _importingPackage True while a package is imported, false while exported
+     */
+    bool _importingPackage;
+
+    /**
+     * @brief _mediaIngest Background ingest of the watch folders
+     */
+    MediaIngest *_mediaIngest;
+
+    /**
+     * @brief _proxyGenerator Background transcode of the low resolution proxies
+     */
+    ProxyGenerator *_proxyGenerator;
+
+    /**
+     * @brief _previewExtractor Frames shown over the seek bar, decoded from the proxies
+     */
+    FrameExtractor *_previewExtractor;
+
+    /**
+     * @brief _posterExtractor Poster frames of the media without screenshot
+     */
+    FrameExtractor *_posterExtractor;
+
+    /**
+     * @brief _screenshotQueue The media locations waiting for their poster frame
+     */
+    QStringList _screenshotQueue;
+
+    /**
+     * @brief _screensIndex The playback shown by setSelectedMediaTimeByIndex, -1 if none
+     */
+    int _screensIndex;
+
+    /**
+     * @brief _playbackRecovery Resume or skip the failing playbacks of the playlist player
+     */
+    PlaybackRecovery *_playbackRecovery;
+
     /**
      * @brief logger
      */
     LoggerSingleton *_logger;
 
     /**
-     * @brief vlc instance for the test pattern
+     * @brief vlc instance for the test pattern (the shared instance of _app)
      */
     libvlc_instance_t *_vlcMire;
 
@@ -36,14 +36,16 @@
 
 #include <vlc/vlc.h>
 
-int Media::s_instanceCount = 0;
+QAtomicInt Media::s_instanceCount(0);
 
 Media::Media(const QString &location, libvlc_instance_t *vlcInstance, QObject *parent , bool isFile) :
-    QObject(parent), _usageCount(0), _original(NULL)
+    QObject(parent), _usageCount(0), _original(NULL),
+    _hasLoudness(false), _loudness(0.0), _loudnessRange(0.0), _truePeak(0.0),
+    _hasBlackMarks(false), _blackInMark(0), _blackOutMark(0),
+    _hasDetectedCrop(false), _detectedRatio(0), _scanType(UnknownScan),
+    _health(UnknownHealth)
 {
-    _id = s_instanceCount;
-
-    s_instanceCount++;
+    _id = s_instanceCount.fetchAndAddOrdered(1);
 
     initMedia(location);
     if(isFile)
@@ -55,9 +57,13 @@ Media::Media(const QString &location, libvlc_instance_t *vlcInstance, QObject *p
     parseMediaInfos();
 }
 
-Media::Media(Media *media, bool incrementParent)
+Media::Media(Media *media, bool incrementParent) :
+    _hasLoudness(false), _loudness(0.0), _loudnessRange(0.0), _truePeak(0.0),
+    _hasBlackMarks(false), _blackInMark(0), _blackOutMark(0),
+    _hasDetectedCrop(false), _detectedRatio(0), _scanType(UnknownScan),
+    _health(UnknownHealth)
 {
-    s_instanceCount++;
+    s_instanceCount.fetchAndAddOrdered(1);
 
     _original = media;
     initMedia(media->_location);
@@ -143,19 +149,35 @@ void Media::parseMediaInfos()
 }
 
 void Media::setImageTime(QString time){
+    _imageTime = time;
     libvlc_media_add_option(_vlcMedia,(QString(":image-duration=") + time).toLocal8Bit().data());
 }
 
 void Media::initMedia(const QString &location)
 {
     _location = location;
+    _playbackLocation = location;
     _fileInfo = QFileInfo(location);
 }
 
+void Media::setPlaybackLocation(const QString &file)
+{
+    const QString playbackLocation = file.isEmpty() ? _location : file;
+
+    if (playbackLocation == _playbackLocation)
+        return;
+
+    libvlc_media_release(_vlcMedia);
+    _vlcMedia = libvlc_media_new_path(_instance, playbackLocation.toStdString().data());
+    _playbackLocation = playbackLocation;
+}
+
 Media & Media::operator=(const Media &media)
 {
     if (this != &media) {
         _location = media._location;
+        _playbackLocation = media._playbackLocation;
+        _imageTime = media._imageTime;
         _fileInfo = QFileInfo(_location);
         _vlcMedia = libvlc_media_duplicate(media._vlcMedia);
     }
@@ -167,6 +189,98 @@ bool Media::operator==(const Media &media) const
     return _location == media.location();
 }
 
+void Media::setLoudness(double loudness, double range, double peak)
+{
+    // the analysis belongs to the media of the bin, shared by its playbacks
+    if (_original != NULL) {
+        _original->setLoudness(loudness, range, peak);
+        return;
+    }
+
+    _hasLoudness = true;
+    _loudness = loudness;
+    _loudnessRange = range;
+    _truePeak = peak;
+}
+
+void Media::setBlackMarks(int inMark, int outMark)
+{
+    if (_original != NULL) {
+        _original->setBlackMarks(inMark, outMark);
+        return;
+    }
+
+    _hasBlackMarks = true;
+    _blackInMark = inMark;
+    _blackOutMark = outMark;
+}
+
+void Media::setDetectedCrop(const QMargins &crop, int ratio)
+{
+    if (_original != NULL) {
+        _original->setDetectedCrop(crop, ratio);
+        return;
+    }
+
+    _hasDetectedCrop = true;
+    _detectedCrop = crop;
+    _detectedRatio = ratio;
+}
+
+void Media::setScanType(ScanType scanType)
+{
+    if (_original != NULL) {
+        _original->setScanType(scanType);
+        return;
+    }
+
+    _scanType = scanType;
+}
+
+void Media::setHealth(MediaHealth health, const QString &report)
+{
+    if (_original != NULL) {
+        _original->setHealth(health, report);
+        return;
+    }
+
+    _health = health;
+    _healthReport = report;
+}
+
+void Media::clearAnalyses()
+{
+    if (_original != NULL) {
+        _original->clearAnalyses();
+        return;
+    }
+
+    _hasLoudness = false;
+    _loudness = 0.0;
+    _loudnessRange = 0.0;
+    _truePeak = 0.0;
+    _hasBlackMarks = false;
+    _blackInMark = 0;
+    _blackOutMark = 0;
+    _hasDetectedCrop = false;
+    _detectedCrop = QMargins();
+    _detectedRatio = 0;
+    _scanType = UnknownScan;
+    _health = UnknownHealth;
+    _healthReport.clear();
+}
+
+void Media::setFingerprint(const QString &fingerprint, const QDateTime &date)
+{
+    if (_original != NULL) {
+        _original->setFingerprint(fingerprint, date);
+        return;
+    }
+
+    _fingerprint = fingerprint;
+    _fingerprintDate = date;
+}
+
 void Media::setId(int id)
 {
     _id = id;
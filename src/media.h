@@ -44,10 +44,13 @@
 #define EXTENSIONS_IMAGE "*.png;*.jpeg;*.jpg;*.gif;*.tiff"
 
 #include <QtCore/QObject>
+#include <QAtomicInt>
 #include <QFileInfo>
+#include <QDateTime>
 #include <QTime>
 #include <QPair>
 #include <QSize>
+#include <QMargins>
 
 #include "audiotrack.h"
 #include "videotrack.h"
@@ -56,6 +59,12 @@
 struct libvlc_media_t;
 struct libvlc_instance_t;
 
+/**
+ * @enum MediaHealth
+ * @brief Result of the verification of a media by a full decode
+ */
+enum MediaHealth {UnknownHealth = 0, Healthy = 1, Damaged = 2, Unreadable = 3};
+
 /**
  * @brief Manage media informations
  */
@@ -117,6 +126,22 @@ public:
      */
     inline libvlc_media_t* core() const { return _vlcMedia; }
 
+    /**
+     * @brief Read the media from another file, a local copy of the location
+     *
+     * The libvlc media core is replaced, so the options added to the previous
+     * one are lost. The location does not change.
+     *
+     * @param file The file to read, the location itself if empty
+     */
+    void setPlaybackLocation(const QString &file);
+
+    /**
+     * @brief Get the file read by the libvlc media core
+     * @return The local copy, or the location itself
+     */
+    inline QString playbackLocation() const { return _playbackLocation; }
+
     /**
      * @brief Get identifier
      * @return
@@ -275,6 +300,11 @@ public:
      */
     void setImageTime(QString time);
 
+    /**
+     * @brief Get the time given to an image, in seconds, empty if none
+     */
+    inline QString imageTime() const { return _imageTime; }
+
     /**
      * @brief Method used to set the duration of media
      *
@@ -310,6 +340,148 @@ public:
       */
     int size(){return _size;}
 
+    /**
+     * @brief Allow to know if the loudness of the media was analyzed
+     *
+     * The analysis of a playback media is the one of its original media.
+     *
+     * @return True if analyzed, false otherwise
+     */
+    inline bool hasLoudness() const { return _original != NULL ? _original->hasLoudness() : _hasLoudness; }
+
+    /**
+     * @brief Get the integrated loudness (EBU R128)
+     * @return The loudness in LUFS
+     */
+    inline double loudness() const { return _original != NULL ? _original->loudness() : _loudness; }
+
+    /**
+     * @brief Get the loudness range (EBU R128)
+     * @return The range in LU
+     */
+    inline double loudnessRange() const { return _original != NULL ? _original->loudnessRange() : _loudnessRange; }
+
+    /**
+     * @brief Get the true peak
+     * @return The peak in dBTP
+     */
+    inline double truePeak() const { return _original != NULL ? _original->truePeak() : _truePeak; }
+
+    /**
+     * @brief Set the result of a loudness analysis
+     * @param loudness The integrated loudness (LUFS)
+     * @param range The loudness range (LU)
+     * @param peak The true peak (dBTP)
+     */
+    void setLoudness(double loudness, double range, double peak);
+
+    /**
+     * @brief Allow to know if the black frames of the media were detected
+     * @return True if detected, false otherwise
+     */
+    inline bool hasBlackMarks() const { return _original != NULL ? _original->hasBlackMarks() : _hasBlackMarks; }
+
+    /**
+     * @brief Get the in mark proposed by the black frame detection
+     * @return The end of the black leader (ms), 0 without leader
+     */
+    inline int blackInMark() const { return _original != NULL ? _original->blackInMark() : _blackInMark; }
+
+    /**
+     * @brief Get the out mark proposed by the black frame detection
+     * @return The start of the black tail (ms), the duration without tail
+     */
+    inline int blackOutMark() const { return _original != NULL ? _original->blackOutMark() : _blackOutMark; }
+
+    /**
+     * @brief Set the result of a black frame detection
+     * @param inMark The end of the black leader (ms)
+     * @param outMark The start of the black tail (ms)
+     */
+    void setBlackMarks(int inMark, int outMark);
+
+    /**
+     * @brief Allow to know if the black bars of the media were detected
+     * @return True if detected, false otherwise
+     */
+    inline bool hasDetectedCrop() const { return _original != NULL ? _original->hasDetectedCrop() : _hasDetectedCrop; }
+
+    /**
+     * @brief Get the crop proposed by the black bar detection
+     * @return The width of the bars in pixels of the video track
+     */
+    inline QMargins detectedCrop() const { return _original != NULL ? _original->detectedCrop() : _detectedCrop; }
+
+    /**
+     * @brief Get the ratio of the picture inside the black bars
+     * @return A Ratio value, Original if not a known ratio
+     */
+    inline int detectedRatio() const { return _original != NULL ? _original->detectedRatio() : _detectedRatio; }
+
+    /**
+     * @brief Set the result of a black bar detection
+     * @param crop The width of the bars in pixels of the video track
+     * @param ratio The ratio of the picture inside the bars, a Ratio value
+     */
+    void setDetectedCrop(const QMargins &crop, int ratio);
+
+    /**
+     * @brief Get the scan type found by the interlace detection
+     * @return The scan type, UnknownScan if not detected
+     */
+    inline ScanType scanType() const { return _original != NULL ? _original->scanType() : _scanType; }
+
+    /**
+     * @brief Set the result of an interlace detection
+     */
+    void setScanType(ScanType scanType);
+
+    /**
+     * @brief Get the health found by the last verification
+     * @return The health, UnknownHealth if not verified
+     */
+    inline MediaHealth health() const { return _original != NULL ? _original->health() : _health; }
+
+    /**
+     * @brief Get the problems found by the last verification
+     * @return One problem per line, empty if none
+     */
+    inline QString healthReport() const { return _original != NULL ? _original->healthReport() : _healthReport; }
+
+    /**
+     * @brief Set the result of a verification
+     * @param health The health
+     * @param report The problems found, one per line
+     */
+    void setHealth(MediaHealth health, const QString &report);
+
+    /**
+     * @brief Forget the results of the analyses, when the file is replaced
+     *
+     * The loudness, the black marks, the detected crop, the scan type and
+     * the health are unknown again.
+     */
+    void clearAnalyses();
+
+    /**
+     * @brief Get the fingerprint of the content of the file
+     * @return The fingerprint, empty if not computed
+     * @see Fingerprint
+     */
+    inline QString fingerprint() const { return _original != NULL ? _original->fingerprint() : _fingerprint; }
+
+    /**
+     * @brief Get the modification date of the file when its fingerprint was computed
+     * @return The date, invalid if unknown
+     */
+    inline QDateTime fingerprintDate() const { return _original != NULL ? _original->fingerprintDate() : _fingerprintDate; }
+
+    /**
+     * @brief Set the fingerprint of the content of the file
+     * @param fingerprint The fingerprint
+     * @param date The modification date of the file when it was computed
+     */
+    void setFingerprint(const QString &fingerprint, const QDateTime &date = QDateTime());
 
 protected:
 
@@ -337,8 +509,9 @@ private:
 
     /**
      * @brief The number of created instances, used to set a unique identifier for each instance.
+     * Atomic as media are also created by the background ingest.
      */
-    static int s_instanceCount;
+    static QAtomicInt s_instanceCount;
 
     /**
      * @brief The instance identifier. Used for data serialization
@@ -350,6 +523,16 @@ private:
      */
     QString _location;
 
+    /**
+     * @brief The file read by the libvlc media core, a local copy or the location
+     */
+    QString _playbackLocation;
+
+    /**
+     * @brief The time given to an image, in seconds
+     */
+    QString _imageTime;
+
     /**
      * @brief Helper, it is used to fetch file informations
      */
@@ -399,6 +582,81 @@ private:
       * @brief size of the file
       */
     int _size;
+
+    /**
+     * @brief True if the loudness was analyzed
+     */
+    bool _hasLoudness;
+
+    /**
+     * @brief Integrated loudness (LUFS)
+     */
+    double _loudness;
+
+    /**
+     * @brief Loudness range (LU)
+     */
+    double _loudnessRange;
+
+    /**
+     * @brief True peak (dBTP)
+     */
+    double _truePeak;
+
+    /**
+     * @brief True if the black frames were detected
+     */
+    bool _hasBlackMarks;
+
+    /**
+     * @brief End of the black leader (ms)
+     */
+    int _blackInMark;
+
+    /**
+     * @brief Start of the black tail (ms)
+     */
+    int _blackOutMark;
+
+    /**
+     * @brief True if the black bars were detected
+     */
+    bool _hasDetectedCrop;
+
+    /**
+     * @brief Width of the black bars (pixels)
+     */
+    QMargins _detectedCrop;
+
+    /**
+     * @brief Ratio of the picture inside the bars
+     */
+    int _detectedRatio;
+
+    /**
+     * @brief Scan type of the video
+     */
+    ScanType _scanType;
+
+    /**
+     * @brief Health found by the last verification
+     */
+    MediaHealth _health;
+
+    /**
+     * @brief Problems found by the last verification
+     */
+    QString _healthReport;
+
+    /**
+     * @brief Fingerprint of the content, to find the file again when moved
+     */
+    QString _fingerprint;
+
+    /**
+     * @brief Modification date of the file when the fingerprint was computed
+     */
+    QDateTime _fingerprintDate;
 };
 
 #endif // MEDIA_H
@@ -0,0 +1,361 @@
+/**********************************************************************************
+ * This file is part of Open Projection Program (OPP).
+ *
+ * Copyright (C) 2013 Catalogue Ouvert du Cinéma <dev@cinemaouvert.fr>
+ *
+ * Authors: Jerome Blanchi <d.j.a.y@free.fr>
+ *
+ * Open Projection Program is an initiative of Catalogue Ouvert du Cinéma.
+ * The software was developed by four students of University of Poitiers
+ * as school project.
+ *
+ * Open Projection Program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Open Projection Program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Open Projection Program. If not, see <http://www.gnu.org/licenses/>.
+ **********************************************************************************/
+
+#include "mediaingest.h"
+
+#include <QCoreApplication>
+#include <QDebug>
+#include <QDir>
+#include <QDirIterator>
+#include <QFile>
+#include <QFileInfo>
+#include <QRunnable>
+#include <QSettings>
+#include <QThread>
+#include <QTimer>
+
+#include "VLCApplication.h"
+#include "fingerprint.h"
+#include "frameextractor.h"
+#include "medialistmodel.h"
+#include "proxygenerator.h"
+#include "thumbnailstore.h"
+#include "waveform.h"
+
+/**
+ * @brief Size and date of a file, empty if the file is gone
+ */
+static QString fileStamp(const QFileInfo &info)
+{
+    if (!info.exists())
+        return QString();
+
+    return QString("%1:%2").arg(info.size()).arg(info.lastModified().toMSecsSinceEpoch());
+}
+
+/**
+ * @brief List the media files and the subdirectories of a directory
+ */
+class IngestScan : public QRunnable
+{
+public:
+    IngestScan(QObject *ingest, const QString &directory, bool recursive) :
+        ingest(ingest), directory(directory), recursive(recursive) {}
+
+    void run()
+    {
+        const QStringList extensions = Media::mediaExtensions();
+        QStringList directories;
+        QStringList files;
+        QStringList stamps;
+
+        QDirIterator it(directory, QDir::AllDirs | QDir::Files | QDir::Readable | QDir::NoDotAndDotDot,
+                        recursive ? QDirIterator::Subdirectories : QDirIterator::NoIteratorFlags);
+
+        while (it.hasNext()) {
+            it.next();
+            QFileInfo info = it.fileInfo();
+
+            if (info.isDir()) {
+                directories << info.absoluteFilePath();
+            } else if (QDir::match(extensions, info.fileName())) {
+                files << info.absoluteFilePath();
+                stamps << fileStamp(info);
+            }
+        }
+
+        QMetaObject::invokeMethod(ingest, "directoryScanned", Qt::QueuedConnection,
+                                  Q_ARG(bool, recursive), Q_ARG(QStringList, directories),
+                                  Q_ARG(QStringList, files), Q_ARG(QStringList, stamps));
+    }
+
+    QObject *ingest;
+    QString directory;
+    bool recursive;
+};
+
+/**
+ * @brief Get the size and date of the files being written
+ */
+class IngestCheck : public QRunnable
+{
+public:
+    IngestCheck(QObject *ingest, const QStringList &files) : ingest(ingest), files(files) {}
+
+    void run()
+    {
+        QStringList stamps;
+        foreach (const QString &file, files)
+            stamps << fileStamp(QFileInfo(file));
+
+        QMetaObject::invokeMethod(ingest, "filesChecked", Qt::QueuedConnection,
+                                  Q_ARG(QStringList, files), Q_ARG(QStringList, stamps));
+    }
+
+    QObject *ingest;
+    QStringList files;
+};
+
+/**
+ * @brief Parse and fingerprint a file, the media is given to the UI thread
+ */
+class IngestProbe : public QRunnable
+{
+public:
+    IngestProbe(QObject *ingest, libvlc_instance_t *vlcInstance, const QString &file) :
+        ingest(ingest), vlcInstance(vlcInstance), file(file) {}
+
+    void run()
+    {
+        Media *media = new Media(file, vlcInstance);
+        // the date before the content: a file changed meanwhile is fingerprinted again
+        QDateTime modified = QFileInfo(file).lastModified();
+        media->setFingerprint(Fingerprint::compute(file), modified);
+        media->moveToThread(QCoreApplication::instance()->thread());
+
+        QMetaObject::invokeMethod(ingest, "mediaProbed", Qt::QueuedConnection,
+                                  Q_ARG(void *, media));
+    }
+
+    QObject *ingest;
+    libvlc_instance_t *vlcInstance;
+    QString file;
+};
+
+MediaIngest::MediaIngest(VLCApplication *vlcApp, MediaListModel *mediaListModel, QObject *parent) :
+    QObject(parent),
+    _vlcApp(vlcApp),
+    _mediaListModel(mediaListModel),
+    _watcher(new QFileSystemWatcher(this)),
+    _timer(new QTimer(this)),
+    _checking(false),
+    _extractor(new FrameExtractor(vlcApp, this))
+{
+    _pool.setMaxThreadCount(PROBE_THREADS);
+
+    connect(_watcher, SIGNAL(directoryChanged(QString)), this, SLOT(directoryChanged(QString)));
+    connect(_extractor, SIGNAL(posterExtracted(QString,QImage)), this, SLOT(posterExtracted(QString,QImage)));
+    connect(_extractor, SIGNAL(finished()), this, SLOT(screenshotTaken()));
+    connect(_timer, SIGNAL(timeout()), this, SLOT(poll()));
+    _timer->start(POLL_INTERVAL);
+}
+
+MediaIngest::~MediaIngest()
+{
+    // the end of the extraction would start the next one
+    _screenshots.clear();
+    _extractor->cancel();
+    _pool.waitForDone();
+}
+
+void MediaIngest::setFolders(const QStringList &folders)
+{
+    _folders = folders;
+
+    if (!_watcher->directories().isEmpty())
+        _watcher->removePaths(_watcher->directories());
+    _pending.clear();
+
+    foreach (const QString &folder, _folders) {
+        if (!QDir(folder).exists())
+            continue;
+
+        _watcher->addPath(folder);
+        scan(folder, true);
+    }
+}
+
+void MediaIngest::directoryChanged(const QString &directory)
+{
+    // a removed directory is not watched anymore
+    if (QDir(directory).exists())
+        scan(directory, false);
+}
+
+void MediaIngest::directoryScanned(bool recursive, const QStringList &directories, const QStringList &files, const QStringList &stamps)
+{
+    const QStringList watched = _watcher->directories();
+
+    foreach (const QString &directory, directories) {
+        if (watched.contains(directory))
+            continue;
+
+        _watcher->addPath(directory);
+        if (!recursive)
+            scan(directory, true);
+    }
+
+    const QDateTime now = QDateTime::currentDateTime();
+
+    for (int i = 0; i < files.count(); i++) {
+        const QString &file = files.at(i);
+        const QString &stamp = stamps.at(i);
+
+        if (_ingested.value(file) == stamp || (_pending.contains(file) && _pending.value(file).stamp == stamp))
+            continue;
+
+        // in the bin before it was watched
+        if (!_ingested.contains(file) && _mediaListModel->contains(file)) {
+            _ingested.insert(file, stamp);
+            continue;
+        }
+
+        Pending pending;
+        pending.stamp = stamp;
+        pending.since = now;
+        _pending.insert(file, pending);
+    }
+}
+
+void MediaIngest::poll()
+{
+    QSettings settings("opp", "opp");
+    QStringList folders = settings.value("watchFolders").toStringList();
+    if (folders != _folders)
+        setFolders(folders);
+
+    if (_checking || _pending.isEmpty())
+        return;
+
+    _checking = true;
+    _pool.start(new IngestCheck(this, _pending.keys()));
+}
+
+void MediaIngest::filesChecked(const QStringList &files, const QStringList &stamps)
+{
+    _checking = false;
+
+    const QDateTime now = QDateTime::currentDateTime();
+
+    for (int i = 0; i < files.count(); i++) {
+        const QString &file = files.at(i);
+        const QString &stamp = stamps.at(i);
+
+        if (!_pending.contains(file))
+            continue;
+
+        if (stamp.isEmpty()) {
+            _pending.remove(file);
+        } else if (stamp != _pending.value(file).stamp) {
+            // still being written
+            _pending[file].stamp = stamp;
+            _pending[file].since = now;
+        } else if (_pending.value(file).since.msecsTo(now) >= SETTLE_TIME) {
+            _pending.remove(file);
+            _ingested.insert(file, stamp);
+            _pool.start(new IngestProbe(this, _vlcApp->vlcInstance(), file));
+        }
+    }
+}
+
+void MediaIngest::mediaProbed(void *data)
+{
+    Media *media = (Media *)data;
+    const QString location = media->location();
+
+    // a file of the bin was replaced, the results of its analyses are outdated
+    if (_mediaListModel->contains(location)) {
+        foreach (Media *binMedia, _mediaListModel->mediaList()) {
+            if (binMedia->location() != location || binMedia->fingerprint() == media->fingerprint())
+                continue;
+
+            // the caches of the previous version, named after its size and date
+            const QDateTime previousDate = binMedia->fingerprintDate();
+            if (previousDate.isValid()) {
+                const qint64 previousSize = Fingerprint::size(binMedia->fingerprint());
+                QFile::remove(Waveform::cacheFile(location, previousSize, previousDate));
+                QFile::remove(ProxyGenerator::proxyFile(location, previousSize, previousDate));
+            }
+            FrameExtractor::removeFilmstrips(location);
+
+            binMedia->setFingerprint(media->fingerprint(), media->fingerprintDate());
+            binMedia->clearAnalyses();
+            // the new content has no thumbnail, a screenshot of an older version is dropped
+            ThumbnailStore::remove(location);
+            _screenshots << binMedia;
+        }
+        delete media;
+        takeNextScreenshot();
+        return;
+    }
+
+    if (!media->exists() || (media->audioTracks().isEmpty() && media->videoTracks().isEmpty() && !media->isImage())) {
+        qDebug() << "Ingest: no media in" << location;
+        delete media;
+        return;
+    }
+
+    if (!media->fingerprint().isEmpty()) {
+        foreach (Media *binMedia, _mediaListModel->mediaList()) {
+            if (binMedia->fingerprint() == media->fingerprint()) {
+                qDebug() << "Ingest:" << location << "is a copy of" << binMedia->location();
+                delete media;
+                return;
+            }
+        }
+    }
+
+    _mediaListModel->addMedia(media);
+    emit ingested(media);
+
+    if (!media->isAudio() && !media->isImage() && !ThumbnailStore::contains(location)) {
+        _screenshots << media;
+        takeNextScreenshot();
+    }
+}
+
+void MediaIngest::takeNextScreenshot()
+{
+    while (!_extractor->isRunning() && !_screenshots.isEmpty()) {
+        Media *media = _screenshots.takeFirst();
+        if (media == NULL)
+            continue;
+
+        // a media without duration or picture is not started
+        _screenshotMedia = media;
+        _extractor->extractPoster(media, FrameExtractor::frameSize(media, SCREENSHOT_WIDTH));
+    }
+}
+
+void MediaIngest::posterExtracted(const QString &location, const QImage &poster)
+{
+    if (_screenshotMedia == NULL || _screenshotMedia->location() != location || poster.isNull())
+        return;
+
+    if (!ThumbnailStore::store(location, poster, _screenshotMedia->fingerprint()))
+        qDebug() << "Ingest: can not save the screenshot of" << location;
+}
+
+void MediaIngest::screenshotTaken()
+{
+    _screenshotMedia = NULL;
+
+    takeNextScreenshot();
+}
+
+void MediaIngest::scan(const QString &directory, bool recursive)
+{
+    _pool.start(new IngestScan(this, directory, recursive));
+}
@@ -0,0 +1,197 @@
+/**********************************************************************************
+ * This file is part of Open Projection Program (OPP).
+ *
+ * Copyright (C) 2013 Catalogue Ouvert du Cinéma <dev@cinemaouvert.fr>
+ *
+ * Authors: Jerome Blanchi <d.j.a.y@free.fr>
+ *
+ * Open Projection Program is an initiative of Catalogue Ouvert du Cinéma.
+ * The software was developed by four students of University of Poitiers
+ * as school project.
+ *
+ * Open Projection Program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Open Projection Program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Open Projection Program. If not, see <http://www.gnu.org/licenses/>.
+ **********************************************************************************/
+
+#ifndef MEDIAINGEST_H
+#define MEDIAINGEST_H
+
+#include <QObject>
+#include <QDateTime>
+#include <QFileSystemWatcher>
+#include <QHash>
+#include <QImage>
+#include <QPointer>
+#include <QStringList>
+#include <QThreadPool>
+
+#include "media.h"
+
+class QTimer;
+class FrameExtractor;
+class MediaListModel;
+class VLCApplication;
+
+/**
+ * @brief Add the media arriving in watch folders to the bin, in background
+ *
+ * The folders of the watchFolders setting and their subdirectories are
+ * watched, and a changed directory is listed again on the thread pool. A new
+ * or changed file waits until its size and date stay the same for
+ * SETTLE_TIME, then it is parsed and fingerprinted on the pool. It is added
+ * to the bin unless a media of the bin has its location or its fingerprint.
+ * The screenshots are taken afterwards, one media at a time, as by the main
+ * window. The UI thread only receives the results.
+ */
+class MediaIngest : public QObject
+{
+    Q_OBJECT
+public:
+    explicit MediaIngest(VLCApplication *vlcApp, MediaListModel *mediaListModel, QObject *parent = 0);
+    ~MediaIngest();
+
+    /**
+     * @brief POLL_INTERVAL Time between two checks of the files being written (ms)
+     */
+    static const int POLL_INTERVAL = 2000;
+
+    /**
+     * @brief SETTLE_TIME Time a file must stay unchanged before its ingest (ms)
+     */
+    static const int SETTLE_TIME = 5000;
+
+    /**
+     * @brief PROBE_THREADS Files listed or parsed at once
+     */
+    static const int PROBE_THREADS = 2;
+
+    /**
+     * @brief SCREENSHOT_WIDTH Width of the screenshots taken
+     */
+    static const int SCREENSHOT_WIDTH = 320;
+
+public slots:
+    /**
+     * @brief Watch other folders, the files already found are not ingested again
+     * @param folders The folders, watched with their subdirectories
+     */
+    void setFolders(const QStringList &folders);
+
+signals:
+    /**
+     * @brief Emitted when a media is added to the bin
+     * @param media The media
+     */
+    void ingested(Media *media);
+
+private slots:
+    /**
+     * @brief List a changed directory again
+     */
+    void directoryChanged(const QString &directory);
+
+    /**
+     * @brief Receive the listing of a directory
+     * @param recursive True if the subdirectories were listed too
+     * @param directories The subdirectories, the new ones are watched
+     * @param files The media files
+     * @param stamps The size and date of each file
+     */
+    void directoryScanned(bool recursive, const QStringList &directories, const QStringList &files, const QStringList &stamps);
+
+    /**
+     * @brief Check the settings and the files being written
+     */
+    void poll();
+
+    /**
+     * @brief Receive the size and date of the files being written
+     */
+    void filesChecked(const QStringList &files, const QStringList &stamps);
+
+    /**
+     * @brief Add a parsed media to the bin unless it is a duplicate
+     * @param media The media, created on the pool
+     */
+    void mediaProbed(void *media);
+
+    /**
+     * @brief Save the screenshot of the running extraction
+     */
+    void posterExtracted(const QString &location, const QImage &poster);
+
+    /**
+     * @brief Take the next screenshot once the extraction ended
+     */
+    void screenshotTaken();
+
+private:
+    /**
+     * @brief File waiting for the end of its writing
+     */
+    struct Pending {
+        QString stamp;
+        QDateTime since;
+    };
+
+    /**
+     * @brief List a directory on the pool
+     */
+    void scan(const QString &directory, bool recursive);
+
+    /**
+     * @brief Take the next screenshot of the queue
+     */
+    void takeNextScreenshot();
+
+    VLCApplication *_vlcApp;
+
+    MediaListModel *_mediaListModel;
+
+    QFileSystemWatcher *_watcher;
+
+    QThreadPool _pool;
+
+    QTimer *_timer;
+
+    QStringList _folders;
+
+    /**
+     * @brief _ingested The size and date of each file found, when it was ingested
+     */
+    QHash<QString, QString> _ingested;
+
+    /**
+     * @brief _pending The files being written
+     */
+    QHash<QString, Pending> _pending;
+
+    /**
+     * @brief _checking True while the pending files are checked on the pool
+     */
+    bool _checking;
+
+    FrameExtractor *_extractor;
+
+    /**
+     * @brief _screenshots The media waiting for their screenshot
+     */
+    QList<QPointer<Media> > _screenshots;
+
+    /**
+     * @brief _screenshotMedia The media of the running extraction
+     */
+    QPointer<Media> _screenshotMedia;
+};
+
+#endif // MEDIAINGEST_H
@@ -62,6 +62,13 @@ public:
      */
     inline const QList<Media*>& mediaList() { return _mediaList; }
 
+    /**
+     * @brief Allow to know if a file is in the list
+     * @param location The file location
+     * @return True if a media has this location, false otherwise
+     */
+    inline bool contains(const QString &location) const { return _mediaFileList.contains(location); }
+
     /**
      * @brief Returns the number of columns
      * @return The number of columns
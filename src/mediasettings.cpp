@@ -41,6 +41,98 @@ QString MediaSettings::subtitlesFile() const
     return _subtitlesFile;
 }
 
+QVariantMap MediaSettings::toMap() const
+{
+    QVariantMap map;
+
+    map["ratio"] = (int)_ratio;
+    map["scale"] = (int)_scale;
+    map["deinterlacing"] = (int)_deinterlacing;
+    map["subtitlesSync"] = _subtitlesSync;
+    map["subtitlesFile"] = _subtitlesFile;
+    map["gamma"] = _gamma;
+    map["contrast"] = _contrast;
+    map["brightness"] = _brightness;
+    map["saturation"] = _saturation;
+    map["hue"] = _hue;
+    map["audioSync"] = _audioSync;
+    map["audioTrack"] = _audioTrack;
+    map["videoTrack"] = _videoTrack;
+    map["subtitlesTrack"] = _subtitlesTrack;
+    map["subtitlesEncode"] = _subtitlesEncode;
+    map["decoderProfile"] = (int)_decoderProfile;
+    map["testPattern"] = _testPattern;
+    map["inMark"] = _inMark;
+    map["outMark"] = _outMark;
+    map["gain"] = _gain;
+    map["cropTop"] = _cropTop;
+    map["cropLeft"] = _cropLeft;
+    map["cropRight"] = _cropRight;
+    map["cropBot"] = _cropBot;
+    map["audioFadeOut"] = _audioFadeOut;
+    map["audioFadeIn"] = _audioFadeIn;
+    map["videoFadeOut"] = _videoFadeOut;
+    map["videoFadeIn"] = _videoFadeIn;
+
+    return map;
+}
+
+void MediaSettings::fromMap(const QVariantMap &map)
+{
+    if (map.value("ratio").toInt() != (int)_ratio)
+        setRatio((Ratio)map.value("ratio").toInt());
+    if (map.value("scale").toInt() != (int)_scale)
+        setScale((Scale)map.value("scale").toInt());
+    if (map.value("deinterlacing").toInt() != (int)_deinterlacing)
+        setDeinterlacing((Deinterlacing)map.value("deinterlacing").toInt());
+    if (map.value("subtitlesSync").toDouble() != _subtitlesSync)
+        setSubtitlesSync(map.value("subtitlesSync").toDouble());
+    if (map.value("subtitlesFile").toString() != _subtitlesFile)
+        setSubtitlesFile(map.value("subtitlesFile").toString());
+    if (map.value("gamma").toFloat() != _gamma)
+        setGamma(map.value("gamma").toFloat());
+    if (map.value("contrast").toFloat() != _contrast)
+        setContrast(map.value("contrast").toFloat());
+    if (map.value("brightness").toFloat() != _brightness)
+        setBrightness(map.value("brightness").toFloat());
+    if (map.value("saturation").toFloat() != _saturation)
+        setSaturation(map.value("saturation").toFloat());
+    if (map.value("hue").toInt() != _hue)
+        setHue(map.value("hue").toInt());
+    if (map.value("audioSync").toDouble() != _audioSync)
+        setAudioSync(map.value("audioSync").toDouble());
+    if (map.value("audioTrack").toInt() != _audioTrack)
+        setAudioTrack(map.value("audioTrack").toInt());
+    if (map.value("videoTrack").toInt() != _videoTrack)
+        setVideoTrack(map.value("videoTrack").toInt());
+    if (map.value("subtitlesTrack").toInt() != _subtitlesTrack)
+        setSubtitlesTrack(map.value("subtitlesTrack").toInt());
+    if (map.value("subtitlesEncode").toInt() != _subtitlesEncode)
+        setSubtitlesEncode(map.value("subtitlesEncode").toInt());
+    if (map.value("decoderProfile").toInt() != (int)_decoderProfile)
+        setDecoderProfile((DecoderProfile)map.value("decoderProfile").toInt());
+    if (map.value("testPattern").toBool() != _testPattern)
+        setTestPattern(map.value("testPattern").toBool());
+    if (map.value("inMark").toInt() != _inMark)
+        setInMark(map.value("inMark").toInt());
+    if (map.value("outMark").toInt() != _outMark)
+        setOutMark(map.value("outMark").toInt());
+    if (map.value("gain").toFloat() != _gain)
+        setGain(map.value("gain").toFloat());
+    if (map.value("cropTop").toInt() != _cropTop || map.value("cropLeft").toInt() != _cropLeft
+            || map.value("cropRight").toInt() != _cropRight || map.value("cropBot").toInt() != _cropBot)
+        setCrop(map.value("cropTop").toInt(), map.value("cropLeft").toInt(),
+                map.value("cropRight").toInt(), map.value("cropBot").toInt());
+    if (map.value("audioFadeOut").toInt() != _audioFadeOut)
+        setAudioFadeOut(map.value("audioFadeOut").toInt());
+    if (map.value("audioFadeIn").toInt() != _audioFadeIn)
+        setAudioFadeIn(map.value("audioFadeIn").toInt());
+    if (map.value("videoFadeOut").toInt() != _videoFadeOut)
+        setVideoFadeOut(map.value("videoFadeOut").toInt());
+    if (map.value("videoFadeIn").toInt() != _videoFadeIn)
+        setVideoFadeIn(map.value("videoFadeIn").toInt());
+}
+
 void MediaSettings::setRatio(Ratio ratio) {
     _ratio = ratio;
     emit ratioChanged(_ratio);
@@ -87,6 +179,11 @@ void MediaSettings::setSubtitlesEncode(const int &encode){
      emit subtitlesEncodeChanged(_subtitlesEncode);
 }
 
+void MediaSettings::setDecoderProfile(DecoderProfile profile){
+    _decoderProfile = profile;
+    emit decoderProfileChanged(_decoderProfile);
+}
+
 void MediaSettings::setGamma(float gamma) {
     _gamma = gamma;
     emit gammaChanged(_gamma);
@@ -164,7 +261,7 @@ void MediaSettings::initDefault()
     _subtitlesTrack = 0; /* subtitles disabled */
     _ratio = Original;
     _scale = NoScale;
-    _deinterlacing = Discard;
+    _deinterlacing = AutoDeinterlacing;
     _subtitlesSync = 0;
     _gamma = 1;
     _contrast = 1;
@@ -186,6 +283,7 @@ void MediaSettings::initDefault()
     _videoFadeOut = 0;
     _videoFadeIn = 0;
     _subtitlesFile = "";
+    _decoderProfile = AutoProfile;
 }
 
 QStringList MediaSettings::ratioValues()
@@ -262,7 +360,10 @@ QStringList MediaSettings::deinterlacingValues()
         << "Blend"
         << "Mean"
         << "Bob"
-        << "Linear";
+        << "Linear"
+        << "Disabled"
+        << "IVTC"
+        << "Auto";
 
     return list;
 }
@@ -285,3 +386,102 @@ QList<float> MediaSettings::scaleValues()
 
     return list;
 }
+
+QStringList MediaSettings::decoderProfileValues()
+{
+    QStringList list;
+    list << tr("Automatic")
+        << tr("Light (SD, slideshow)")
+        << tr("Standard (HD)")
+        << tr("Heavy (4K, HEVC)");
+
+    return list;
+}
+
+DecoderProfile MediaSettings::autoDecoderProfile(const QList<VideoTrack> &videoTracks)
+{
+    // libvlc codecs are fourcc, stored little endian
+    const uint hevc = 'h' | ('e' << 8) | ('v' << 16) | ('c' << 24);
+    const uint vp9 = 'V' | ('P' << 8) | ('9' << 16) | ('0' << 24);
+
+    if (videoTracks.isEmpty())
+        return LightProfile;
+
+    DecoderProfile profile = LightProfile;
+    foreach (VideoTrack track, videoTracks) {
+        if (track.width() >= 2560 || track.height() >= 1440
+                || track.codec() == hevc || track.codec() == vp9)
+            return HeavyProfile;
+
+        if (track.width() > 1024 || track.height() > 576)
+            profile = StandardProfile;
+    }
+
+    return profile;
+}
+
+Deinterlacing MediaSettings::autoDeinterlacing(ScanType scanType)
+{
+    switch (scanType) {
+    case Progressive:
+        return NoDeinterlacing;
+    case Telecined:
+        return Ivtc;
+    case InterlacedTff:
+    case InterlacedBff:
+        // libvlc takes the field order from the decoder
+        return Linear;
+    default:
+        return Discard;
+    }
+}
+
+QStringList MediaSettings::scanTypeValues()
+{
+    QStringList list;
+    list << tr("not detected")
+        << tr("progressive")
+        << tr("interlaced, top field first")
+        << tr("interlaced, bottom field first")
+        << tr("telecined");
+
+    return list;
+}
+
+QStringList MediaSettings::decoderProfileOptions(DecoderProfile profile)
+{
+    QStringList options;
+
+    switch (profile) {
+    case LightProfile:
+        // show every frame, small cache, no hardware decoder to set up
+        options << ":avcodec-threads=2"
+                << ":file-caching=300"
+                << ":avcodec-skiploopfilter=0"
+                << ":no-drop-late-frames"
+                << ":no-skip-frames"
+                << ":avcodec-hw=none";
+        break;
+    case HeavyProfile:
+        // every core, large cache, loop filter skipped on non reference frames
+        options << ":avcodec-threads=0"
+                << ":file-caching=3000"
+                << ":avcodec-skiploopfilter=1"
+                << ":drop-late-frames"
+                << ":skip-frames"
+                << ":avcodec-hw=any";
+        break;
+    case AutoProfile:
+    case StandardProfile:
+    default:
+        options << ":avcodec-threads=0"
+                << ":file-caching=1000"
+                << ":avcodec-skiploopfilter=0"
+                << ":drop-late-frames"
+                << ":skip-frames"
+                << ":avcodec-hw=any";
+        break;
+    }
+
+    return options;
+}
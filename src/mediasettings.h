@@ -34,6 +34,7 @@
 #include <QObject>
 #include <QStringList>
 #include <QList>
+#include <QVariantMap>
 #include <QDebug>
 
 #include "track.h"
@@ -86,7 +87,21 @@ enum Deinterlacing {
     Blend = 1,
     Mean = 2,
     Bob = 3,
-    Linear = 4
+    Linear = 4,
+    NoDeinterlacing = 5,
+    Ivtc = 6,
+    AutoDeinterlacing = 7
+};
+
+/**
+ * @enum DecoderProfile
+ * @brief Contains available decoder and caching profiles
+ */
+enum DecoderProfile {
+    AutoProfile = 0,
+    LightProfile = 1,
+    StandardProfile = 2,
+    HeavyProfile = 3
 };
 
 /**
@@ -105,6 +120,21 @@ public:
      */
     void initDefault();
 
+    /**
+     * @brief Get every setting, to give them to another process
+     * @return The settings by name
+     */
+    QVariantMap toMap() const;
+
+    /**
+     * @brief Set the settings of a toMap() snapshot
+     *
+     * Only the settings which differ are set, so only their signals are emitted.
+     *
+     * @param map The settings by name
+     */
+    void fromMap(const QVariantMap &map);
+
     /**
      * @brief Get subtitle encode
      * @return The subtitle encode
@@ -113,6 +143,12 @@ public:
      */
     inline int subtitlesEncode() const { return _subtitlesEncode; }
 
+    /**
+     * @brief Get the decoder profile
+     * @return The decoder profile, AutoProfile to choose from the video tracks
+     */
+    inline DecoderProfile decoderProfile() const { return _decoderProfile; }
+
     /**
      * @brief Get video ratio
      * @return The video ratio
@@ -245,7 +281,7 @@ public:
 
     /**
      * @brief Get current audio gain
-     * @return The audio gain
+     * @return The audio gain in amplitude dB (20 log10), 0 for none
      *
      * @author Cyril Naud <futuramath@gmail.com>
      */
@@ -335,7 +371,7 @@ public:
 
     /**
      * @brief setGain
-     * @param gain
+     * @param gain The gain in amplitude dB (20 log10)
      *
      * @author Cyril Naud <futuramath@gmail.com>
      */
@@ -373,6 +409,12 @@ public:
     */
     void setSubtitlesEncode(const int &encode);
 
+    /**
+     * @brief setDecoderProfile
+     * @param profile
+     */
+    void setDecoderProfile(DecoderProfile profile);
+
     /**
      * @brief setTestPattern
      * @param testpattern
@@ -426,6 +468,40 @@ public:
      */
     static QList<float> scaleValues();
 
+    /**
+     * @brief decoderProfileValues
+     * @return The names of the decoder profiles
+     */
+    static QStringList decoderProfileValues();
+
+    /**
+     * @brief Choose a decoder profile from the resolution and the codec of the video
+     * @param videoTracks The video tracks of the media
+     * @return LightProfile, StandardProfile or HeavyProfile
+     */
+    static DecoderProfile autoDecoderProfile(const QList<VideoTrack> &videoTracks);
+
+    /**
+     * @brief Get the libvlc media options of a decoder profile
+     * @param profile The profile, AutoProfile is handled as StandardProfile
+     * @return The media options
+     */
+    static QStringList decoderProfileOptions(DecoderProfile profile);
+
+    /**
+     * @brief Choose a deinterlacing mode from the scan type of the video
+     * @param scanType The scan type found by the interlace detection
+     * @return NoDeinterlacing for progressive video, Ivtc for telecined video,
+     *         Linear for interlaced video, Discard if unknown
+     */
+    static Deinterlacing autoDeinterlacing(ScanType scanType);
+
+    /**
+     * @brief scanTypeValues
+     * @return The names of the scan types
+     */
+    static QStringList scanTypeValues();
+
     /**
      * @brief Set crop values
      *
@@ -612,6 +688,11 @@ signals:
      */
     void subtitlesEncodeChanged(int);
 
+    /**
+     * @brief decoderProfileChanged
+     */
+    void decoderProfileChanged(DecoderProfile);
+
     /**
      * @brief crop changed top left right bot
      */
@@ -774,6 +855,11 @@ private:
     int _videoFadeIn;
 
     QString _subtitlesFile;
+
+    /**
+     * @brief decoder and caching profile
+     */
+    DecoderProfile _decoderProfile;
 };
 
 #endif // MEDIASETTINGS_H
@@ -0,0 +1,391 @@
+/**********************************************************************************
+ * This file is part of Open Projection Program (OPP).
+ *
+ * Copyright (C) 2013 Catalogue Ouvert du Cinéma <dev@cinemaouvert.fr>
+ *
+ * Authors: Jerome Blanchi <d.j.a.y@free.fr>
+ *
+ * Open Projection Program is an initiative of Catalogue Ouvert du Cinéma.
+ * The software was developed by four students of University of Poitiers
+ * as school project.
+ *
+ * Open Projection Program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Open Projection Program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Open Projection Program. If not, see <http://www.gnu.org/licenses/>.
+ **********************************************************************************/
+
+#include "mediaverifier.h"
+
+#include <string.h>
+
+#include <QDebug>
+#include <QDir>
+#include <QFile>
+#include <QFileInfo>
+#include <QTime>
+
+#ifndef Q_OS_WIN
+# include <sys/stat.h>
+#endif
+
+#include "VLCApplication.h"
+#include "jobscheduler.h"
+
+// the pictures are only counted, scale them down to a thumbnail
+#define PICTURE_WIDTH 64
+#define PICTURE_HEIGHT 36
+
+MediaVerifier::MediaVerifier(VLCApplication *vlcApp, QObject *parent) :
+    QObject(parent),
+    _vlcApp(vlcApp),
+    _done(0),
+    _total(0)
+{
+    _vlcApp->jobScheduler()->addClient(this, JobScheduler::DecodeResource, JobScheduler::NormalPriority);
+}
+
+MediaVerifier::~MediaVerifier()
+{
+    cancel();
+    _vlcApp->jobScheduler()->removeClient(this);
+}
+
+void MediaVerifier::verify(Media *media)
+{
+    if (media == NULL || _queue.contains(media))
+        return;
+
+    foreach (Job *job, _jobs)
+        if (job->media == media)
+            return;
+
+    _queue.append(media);
+    _total++;
+    startJobs();
+}
+
+void MediaVerifier::cancel()
+{
+    _queue.clear();
+    _vlcApp->jobScheduler()->withdraw(this);
+
+    foreach (Job *job, _jobs) {
+        releaseJob(job);
+        delete job;
+        _vlcApp->jobScheduler()->release(this);
+    }
+    _jobs.clear();
+
+    _done = 0;
+    _total = 0;
+}
+
+void MediaVerifier::startJobs()
+{
+    int index = 0;
+
+    while (index < _queue.count()) {
+        Media *media = _queue.at(index);
+
+        if (media == NULL) {
+            _queue.removeAt(index);
+            continue;
+        }
+
+        // leave the media of a busy disk for later
+        const QString mediaDisk = disk(media->location());
+        if (!mediaDisk.isEmpty() && diskJobs(mediaDisk) >= MAX_JOBS_PER_DISK) {
+            index++;
+            continue;
+        }
+
+        // the scheduler calls again when a slot is free
+        if (!_vlcApp->jobScheduler()->acquire(this))
+            break;
+
+        _queue.removeAt(index);
+        startJob(media, mediaDisk);
+    }
+
+    if (_jobs.isEmpty() && _queue.isEmpty() && _total > 0) {
+        _done = 0;
+        _total = 0;
+        emit finished();
+    }
+}
+
+void MediaVerifier::startJob(Media *media, const QString &disk)
+{
+    Job *job = new Job;
+    job->media = media;
+    job->disk = disk;
+    memset(&job->video, 0, sizeof(Stream));
+    memset(&job->audio, 0, sizeof(Stream));
+
+    // decode pictures and samples in memory, without waiting for the clock
+    const QString output = QString(":sout=#transcode{vcodec=I420,width=%1,height=%2,acodec=s16l,scodec=none}"
+                                   ":smem{video-prerender-callback=%3,video-postrender-callback=%4,"
+                                   "audio-prerender-callback=%5,audio-postrender-callback=%6,"
+                                   "video-data=%7,audio-data=%7,time-sync=false}")
+            .arg(PICTURE_WIDTH)
+            .arg(PICTURE_HEIGHT)
+            .arg((long long)(intptr_t)&MediaVerifier::videoPrerenderCallback)
+            .arg((long long)(intptr_t)&MediaVerifier::videoPostrenderCallback)
+            .arg((long long)(intptr_t)&MediaVerifier::audioPrerenderCallback)
+            .arg((long long)(intptr_t)&MediaVerifier::audioPostrenderCallback)
+            .arg((long long)(intptr_t)job);
+
+    job->vlcMedia = libvlc_media_new_path(_vlcApp->vlcInstance(), media->location().toStdString().data());
+    libvlc_media_add_option(job->vlcMedia, output.toLocal8Bit().data());
+    libvlc_media_add_option(job->vlcMedia, ":no-sout-spu");
+    libvlc_media_add_option(job->vlcMedia, ":no-sout-all");
+
+    job->player = libvlc_media_player_new_from_media(job->vlcMedia);
+
+    libvlc_event_manager_t *events = libvlc_media_player_event_manager(job->player);
+    libvlc_event_attach(events, libvlc_MediaPlayerEndReached, eventCallback, this);
+    libvlc_event_attach(events, libvlc_MediaPlayerEncounteredError, eventCallback, this);
+
+    _jobs.append(job);
+    _vlcApp->jobScheduler()->startPlayer(this, job->player);
+}
+
+MediaVerifier::Job *MediaVerifier::job(void *player) const
+{
+    foreach (Job *job, _jobs)
+        if (job->player == player)
+            return job;
+
+    return NULL;
+}
+
+int MediaVerifier::diskJobs(const QString &disk) const
+{
+    int count = 0;
+
+    foreach (Job *job, _jobs)
+        if (job->disk == disk)
+            count++;
+
+    return count;
+}
+
+void MediaVerifier::jobEnded(void *player)
+{
+    Job *job = this->job(player);
+
+    if (job == NULL)
+        return;
+
+    // the statistics live in the media, read them before releasing it
+    libvlc_media_stats_t stats;
+    bool hasStats = libvlc_media_get_stats(job->vlcMedia, &stats);
+
+    // stopping joins the decoders, the streams are complete afterwards
+    releaseJob(job);
+
+    if (job->media != NULL) {
+        Media *media = job->media;
+        MediaHealth health = Healthy;
+        QStringList report;
+
+        if (hasStats) {
+            if (stats.i_demux_corrupted > 0)
+                report << tr("%1 corrupted blocks").arg(stats.i_demux_corrupted);
+            if (stats.i_demux_discontinuity > 0)
+                report << tr("%1 stream discontinuities").arg(stats.i_demux_discontinuity);
+            if (stats.i_lost_pictures > 0)
+                report << tr("%1 lost pictures").arg(stats.i_lost_pictures);
+            if (stats.i_lost_abuffers > 0)
+                report << tr("%1 lost audio buffers").arg(stats.i_lost_abuffers);
+        }
+
+        if (job->video.gaps > 0)
+            report << tr("%1 gaps in the pictures").arg(job->video.gaps);
+        if (job->audio.gaps > 0)
+            report << tr("%1 gaps in the sound").arg(job->audio.gaps);
+
+        if (job->video.frames == 0 && job->audio.frames == 0) {
+            health = Unreadable;
+            report.prepend(tr("No picture nor sound decoded"));
+        } else {
+            if (!media->videoTracks().isEmpty() && job->video.frames == 0)
+                report << tr("No picture decoded");
+            if (!media->audioTracks().isEmpty() && job->audio.frames == 0)
+                report << tr("No sound decoded");
+
+            // a truncated file ends early
+            int64_t length = qMax(job->video.next - job->video.first, job->audio.next - job->audio.first) / 1000;
+            int duration = media->getOriginalDuration();
+            if (duration > 0 && length < duration - END_TOLERANCE)
+                report << tr("Decoded up to %1 of %2")
+                          .arg(QTime(0, 0).addMSecs(length).toString("hh:mm:ss"))
+                          .arg(QTime(0, 0).addMSecs(duration).toString("hh:mm:ss"));
+        }
+
+        if (health == Healthy && !report.isEmpty())
+            health = Damaged;
+
+        media->setHealth(health, report.join("\n"));
+        emit verified(media);
+    }
+
+    finishJob(job);
+}
+
+void MediaVerifier::jobFailed(void *player)
+{
+    Job *job = this->job(player);
+
+    if (job == NULL)
+        return;
+
+    releaseJob(job);
+
+    if (job->media != NULL) {
+        qDebug() << "Verification: can not decode" << job->media->location();
+        job->media->setHealth(Unreadable, tr("Can not be decoded"));
+        emit verified(job->media);
+    }
+
+    finishJob(job);
+}
+
+void MediaVerifier::finishJob(Job *job)
+{
+    _jobs.removeOne(job);
+    delete job;
+    _vlcApp->jobScheduler()->release(this);
+
+    _done++;
+    emit progress(_done, _total);
+
+    startJobs();
+}
+
+void MediaVerifier::releaseJob(Job *job)
+{
+    if (job->player == NULL)
+        return;
+
+    _vlcApp->jobScheduler()->removePlayer(job->player);
+
+    libvlc_event_manager_t *events = libvlc_media_player_event_manager(job->player);
+    libvlc_event_detach(events, libvlc_MediaPlayerEndReached, eventCallback, this);
+    libvlc_event_detach(events, libvlc_MediaPlayerEncounteredError, eventCallback, this);
+
+    libvlc_media_player_stop(job->player);
+    libvlc_media_player_release(job->player);
+    libvlc_media_release(job->vlcMedia);
+    job->player = NULL;
+    job->vlcMedia = NULL;
+}
+
+QString MediaVerifier::disk(const QString &location)
+{
+#ifdef Q_OS_WIN
+    // drive letter, or server and share of a network path
+    QString path = QDir::fromNativeSeparators(QFileInfo(location).absoluteFilePath());
+    if (path.startsWith("//"))
+        return path.section('/', 0, 3).toLower();
+    return path.left(2).toUpper();
+#else
+    struct stat info;
+    if (stat(QFile::encodeName(location).constData(), &info) != 0)
+        return QString();
+    return QString::number((qulonglong)info.st_dev);
+#endif
+}
+
+void MediaVerifier::addBlock(Stream *stream, int64_t pts, int64_t duration)
+{
+    // timestamps jumping back or forward
+    if (stream->frames > 0 && (pts < stream->last || pts - stream->next > (int64_t)GAP_TOLERANCE * 1000))
+        stream->gaps++;
+
+    if (stream->frames == 0)
+        stream->first = pts;
+
+    stream->frames++;
+    stream->last = pts;
+    stream->next = pts + duration;
+}
+
+/***********************************************************************\
+                          LIBVLC CALLBACKS
+\***********************************************************************/
+
+void MediaVerifier::videoPrerenderCallback(void *data, uint8_t **buffer, size_t size)
+{
+    Job *job = (Job *)data;
+
+    if ((size_t)job->videoBuffer.size() < size)
+        job->videoBuffer.resize(size);
+
+    *buffer = (uint8_t *)job->videoBuffer.data();
+}
+
+void MediaVerifier::videoPostrenderCallback(void *data, uint8_t *buffer, int width, int height,
+                                            int bits, size_t size, int64_t pts)
+{
+    Q_UNUSED(buffer);
+    Q_UNUSED(width);
+    Q_UNUSED(height);
+    Q_UNUSED(bits);
+    Q_UNUSED(size);
+    Job *job = (Job *)data;
+
+    // the stream lives in the video decoder thread until the player is stopped
+    if (pts > 0)
+        addBlock(&job->video, pts, 0);
+}
+
+void MediaVerifier::audioPrerenderCallback(void *data, uint8_t **buffer, size_t size)
+{
+    Job *job = (Job *)data;
+
+    if ((size_t)job->audioBuffer.size() < size)
+        job->audioBuffer.resize(size);
+
+    *buffer = (uint8_t *)job->audioBuffer.data();
+}
+
+void MediaVerifier::audioPostrenderCallback(void *data, uint8_t *buffer, unsigned channels, unsigned rate,
+                                            unsigned frames, unsigned bits, size_t size, int64_t pts)
+{
+    Q_UNUSED(buffer);
+    Q_UNUSED(channels);
+    Q_UNUSED(bits);
+    Q_UNUSED(size);
+    Job *job = (Job *)data;
+
+    // the stream lives in the audio decoder thread until the player is stopped
+    if (pts > 0 && rate > 0)
+        addBlock(&job->audio, pts, (int64_t)frames * 1000000 / rate);
+}
+
+void MediaVerifier::eventCallback(const libvlc_event_t *event, void *data)
+{
+    MediaVerifier *verifier = (MediaVerifier *)data;
+    void *player = event->p_obj;
+
+    switch (event->type) {
+    case libvlc_MediaPlayerEndReached:
+        QMetaObject::invokeMethod(verifier, "jobEnded", Qt::QueuedConnection, Q_ARG(void *, player));
+        break;
+    case libvlc_MediaPlayerEncounteredError:
+        QMetaObject::invokeMethod(verifier, "jobFailed", Qt::QueuedConnection, Q_ARG(void *, player));
+        break;
+    default:
+        break;
+    }
+}
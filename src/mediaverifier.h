@@ -0,0 +1,246 @@
+/**********************************************************************************
+ * This file is part of Open Projection Program (OPP).
+ *
+ * Copyright (C) 2013 Catalogue Ouvert du Cinéma <dev@cinemaouvert.fr>
+ *
+ * Authors: Jerome Blanchi <d.j.a.y@free.fr>
+ *
+ * Open Projection Program is an initiative of Catalogue Ouvert du Cinéma.
+ * The software was developed by four students of University of Poitiers
+ * as school project.
+ *
+ * Open Projection Program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Open Projection Program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Open Projection Program. If not, see <http://www.gnu.org/licenses/>.
+ **********************************************************************************/
+
+#ifndef MEDIAVERIFIER_H
+#define MEDIAVERIFIER_H
+
+#include <QObject>
+#include <QList>
+#include <QPointer>
+#include <QByteArray>
+#include <QStringList>
+
+#include <vlc/vlc.h>
+
+#include "media.h"
+
+class VLCApplication;
+
+/**
+ * @brief Decode whole media in background to find the damaged ones before a show
+ *
+ * Each media is decoded end to end by its own libvlc player into memory, as
+ * fast as the decoders go, the pictures scaled down to a thumbnail so the
+ * output costs nothing. Several media are verified at once on several cores,
+ * at most MAX_JOBS_PER_DISK from the same disk so they do not fight for its
+ * bandwidth. The libvlc statistics (corrupted blocks, discontinuities, lost
+ * frames) and the timestamp gaps seen in each stream give the health of the
+ * media, stored in the media.
+ */
+class MediaVerifier : public QObject
+{
+    Q_OBJECT
+public:
+    explicit MediaVerifier(VLCApplication *vlcApp, QObject *parent = 0);
+    virtual ~MediaVerifier();
+
+    /**
+     * @brief Add a media to the verification queue
+     * @param media The media, skipped if already queued
+     */
+    void verify(Media *media);
+
+
+    /**
+     * @brief Allow to know if a verification is running
+     * @return True if running, false otherwise
+     */
+    inline bool isRunning() const { return !_jobs.isEmpty(); }
+
+    /**
+     * @brief MAX_JOBS_PER_DISK Media of a same disk verified at once
+     */
+    static const int MAX_JOBS_PER_DISK = 2;
+
+    /**
+     * @brief GAP_TOLERANCE Timestamp jump counted as a gap (ms)
+     */
+    static const int GAP_TOLERANCE = 500;
+
+    /**
+     * @brief END_TOLERANCE Missing length at the end counted as truncated (ms)
+     */
+    static const int END_TOLERANCE = 2000;
+
+public slots:
+    /**
+     * @brief Stop the running verifications and clear the queue
+     */
+    void cancel();
+
+signals:
+    /**
+     * @brief Emitted when the health of a media is stored
+     * @param media The media
+     */
+    void verified(Media *media);
+
+    /**
+     * @brief Emitted each time a media is done
+     * @param done The number of media done since the queue was empty
+     * @param total The number of media queued since the queue was empty
+     */
+    void progress(int done, int total);
+
+    /**
+     * @brief Emitted when the queue is empty
+     */
+    void finished();
+
+private slots:
+    /**
+     * @brief Start jobs from the queue when the scheduler gives a slot and the disk is free
+     */
+    void startJobs();
+
+    /**
+     * @brief Store the health of the media of a player at its end
+     * @param player The libvlc player of the job
+     */
+    void jobEnded(void *player);
+
+    /**
+     * @brief Mark the media of a player which could not be decoded as unreadable
+     * @param player The libvlc player of the job
+     */
+    void jobFailed(void *player);
+
+private:
+    /**
+     * @brief Timestamps seen in a decoded stream, updated by its decoder thread
+     */
+    struct Stream {
+        int frames;
+        int gaps;
+        int64_t first;
+        int64_t last;
+        int64_t next;
+    };
+
+    /**
+     * @brief Verification of one media
+     */
+    struct Job {
+        QPointer<Media> media;
+        QString disk;
+        libvlc_media_t *vlcMedia;
+        libvlc_media_player_t *player;
+        Stream video;
+        Stream audio;
+        QByteArray videoBuffer;
+        QByteArray audioBuffer;
+    };
+
+    /**
+     * @brief Start the decoding of a media
+     */
+    void startJob(Media *media, const QString &disk);
+
+    /**
+     * @brief Find the job of a player
+     */
+    Job *job(void *player) const;
+
+    /**
+     * @brief Count the running jobs reading a disk
+     */
+    int diskJobs(const QString &disk) const;
+
+    /**
+     * @brief Delete a released job and start the next ones
+     */
+    void finishJob(Job *job);
+
+    /**
+     * @brief Stop and release the player and the media of a job
+     */
+    void releaseJob(Job *job);
+
+    /**
+     * @brief Get an identifier of the disk holding a file
+     * @param location The file location
+     * @return The identifier, empty if unknown
+     */
+    static QString disk(const QString &location);
+
+    /**
+     * @brief Count a decoded block in the timestamps of its stream
+     * @param stream The stream
+     * @param pts The timestamp of the block (us)
+     * @param duration The duration of the block (us), 0 if unknown
+     */
+    static void addBlock(Stream *stream, int64_t pts, int64_t duration);
+
+    /**
+     * @brief libvlc stream output callback, give the buffer to decode a picture into
+     */
+    static void videoPrerenderCallback(void *data, uint8_t **buffer, size_t size);
+
+    /**
+     * @brief libvlc stream output callback, count the decoded picture
+     */
+    static void videoPostrenderCallback(void *data, uint8_t *buffer, int width, int height,
+                                        int bits, size_t size, int64_t pts);
+
+    /**
+     * @brief libvlc stream output callback, give the buffer to decode samples into
+     */
+    static void audioPrerenderCallback(void *data, uint8_t **buffer, size_t size);
+
+    /**
+     * @brief libvlc stream output callback, count the decoded samples
+     */
+    static void audioPostrenderCallback(void *data, uint8_t *buffer, unsigned channels, unsigned rate,
+                                        unsigned frames, unsigned bits, size_t size, int64_t pts);
+
+    /**
+     * @brief libvlc event callback
+     */
+    static void eventCallback(const libvlc_event_t *event, void *data);
+
+    VLCApplication *_vlcApp;
+
+    /**
+     * @brief _queue The media waiting for a free job
+     */
+    QList<QPointer<Media> > _queue;
+
+    /**
+     * @brief _jobs The running jobs
+     */
+    QList<Job*> _jobs;
+
+    /**
+     * @brief _done The number of media done since the queue was empty
+     */
+    int _done;
+
+    /**
+     * @brief _total The number of media queued since the queue was empty
+     */
+    int _total;
+};
+
+#endif // MEDIAVERIFIER_H
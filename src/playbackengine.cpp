@@ -0,0 +1,302 @@
+/**********************************************************************************
+ * This file is part of Open Projection Program (OPP).
+ *
+ * Copyright (C) 2013 Catalogue Ouvert du Cinéma <dev@cinemaouvert.fr>
+ *
+ * Authors: Jerome Blanchi <d.j.a.y@free.fr>
+ *
+ * Open Projection Program is an initiative of Catalogue Ouvert du Cinéma.
+ * The software was developed by four students of University of Poitiers
+ * as school project.
+ *
+ * Open Projection Program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Open Projection Program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Open Projection Program. If not, see <http://www.gnu.org/licenses/>.
+ **********************************************************************************/
+
+#include "playbackengine.h"
+
+#include <QApplication>
+#include <QDesktopWidget>
+#include <QDataStream>
+#include <QLocalSocket>
+#include <QSharedMemory>
+#include <QTimer>
+#include <QDebug>
+
+#include <vlc/vlc.h>
+
+#include "VLCApplication.h"
+#include "MediaPlayer.h"
+#include "media.h"
+#include "mediasettings.h"
+#include "playback.h"
+#include "videowidget.h"
+#include "videowindow.h"
+
+PlaybackEngine::PlaybackEngine(const QString &name, QObject *parent) :
+    QObject(parent),
+    _vlcApp(new VLCApplication()),
+    _player(NULL),
+    _playback(NULL),
+    _next(NULL),
+    _videoWidget(new VideoWidget()),
+    _socket(new QLocalSocket(this)),
+    _status(new QSharedMemory(name, this)),
+    _heartbeatTimer(new QTimer(this)),
+    _heartbeat(0),
+    _commands(0),
+    _item(0),
+    _state(IdleState),
+    _blockSize(0)
+{
+    _videoWidget->setWindowTitle("Video");
+    _videoWidget->resize(640, 480);
+
+    // the interface shows the back view, from the status
+    _player = new MediaPlayer(_vlcApp->vlcInstance());
+    _player->setBackMode(MediaPlayer::NONE);
+    _player->setVideoView((VideoView *)_videoWidget);
+
+    // emitted from the libvlc threads
+    connect(_player, SIGNAL(end()), this, SLOT(playerEnd()), Qt::QueuedConnection);
+    connect(_player, SIGNAL(error()), this, SLOT(playerError()), Qt::QueuedConnection);
+    connect(_player, SIGNAL(endGoToBlack()), this, SLOT(playerBlack()));
+
+    // created by the supervisor before the engine is started
+    if (!_status->attach())
+        qDebug() << "Playback engine: no status" << _status->errorString();
+
+    connect(_socket, SIGNAL(readyRead()), this, SLOT(readCommands()));
+    _socket->connectToServer(name);
+
+    connect(_heartbeatTimer, SIGNAL(timeout()), this, SLOT(publishStatus()));
+    _heartbeatTimer->start(HEARTBEAT_INTERVAL);
+}
+
+PlaybackEngine::~PlaybackEngine()
+{
+    _player->stop();
+    if (_playback != NULL)
+        _player->close(_playback);
+    delete _player;
+
+    delete _playback;
+    delete _next;
+
+    delete _videoWidget;
+    delete _vlcApp;
+}
+
+void PlaybackEngine::readCommands()
+{
+    QDataStream in(_socket);
+    in.setVersion(QDataStream::Qt_4_6);
+
+    forever {
+        if (_blockSize == 0) {
+            if (_socket->bytesAvailable() < (qint64)sizeof(quint32))
+                return;
+            in >> _blockSize;
+        }
+
+        if (_socket->bytesAvailable() < _blockSize)
+            return;
+        _blockSize = 0;
+
+        qint32 command;
+        in >> command;
+
+        _commands++;
+
+        switch (command) {
+        case OpenCommand: {
+            Playback *playback = readPlayback(in);
+            QStringList options;
+            qint32 time;
+            in >> options >> time;
+            open(playback, options, time);
+            break;
+        }
+        case PlayCommand:
+            if (_playback == NULL)
+                break;
+            if (_player->isPaused())
+                _player->resume();
+            else
+                _player->play();
+            _state = PlayingState;
+            break;
+        case PauseCommand:
+            _player->pause();
+            _state = PausedState;
+            break;
+        case StopCommand:
+            // before the end emitted by the player stopped while paused
+            _state = IdleState;
+            _player->stop();
+            break;
+        case SeekCommand: {
+            qint32 time;
+            in >> time;
+            _player->setCurrentTime(time);
+            break;
+        }
+        case VolumeCommand: {
+            qint32 volume;
+            in >> volume;
+            _player->setVolume(volume);
+            break;
+        }
+        case DisplayCommand: {
+            qint32 mode;
+            in >> mode;
+            setDisplayMode(mode);
+            break;
+        }
+        case SettingsCommand: {
+            QVariantMap settings;
+            in >> settings;
+            if (_playback != NULL)
+                _playback->mediaSettings()->fromMap(settings);
+            break;
+        }
+        case QueueCommand:
+            delete _next;
+            _next = readPlayback(in);
+            break;
+        case GoToBlackCommand:
+            // the fade waits in the event loop, out of the reading of the commands
+            QTimer::singleShot(0, _player, SLOT(goToBlack()));
+            break;
+        case QuitCommand:
+            qApp->quit();
+            return;
+        default:
+            qDebug() << "Playback engine: unknown command" << command;
+            break;
+        }
+    }
+}
+
+void PlaybackEngine::publishStatus()
+{
+    if (_status->isAttached() && _status->lock()) {
+        Status *status = (Status *)_status->data();
+        status->heartbeat = ++_heartbeat;
+        status->commands = _commands;
+        status->item = _item;
+        status->state = _state;
+        status->time = _player->currentTime();
+        status->length = _player->currentLength();
+        status->channels = _player->audioLevels(status->peaks, status->rms, MAX_CHANNELS);
+        _status->unlock();
+    }
+
+    if (_socket->state() == QLocalSocket::UnconnectedState && _state != PlayingState) {
+        qDebug() << "Playback engine: no supervisor, quit";
+        qApp->quit();
+    }
+}
+
+void PlaybackEngine::playerEnd()
+{
+    // the end of a player stopped on purpose
+    if (_state != PlayingState)
+        return;
+
+    if (_next == NULL) {
+        _state = EndedState;
+        return;
+    }
+
+    Playback *next = _next;
+    _next = NULL;
+
+    open(next, QStringList(), 0);
+    _player->play();
+    _state = PlayingState;
+    _item++;
+}
+
+void PlaybackEngine::playerError()
+{
+    _state = ErrorState;
+}
+
+void PlaybackEngine::playerBlack()
+{
+    _state = BlackState;
+}
+
+Playback *PlaybackEngine::readPlayback(QDataStream &in)
+{
+    QString location;
+    qint32 scanType;
+    QString imageTime;
+    QVariantMap settings;
+    in >> location >> scanType >> imageTime >> settings;
+
+    if (location.isEmpty())
+        return NULL;
+
+    // the file is the copy staged by the interface, if any
+    Media *media = new Media(location, _vlcApp->vlcInstance());
+    media->setScanType((ScanType)scanType);
+
+    // the playback reads its media through a copy, they are released together
+    Playback *playback = new Playback(media, this);
+    media->setParent(playback);
+
+    if (!imageTime.isEmpty())
+        playback->media()->setImageTime(imageTime);
+    playback->mediaSettings()->fromMap(settings);
+
+    return playback;
+}
+
+void PlaybackEngine::open(Playback *playback, const QStringList &options, int time)
+{
+    if (playback == NULL)
+        return;
+
+    Playback *previous = _playback;
+
+    _state = IdleState;
+    _player->stop();
+    if (previous != NULL)
+        _player->close(previous);
+
+    _playback = playback;
+    _player->open(_playback);
+    _player->setRecoveryOptions(options);
+    _player->setResumeTime(time);
+
+    // released once the player uses the new one
+    delete previous;
+}
+
+void PlaybackEngine::setDisplayMode(int mode)
+{
+    switch (mode) {
+    case VideoWindow::PROJECTION:
+        _videoWidget->move(QApplication::desktop()->screenGeometry(1).topLeft());
+        _videoWidget->showFullScreen();
+        _videoWidget->setCursor(Qt::BlankCursor);
+        break;
+    default:
+        _videoWidget->move(QApplication::desktop()->screenGeometry(0).topLeft());
+        _videoWidget->showNormal();
+        _videoWidget->setCursor(Qt::ArrowCursor);
+        break;
+    }
+}
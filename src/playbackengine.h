@@ -0,0 +1,262 @@
+/**********************************************************************************
+ * This file is part of Open Projection Program (OPP).
+ *
+ * Copyright (C) 2013 Catalogue Ouvert du Cinéma <dev@cinemaouvert.fr>
+ *
+ * Authors: Jerome Blanchi <d.j.a.y@free.fr>
+ *
+ * Open Projection Program is an initiative of Catalogue Ouvert du Cinéma.
+ * The software was developed by four students of University of Poitiers
+ * as school project.
+ *
+ * Open Projection Program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Open Projection Program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Open Projection Program. If not, see <http://www.gnu.org/licenses/>.
+ **********************************************************************************/
+
+#ifndef PLAYBACKENGINE_H
+#define PLAYBACKENGINE_H
+
+#include <QObject>
+#include <QString>
+#include <QStringList>
+
+class QDataStream;
+class QLocalSocket;
+class QSharedMemory;
+class QTimer;
+class VLCApplication;
+class VideoWidget;
+class MediaPlayer;
+class Playback;
+
+/**
+ * @brief Projection of the playlist player run in its own OPP process
+ *
+ * The engine process owns the projection window and a MediaPlayer which
+ * decodes into it, so a crash or a freeze of the decoders does not take the
+ * interface down. It is started by an EngineSupervisor as
+ * "opp --engine <name>", reads its commands from the local socket <name>
+ * and publishes its status in the shared memory <name>, refreshed every
+ * HEARTBEAT_INTERVAL ms by the event loop. A frozen engine stops the
+ * heartbeat and is restarted by the supervisor.
+ *
+ * The playbacks are sent with their settings, which are sent again when
+ * they change, so the player of the engine applies the marks, the fades,
+ * the tracks and the picture settings itself. The next item of the
+ * playlist is queued in the engine: it is played at the end of the current
+ * one without waiting for the interface, which adopts it from the status.
+ */
+class PlaybackEngine : public QObject
+{
+    Q_OBJECT
+public:
+    /**
+     * @brief Commands sent by the supervisor
+     *
+     * A playback is sent as its location, its scan type (qint32), its image
+     * time (QString) and its settings (QVariantMap, MediaSettings::toMap).
+     */
+    enum Command {
+        /**
+         * playback, recovery options (QStringList), start time (qint32, ms)
+         */
+        OpenCommand = 0,
+        PlayCommand = 1,
+        PauseCommand = 2,
+        StopCommand = 3,
+        /**
+         * time (qint32, ms)
+         */
+        SeekCommand = 4,
+        /**
+         * volume (qint32, 0 to 100), the gain of the playback is applied by the engine
+         */
+        VolumeCommand = 5,
+        /**
+         * mode (qint32, VideoWindow::DisplayMode)
+         */
+        DisplayCommand = 6,
+        QuitCommand = 7,
+        /**
+         * settings of the current playback (QVariantMap, MediaSettings::toMap)
+         */
+        SettingsCommand = 8,
+        /**
+         * playback played at the end of the current one, an empty location for none
+         */
+        QueueCommand = 9,
+        GoToBlackCommand = 10
+    };
+
+    /**
+     * @brief States published in the status
+     */
+    enum State {
+        IdleState = 0,
+        PlayingState = 1,
+        PausedState = 2,
+        EndedState = 3,
+        ErrorState = 4,
+        /**
+         * @brief Stopped at the end of a go to black
+         */
+        BlackState = 5
+    };
+
+    /**
+     * @brief MAX_CHANNELS Audio channels published at most
+     */
+    static const int MAX_CHANNELS = 8;
+
+    /**
+     * @brief Status shared with the supervisor
+     */
+    struct Status {
+        /**
+         * @brief heartbeat Incremented at each publication
+         */
+        quint32 heartbeat;
+        /**
+         * @brief commands The commands executed since the connection
+         */
+        quint32 commands;
+        /**
+         * @brief item Incremented when a queued playback starts
+         */
+        quint32 item;
+        qint32 state;
+        qint32 time;
+        qint32 length;
+        /**
+         * @brief channels The audio channels of the levels, 0 for none
+         */
+        qint32 channels;
+        float peaks[MAX_CHANNELS];
+        float rms[MAX_CHANNELS];
+    };
+
+    /**
+     * @brief Connect to the supervisor and wait for its commands
+     * @param name The name of the local socket and of the shared status
+     */
+    explicit PlaybackEngine(const QString &name, QObject *parent = 0);
+    ~PlaybackEngine();
+
+    /**
+     * @brief Get the command line option starting an engine instead of the interface
+     */
+    static inline QString option() { return "--engine"; }
+
+    /**
+     * @brief HEARTBEAT_INTERVAL Interval between the status publications (ms)
+     */
+    static const int HEARTBEAT_INTERVAL = 100;
+
+private slots:
+    /**
+     * @brief Execute the complete commands received
+     */
+    void readCommands();
+
+    /**
+     * @brief Write the status and the heartbeat in the shared memory
+     *
+     * Without supervisor (crashed), the current media is played to its end,
+     * then the engine quits.
+     */
+    void publishStatus();
+
+    /**
+     * @brief Play the queued playback at the end of the current one
+     */
+    void playerEnd();
+
+    /**
+     * @brief Publish the error of the player
+     */
+    void playerError();
+
+    /**
+     * @brief Publish the end of a go to black
+     */
+    void playerBlack();
+
+private:
+    /**
+     * @brief Read a playback sent by the supervisor
+     * @return The playback, NULL for an empty location
+     */
+    Playback *readPlayback(QDataStream &in);
+
+    /**
+     * @brief Open a playback, played on the next PlayCommand
+     * @param playback The playback, owned by the engine, NULL to keep the current one
+     * @param options The recovery options of the decoder
+     * @param time The start time (ms), to resume after a restart, 0 for the in mark
+     */
+    void open(Playback *playback, const QStringList &options, int time);
+
+    /**
+     * @brief Show the projection window in a VideoWindow::DisplayMode
+     */
+    void setDisplayMode(int mode);
+
+    VLCApplication *_vlcApp;
+
+    /**
+     * @brief _player The player of the projection, without back view
+     */
+    MediaPlayer *_player;
+
+    /**
+     * @brief _playback The current playback, NULL if none
+     */
+    Playback *_playback;
+
+    /**
+     * @brief _next The playback queued after the current one, NULL if none
+     */
+    Playback *_next;
+
+    /**
+     * @brief _videoWidget The projection window
+     */
+    VideoWidget *_videoWidget;
+
+    /**
+     * @brief _socket The commands of the supervisor
+     */
+    QLocalSocket *_socket;
+
+    /**
+     * @brief _status The Status read by the supervisor
+     */
+    QSharedMemory *_status;
+
+    QTimer *_heartbeatTimer;
+
+    quint32 _heartbeat;
+
+    quint32 _commands;
+
+    quint32 _item;
+
+    State _state;
+
+    /**
+     * @brief _blockSize The size of the command being received, 0 between commands
+     */
+    quint32 _blockSize;
+};
+
+#endif // PLAYBACKENGINE_H
@@ -0,0 +1,210 @@
+/**********************************************************************************
+ * This file is part of Open Projection Program (OPP).
+ *
+ * Copyright (C) 2013 Catalogue Ouvert du Cinéma <dev@cinemaouvert.fr>
+ *
+ * Authors: Jerome Blanchi <d.j.a.y@free.fr>
+ *
+ * Open Projection Program is an initiative of Catalogue Ouvert du Cinéma.
+ * The software was developed by four students of University of Poitiers
+ * as school project.
+ *
+ * Open Projection Program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Open Projection Program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Open Projection Program. If not, see <http://www.gnu.org/licenses/>.
+ **********************************************************************************/
+
+#include "playbackrecovery.h"
+
+#include <QSettings>
+#include <QTimer>
+#include <QDebug>
+
+#include "PlaylistPlayer.h"
+#include "MediaPlayer.h"
+#include "playback.h"
+#include "media.h"
+#include "mediasettings.h"
+
+PlaybackRecovery::PlaybackRecovery(PlaylistPlayer *playlistPlayer, QObject *parent) :
+    QObject(parent),
+    _playlistPlayer(playlistPlayer),
+    _timer(new QTimer(this)),
+    _playback(NULL),
+    _attempts(0),
+    _lastTime(0),
+    _resumeTime(-1),
+    _resumedTime(0)
+{
+    MediaPlayer *player = _playlistPlayer->mediaPlayer();
+
+    // emitted from the libvlc threads, the player is driven from here
+    connect(player, SIGNAL(error()), this, SLOT(playerError()), Qt::QueuedConnection);
+    connect(player, SIGNAL(timeChanged(int)), this, SLOT(timeChanged(int)), Qt::QueuedConnection);
+    connect(player, SIGNAL(playing(bool)), this, SLOT(playing()), Qt::QueuedConnection);
+    connect(player, SIGNAL(paused()), this, SLOT(idle()), Qt::QueuedConnection);
+    connect(player, SIGNAL(stopped()), this, SLOT(idle()), Qt::QueuedConnection);
+    connect(player, SIGNAL(end()), this, SLOT(idle()), Qt::QueuedConnection);
+
+    connect(_timer, SIGNAL(timeout()), this, SLOT(checkClock()));
+    _timer->start(CHECK_INTERVAL);
+}
+
+QStringList PlaybackRecovery::fallbackOptions(int attempt)
+{
+    QStringList options;
+
+    // the same decoder first, a network share or a disk may just have been slow
+    if (attempt <= 1)
+        return options;
+
+    // then the cache and the frame skipping of the heaviest profile, without loop filter
+    if (attempt >= 3)
+        options << MediaSettings::decoderProfileOptions(HeavyProfile)
+                << ":network-caching=3000"
+                << ":avcodec-skiploopfilter=4";
+
+    // the hardware decoders fail more often than the software one, the last option wins
+    options << ":avcodec-hw=none";
+
+    return options;
+}
+
+void PlaybackRecovery::playerError()
+{
+    _progress = QTime();
+
+    recover("error");
+}
+
+void PlaybackRecovery::checkClock()
+{
+    if (_progress.isNull() || _progress.elapsed() < STALL_TIMEOUT)
+        return;
+
+    Playback *playback = _playlistPlayer->mediaPlayer()->currentPlayback();
+
+    // a picture has no clock
+    if (playback == NULL || playback->media()->isImage()) {
+        _progress = QTime();
+        return;
+    }
+
+    _progress = QTime();
+
+    recover(QString("stall of %1 ms").arg(STALL_TIMEOUT));
+}
+
+void PlaybackRecovery::timeChanged(int time)
+{
+    updatePlayback();
+
+    // the player reopened has not started from the resume time yet
+    if (_resumeTime >= 0 || time == _lastTime)
+        return;
+
+    _lastTime = time;
+    if (!_progress.isNull())
+        _progress.start();
+
+    if (_attempts > 0 && time - _resumedTime > RECOVERED_TIME) {
+        qDebug() << "Playback recovery: recovered after" << _attempts << "attempts";
+        _attempts = 0;
+    }
+}
+
+void PlaybackRecovery::playing()
+{
+    updatePlayback();
+    _progress.start();
+
+    if (_resumeTime < 0)
+        return;
+
+    // the input has started from the resume time
+    _resumedTime = _resumeTime;
+    _lastTime = _resumeTime;
+    _resumeTime = -1;
+}
+
+void PlaybackRecovery::idle()
+{
+    _progress = QTime();
+}
+
+void PlaybackRecovery::recover(const QString &reason)
+{
+    MediaPlayer *player = _playlistPlayer->mediaPlayer();
+    Playback *playback = player->currentPlayback();
+
+    QSettings settings("opp", "opp");
+    const int attempts = settings.value("recoveryAttempts").toInt();
+
+    if (playback == NULL || attempts <= 0)
+        return;
+
+    updatePlayback();
+
+    qDebug() << "Playback recovery:" << reason << "on" << playback->media()->location()
+             << "at" << _lastTime << "ms";
+
+    if (_attempts >= attempts) {
+        _resumeTime = -1;
+
+        const int index = _playlistPlayer->nextIndex();
+        if (index < 0) {
+            qDebug() << "Playback recovery: given up after" << _attempts << "attempts, no next item, stop";
+            _playlistPlayer->stop();
+        } else {
+            qDebug() << "Playback recovery: given up after" << _attempts << "attempts, play the item" << index;
+            player->stop();
+            _playlistPlayer->playItemAt(index);
+        }
+
+        emit skipped();
+        return;
+    }
+
+    _attempts++;
+
+    const int inMark = playback->mediaSettings()->inMark() > 0 ? playback->mediaSettings()->inMark() : 0;
+    _resumeTime = qMax(inMark, _lastTime - RESUME_MARGIN);
+
+    const QStringList options = fallbackOptions(_attempts);
+    qDebug() << "Playback recovery: attempt" << _attempts << "of" << attempts << ", open again"
+             << (options.isEmpty() ? QString("with the same decoder") : "with " + options.join(" "));
+
+    qDebug() << "Playback recovery: resume at" << _resumeTime << "ms";
+
+    // the start time of the input, a seek after the start may be lost by a failing decoder
+    player->setRecoveryOptions(options);
+    player->stop();
+    player->open(playback);
+    player->setResumeTime(_resumeTime);
+    player->play();
+
+    emit retried(_attempts, attempts);
+}
+
+void PlaybackRecovery::updatePlayback()
+{
+    Playback *playback = _playlistPlayer->mediaPlayer()->currentPlayback();
+
+    if (playback == _playback)
+        return;
+
+    _playback = playback;
+    _attempts = 0;
+    _lastTime = 0;
+    _resumeTime = -1;
+    _resumedTime = 0;
+}
@@ -0,0 +1,170 @@
+/**********************************************************************************
+ * This file is part of Open Projection Program (OPP).
+ *
+ * Copyright (C) 2013 Catalogue Ouvert du Cinéma <dev@cinemaouvert.fr>
+ *
+ * Authors: Jerome Blanchi <d.j.a.y@free.fr>
+ *
+ * Open Projection Program is an initiative of Catalogue Ouvert du Cinéma.
+ * The software was developed by four students of University of Poitiers
+ * as school project.
+ *
+ * Open Projection Program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Open Projection Program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Open Projection Program. If not, see <http://www.gnu.org/licenses/>.
+ **********************************************************************************/
+
+#ifndef PLAYBACKRECOVERY_H
+#define PLAYBACKRECOVERY_H
+
+#include <QObject>
+#include <QStringList>
+#include <QTime>
+
+class PlaylistPlayer;
+class Playback;
+class QTimer;
+
+/**
+ * @brief Recover the playlist player from a failing playback
+ *
+ * A failure is an error of the media player or a stall: the player is
+ * playing but its time has not moved for STALL_TIMEOUT ms. The playback is
+ * then opened again to start RESUME_MARGIN ms before the last time seen,
+ * first as it was, then with fallbackOptions() on top of its decoder profile.
+ * After the number of attempts of the "recoveryAttempts" setting (0 to
+ * disable), the playlist goes on with the next item. Each action is logged.
+ */
+class PlaybackRecovery : public QObject
+{
+    Q_OBJECT
+public:
+    /**
+     * @brief Watch the media player of a playlist player
+     */
+    explicit PlaybackRecovery(PlaylistPlayer *playlistPlayer, QObject *parent = 0);
+
+    /**
+     * @brief Get the libvlc options added to the decoder profile for an attempt
+     * @param attempt The attempt, from 1
+     * @return The options, none for the first attempt
+     */
+    static QStringList fallbackOptions(int attempt);
+
+    /**
+     * @brief STALL_TIMEOUT Time without progress of a playing player to be a stall (ms)
+     */
+    static const int STALL_TIMEOUT = 2000;
+
+    /**
+     * @brief CHECK_INTERVAL Interval between two checks of the clock (ms)
+     */
+    static const int CHECK_INTERVAL = 500;
+
+    /**
+     * @brief RESUME_MARGIN The playback resumes this time before the last time seen (ms)
+     */
+    static const int RESUME_MARGIN = 2000;
+
+    /**
+     * @brief RECOVERED_TIME Time played after a resume to count the attempts from zero again (ms)
+     */
+    static const int RECOVERED_TIME = 10000;
+
+signals:
+    /**
+     * @brief Emitted when the current playback is opened again
+     * @param attempt The attempt, from 1
+     * @param attempts The number of attempts before the next item
+     */
+    void retried(int attempt, int attempts);
+
+    /**
+     * @brief Emitted when the playlist goes on with the next item after the last attempt
+     */
+    void skipped();
+
+private slots:
+    /**
+     * @brief Recover from an error of the media player
+     */
+    void playerError();
+
+    /**
+     * @brief Recover from a stall of the clock
+     */
+    void checkClock();
+
+    /**
+     * @brief Note the progress of the clock
+     * @param time The time of the player (ms)
+     */
+    void timeChanged(int time);
+
+    /**
+     * @brief Start to wait for the clock, from the resume time after an attempt
+     */
+    void playing();
+
+    /**
+     * @brief Stop waiting for the clock while paused or stopped
+     */
+    void idle();
+
+private:
+    /**
+     * @brief Open the current playback again, or go on with the next item after the last attempt
+     * @param reason The failure, for the log
+     */
+    void recover(const QString &reason);
+
+    /**
+     * @brief Follow the current playback, the attempts start again on a new one
+     */
+    void updatePlayback();
+
+    PlaylistPlayer *_playlistPlayer;
+
+    QTimer *_timer;
+
+    /**
+     * @brief _playback The playback the attempts are counted for
+     */
+    Playback *_playback;
+
+    /**
+     * @brief _attempts The attempts made on the playback
+     */
+    int _attempts;
+
+    /**
+     * @brief _lastTime The last time seen (ms)
+     */
+    int _lastTime;
+
+    /**
+     * @brief _progress Time since the clock last moved
+     */
+    QTime _progress;
+
+    /**
+     * @brief _resumeTime The time to seek to once playing again (ms), -1 if none
+     */
+    int _resumeTime;
+
+    /**
+     * @brief _resumedTime The time the last attempt resumed at (ms)
+     */
+    int _resumedTime;
+};
+
+#endif // PLAYBACKRECOVERY_H
@@ -0,0 +1,296 @@
+/**********************************************************************************
+ * This file is part of Open Projection Program (OPP).
+ *
+ * Copyright (C) 2013 Catalogue Ouvert du Cinéma <dev@cinemaouvert.fr>
+ *
+ * Authors: Jerome Blanchi <d.j.a.y@free.fr>
+ *
+ * Open Projection Program is an initiative of Catalogue Ouvert du Cinéma.
+ * The software was developed by four students of University of Poitiers
+ * as school project.
+ *
+ * Open Projection Program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Open Projection Program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Open Projection Program. If not, see <http://www.gnu.org/licenses/>.
+ **********************************************************************************/
+
+#include "proxygenerator.h"
+
+#include <QCoreApplication>
+#include <QCryptographicHash>
+#include <QDateTime>
+#include <QDebug>
+#include <QDir>
+#include <QFile>
+#include <QFileInfo>
+#include <QSettings>
+
+#include "VLCApplication.h"
+#include "jobscheduler.h"
+#include "media.h"
+#include "medialistmodel.h"
+
+ProxyGenerator::ProxyGenerator(VLCApplication *vlcApp, MediaListModel *mediaListModel, QObject *parent) :
+    QObject(parent),
+    _vlcApp(vlcApp),
+    _mediaListModel(mediaListModel),
+    _done(0),
+    _total(0)
+{
+    _vlcApp->jobScheduler()->addClient(this, JobScheduler::DecodeResource, JobScheduler::LowPriority);
+
+    connect(_mediaListModel, SIGNAL(mediaListChanged(int)), this, SLOT(mediaListChanged()));
+}
+
+ProxyGenerator::~ProxyGenerator()
+{
+    cancel();
+    _vlcApp->jobScheduler()->removeClient(this);
+}
+
+void ProxyGenerator::generate(const QString &location)
+{
+    if (location.isEmpty() || _queue.contains(location) || QFile::exists(proxyFile(location)))
+        return;
+
+    foreach (Job *job, _jobs)
+        if (job->location == location)
+            return;
+
+    _queue.append(location);
+    _total++;
+    startJobs();
+}
+
+int ProxyGenerator::generateAll()
+{
+    int count = 0;
+
+    foreach (Media *media, _mediaListModel->mediaList()) {
+        if (media->isAudio() || media->isImage() || !media->exists())
+            continue;
+
+        if (_failed.contains(media->location()) || QFile::exists(proxyFile(media->location())))
+            continue;
+
+        generate(media->location());
+        count++;
+    }
+
+    return count;
+}
+
+QString ProxyGenerator::proxyFile(const QString &location)
+{
+    QFileInfo info(location);
+
+    return proxyFile(location, info.size(), info.lastModified());
+}
+
+QString ProxyGenerator::proxyFile(const QString &location, qint64 size, const QDateTime &modified)
+{
+    QSettings settings("opp", "opp");
+    QByteArray key = location.toUtf8() + '|' + QByteArray::number(size)
+            + '|' + modified.toString(Qt::ISODate).toUtf8();
+
+    return settings.value("proxyPath", QCoreApplication::applicationDirPath() + "/proxy").toString() + "/"
+            + QCryptographicHash::hash(key, QCryptographicHash::Md5).toHex() + ".mp4";
+}
+
+QString ProxyGenerator::previewLocation(const QString &location, const QSize &size)
+{
+    // a proxy upscaled would show less than the master
+    if (size.height() > PROXY_HEIGHT)
+        return location;
+
+    QString proxy = proxyFile(location);
+
+    return QFile::exists(proxy) ? proxy : location;
+}
+
+void ProxyGenerator::cancel()
+{
+    _queue.clear();
+    _vlcApp->jobScheduler()->withdraw(this);
+
+    foreach (Job *job, _jobs) {
+        releaseJob(job);
+        QFile::remove(job->partFile);
+        delete job;
+        _vlcApp->jobScheduler()->release(this);
+    }
+    _jobs.clear();
+
+    _done = 0;
+    _total = 0;
+}
+
+void ProxyGenerator::mediaListChanged()
+{
+    QSettings settings("opp", "opp");
+
+    if (settings.value("proxyEnabled", false).toBool())
+        generateAll();
+}
+
+void ProxyGenerator::startJobs()
+{
+    while (!_queue.isEmpty()) {
+        // the scheduler calls again when a slot is free
+        if (!_vlcApp->jobScheduler()->acquire(this))
+            break;
+
+        QString location = _queue.takeFirst();
+        QString proxy = proxyFile(location);
+
+        if (!QDir().mkpath(QFileInfo(proxy).absolutePath())) {
+            qDebug() << "Proxy: can not create the directory of" << proxy;
+            _vlcApp->jobScheduler()->release(this);
+            _done++;
+            emit progress(_done, _total);
+            continue;
+        }
+
+        Job *job = new Job;
+        job->location = location;
+        job->partFile = proxy + ".part";
+        QFile::remove(job->partFile);
+
+        // small intra heavy video only, as fast as the decoder goes
+        const QString output = QString(":sout=#transcode{vcodec=h264,venc=x264{preset=veryfast,tune=fastdecode,keyint=%1,bframes=0},"
+                                       "maxheight=%2,acodec=none,scodec=none}"
+                                       ":std{access=file,mux=mp4,dst=\"%3\"}")
+                .arg(KEYFRAME_INTERVAL)
+                .arg(PROXY_HEIGHT)
+                .arg(QDir::toNativeSeparators(job->partFile));
+
+        job->vlcMedia = libvlc_media_new_path(_vlcApp->vlcInstance(), location.toStdString().data());
+        libvlc_media_add_option(job->vlcMedia, output.toLocal8Bit().data());
+        libvlc_media_add_option(job->vlcMedia, ":no-sout-audio");
+        libvlc_media_add_option(job->vlcMedia, ":no-sout-spu");
+
+        job->player = libvlc_media_player_new_from_media(job->vlcMedia);
+
+        libvlc_event_manager_t *events = libvlc_media_player_event_manager(job->player);
+        libvlc_event_attach(events, libvlc_MediaPlayerEndReached, eventCallback, this);
+        libvlc_event_attach(events, libvlc_MediaPlayerEncounteredError, eventCallback, this);
+
+        _jobs.append(job);
+        _vlcApp->jobScheduler()->startPlayer(this, job->player);
+    }
+
+    if (_jobs.isEmpty() && _queue.isEmpty() && _total > 0) {
+        _done = 0;
+        _total = 0;
+        emit finished();
+    }
+}
+
+ProxyGenerator::Job *ProxyGenerator::job(void *player) const
+{
+    foreach (Job *job, _jobs)
+        if (job->player == player)
+            return job;
+
+    return NULL;
+}
+
+void ProxyGenerator::jobEnded(void *player)
+{
+    Job *job = this->job(player);
+
+    if (job == NULL)
+        return;
+
+    // stopping closes the muxer, the file is complete afterwards
+    releaseJob(job);
+
+    QString proxy = proxyFile(job->location);
+    QFile::remove(proxy);
+
+    if (QFileInfo(job->partFile).size() == 0 || !QFile::rename(job->partFile, proxy)) {
+        qDebug() << "Proxy: no video transcoded from" << job->location;
+        QFile::remove(job->partFile);
+        _failed << job->location;
+    } else {
+        emit generated(job->location);
+    }
+
+    finishJob(job);
+}
+
+void ProxyGenerator::jobFailed(void *player)
+{
+    Job *job = this->job(player);
+
+    if (job == NULL)
+        return;
+
+    releaseJob(job);
+    QFile::remove(job->partFile);
+
+    qDebug() << "Proxy: can not transcode" << job->location;
+    _failed << job->location;
+
+    finishJob(job);
+}
+
+void ProxyGenerator::finishJob(Job *job)
+{
+    _jobs.removeOne(job);
+    delete job;
+    _vlcApp->jobScheduler()->release(this);
+
+    _done++;
+    emit progress(_done, _total);
+
+    startJobs();
+}
+
+void ProxyGenerator::releaseJob(Job *job)
+{
+    if (job->player == NULL)
+        return;
+
+    _vlcApp->jobScheduler()->removePlayer(job->player);
+
+    libvlc_event_manager_t *events = libvlc_media_player_event_manager(job->player);
+    libvlc_event_detach(events, libvlc_MediaPlayerEndReached, eventCallback, this);
+    libvlc_event_detach(events, libvlc_MediaPlayerEncounteredError, eventCallback, this);
+
+    libvlc_media_player_stop(job->player);
+    libvlc_media_player_release(job->player);
+    libvlc_media_release(job->vlcMedia);
+    job->player = NULL;
+    job->vlcMedia = NULL;
+}
+
+/***********************************************************************\
+                          LIBVLC CALLBACKS
+\***********************************************************************/
+
+void ProxyGenerator::eventCallback(const libvlc_event_t *event, void *data)
+{
+    ProxyGenerator *generator = (ProxyGenerator *)data;
+    void *player = event->p_obj;
+
+    switch (event->type) {
+    case libvlc_MediaPlayerEndReached:
+        QMetaObject::invokeMethod(generator, "jobEnded", Qt::QueuedConnection, Q_ARG(void *, player));
+        break;
+    case libvlc_MediaPlayerEncounteredError:
+        QMetaObject::invokeMethod(generator, "jobFailed", Qt::QueuedConnection, Q_ARG(void *, player));
+        break;
+    default:
+        break;
+    }
+}
@@ -0,0 +1,216 @@
+/**********************************************************************************
+ * This file is part of Open Projection Program (OPP).
+ *
+ * Copyright (C) 2013 Catalogue Ouvert du Cinéma <dev@cinemaouvert.fr>
+ *
+ * Authors: Jerome Blanchi <d.j.a.y@free.fr>
+ *
+ * Open Projection Program is an initiative of Catalogue Ouvert du Cinéma.
+ * The software was developed by four students of University of Poitiers
+ * as school project.
+ *
+ * Open Projection Program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Open Projection Program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Open Projection Program. If not, see <http://www.gnu.org/licenses/>.
+ **********************************************************************************/
+
+#ifndef PROXYGENERATOR_H
+#define PROXYGENERATOR_H
+
+#include <QObject>
+#include <QDateTime>
+#include <QList>
+#include <QSize>
+#include <QStringList>
+
+#include <vlc/vlc.h>
+
+class MediaListModel;
+class VLCApplication;
+
+/**
+ * @brief Transcode the media of the bin into low resolution proxies, in background
+ *
+ * A proxy is a PROXY_HEIGHT lines H.264 copy of the video, without audio,
+ * with a keyframe every KEYFRAME_INTERVAL frames, so the previews decode it
+ * for a fraction of the cost of the master and seek in it precisely. The
+ * projection always plays the master, only the frame extraction of the
+ * previews and of the seek bar reads the proxies.
+ *
+ * The proxies are written into the proxyPath directory under a name depending
+ * on the location, the size and the date of the master, so a replaced file
+ * gets a new proxy. With the proxyEnabled setting, each media added to the
+ * bin is queued.
+ */
+class ProxyGenerator : public QObject
+{
+    Q_OBJECT
+public:
+    explicit ProxyGenerator(VLCApplication *vlcApp, MediaListModel *mediaListModel, QObject *parent = 0);
+    ~ProxyGenerator();
+
+    /**
+     * @brief Add a media file to the transcode queue
+     * @param location The media location, skipped if queued or its proxy exists
+     */
+    void generate(const QString &location);
+
+    /**
+     * @brief Queue every video of the bin without proxy, except the ones which failed
+     * @return The number of media queued
+     */
+    int generateAll();
+
+    /**
+     * @brief Get the proxy file of a media file, whether it exists or not
+     * @param location The media location
+     * @return The file name
+     */
+    static QString proxyFile(const QString &location);
+
+    /**
+     * @brief Get the proxy file of a version of a media file
+     * @param location The media location
+     * @param size The size of the file
+     * @param modified The date of the file
+     * @return The file name
+     */
+    static QString proxyFile(const QString &location, qint64 size, const QDateTime &modified);
+
+    /**
+     * @brief Get the file a preview should decode
+     * @param location The media location
+     * @param size The size of the images wanted
+     * @return The proxy if it exists and is large enough, the location otherwise
+     */
+    static QString previewLocation(const QString &location, const QSize &size);
+
+    /**
+     * @brief PROXY_HEIGHT Lines of the proxies, smaller videos keep their size
+     */
+    static const int PROXY_HEIGHT = 360;
+
+    /**
+     * @brief KEYFRAME_INTERVAL Frames between two keyframes of the proxies
+     */
+    static const int KEYFRAME_INTERVAL = 12;
+
+public slots:
+    /**
+     * @brief Stop the running transcodes and clear the queue
+     */
+    void cancel();
+
+signals:
+    /**
+     * @brief Emitted when the proxy of a media file is ready
+     * @param location The media location
+     */
+    void generated(const QString &location);
+
+    /**
+     * @brief Emitted each time a media is done
+     * @param done The number of media done since the queue was empty
+     * @param total The number of media queued since the queue was empty
+     */
+    void progress(int done, int total);
+
+    /**
+     * @brief Emitted when the queue is empty
+     */
+    void finished();
+
+private slots:
+    /**
+     * @brief Start jobs from the queue when the scheduler gives a slot
+     */
+    void startJobs();
+
+    /**
+     * @brief Queue the new media of the bin if the proxies are enabled
+     */
+    void mediaListChanged();
+
+    /**
+     * @brief Publish the proxy of a player at the end of its media
+     * @param player The libvlc player of the job
+     */
+    void jobEnded(void *player);
+
+    /**
+     * @brief Drop the job of a player which could not transcode its media
+     * @param player The libvlc player of the job
+     */
+    void jobFailed(void *player);
+
+private:
+    /**
+     * @brief Transcode of one media
+     */
+    struct Job {
+        QString location;
+        QString partFile;
+        libvlc_media_t *vlcMedia;
+        libvlc_media_player_t *player;
+    };
+
+    /**
+     * @brief Find the job of a player
+     */
+    Job *job(void *player) const;
+
+    /**
+     * @brief Delete a released job and start the next ones
+     */
+    void finishJob(Job *job);
+
+    /**
+     * @brief Stop and release the player and the media of a job
+     */
+    void releaseJob(Job *job);
+
+    /**
+     * @brief libvlc event callback
+     */
+    static void eventCallback(const libvlc_event_t *event, void *data);
+
+    VLCApplication *_vlcApp;
+
+    MediaListModel *_mediaListModel;
+
+    /**
+     * @brief _queue The media locations waiting for a free job
+     */
+    QStringList _queue;
+
+    /**
+     * @brief _failed The media locations which could not be transcoded, not queued again with the bin
+     */
+    QStringList _failed;
+
+    /**
+     * @brief _jobs The running jobs
+     */
+    QList<Job*> _jobs;
+
+    /**
+     * @brief _done The number of media done since the queue was empty
+     */
+    int _done;
+
+    /**
+     * @brief _total The number of media queued since the queue was empty
+     */
+    int _total;
+};
+
+#endif // PROXYGENERATOR_H
@@ -27,29 +27,39 @@
 #include "ui_screenshotselector.h"
 #include "utils.h"
 #include "mainwindow.h"
+#include "frameextractor.h"
+#include "jobscheduler.h"
+#include "thumbnailstore.h"
+#include "VLCApplication.h"
 
 #include <QDir>
+#include <QListWidgetItem>
+#include <QPixmap>
 
 ScreenshotSelector::ScreenshotSelector(QWidget *parent) :
     QDialog(parent),
-    ui(new Ui::ScreenshotSelector)
+    ui(new Ui::ScreenshotSelector),
+    _media(NULL),
+    _extractor(NULL)
 {
     ui->setupUi(this);
 
-    vlc = libvlc_new(0, NULL);
-    vlcp = libvlc_media_player_new(vlc);
+    _extractor = new FrameExtractor(((MainWindow*)parent)->vlcApplication(), this);
+    // the filmstrip is waited for on screen
+    ((MainWindow*)parent)->vlcApplication()->jobScheduler()->setPriority(_extractor, JobScheduler::HighPriority);
+    connect(_extractor, SIGNAL(frameExtracted(int,int,QImage)), this, SLOT(addFilmstripFrame(int,int,QImage)));
+
+    connect(ui->filmstripList, SIGNAL(itemClicked(QListWidgetItem*)), this, SLOT(selectFilmstripFrame(QListWidgetItem*)));
 }
 
 ScreenshotSelector::~ScreenshotSelector()
 {
-    libvlc_release(vlc);
-    libvlc_media_player_release(vlcp);
-
     delete ui;
 }
 
 void ScreenshotSelector::setMedia(Media *media){
     this->_media = media;
+    _screenLocation.clear();
 
     ui->startLabel->setText("00:00:00:000");
     uint duration = this->_media->duration();
@@ -64,50 +74,25 @@ void ScreenshotSelector::setMedia(Media *media){
     ui->seekSlider->setPageStep(ui->stepInput->value());
     ui->seekSlider->setValue(1);
 
-    _currentWId = ui->videoWidget->request();
-
-    if (_currentWId) {
-        #if defined(Q_OS_WIN)
-                libvlc_media_player_set_hwnd(vlcp, (void *)_currentWId);
-        #elif defined(Q_OS_MAC)
-                libvlc_media_player_set_nsobject(vlcp, (void *)_currentWId);
-        #elif defined(Q_OS_UNIX)
-                libvlc_media_player_set_xwindow(vlcp, _currentWId);
-        #endif
-    }
-
+    ui->filmstripList->clear();
+    ui->previewLabel->clear();
 
-    libvlc_media_player_set_media(vlcp, _media->core());
-    libvlc_media_add_option(_media->core(),":noaudio");
-
-    libvlc_media_player_play(vlcp);
-    wait(750);
-    libvlc_media_player_pause(vlcp);
+    if(!_media->isAudio() && !_media->isImage())
+        _extractor->extractFilmstrip(_media, FILMSTRIP_COUNT, FrameExtractor::frameSize(_media, FILMSTRIP_WIDTH));
 }
 
 void ScreenshotSelector::on_buttonBox_accepted()
 {
-    QString screenPath = qApp->applicationDirPath() + "/screenshot/";
-    screenPath = screenPath.replace("/",QDir::separator());
-    screenPath +=  _media->getLocation().replace(QDir::separator(),"_").remove(":");
-    screenPath += ".png";
-
-    unsigned* width = new unsigned(0);
-    unsigned* height = new unsigned(0);
-    libvlc_video_get_size(vlcp, 0, width, height);
-
-    // reduce the size to a usable size
-    unsigned denom = *width / (unsigned)((MainWindow*)parent())->screenBefore()->width();
-    if(denom >= 1){
-        *width = *width/denom;
-        *height = *height/denom;
-    }
-    libvlc_video_take_snapshot(vlcp, 0, screenPath.toStdString().c_str(), *width, *height);
+    if(_media == NULL)
+        return;
 
-    delete width;
-    delete height;
+    // only the chosen frame is decoded with a precise seek, the filmstrip is dropped
+    // the store keeps the smaller sizes, scaled from the largest
+    QList<int> times;
+    times << ui->seekSlider->value();
+    _extractor->extract(_media->location(), times, FrameExtractor::frameSize(_media, ThumbnailStore::LARGE_WIDTH));
+    _screenLocation = _media->location();
 
-    ((MainWindow*) this->parent())->updateCurrentScreenshot();
     close();
 }
 
@@ -121,18 +106,63 @@ void ScreenshotSelector::closeEvent (QCloseEvent *event){
 }
 
 void ScreenshotSelector::close(){
-    libvlc_media_player_stop(vlcp);
+    if(_screenLocation.isEmpty())
+        _extractor->cancel();
 }
 
-void ScreenshotSelector::setScreenshot(int position){
-    libvlc_media_player_set_time(vlcp,position);
+void ScreenshotSelector::addFilmstripFrame(int index, int time, const QImage &image){
+    if(!_screenLocation.isEmpty()){
+        ThumbnailStore::store(_screenLocation, image);
+        _screenLocation.clear();
+        ((MainWindow*) this->parent())->updateCurrentScreenshot();
+        return;
+    }
+
+    QPixmap pixmap = QPixmap::fromImage(image);
+
+    QListWidgetItem *item = new QListWidgetItem(QIcon(pixmap), msecToQTime(time).toString("hh:mm:ss"));
+    item->setData(Qt::UserRole, time);
+    item->setData(Qt::UserRole + 1, pixmap);
+    ui->filmstripList->addItem(item);
+
+    if(index == 0)
+        showPreview(time);
+}
+
+void ScreenshotSelector::selectFilmstripFrame(QListWidgetItem *item){
+    int time = item->data(Qt::UserRole).toInt();
+
+    ui->seekSlider->setValue(time);
+    ui->startLabel->setText(msecToQTime(time).toString("hh:mm:ss:zzz"));
+    showPreview(time);
+}
+
+void ScreenshotSelector::showPreview(int time){
+    QListWidgetItem *nearest = NULL;
+    int distance = 0;
+
+    for(int i = 0; i < ui->filmstripList->count(); ++i){
+        QListWidgetItem *item = ui->filmstripList->item(i);
+        int d = qAbs(item->data(Qt::UserRole).toInt() - time);
+        if(nearest == NULL || d < distance){
+            nearest = item;
+            distance = d;
+        }
+    }
+
+    if(nearest == NULL)
+        return;
+
+    ui->filmstripList->setCurrentItem(nearest);
+    QPixmap pixmap = nearest->data(Qt::UserRole + 1).value<QPixmap>();
+    ui->previewLabel->setPixmap(pixmap.scaled(ui->previewLabel->size(), Qt::KeepAspectRatio, Qt::SmoothTransformation));
 }
 
 
 void ScreenshotSelector::on_seekSlider_sliderReleased()
 {
     int position = ui->seekSlider->value();
-    setScreenshot(position);
+    showPreview(position);
     QTime durationTime = msecToQTime(position);
     ui->startLabel->setText(durationTime.toString("hh:mm:ss:zzz"));
 }
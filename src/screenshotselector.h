@@ -27,9 +27,11 @@
 #define SCREENSHOTSELECTOR_H
 
 #include <QDialog>
+#include <QImage>
 #include "media.h"
-#include <vlc/vlc.h>
 
+class QListWidgetItem;
+class FrameExtractor;
 
 namespace Ui {
 class ScreenshotSelector;
@@ -93,6 +95,20 @@ private slots:
       */
     void on_stepInput_valueChanged(int arg1);
 
+    /**
+      * @brief Add a frame of the filmstrip, or save the chosen screenshot
+      * @param index The index of the frame
+      * @param time The time of the frame in ms
+      * @param image The frame
+      */
+    void addFilmstripFrame(int index, int time, const QImage &image);
+
+    /**
+      * @brief Move the slider on a frame of the filmstrip
+      * @param item The frame clicked
+      */
+    void selectFilmstripFrame(QListWidgetItem *item);
+
 private:
     /**
       * @brief ui The ui
@@ -101,31 +117,37 @@ private:
     Ui::ScreenshotSelector *ui;
 
     /**
-      * @brief vlc The libvlc instance
+      * @brief _media The media
+      *
+      */
+    Media *_media;
+
+    /**
+      * @brief _extractor Decode the filmstrip and the chosen screenshot in background
       *
       */
-    libvlc_instance_t *vlc;
+    FrameExtractor *_extractor;
 
     /**
-      * @brief vlcp The liblvc media player
+      * @brief _screenLocation The media whose chosen screenshot is pending, empty if none
       *
       */
-    libvlc_media_player_t *vlcp;
+    QString _screenLocation;
 
     /**
-      * @brief _currentWId The current WId
+      * @brief FILMSTRIP_COUNT Number of frames of the filmstrip
       *
       */
-    WId _currentWId;
+    static const int FILMSTRIP_COUNT = 12;
 
     /**
-      * @brief _media The media
+      * @brief FILMSTRIP_WIDTH Width of the frames of the filmstrip
       *
       */
-    Media *_media;
+    static const int FILMSTRIP_WIDTH = 320;
 
     /**
-      * @brief Stop the libvlc media player
+      * @brief Stop the filmstrip extraction
       *
       * @author Thibaud Lamarche <lamarchethibaud@hotmail.fr>
       */
@@ -139,11 +161,10 @@ private:
     void closeEvent (QCloseEvent *event);
 
     /**
-      * @brief Set time in the libvlc media player
-      *
-      * @author Thibaud Lamarche <lamarchethibaud@hotmail.fr>
+      * @brief Show the frame of the filmstrip nearest to a time
+      * @param time The time in ms
       */
-    void setScreenshot(int position);
+    void showPreview(int time);
 
 
 };
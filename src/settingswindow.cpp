@@ -66,6 +66,12 @@ void SettingsWindow::init(){
     QSettings settings("opp","opp");
     ui->lineEdit_moviesPath->setText(settings.value("moviesPath").toString());
     ui->lineEdit_UpdatePath->setText(settings.value("updatePath").toString());
+    ui->lineEdit_stagingPath->setText(settings.value("stagingPath").toString());
+    ui->checkBox_staging->setChecked(settings.value("stagingEnabled").toBool());
+    ui->spinBox_stagingSize->setValue(settings.value("stagingSize").toInt());
+    ui->lineEdit_watchFolders->setText(settings.value("watchFolders").toStringList().join(";"));
+    ui->checkBox_proxy->setChecked(settings.value("proxyEnabled").toBool());
+    ui->checkBox_engine->setChecked(settings.value("engineProcess").toBool());
     ui->groupBox_3->setEnabled(false);
     setVideoReturnMode();
 
@@ -156,6 +162,12 @@ void SettingsWindow::accept() {
     settings.setValue("locateR", ui->radioButton_locateRight->isChecked());
     settings.setValue("updatePath", ui->lineEdit_UpdatePath->text());
     settings.setValue("subtitleColor", ui->comboBox_SubtitleColor->currentIndex());
+    settings.setValue("stagingPath", ui->lineEdit_stagingPath->text());
+    settings.setValue("stagingEnabled", ui->checkBox_staging->isChecked());
+    settings.setValue("stagingSize", ui->spinBox_stagingSize->value());
+    settings.setValue("watchFolders", ui->lineEdit_watchFolders->text().split(";", QString::SkipEmptyParts));
+    settings.setValue("proxyEnabled", ui->checkBox_proxy->isChecked());
+    settings.setValue("engineProcess", ui->checkBox_engine->isChecked());
     setSettingsVideoReturnMode();
 }
 
@@ -172,6 +184,13 @@ void SettingsWindow::on_pushButton_moviesPath_clicked()
         ui->lineEdit_moviesPath->setText(pathMovies);
 }
 
+void SettingsWindow::on_pushButton_stagingPath_clicked()
+{
+    QString path = QFileDialog::getExistingDirectory(this, tr("Open Directory"), ui->lineEdit_stagingPath->text(), QFileDialog::ShowDirsOnly);
+    if(path!="")
+        ui->lineEdit_stagingPath->setText(path);
+}
+
 void SettingsWindow::on_radioButton_Streaming_clicked()
 {
     ui->groupBox_3->setEnabled(true);
@@ -84,6 +84,11 @@ private slots:
      */
     void on_pushButton_moviesPath_clicked();
 
+    /**
+     * @brief Change the value of the staging path field
+     */
+    void on_pushButton_stagingPath_clicked();
+
     /**
      * @brief Activate the group box for the screen position and show an information message
      *
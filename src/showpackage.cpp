@@ -0,0 +1,429 @@
+/**********************************************************************************
+ * This file is part of Open Projection Program (OPP).
+ *
+ * Copyright (C) 2013 Catalogue Ouvert du Cinéma <dev@cinemaouvert.fr>
+ *
+ * Authors: Jerome Blanchi <d.j.a.y@free.fr>
+ *
+ * Open Projection Program is an initiative of Catalogue Ouvert du Cinéma.
+ * The software was developed by four students of University of Poitiers
+ * as school project.
+ *
+ * Open Projection Program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Open Projection Program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Open Projection Program. If not, see <http://www.gnu.org/licenses/>.
+ **********************************************************************************/
+
+#include "showpackage.h"
+
+#include <QDir>
+#include <QFile>
+#include <QFileInfo>
+#include <QImage>
+#include <QRunnable>
+#include <QSettings>
+#include <QTextStream>
+#include <QtXml>
+
+#include "filecopy.h"
+#include "fingerprint.h"
+#include "thumbnailstore.h"
+
+/**
+ * @brief Copy and check one file of a package
+ */
+class PackageCopy : public QRunnable
+{
+public:
+    PackageCopy(QObject *package, int generation, const QString &source, const QString &destination,
+                const QString &fingerprint, QAtomicInt *cancelled) :
+        package(package), generation(generation), source(source), destination(destination),
+        fingerprint(fingerprint), cancelled(cancelled) {}
+
+    void run()
+    {
+        bool succeeded = false;
+        QString error;
+        const QString part = destination + ".part";
+
+        if (QFileInfo(destination).size() == QFileInfo(source).size() && Fingerprint::compute(destination) == fingerprint) {
+            // copied by a previous run
+            succeeded = true;
+        } else if (FileCopy::copy(source, part, NULL, cancelled, &error)) {
+            if (Fingerprint::compute(part) != fingerprint) {
+                error = "the copy differs from the original";
+                QFile::remove(part);
+            } else {
+                QFile::remove(destination);
+                succeeded = QFile::rename(part, destination);
+                if (!succeeded)
+                    error = "can not rename the copy";
+            }
+        }
+
+        if (!succeeded)
+            error = source + ": " + error;
+
+        QMetaObject::invokeMethod(package, "copyDone", Qt::QueuedConnection,
+                                  Q_ARG(int, generation), Q_ARG(bool, succeeded), Q_ARG(QString, error));
+    }
+
+    QObject *package;
+    int generation;
+    QString source;
+    QString destination;
+    QString fingerprint;
+    QAtomicInt *cancelled;
+};
+
+ShowPackage::ShowPackage(QObject *parent) :
+    QObject(parent),
+    _done(0),
+    _running(false),
+    _generation(0),
+    _searcher(new FingerprintSearcher(this))
+{
+    _pool.setMaxThreadCount(PARALLEL_COPIES);
+
+    connect(_searcher, SIGNAL(progress(int)), this, SIGNAL(searchProgress(int)));
+    connect(_searcher, SIGNAL(finished()), this, SLOT(importSearched()));
+}
+
+ShowPackage::~ShowPackage()
+{
+    cancel();
+}
+
+bool ShowPackage::exportTo(const QString &listing, const QString &directory)
+{
+    if (_running)
+        return false;
+
+    QFile file(listing);
+    QDomDocument doc;
+    if (!file.open(QIODevice::ReadOnly) || !doc.setContent(&file))
+        return false;
+
+    QDir package(directory);
+    if (!package.mkpath("."))
+        return false;
+
+    _items.clear();
+    _paths.clear();
+    _errors.clear();
+
+    // the files of the listing, with relative locations
+    QStringList sources;
+    QStringList paths;
+
+    // the fingerprints saved with the listing, for the media unchanged since
+    QHash<QString, QString> known;
+
+    QDomNodeList mediaNodes = doc.elementsByTagName("media");
+    for (int i = 0; i < mediaNodes.count(); i++) {
+        QDomElement media = mediaNodes.at(i).toElement();
+        const QString location = media.attribute("location");
+        const QString path = packagePath("media", location);
+
+        if (media.hasAttribute("fingerprintDate")
+                && Fingerprint::isCurrent(media.attribute("fingerprint"),
+                                          QDateTime::fromTime_t(media.attribute("fingerprintDate").toUInt()), location))
+            known.insert(location, media.attribute("fingerprint"));
+
+        if (!sources.contains(location)) {
+            sources << location;
+            paths << path;
+
+            const QString screenshot = ThumbnailStore::exportFile(location);
+            if (!screenshot.isEmpty()) {
+                sources << screenshot;
+                paths << packageScreenshot(path);
+            }
+        }
+        media.setAttribute("location", path);
+    }
+
+    QDomNodeList playbackNodes = doc.elementsByTagName("playback");
+    for (int i = 0; i < playbackNodes.count(); i++) {
+        QDomElement playback = playbackNodes.at(i).toElement();
+        const QString subtitles = playback.attribute("subtitlesFile");
+        if (subtitles.isEmpty())
+            continue;
+
+        const QString path = packagePath("subtitles", subtitles);
+        if (!sources.contains(subtitles)) {
+            sources << subtitles;
+            paths << path;
+        }
+        playback.setAttribute("subtitlesFile", path);
+    }
+
+    QStringList unknown;
+    foreach (const QString &source, sources)
+        if (!known.contains(source))
+            unknown << source;
+
+    QStringList computed = Fingerprint::compute(unknown);
+    for (int i = 0; i < unknown.count(); i++)
+        known.insert(unknown.at(i), computed.at(i));
+
+    QStringList fingerprints;
+    foreach (const QString &source, sources)
+        fingerprints << known.value(source);
+
+    QSettings index(package.filePath("index.ini"), QSettings::IniFormat);
+    index.clear();
+    index.beginWriteArray("files", sources.count());
+    for (int i = 0; i < sources.count(); i++) {
+        index.setArrayIndex(i);
+        index.setValue("path", paths.at(i));
+        index.setValue("size", QFileInfo(sources.at(i)).size());
+        index.setValue("fingerprint", fingerprints.at(i));
+
+        if (fingerprints.at(i).isEmpty())
+            _errors << sources.at(i) + ": " + tr("can not be read");
+        else
+            addItem(sources.at(i), package.filePath(paths.at(i)), fingerprints.at(i));
+    }
+    index.endArray();
+
+    _listing = package.filePath("listing.opp");
+    _listingContent = doc.toString(2);
+
+    start();
+
+    return true;
+}
+
+bool ShowPackage::importFrom(const QString &directory, const QString &destination)
+{
+    if (_running)
+        return false;
+
+    QDir package(directory);
+    QFile file(package.filePath("listing.opp"));
+    QDomDocument doc;
+    if (!file.open(QIODevice::ReadOnly) || !doc.setContent(&file))
+        return false;
+
+    QDir target(destination);
+    if (!target.mkpath("."))
+        return false;
+
+    _items.clear();
+    _paths.clear();
+    _errors.clear();
+
+    // the fingerprint of each file of the package
+    QHash<QString, QString> fingerprints;
+    QSettings index(package.filePath("index.ini"), QSettings::IniFormat);
+    int count = index.beginReadArray("files");
+    for (int i = 0; i < count; i++) {
+        index.setArrayIndex(i);
+        fingerprints.insert(index.value("path").toString(), index.value("fingerprint").toString());
+    }
+    index.endArray();
+
+    _importPackage = package.absolutePath();
+    _importDestination = target.absolutePath();
+    _importFingerprints = fingerprints;
+    _listing = target.filePath(package.dirName() + ".opp");
+    _listingContent = doc.toString(2);
+
+    // the files already on this computer are not copied
+    QSettings settings("opp", "opp");
+    QStringList roots = settings.value("relinkRoots").toStringList();
+    roots << settings.value("moviesPath").toString();
+    roots << destination;
+
+    _running = true;
+    _searcher->start(fingerprints.values(), roots);
+
+    return true;
+}
+
+void ShowPackage::importSearched()
+{
+    if (!_running)
+        return;
+
+    QDir package(_importPackage);
+    QDir target(_importDestination);
+    const QHash<QString, QString> &fingerprints = _importFingerprints;
+
+    QDomDocument doc;
+    doc.setContent(_listingContent);
+
+    QHash<QString, QString> present = _searcher->found();
+    QHash<QString, QString>::iterator it = present.begin();
+    while (it != present.end()) {
+        // the package itself is only the source of the copies
+        if (QFileInfo(it.value()).absoluteFilePath().startsWith(package.absolutePath() + "/"))
+            it = present.erase(it);
+        else
+            ++it;
+    }
+
+    QStringList copied;
+
+    QDomNodeList mediaNodes = doc.elementsByTagName("media");
+    for (int i = 0; i < mediaNodes.count(); i++) {
+        QDomElement media = mediaNodes.at(i).toElement();
+        const QString path = media.attribute("location");
+        const QString fingerprint = fingerprints.value(path);
+        QString location = present.value(fingerprint);
+
+        if (location.isEmpty()) {
+            location = target.filePath(path);
+            if (!copied.contains(path)) {
+                copied << path;
+                addItem(package.filePath(path), location, fingerprint);
+            }
+        }
+
+        // stored under the fingerprint of the media, which may not be copied yet
+        const QString screenshot = packageScreenshot(path);
+        if (fingerprints.contains(screenshot) && !fingerprint.isEmpty() && !ThumbnailStore::contains(location))
+            ThumbnailStore::store(location, QImage(package.filePath(screenshot)), fingerprint);
+
+        media.setAttribute("location", location);
+    }
+
+    QDomNodeList playbackNodes = doc.elementsByTagName("playback");
+    for (int i = 0; i < playbackNodes.count(); i++) {
+        QDomElement playback = playbackNodes.at(i).toElement();
+        const QString path = playback.attribute("subtitlesFile");
+        if (path.isEmpty())
+            continue;
+
+        const QString fingerprint = fingerprints.value(path);
+        QString location = present.value(fingerprint);
+
+        if (location.isEmpty()) {
+            location = target.filePath(path);
+            if (!copied.contains(path)) {
+                copied << path;
+                addItem(package.filePath(path), location, fingerprint);
+            }
+        }
+
+        playback.setAttribute("subtitlesFile", location);
+    }
+
+    _listingContent = doc.toString(2);
+
+    start();
+}
+
+void ShowPackage::cancel()
+{
+    if (!_running)
+        return;
+
+    // an import still searching, its copies never start
+    _searcher->cancel();
+
+    _cancelled.fetchAndStoreOrdered(1);
+    _pool.waitForDone();
+
+    _running = false;
+    _items.clear();
+}
+
+void ShowPackage::addItem(const QString &source, const QString &destination, const QString &fingerprint)
+{
+    Item item;
+    item.source = source;
+    item.destination = destination;
+    item.fingerprint = fingerprint;
+
+    QDir().mkpath(QFileInfo(destination).absolutePath());
+    _items << item;
+}
+
+QString ShowPackage::packagePath(const QString &directory, const QString &file)
+{
+    if (_paths.contains(file))
+        return _paths.value(file);
+
+    // the same name in another directory gets a number
+    QFileInfo info(file);
+    QString path = directory + "/" + info.fileName();
+    for (int i = 2; _paths.values().contains(path); i++)
+        path = directory + "/" + info.completeBaseName() + QString("-%1").arg(i)
+                + (info.suffix().isEmpty() ? QString() : "." + info.suffix());
+
+    _paths.insert(file, path);
+
+    return path;
+}
+
+void ShowPackage::start()
+{
+    _running = true;
+    _done = 0;
+    _generation++;
+    _cancelled.fetchAndStoreOrdered(0);
+
+    if (_items.isEmpty()) {
+        finish();
+        return;
+    }
+
+    foreach (const Item &item, _items)
+        _pool.start(new PackageCopy(this, _generation, item.source, item.destination, item.fingerprint, &_cancelled));
+}
+
+void ShowPackage::copyDone(int generation, bool succeeded, const QString &error)
+{
+    if (!_running || generation != _generation)
+        return;
+
+    if (!succeeded)
+        _errors << error;
+
+    _done++;
+    emit progress(_done, _items.count());
+
+    if (_done == _items.count())
+        finish();
+}
+
+void ShowPackage::finish()
+{
+    _running = false;
+
+    if (!_errors.isEmpty()) {
+        emit finished(false, QString(), _errors.join("\n"));
+        return;
+    }
+
+    QFile file(_listing);
+    if (!file.open(QIODevice::WriteOnly)) {
+        emit finished(false, QString(), _listing + ": " + file.errorString());
+        return;
+    }
+
+    QTextStream stream(&file);
+    stream.setCodec("UTF-8");
+    stream << _listingContent;
+    file.close();
+
+    emit finished(true, _listing, QString());
+}
+
+QString ShowPackage::packageScreenshot(const QString &path)
+{
+    QString name = path;
+
+    return "screenshot/" + name.replace("/", "_") + ".jpg";
+}
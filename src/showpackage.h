@@ -0,0 +1,221 @@
+/**********************************************************************************
+ * This file is part of Open Projection Program (OPP).
+ *
+ * Copyright (C) 2013 Catalogue Ouvert du Cinéma <dev@cinemaouvert.fr>
+ *
+ * Authors: Jerome Blanchi <d.j.a.y@free.fr>
+ *
+ * Open Projection Program is an initiative of Catalogue Ouvert du Cinéma.
+ * The software was developed by four students of University of Poitiers
+ * as school project.
+ *
+ * Open Projection Program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Open Projection Program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Open Projection Program. If not, see <http://www.gnu.org/licenses/>.
+ **********************************************************************************/
+
+#ifndef SHOWPACKAGE_H
+#define SHOWPACKAGE_H
+
+#include <QObject>
+#include <QAtomicInt>
+#include <QHash>
+#include <QList>
+#include <QStringList>
+#include <QThreadPool>
+
+class FingerprintSearcher;
+
+/**
+ * @brief Export and import a listing with all its files, to move a show between venues
+ *
+ * A package is a directory holding the listing (listing.opp) with relative
+ * locations, the media (media/), the subtitles (subtitles/), the screenshots
+ * of the media (screenshot/) and an index of the files with their size and
+ * fingerprint (index.ini).
+ *
+ * The files are copied by FileCopy, PARALLEL_COPIES at once, then checked by
+ * their fingerprint. A file already copied is skipped and an interrupted copy
+ * is resumed, so an export or an import may simply be started again. The
+ * import does not copy the files found on the computer by their fingerprint,
+ * searched in background before the copies.
+ * The listing is written once every file is copied.
+ */
+class ShowPackage : public QObject
+{
+    Q_OBJECT
+public:
+    explicit ShowPackage(QObject *parent = 0);
+    ~ShowPackage();
+
+    /**
+     * @brief Start the export of a listing to a package
+     * @param listing The listing file
+     * @param directory The package directory
+     * @return True if started, false if the listing can not be read or a copy is running
+     */
+    bool exportTo(const QString &listing, const QString &directory);
+
+    /**
+     * @brief Start the import of a package
+     * @param directory The package directory
+     * @param destination The directory receiving the files and the listing
+     * @return True if started, false if the package can not be read or a copy is running
+     */
+    bool importFrom(const QString &directory, const QString &destination);
+
+    /**
+     * @brief Allow to know if a copy is running
+     * @return True if running, false otherwise
+     */
+    inline bool isRunning() const { return _running; }
+
+    /**
+     * @brief PARALLEL_COPIES Files copied at once
+     */
+    static const int PARALLEL_COPIES = 4;
+
+public slots:
+    /**
+     * @brief Stop the copies, the files copied are kept for the next time
+     */
+    void cancel();
+
+signals:
+    /**
+     * @brief Emitted each time a file is done
+     * @param done The number of files done
+     * @param total The number of files to copy
+     */
+    void progress(int done, int total);
+
+    /**
+     * @brief Emitted periodically while the import searches the files already on the computer
+     * @param scanned The number of files walked
+     */
+    void searchProgress(int scanned);
+
+    /**
+     * @brief Emitted when every file is done
+     * @param succeeded True if every file is copied and the listing written
+     * @param listing The listing written
+     * @param report The files which could not be copied, one per line
+     */
+    void finished(bool succeeded, const QString &listing, const QString &report);
+
+private slots:
+    /**
+     * @brief Count a copy done, write the listing after the last one
+     * @param generation The export or import of the copy
+     * @param succeeded True if the file is copied and checked
+     * @param error The reason of a failure
+     */
+    void copyDone(int generation, bool succeeded, const QString &error);
+
+    /**
+     * @brief Queue the files of the package not found on the computer and start the copies
+     */
+    void importSearched();
+
+private:
+    /**
+     * @brief File to copy
+     */
+    struct Item {
+        QString source;
+        QString destination;
+        QString fingerprint;
+    };
+
+    /**
+     * @brief Queue a file, create the directory of the copy
+     */
+    void addItem(const QString &source, const QString &destination, const QString &fingerprint);
+
+    /**
+     * @brief Give a file of the listing a path in the package, once per file
+     * @param directory The directory of the package for this kind of file
+     * @param file The file
+     * @return The path relative to the package
+     */
+    QString packagePath(const QString &directory, const QString &file);
+
+    /**
+     * @brief Start the copies of the queued files
+     */
+    void start();
+
+    /**
+     * @brief Write the listing and tell the result
+     */
+    void finish();
+
+    /**
+     * @brief Get the screenshot of a media in a package
+     * @param path The path of the media relative to the package
+     */
+    static QString packageScreenshot(const QString &path);
+
+    QThreadPool _pool;
+
+    QList<Item> _items;
+
+    /**
+     * @brief _paths The path in the package of each file of the listing
+     */
+    QHash<QString, QString> _paths;
+
+    /**
+     * @brief _listing The file of the listing written at the end
+     */
+    QString _listing;
+
+    /**
+     * @brief _listingContent The listing with the locations of the copies
+     */
+    QString _listingContent;
+
+    QStringList _errors;
+
+    int _done;
+
+    bool _running;
+
+    /**
+     * @brief _generation Tells the copies of a cancelled run apart
+     */
+    int _generation;
+
+    QAtomicInt _cancelled;
+
+    /**
+     * @brief _searcher Search the files of an import already on the computer
+     */
+    FingerprintSearcher *_searcher;
+
+    /**
+     * @brief _importPackage The package directory of the running import
+     */
+    QString _importPackage;
+
+    /**
+     * @brief _importDestination The directory receiving the files of the running import
+     */
+    QString _importDestination;
+
+    /**
+     * @brief _importFingerprints The fingerprint of each file of the running import
+     */
+    QHash<QString, QString> _importFingerprints;
+};
+
+#endif // SHOWPACKAGE_H
@@ -0,0 +1,548 @@
+/**********************************************************************************
+ * This file is part of Open Projection Program (OPP).
+ *
+ * Copyright (C) 2013 Catalogue Ouvert du Cinéma <dev@cinemaouvert.fr>
+ *
+ * Authors: Jerome Blanchi <d.j.a.y@free.fr>
+ *
+ * Open Projection Program is an initiative of Catalogue Ouvert du Cinéma.
+ * The software was developed by four students of University of Poitiers
+ * as school project.
+ *
+ * Open Projection Program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Open Projection Program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Open Projection Program. If not, see <http://www.gnu.org/licenses/>.
+ **********************************************************************************/
+
+#include "stagingcache.h"
+
+#include <limits.h>
+
+#include <QCoreApplication>
+#include <QCryptographicHash>
+#include <QDebug>
+#include <QDir>
+#include <QFile>
+#include <QFileInfo>
+#include <QMutexLocker>
+#include <QSettings>
+#include <QThread>
+#include <QTimer>
+
+#if defined(Q_OS_WIN)
+# include <windows.h>
+#elif defined(Q_OS_LINUX)
+# include <sys/statfs.h>
+#elif defined(Q_OS_MAC)
+# include <sys/param.h>
+# include <sys/mount.h>
+#endif
+
+#include "VLCApplication.h"
+#include "filecopy.h"
+#include "jobscheduler.h"
+#include "playback.h"
+#include "schedulelistmodel.h"
+
+QHash<QString, StagingCache::Entry> StagingCache::s_entries;
+QMutex StagingCache::s_mutex;
+
+/**
+ * @brief Check and copy one media in its own thread
+ *
+ * The media is only read here: its size and date are compared with the copy
+ * of the index, an outdated copy is removed and a new one is made.
+ */
+class StagingCopy : public QThread
+{
+public:
+    StagingCopy(StagingCache *cache, const QString &source, const QStringList &protectedLocations, int rate,
+                JobScheduler *scheduler, QObject *parent) :
+        QThread(parent),
+        cache(cache),
+        source(source),
+        protectedLocations(protectedLocations),
+        size(0),
+        rate(rate),
+        scheduler(scheduler),
+        cancelled(0),
+        upToDate(false),
+        succeeded(false)
+    {
+    }
+
+    StagingCache *cache;
+    QString source;
+
+    /**
+     * @brief protectedLocations The media needed within the horizon, kept when making room
+     */
+    QStringList protectedLocations;
+
+    QString destination;
+    qint64 size;
+    QDateTime modified;
+
+    /**
+     * @brief rate Bytes per second, 0 for no limit, changed by the GUI thread
+     */
+    QAtomicInt rate;
+
+    /**
+     * @brief scheduler Charged with the bytes read while projecting
+     */
+    JobScheduler *scheduler;
+
+    QAtomicInt cancelled;
+
+    /**
+     * @brief upToDate True if the copy of the index was kept, nothing was copied
+     */
+    bool upToDate;
+
+    bool succeeded;
+    QString error;
+
+protected:
+    void run()
+    {
+        // the projection reads first
+        JobScheduler::lowerIoPriority();
+
+        // the network share may stall, it is only read from this thread
+        QFileInfo info(source);
+        if (!info.exists()) {
+            error = "not found";
+            return;
+        }
+        size = info.size();
+        modified = info.lastModified();
+
+        if (cache->checkCopy(source, size, modified)) {
+            upToDate = true;
+            succeeded = true;
+            return;
+        }
+
+        if (!cache->makeRoom(size, protectedLocations)) {
+            error = "no room in the cache";
+            return;
+        }
+
+        // a new name when the media is replaced, the suffix helps the demuxers
+        QByteArray key = source.toUtf8() + '|' + QByteArray::number(size)
+                + '|' + modified.toString(Qt::ISODate).toUtf8();
+        destination = cache->_path + "/" + QCryptographicHash::hash(key, QCryptographicHash::Md5).toHex();
+        if (!info.suffix().isEmpty())
+            destination += "." + info.suffix();
+
+        const QString part = destination + ".part";
+
+        succeeded = FileCopy::copy(source, part, &rate, &cancelled, &error, scheduler) && verify(part);
+        if (succeeded) {
+            QFile::remove(destination);
+            succeeded = QFile::rename(part, destination);
+        }
+        // an interrupted copy is resumed the next time
+        if (!succeeded && !cancelled.fetchAndAddOrdered(0))
+            QFile::remove(part);
+    }
+
+private:
+    bool verify(const QString &part)
+    {
+        QFile original(source);
+        QFile copy(part);
+
+        if (!original.open(QIODevice::ReadOnly) || !copy.open(QIODevice::ReadOnly)) {
+            error = "can not read back";
+            return false;
+        }
+
+        if (original.size() != copy.size()) {
+            error = "size differs";
+            return false;
+        }
+
+        // blocks spread over the file, the first and the last included
+        for (int i = 0; i < StagingCache::VERIFY_SAMPLES; ++i) {
+            qint64 offset = qMax((qint64)0, copy.size() - StagingCache::VERIFY_BLOCK) * i / (StagingCache::VERIFY_SAMPLES - 1);
+            original.seek(offset);
+            copy.seek(offset);
+            scheduler->addReadBytes(StagingCache::VERIFY_BLOCK);
+            if (original.read(StagingCache::VERIFY_BLOCK) != copy.read(StagingCache::VERIFY_BLOCK)) {
+                error = QString("content differs at %1").arg(offset);
+                return false;
+            }
+        }
+
+        return true;
+    }
+};
+
+/**
+ * @brief Order schedules by launch date
+ */
+static bool launchesBefore(Schedule *first, Schedule *second)
+{
+    return first->launchAt() < second->launchAt();
+}
+
+StagingCache::StagingCache(VLCApplication *vlcApp, ScheduleListModel *scheduleListModel, QObject *parent) :
+    QObject(parent),
+    _vlcApp(vlcApp),
+    _scheduleListModel(scheduleListModel),
+    _copy(NULL),
+    _timer(new QTimer(this)),
+    _done(0),
+    _total(0)
+{
+    // the main window is built before the settings are initialized
+    QSettings settings("opp", "opp");
+    _path = settings.value("stagingPath", QCoreApplication::applicationDirPath() + "/staging").toString();
+    QDir().mkpath(_path);
+    loadIndex();
+
+    // needed before a show
+    _vlcApp->jobScheduler()->addClient(this, JobScheduler::IoResource, JobScheduler::HighPriority);
+    connect(_vlcApp->jobScheduler(), SIGNAL(activityChanged(int,int,bool)), this, SLOT(updateRate(int,int,bool)));
+
+    connect(_scheduleListModel, SIGNAL(scheduleListChanged()), this, SLOT(update()));
+    connect(_timer, SIGNAL(timeout()), this, SLOT(update()));
+    _timer->start(CHECK_INTERVAL);
+}
+
+StagingCache::~StagingCache()
+{
+    cancel();
+    saveIndex();
+    _vlcApp->jobScheduler()->removeClient(this);
+}
+
+QString StagingCache::stagedFile(const QString &location)
+{
+    QMutexLocker locker(&s_mutex);
+
+    // the index only, the media itself is checked by the copy thread at each update
+    if (!s_entries.contains(location) || !QFile::exists(s_entries.value(location).file))
+        return QString();
+
+    Entry &entry = s_entries[location];
+    entry.used = QDateTime::currentDateTime();
+
+    return entry.file;
+}
+
+bool StagingCache::checkCopy(const QString &location, qint64 size, const QDateTime &modified)
+{
+    {
+        QMutexLocker locker(&s_mutex);
+        if (!s_entries.contains(location))
+            return false;
+
+        const Entry &entry = s_entries[location];
+        if (entry.size == size && entry.modified == modified && QFile::exists(entry.file))
+            return true;
+    }
+
+    // the media was replaced since it was copied
+    qDebug() << "Staging: the copy of" << location << "is outdated";
+    evict(location);
+
+    return false;
+}
+
+bool StagingCache::isRemote(const QString &location)
+{
+#if defined(Q_OS_WIN)
+    QString path = QDir::toNativeSeparators(QFileInfo(location).absoluteFilePath());
+    if (path.startsWith("\\\\"))
+        return true;
+    return GetDriveTypeW((LPCWSTR)path.left(3).utf16()) == DRIVE_REMOTE;
+#elif defined(Q_OS_LINUX)
+    struct statfs info;
+    if (statfs(QFile::encodeName(location).constData(), &info) != 0)
+        return false;
+
+    switch ((unsigned long)info.f_type) {
+    case 0x6969:        // NFS
+    case 0x517B:        // SMB
+    case 0xFF534D42:    // CIFS
+    case 0xFE534D42:    // SMB2
+    case 0x5346414F:    // AFS
+    case 0x00C36400:    // Ceph
+        return true;
+    default:
+        return false;
+    }
+#elif defined(Q_OS_MAC)
+    struct statfs info;
+    if (statfs(QFile::encodeName(location).constData(), &info) != 0)
+        return false;
+
+    const QString type = QString::fromLatin1(info.f_fstypename);
+    return type == "nfs" || type == "smbfs" || type == "afpfs" || type == "webdav";
+#else
+    Q_UNUSED(location);
+    return false;
+#endif
+}
+
+void StagingCache::update()
+{
+    QSettings settings("opp", "opp");
+    if (!settings.value("stagingEnabled").toBool())
+        return;
+
+    // the copies already made are checked against the media by the copy thread
+    foreach (const QString &location, scheduledMedia()) {
+        if (_queue.contains(location) || (_copy != NULL && _copy->source == location))
+            continue;
+
+        _queue << location;
+        _total++;
+    }
+
+    startJobs();
+}
+
+void StagingCache::cancel()
+{
+    _queue.clear();
+    _vlcApp->jobScheduler()->withdraw(this);
+
+    if (_copy != NULL) {
+        disconnect(_copy, SIGNAL(finished()), this, SLOT(copyFinished()));
+        _copy->cancelled.fetchAndStoreOrdered(1);
+        _copy->wait();
+        delete _copy;
+        _copy = NULL;
+        _vlcApp->jobScheduler()->release(this);
+    }
+
+    _done = 0;
+    _total = 0;
+}
+
+void StagingCache::startJobs()
+{
+    if (_copy == NULL && !_queue.isEmpty()) {
+        // the scheduler calls again when a slot is free
+        if (!_vlcApp->jobScheduler()->acquire(this))
+            return;
+
+        _copy = new StagingCopy(this, _queue.takeFirst(), scheduledMedia(),
+                                rate(_vlcApp->jobScheduler()->isThrottled()), _vlcApp->jobScheduler(), this);
+        connect(_copy, SIGNAL(finished()), this, SLOT(copyFinished()));
+        _copy->start(QThread::LowestPriority);
+    }
+
+    if (_copy == NULL && _queue.isEmpty()) {
+        _done = 0;
+        _total = 0;
+    }
+}
+
+void StagingCache::copyFinished()
+{
+    StagingCopy *copy = _copy;
+    _copy = NULL;
+
+    if (copy == NULL)
+        return;
+
+    // nothing was copied, not counted in the progress
+    if (copy->upToDate) {
+        copy->deleteLater();
+        _vlcApp->jobScheduler()->release(this);
+
+        _total--;
+        if (_done > 0 && _done == _total)
+            emit progress(_done, _total);
+
+        startJobs();
+        return;
+    }
+
+    if (copy->succeeded) {
+        Entry entry;
+        entry.file = copy->destination;
+        entry.size = copy->size;
+        entry.modified = copy->modified;
+        entry.used = QDateTime::currentDateTime();
+
+        {
+            QMutexLocker locker(&s_mutex);
+            s_entries.insert(copy->source, entry);
+        }
+
+        saveIndex();
+        emit staged(copy->source);
+    } else {
+        qDebug() << "Staging: can not copy" << copy->source << copy->error;
+    }
+
+    copy->deleteLater();
+    _vlcApp->jobScheduler()->release(this);
+
+    _done++;
+    emit progress(_done, _total);
+
+    startJobs();
+}
+
+void StagingCache::updateRate(int running, int waiting, bool throttled)
+{
+    Q_UNUSED(running);
+    Q_UNUSED(waiting);
+
+    if (_copy != NULL)
+        _copy->rate.fetchAndStoreOrdered(rate(throttled));
+}
+
+QStringList StagingCache::scheduledMedia() const
+{
+    QSettings settings("opp", "opp");
+    QDateTime now = QDateTime::currentDateTime();
+    QDateTime horizon = now.addSecs(settings.value("stagingHorizon").toInt() * 3600);
+
+    QList<Schedule*> schedules = _scheduleListModel->scheduleList();
+    qSort(schedules.begin(), schedules.end(), launchesBefore);
+
+    QStringList locations;
+
+    foreach (Schedule *schedule, schedules) {
+        if (schedule->finishAt() < now || schedule->launchAt() > horizon)
+            continue;
+
+        foreach (Playback *playback, schedule->playlist()->playbackList()) {
+            // the options of an image are added to its libvlc media core
+            if (playback->media()->isImage())
+                continue;
+
+            const QString location = playback->media()->location();
+            if (!locations.contains(location) && isRemote(location))
+                locations << location;
+        }
+    }
+
+    return locations;
+}
+
+bool StagingCache::makeRoom(qint64 size, const QStringList &protectedLocations)
+{
+    QSettings settings("opp", "opp");
+    qint64 capacity = settings.value("stagingSize").toLongLong() * 1024 * 1024 * 1024;
+
+    if (size > capacity)
+        return false;
+
+    forever {
+        qint64 used = 0;
+        QString oldest;
+        QDateTime oldestUse;
+
+        {
+            QMutexLocker locker(&s_mutex);
+            QHash<QString, Entry>::const_iterator it;
+            for (it = s_entries.constBegin(); it != s_entries.constEnd(); ++it) {
+                used += it.value().size;
+                if (!protectedLocations.contains(it.key()) && (oldest.isEmpty() || it.value().used < oldestUse)) {
+                    oldest = it.key();
+                    oldestUse = it.value().used;
+                }
+            }
+        }
+
+        if (used + size <= capacity)
+            return true;
+
+        // every copy left is needed within the horizon
+        if (oldest.isEmpty())
+            return false;
+
+        evict(oldest);
+    }
+}
+
+void StagingCache::evict(const QString &location)
+{
+    Entry entry;
+
+    {
+        QMutexLocker locker(&s_mutex);
+        if (!s_entries.contains(location))
+            return;
+        entry = s_entries.take(location);
+    }
+
+    QFile::remove(entry.file);
+    saveIndex();
+}
+
+void StagingCache::loadIndex()
+{
+    QSettings index(_path + "/index.ini", QSettings::IniFormat);
+    QMutexLocker locker(&s_mutex);
+
+    int count = index.beginReadArray("copies");
+    for (int i = 0; i < count; ++i) {
+        index.setArrayIndex(i);
+
+        Entry entry;
+        entry.file = index.value("file").toString();
+        entry.size = index.value("size").toLongLong();
+        entry.modified = index.value("modified").toDateTime();
+        entry.used = index.value("used").toDateTime();
+
+        if (QFile::exists(entry.file))
+            s_entries.insert(index.value("location").toString(), entry);
+    }
+    index.endArray();
+}
+
+void StagingCache::saveIndex()
+{
+    QSettings index(_path + "/index.ini", QSettings::IniFormat);
+    QMutexLocker locker(&s_mutex);
+
+    index.remove("copies");
+    index.beginWriteArray("copies", s_entries.count());
+
+    int i = 0;
+    QHash<QString, Entry>::const_iterator it;
+    for (it = s_entries.constBegin(); it != s_entries.constEnd(); ++it) {
+        index.setArrayIndex(i++);
+        index.setValue("location", it.key());
+        index.setValue("file", it.value().file);
+        index.setValue("size", it.value().size);
+        index.setValue("modified", it.value().modified);
+        index.setValue("used", it.value().used);
+    }
+    index.endArray();
+}
+
+int StagingCache::rate(bool throttled) const
+{
+    QSettings settings("opp", "opp");
+    qint64 rate = settings.value("stagingRate").toLongLong() * 1024 * 1024;
+
+    // the projection reads first
+    if (throttled)
+        rate = rate > 0 ? qMin(rate, (qint64)JobScheduler::PLAYING_READ_RATE) : JobScheduler::PLAYING_READ_RATE;
+
+    // faster than the copy counts, no limit
+    if (rate > INT_MAX)
+        rate = 0;
+
+    return (int)rate;
+}
@@ -0,0 +1,231 @@
+/**********************************************************************************
+ * This file is part of Open Projection Program (OPP).
+ *
+ * Copyright (C) 2013 Catalogue Ouvert du Cinéma <dev@cinemaouvert.fr>
+ *
+ * Authors: Jerome Blanchi <d.j.a.y@free.fr>
+ *
+ * Open Projection Program is an initiative of Catalogue Ouvert du Cinéma.
+ * The software was developed by four students of University of Poitiers
+ * as school project.
+ *
+ * Open Projection Program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Open Projection Program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Open Projection Program. If not, see <http://www.gnu.org/licenses/>.
+ **********************************************************************************/
+
+#ifndef STAGINGCACHE_H
+#define STAGINGCACHE_H
+
+#include <QObject>
+#include <QDateTime>
+#include <QHash>
+#include <QMutex>
+#include <QStringList>
+
+class QTimer;
+class StagingCopy;
+class ScheduleListModel;
+class VLCApplication;
+
+/**
+ * @brief Copy the media stored on network shares to a local disk before the shows
+ *
+ * The media of the playlists scheduled within the horizon are copied in
+ * background, one at a time, by FileCopy with a bandwidth limit, then
+ * compared with the original on sampled blocks. The player opens the local
+ * copy instead of the network file (stagedFile). The network files are only
+ * read by the copy thread, which also checks the copies already made against
+ * their media at each update.
+ * When the cache is full, the copies least recently played and not needed
+ * within the horizon are removed first.
+ *
+ * Settings: stagingEnabled, stagingPath, stagingSize (GB), stagingRate
+ * (MB/s, 0 for no limit) and stagingHorizon (hours).
+ */
+class StagingCache : public QObject
+{
+    Q_OBJECT
+    friend class StagingCopy;
+public:
+    explicit StagingCache(VLCApplication *vlcApp, ScheduleListModel *scheduleListModel, QObject *parent = 0);
+    ~StagingCache();
+
+    /**
+     * @brief Get the local copy of a media from the index, and mark it as used
+     * @param location The media location
+     * @return The copy, empty if the media is not staged
+     */
+    static QString stagedFile(const QString &location);
+
+    /**
+     * @brief Allow to know if a file is on a network share
+     * @param location The file location
+     * @return True if on a network file system, false otherwise
+     */
+    static bool isRemote(const QString &location);
+
+    /**
+     * @brief CHECK_INTERVAL Period of the check of the schedules (ms)
+     */
+    static const int CHECK_INTERVAL = 60000;
+
+    /**
+     * @brief VERIFY_SAMPLES Blocks compared between the media and its copy
+     */
+    static const int VERIFY_SAMPLES = 16;
+
+    /**
+     * @brief VERIFY_BLOCK Size of a compared block
+     */
+    static const int VERIFY_BLOCK = 64 * 1024;
+
+public slots:
+    /**
+     * @brief Copy the media scheduled within the horizon
+     */
+    void update();
+
+    /**
+     * @brief Stop the running copy and clear the queue
+     */
+    void cancel();
+
+signals:
+    /**
+     * @brief Emitted when a media is copied and verified
+     * @param location The media location
+     */
+    void staged(const QString &location);
+
+    /**
+     * @brief Emitted each time a media is done
+     * @param done The number of media done since the queue was empty
+     * @param total The number of media queued since the queue was empty
+     */
+    void progress(int done, int total);
+
+private slots:
+    /**
+     * @brief Start the next copy when the scheduler gives a slot
+     */
+    void startJobs();
+
+    /**
+     * @brief Store or drop the copy which just ended
+     */
+    void copyFinished();
+
+    /**
+     * @brief Slow the copy down during the projection
+     */
+    void updateRate(int running, int waiting, bool throttled);
+
+private:
+    /**
+     * @brief A local copy
+     */
+    struct Entry {
+        QString file;
+        qint64 size;
+        QDateTime modified;
+        QDateTime used;
+    };
+
+    /**
+     * @brief Get the media scheduled within the horizon, in the order of the shows
+     */
+    QStringList scheduledMedia() const;
+
+    /**
+     * @brief Remove the least recently used copies not protected until a size is free
+     * @param size The size needed
+     * @param protectedLocations The media needed within the horizon
+     * @return True if the size is free, false otherwise
+     */
+    bool makeRoom(qint64 size, const QStringList &protectedLocations);
+
+    /**
+     * @brief Keep the copy of a media if it is up to date, remove it otherwise
+     * @param location The media location
+     * @param size The size of the media
+     * @param modified The date of the media
+     * @return True if the copy is up to date, false if there is none anymore
+     */
+    bool checkCopy(const QString &location, qint64 size, const QDateTime &modified);
+
+    /**
+     * @brief Remove the copy of a media
+     */
+    void evict(const QString &location);
+
+    /**
+     * @brief Read the index of the copies from the cache directory
+     */
+    void loadIndex();
+
+    /**
+     * @brief Write the index of the copies into the cache directory
+     */
+    void saveIndex();
+
+    /**
+     * @brief Get the copy rate allowed now (bytes per second, 0 for no limit)
+     */
+    int rate(bool throttled) const;
+
+    VLCApplication *_vlcApp;
+
+    ScheduleListModel *_scheduleListModel;
+
+    /**
+     * @brief _path The cache directory
+     */
+    QString _path;
+
+    /**
+     * @brief _queue The media waiting to be copied
+     */
+    QStringList _queue;
+
+    /**
+     * @brief _copy The running copy, NULL if none
+     */
+    StagingCopy *_copy;
+
+    /**
+     * @brief _timer Check the schedules periodically
+     */
+    QTimer *_timer;
+
+    /**
+     * @brief _done The number of media done since the queue was empty
+     */
+    int _done;
+
+    /**
+     * @brief _total The number of media queued since the queue was empty
+     */
+    int _total;
+
+    /**
+     * @brief s_entries The local copies, by media location
+     */
+    static QHash<QString, Entry> s_entries;
+
+    /**
+     * @brief s_mutex Protect s_entries
+     */
+    static QMutex s_mutex;
+};
+
+#endif // STAGINGCACHE_H
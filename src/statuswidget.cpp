@@ -62,6 +62,20 @@ void StatusWidget::setMediaCount(int count)
     );
 }
 
+void StatusWidget::setBackgroundJobs(int running, int waiting, bool throttled)
+{
+    if (running == 0 && waiting == 0) {
+        ui->backgroundJobsLabel->clear();
+        return;
+    }
+
+    QString text = QString("%1 %2").arg(running).arg(tr("background jobs"));
+    if (throttled)
+        text += " " + tr("(slowed down during the projection)");
+
+    ui->backgroundJobsLabel->setText(text);
+}
+
 void StatusWidget::timerEvent(QTimerEvent *event)
 {
     Q_UNUSED(event);
@@ -51,6 +51,14 @@ public slots:
      */
     void setMediaCount(int count);
 
+    /**
+     * @brief Show the activity of the background jobs
+     * @param running The number of running jobs
+     * @param waiting The number of workers waiting for a slot
+     * @param throttled True if the jobs are slowed down by the projection
+     */
+    void setBackgroundJobs(int running, int waiting, bool throttled);
+
     /**
      * @brief lockButton
      */
@@ -0,0 +1,721 @@
+/**********************************************************************************
+ * This file is part of Open Projection Program (OPP).
+ *
+ * Copyright (C) 2013 Catalogue Ouvert du Cinéma <dev@cinemaouvert.fr>
+ *
+ * Authors: Jerome Blanchi <d.j.a.y@free.fr>
+ *
+ * Open Projection Program is an initiative of Catalogue Ouvert du Cinéma.
+ * The software was developed by four students of University of Poitiers
+ * as school project.
+ *
+ * Open Projection Program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Open Projection Program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Open Projection Program. If not, see <http://www.gnu.org/licenses/>.
+ **********************************************************************************/
+
+#include "thumbnailstore.h"
+
+#include <string.h>
+
+#include <QBuffer>
+#include <QCoreApplication>
+#include <QDataStream>
+#include <QDebug>
+#include <QDir>
+#include <QFile>
+#include <QFileInfo>
+#include <QMutexLocker>
+#include <QRunnable>
+#include <QSet>
+#include <QThreadPool>
+
+#if defined(Q_OS_WIN)
+# include <windows.h>
+#else
+# include <stdio.h>
+#endif
+
+#include "fingerprint.h"
+
+QFile *ThumbnailStore::s_pack = NULL;
+uchar *ThumbnailStore::s_map = NULL;
+quint64 ThumbnailStore::s_size = 0;
+bool ThumbnailStore::s_opened = false;
+QHash<QString, QList<ThumbnailStore::Entry> > ThumbnailStore::s_entries;
+QHash<QString, QString> ThumbnailStore::s_locations;
+QHash<QString, ThumbnailStore::FileKey> ThumbnailStore::s_keys;
+int ThumbnailStore::s_newKeys = 0;
+quint64 ThumbnailStore::s_dead = 0;
+QMutex ThumbnailStore::s_mutex;
+
+static const quint32 RECORD_MAGIC = 0x4f505054; // OPPT
+static const quint32 INDEX_MAGIC = 0x4f505049;  // OPPI
+static const quint32 INDEX_VERSION = 2;
+
+/**
+ * @brief The screenshot file of the older versions, named after the location
+ */
+static QString legacyFile(const QString &location)
+{
+    QString path = QCoreApplication::applicationDirPath() + "/screenshot/";
+    path = path.replace("/", QDir::separator());
+
+    QString name = location;
+    path += name.replace(QDir::separator(), "_").remove(":");
+
+    return path + ".png";
+}
+
+/**
+ * @brief Run ThumbnailStore::collect in a thread of the pool
+ */
+class ThumbnailCollect : public QRunnable
+{
+public:
+    ThumbnailCollect(const QStringList &locations) : locations(locations) {}
+
+    void run() { ThumbnailStore::collect(locations); }
+
+    QStringList locations;
+};
+
+QImage ThumbnailStore::thumbnail(const QString &location, int width)
+{
+    const QString key = resolve(location);
+    if (key.isEmpty())
+        return QImage();
+
+    QMutexLocker locker(&s_mutex);
+
+    const Entry *entry = ThumbnailStore::entry(key, width);
+
+    return entry != NULL ? image(*entry) : QImage();
+}
+
+bool ThumbnailStore::contains(const QString &location)
+{
+    const QString key = resolve(location);
+    if (key.isEmpty())
+        return false;
+
+    QMutexLocker locker(&s_mutex);
+
+    return s_entries.contains(key);
+}
+
+bool ThumbnailStore::store(const QString &location, const QImage &image, const QString &key)
+{
+    if (image.isNull())
+        return false;
+
+    const QString fileKey = key.isEmpty() ? ThumbnailStore::key(location) : key;
+    if (fileKey.isEmpty()) {
+        qDebug() << "Thumbnail: can not read" << location;
+        return false;
+    }
+
+    // scaled before locking, from the largest to the smallest
+    QList<QImage> images;
+    QImage scaled = image.width() > LARGE_WIDTH ? image.scaledToWidth(LARGE_WIDTH, Qt::SmoothTransformation) : image;
+    images << scaled;
+    if (scaled.width() > MEDIUM_WIDTH)
+        images << scaled.scaledToWidth(MEDIUM_WIDTH, Qt::SmoothTransformation);
+    if (scaled.width() > SMALL_WIDTH)
+        images << scaled.scaledToWidth(SMALL_WIDTH, Qt::SmoothTransformation);
+
+    QMutexLocker locker(&s_mutex);
+
+    if (!open())
+        return false;
+
+    // the sizes of the previous screenshot may differ, all are dropped
+    if (s_entries.contains(fileKey) && !append(fileKey, location, QImage(), RemovedFormat))
+        return false;
+
+    bool succeeded = true;
+    foreach (const QImage &size, images)
+        succeeded = append(fileKey, location, size, size.width() <= SMALL_WIDTH ? RawFormat : JpegFormat) && succeeded;
+
+    QFile::remove(directory() + "/export/" + fileKey + ".jpg");
+    s_locations.insert(location, fileKey);
+    remap();
+    writeIndex();
+
+    return succeeded;
+}
+
+void ThumbnailStore::remove(const QString &location)
+{
+    QFile::remove(legacyFile(location));
+
+    const QString key = ThumbnailStore::key(location);
+    if (key.isEmpty())
+        return;
+
+    QMutexLocker locker(&s_mutex);
+
+    if (!open() || !s_entries.contains(key))
+        return;
+
+    append(key, location, QImage(), RemovedFormat);
+    QFile::remove(directory() + "/export/" + key + ".jpg");
+    remap();
+    writeIndex();
+}
+
+QString ThumbnailStore::exportFile(const QString &location)
+{
+    const QString key = resolve(location);
+    if (key.isEmpty())
+        return QString();
+
+    QMutexLocker locker(&s_mutex);
+
+    const Entry *entry = ThumbnailStore::entry(key, LARGE_WIDTH);
+    if (entry == NULL)
+        return QString();
+
+    const QString file = directory() + "/export/" + key + ".jpg";
+    if (QFile::exists(file))
+        return file;
+
+    QDir().mkpath(directory() + "/export");
+
+    if (entry->format == JpegFormat) {
+        // the record is already a JPEG file
+        QFile output(file);
+        if (output.open(QIODevice::WriteOnly)
+                && output.write((const char *)s_map + entry->offset, entry->length) == (qint64)entry->length)
+            return file;
+
+        output.remove();
+    } else if (image(*entry).save(file, "JPG", JPEG_QUALITY)) {
+        return file;
+    }
+
+    qDebug() << "Thumbnail: can not write" << file;
+
+    return QString();
+}
+
+QString ThumbnailStore::key(const QString &location)
+{
+    QFileInfo info(location);
+
+    if (info.exists()) {
+        {
+            QMutexLocker locker(&s_mutex);
+            // the keys of the previous runs are read with the index
+            open();
+            if (s_keys.contains(location)) {
+                const FileKey &fileKey = s_keys[location];
+                if (fileKey.size == info.size() && fileKey.modified == info.lastModified())
+                    return fileKey.key;
+            }
+        }
+
+        // a few hundred KB read, without holding the store
+        const QString fingerprint = Fingerprint::compute(location);
+
+        if (!fingerprint.isEmpty()) {
+            FileKey fileKey;
+            fileKey.size = info.size();
+            fileKey.modified = info.lastModified();
+            fileKey.key = fingerprint;
+
+            QMutexLocker locker(&s_mutex);
+            s_keys.insert(location, fileKey);
+
+            // written by batches, the keys lost by a crash are only computed again
+            if (++s_newKeys >= KEYS_PER_WRITE && s_pack != NULL)
+                writeIndex();
+
+            return fingerprint;
+        }
+    }
+
+    // offline, the last thumbnail stored for this location
+    QMutexLocker locker(&s_mutex);
+    open();
+
+    return s_locations.value(location);
+}
+
+void ThumbnailStore::collect(const QStringList &locations)
+{
+    QSet<QString> kept;
+    foreach (const QString &location, locations)
+        kept << key(location);
+
+    // the last location of each key, read without holding the store
+    QHash<QString, QString> lastLocations;
+    {
+        QMutexLocker locker(&s_mutex);
+        if (!open())
+            return;
+
+        QHash<QString, QList<Entry> >::const_iterator it;
+        for (it = s_entries.constBegin(); it != s_entries.constEnd(); ++it)
+            lastLocations.insert(it.key(), it.value().last().location);
+    }
+
+    QSet<QString> orphans;
+    QHash<QString, QString>::const_iterator it;
+    for (it = lastLocations.constBegin(); it != lastLocations.constEnd(); ++it) {
+        if (kept.contains(it.key()))
+            continue;
+
+        QFileInfo info(it.value());
+        // an unmounted disk removes the directory too, its media are kept
+        if (info.exists() ? key(it.value()) != it.key() : info.absoluteDir().exists())
+            orphans << it.key();
+    }
+
+    QMutexLocker locker(&s_mutex);
+
+    // the exported files are only needed while a document is written
+    QDir exported(directory() + "/export");
+    foreach (const QString &name, exported.entryList(QDir::Files))
+        exported.remove(name);
+
+    // the keys of the files deleted from their disk
+    QHash<QString, FileKey>::iterator keyIt = s_keys.begin();
+    while (keyIt != s_keys.end()) {
+        QFileInfo info(keyIt.key());
+        if (!info.exists() && info.absoluteDir().exists()) {
+            keyIt = s_keys.erase(keyIt);
+            s_newKeys++;
+        } else {
+            ++keyIt;
+        }
+    }
+
+    if (orphans.isEmpty() && s_dead == 0) {
+        if (s_newKeys > 0)
+            writeIndex();
+        return;
+    }
+
+    // the live records are copied into a new pack
+    QFile compacted(directory() + "/thumbnails.pack.tmp");
+    if (!compacted.open(QIODevice::ReadWrite | QIODevice::Truncate)) {
+        qDebug() << "Thumbnail: can not write" << compacted.fileName();
+        return;
+    }
+
+    QHash<QString, QList<Entry> > entries;
+    QHash<QString, QList<Entry> >::const_iterator entryIt;
+    for (entryIt = s_entries.constBegin(); entryIt != s_entries.constEnd(); ++entryIt) {
+        if (orphans.contains(entryIt.key()))
+            continue;
+
+        foreach (Entry entry, entryIt.value()) {
+            QByteArray data = QByteArray::fromRawData((const char *)s_map + entry.offset, entry.length);
+            if (!write(&compacted, entryIt.key(), data, &entry)) {
+                qDebug() << "Thumbnail: can not write" << compacted.fileName();
+                compacted.remove();
+                return;
+            }
+            entries[entryIt.key()] << entry;
+        }
+    }
+    compacted.close();
+
+    // the pack is replaced at once, a crash leaves the old or the new one
+    close();
+    const QString packFile = directory() + "/thumbnails.pack";
+    if (!replace(compacted.fileName(), packFile)) {
+        compacted.remove();
+        qDebug() << "Thumbnail: can not replace" << packFile;
+        s_opened = false;
+        open();
+        return;
+    }
+
+    s_pack = new QFile(packFile);
+    if (!s_pack->open(QIODevice::ReadWrite) || !remap()) {
+        qDebug() << "Thumbnail: can not open" << packFile;
+        close();
+        return;
+    }
+
+    s_entries = entries;
+    s_dead = 0;
+
+    QHash<QString, QString>::iterator locationIt = s_locations.begin();
+    while (locationIt != s_locations.end()) {
+        if (orphans.contains(locationIt.value()))
+            locationIt = s_locations.erase(locationIt);
+        else
+            ++locationIt;
+    }
+
+    writeIndex();
+}
+
+void ThumbnailStore::collectInBackground(const QStringList &locations)
+{
+    QThreadPool::globalInstance()->start(new ThumbnailCollect(locations));
+}
+
+/***********************************************************************\
+                                  PACK
+\***********************************************************************/
+
+QString ThumbnailStore::directory()
+{
+    return QCoreApplication::applicationDirPath() + "/thumbnails";
+}
+
+bool ThumbnailStore::open()
+{
+    if (s_opened)
+        return s_pack != NULL;
+
+    s_opened = true;
+
+    if (!QDir().mkpath(directory())) {
+        qDebug() << "Thumbnail: can not create" << directory();
+        return false;
+    }
+
+    s_pack = new QFile(directory() + "/thumbnails.pack");
+    if (!s_pack->open(QIODevice::ReadWrite) || !remap()) {
+        qDebug() << "Thumbnail: can not open" << s_pack->fileName();
+        close();
+        return false;
+    }
+
+    s_entries.clear();
+    s_locations.clear();
+    s_dead = 0;
+
+    // the index covers the pack up to its size
+    quint64 indexed = 0;
+    QFile indexFile(directory() + "/thumbnails.index");
+    if (indexFile.open(QIODevice::ReadOnly)) {
+        QDataStream in(&indexFile);
+        in.setVersion(QDataStream::Qt_4_6);
+
+        quint32 magic, version, count;
+        quint64 size, dead;
+        in >> magic >> version >> size >> dead >> count;
+
+        // the index of the first version has no keys
+        if (in.status() == QDataStream::Ok && magic == INDEX_MAGIC && version <= INDEX_VERSION && size <= s_size) {
+            for (quint32 i = 0; i < count && in.status() == QDataStream::Ok; i++) {
+                QString key;
+                Entry entry;
+                in >> key >> entry.location >> entry.width >> entry.height >> entry.format >> entry.offset >> entry.length;
+                s_entries[key] << entry;
+            }
+            in >> s_locations;
+
+            quint32 keyCount = 0;
+            if (version >= 2)
+                in >> keyCount;
+            for (quint32 i = 0; i < keyCount && in.status() == QDataStream::Ok; i++) {
+                QString location;
+                FileKey fileKey;
+                in >> location >> fileKey.size >> fileKey.modified >> fileKey.key;
+                // computed by this run, newer
+                if (!s_keys.contains(location))
+                    s_keys.insert(location, fileKey);
+            }
+
+            if (in.status() == QDataStream::Ok) {
+                indexed = size;
+                s_dead = dead;
+            } else {
+                s_entries.clear();
+                s_locations.clear();
+            }
+        }
+    }
+
+    if (indexed < s_size) {
+        scan(indexed);
+        writeIndex();
+    }
+
+    return true;
+}
+
+void ThumbnailStore::close()
+{
+    if (s_pack != NULL) {
+        if (s_map != NULL)
+            s_pack->unmap(s_map);
+        delete s_pack;
+    }
+
+    s_pack = NULL;
+    s_map = NULL;
+    s_size = 0;
+}
+
+void ThumbnailStore::scan(quint64 offset)
+{
+    quint64 end = offset;
+
+    while (end < s_size) {
+        QByteArray bytes = QByteArray::fromRawData((const char *)s_map + end, s_size - end);
+        QBuffer buffer(&bytes);
+        buffer.open(QIODevice::ReadOnly);
+        QDataStream in(&buffer);
+        in.setVersion(QDataStream::Qt_4_6);
+
+        quint32 magic;
+        QString key;
+        Entry entry;
+        in >> magic >> key >> entry.location >> entry.width >> entry.height >> entry.format >> entry.length;
+
+        if (in.status() != QDataStream::Ok || magic != RECORD_MAGIC
+                || (quint64)buffer.pos() + entry.length > s_size - end)
+            break;
+
+        entry.offset = end + buffer.pos();
+        insert(key, entry);
+        end = entry.offset + entry.length;
+    }
+
+    // a record cut by a crash, the next one is written over it
+    if (end < s_size) {
+        qDebug() << "Thumbnail: pack truncated at" << end;
+        s_pack->unmap(s_map);
+        s_map = NULL;
+        s_pack->resize(end);
+        remap();
+    }
+}
+
+void ThumbnailStore::insert(const QString &key, const Entry &entry)
+{
+    QList<Entry> &entries = s_entries[key];
+
+    if (entry.format == RemovedFormat) {
+        foreach (const Entry &removed, entries)
+            s_dead += removed.length;
+        s_entries.remove(key);
+
+        QHash<QString, QString>::iterator it = s_locations.begin();
+        while (it != s_locations.end()) {
+            if (it.value() == key)
+                it = s_locations.erase(it);
+            else
+                ++it;
+        }
+        return;
+    }
+
+    for (int i = 0; i < entries.count(); i++) {
+        if (entries.at(i).width == entry.width) {
+            s_dead += entries.at(i).length;
+            entries.removeAt(i);
+            break;
+        }
+    }
+
+    entries << entry;
+    s_locations.insert(entry.location, key);
+}
+
+bool ThumbnailStore::write(QFile *file, const QString &key, const QByteArray &data, Entry *entry)
+{
+    QByteArray header;
+    QDataStream out(&header, QIODevice::WriteOnly);
+    out.setVersion(QDataStream::Qt_4_6);
+    out << RECORD_MAGIC << key << entry->location << entry->width << entry->height << entry->format
+        << (quint32)data.size();
+
+    const qint64 offset = file->size();
+    if (!file->seek(offset) || file->write(header) != header.size() || file->write(data) != data.size()) {
+        // nothing half written stays in the pack
+        file->resize(offset);
+        return false;
+    }
+
+    entry->offset = offset + header.size();
+    entry->length = data.size();
+
+    return true;
+}
+
+bool ThumbnailStore::append(const QString &key, const QString &location, const QImage &image, Format format)
+{
+    QByteArray data;
+    Entry entry;
+    entry.location = location;
+    entry.width = image.width();
+    entry.height = image.height();
+    entry.format = format;
+
+    if (format == RawFormat) {
+        // tightly packed lines, read back without decoding
+        QImage rgb = image.convertToFormat(QImage::Format_RGB888);
+        const int lineSize = rgb.width() * 3;
+        data.resize(lineSize * rgb.height());
+        for (int y = 0; y < rgb.height(); y++)
+            memcpy(data.data() + y * lineSize, rgb.constScanLine(y), lineSize);
+    } else if (format == JpegFormat) {
+        QBuffer buffer(&data);
+        buffer.open(QIODevice::WriteOnly);
+        if (!image.save(&buffer, "JPG", JPEG_QUALITY)) {
+            qDebug() << "Thumbnail: can not encode the thumbnail of" << location;
+            return false;
+        }
+    }
+
+    if (!write(s_pack, key, data, &entry)) {
+        qDebug() << "Thumbnail: can not write" << s_pack->fileName();
+        return false;
+    }
+
+    insert(key, entry);
+
+    return true;
+}
+
+bool ThumbnailStore::remap()
+{
+    if (s_map != NULL)
+        s_pack->unmap(s_map);
+
+    s_size = s_pack->size();
+    s_map = s_size > 0 ? s_pack->map(0, s_size) : NULL;
+
+    return s_size == 0 || s_map != NULL;
+}
+
+void ThumbnailStore::writeIndex()
+{
+    const QString indexFile = directory() + "/thumbnails.index";
+
+    QFile file(indexFile + ".tmp");
+    if (!file.open(QIODevice::WriteOnly | QIODevice::Truncate)) {
+        qDebug() << "Thumbnail: can not write" << file.fileName();
+        return;
+    }
+
+    quint32 count = 0;
+    foreach (const QList<Entry> &entries, s_entries)
+        count += entries.count();
+
+    QDataStream out(&file);
+    out.setVersion(QDataStream::Qt_4_6);
+    out << INDEX_MAGIC << INDEX_VERSION << s_size << s_dead << count;
+
+    QHash<QString, QList<Entry> >::const_iterator it;
+    for (it = s_entries.constBegin(); it != s_entries.constEnd(); ++it)
+        foreach (const Entry &entry, it.value())
+            out << it.key() << entry.location << entry.width << entry.height << entry.format << entry.offset << entry.length;
+
+    out << s_locations;
+
+    out << (quint32)s_keys.count();
+    QHash<QString, FileKey>::const_iterator keyIt;
+    for (keyIt = s_keys.constBegin(); keyIt != s_keys.constEnd(); ++keyIt)
+        out << keyIt.key() << keyIt.value().size << keyIt.value().modified << keyIt.value().key;
+    file.close();
+
+    // the records after the index are read again from the pack on failure
+    if (!replace(file.fileName(), indexFile)) {
+        qDebug() << "Thumbnail: can not write" << indexFile;
+        return;
+    }
+
+    s_newKeys = 0;
+}
+
+bool ThumbnailStore::replace(const QString &source, const QString &destination)
+{
+#if defined(Q_OS_WIN)
+    return MoveFileExW((LPCWSTR)QDir::toNativeSeparators(source).utf16(),
+                       (LPCWSTR)QDir::toNativeSeparators(destination).utf16(),
+                       MOVEFILE_REPLACE_EXISTING | MOVEFILE_WRITE_THROUGH) != 0;
+#else
+    return ::rename(QFile::encodeName(source).constData(), QFile::encodeName(destination).constData()) == 0;
+#endif
+}
+
+QImage ThumbnailStore::image(const Entry &entry)
+{
+    if (s_map == NULL || entry.offset + entry.length > s_size)
+        return QImage();
+
+    const uchar *data = s_map + entry.offset;
+
+    if (entry.format == RawFormat) {
+        if (entry.length != (quint32)entry.width * entry.height * 3)
+            return QImage();
+
+        // the mapping moves when the pack grows, the pixels are copied
+        return QImage(data, entry.width, entry.height, entry.width * 3, QImage::Format_RGB888).copy();
+    }
+
+    return QImage::fromData(data, entry.length, "JPG");
+}
+
+const ThumbnailStore::Entry *ThumbnailStore::entry(const QString &key, int width)
+{
+    if (!open() || !s_entries.contains(key))
+        return NULL;
+
+    const QList<Entry> &entries = s_entries[key];
+    const Entry *best = NULL;
+
+    // the smallest as large as asked, the largest otherwise
+    for (int i = 0; i < entries.count(); i++) {
+        const Entry &entry = entries.at(i);
+        if (best == NULL)
+            best = &entry;
+        else if (entry.width >= width ? best->width < width || entry.width < best->width
+                                      : best->width < width && entry.width > best->width)
+            best = &entry;
+    }
+
+    return best;
+}
+
+QString ThumbnailStore::resolve(const QString &location)
+{
+    const QString key = ThumbnailStore::key(location);
+    if (key.isEmpty())
+        return QString();
+
+    bool stored;
+    {
+        QMutexLocker locker(&s_mutex);
+        stored = open() && s_entries.contains(key);
+    }
+
+    if (!stored)
+        importLegacy(location, key);
+
+    return key;
+}
+
+bool ThumbnailStore::importLegacy(const QString &location, const QString &key)
+{
+    const QString file = legacyFile(location);
+    if (!QFile::exists(file))
+        return false;
+
+    QImage image(file);
+    if (image.isNull() || !store(location, image, key))
+        return false;
+
+    QFile::remove(file);
+
+    return true;
+}
@@ -0,0 +1,308 @@
+/**********************************************************************************
+ * This file is part of Open Projection Program (OPP).
+ *
+ * Copyright (C) 2013 Catalogue Ouvert du Cinéma <dev@cinemaouvert.fr>
+ *
+ * Authors: Jerome Blanchi <d.j.a.y@free.fr>
+ *
+ * Open Projection Program is an initiative of Catalogue Ouvert du Cinéma.
+ * The software was developed by four students of University of Poitiers
+ * as school project.
+ *
+ * Open Projection Program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Open Projection Program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Open Projection Program. If not, see <http://www.gnu.org/licenses/>.
+ **********************************************************************************/
+
+#ifndef THUMBNAILSTORE_H
+#define THUMBNAILSTORE_H
+
+#include <QByteArray>
+#include <QDateTime>
+#include <QHash>
+#include <QImage>
+#include <QList>
+#include <QMutex>
+#include <QString>
+#include <QStringList>
+
+/**
+ * @brief Store of the screenshots of the media, packed in one mapped file
+ *
+ * The thumbnails are addressed by the fingerprint of the content of their
+ * media, so a moved file keeps its thumbnail and two copies share it. Each
+ * media has its screenshot prescaled to SMALL_WIDTH, MEDIUM_WIDTH and
+ * LARGE_WIDTH: the small one is stored as raw RGB pixels, copied from the
+ * mapping without decoding, the larger ones as JPEG.
+ *
+ * The records are appended to a pack file which is mapped in memory, a
+ * removal appends a tombstone. An index of the records is written beside
+ * it, the records appended after the index was written (after a crash)
+ * are read again from the pack. The index also keeps the key of each
+ * location with the size and the date of its file, so a file unchanged is
+ * not read again at the next start. collect drops the replaced records and the
+ * thumbnails of the media deleted from their disk, by rewriting the pack.
+ *
+ * The screenshots of the older versions, one PNG per media in screenshot/,
+ * are moved into the store when first read.
+ */
+class QFile;
+
+class ThumbnailStore
+{
+public:
+    /**
+     * @brief Get the thumbnail of a media file
+     * @param location The media location
+     * @param width The wanted width, the smallest thumbnail as large is returned
+     * @return The thumbnail, null if the media has none
+     */
+    static QImage thumbnail(const QString &location, int width = LARGE_WIDTH);
+
+    /**
+     * @brief Allow to know if a media file has a thumbnail
+     */
+    static bool contains(const QString &location);
+
+    /**
+     * @brief Store the screenshot of a media file, replacing the previous one
+     * @param location The media location
+     * @param image The screenshot, scaled to each width not larger than it
+     * @param key The fingerprint of the media, computed from the file if empty
+     * @return True on success, false otherwise
+     */
+    static bool store(const QString &location, const QImage &image, const QString &key = QString());
+
+    /**
+     * @brief Remove the thumbnail of a media file
+     */
+    static void remove(const QString &location);
+
+    /**
+     * @brief Write the largest thumbnail of a media file into a JPEG file
+     *
+     * For the documents which refer to images by file name (schedule export,
+     * show packages). The files are written into the export directory of the
+     * store, which is emptied by collect.
+     *
+     * @param location The media location
+     * @return The file name, empty if the media has no thumbnail
+     */
+    static QString exportFile(const QString &location);
+
+    /**
+     * @brief Get the key of the thumbnails of a media file
+     * @param location The media location
+     * @return The fingerprint of the file, or the last one stored for this
+     * location if the file can not be read, empty if none
+     */
+    static QString key(const QString &location);
+
+    /**
+     * @brief Drop the replaced records and the orphan thumbnails, in the calling thread
+     *
+     * A thumbnail is orphan when the file of its last location is gone while
+     * its directory is still there, or holds another content. The media
+     * given are kept whatever their location.
+     *
+     * @param locations The locations of the media to keep
+     */
+    static void collect(const QStringList &locations);
+
+    /**
+     * @brief Start collect in the global thread pool
+     */
+    static void collectInBackground(const QStringList &locations);
+
+    /**
+     * @brief SMALL_WIDTH Width of the thumbnails stored raw
+     */
+    static const int SMALL_WIDTH = 160;
+
+    /**
+     * @brief MEDIUM_WIDTH Width of the medium thumbnails
+     */
+    static const int MEDIUM_WIDTH = 320;
+
+    /**
+     * @brief LARGE_WIDTH Width of the largest thumbnails
+     */
+    static const int LARGE_WIDTH = 640;
+
+    /**
+     * @brief JPEG_QUALITY Quality of the thumbnails stored as JPEG
+     */
+    static const int JPEG_QUALITY = 85;
+
+private:
+    /**
+     * @brief Encoding of a record
+     */
+    enum Format {
+        RawFormat = 0,
+        JpegFormat = 1,
+        RemovedFormat = 2
+    };
+
+    /**
+     * @brief Thumbnail of one size in the pack
+     */
+    struct Entry {
+        QString location;
+        quint16 width;
+        quint16 height;
+        quint8 format;
+        quint64 offset;
+        quint32 length;
+    };
+
+    /**
+     * @brief Key of a file, valid while its size and date do not change
+     */
+    struct FileKey {
+        qint64 size;
+        QDateTime modified;
+        QString key;
+    };
+
+    /**
+     * @brief Open the pack and read the index, called with s_mutex locked
+     * @return True if the pack is usable, false otherwise
+     */
+    static bool open();
+
+    /**
+     * @brief Close the pack, called with s_mutex locked
+     */
+    static void close();
+
+    /**
+     * @brief Read the records of the pack from an offset, truncate a record cut by a crash
+     * @param offset The offset of the first record
+     */
+    static void scan(quint64 offset);
+
+    /**
+     * @brief Add a record to the in memory index
+     */
+    static void insert(const QString &key, const Entry &entry);
+
+    /**
+     * @brief Write a record at the end of a file
+     * @param file The file, its size is the offset of the record
+     * @param data The encoded image, empty for a tombstone
+     * @param entry The description of the record, its offset is set
+     * @return True on success, false otherwise
+     */
+    static bool write(QFile *file, const QString &key, const QByteArray &data, Entry *entry);
+
+    /**
+     * @brief Append a record to the pack, called with s_mutex locked
+     * @return True on success, false otherwise
+     */
+    static bool append(const QString &key, const QString &location, const QImage &image, Format format);
+
+    /**
+     * @brief Map the whole pack again after it grew
+     */
+    static bool remap();
+
+    /**
+     * @brief Write the index of the pack, replacing the previous one
+     */
+    static void writeIndex();
+
+    /**
+     * @brief Decode the image of a record
+     */
+    static QImage image(const Entry &entry);
+
+    /**
+     * @brief Choose the thumbnail of a key for a width, called with s_mutex locked
+     * @return The entry, NULL if none
+     */
+    static const Entry *entry(const QString &key, int width);
+
+    /**
+     * @brief Get the key of a media file, moving its PNG screenshot of an older version into the store
+     * @return The key, empty if none
+     */
+    static QString resolve(const QString &location);
+
+    /**
+     * @brief Move the PNG screenshot of an older version into the store
+     * @return True if there was one, false otherwise
+     */
+    static bool importLegacy(const QString &location, const QString &key);
+
+    /**
+     * @brief Get the directory of the store
+     */
+    static QString directory();
+
+    /**
+     * @brief s_pack The pack file, open for reading and appending, NULL if not open
+     */
+    static QFile *s_pack;
+
+    /**
+     * @brief s_map The mapping of the whole pack, NULL if not mapped
+     */
+    static uchar *s_map;
+
+    /**
+     * @brief s_size The size of the pack
+     */
+    static quint64 s_size;
+
+    /**
+     * @brief s_opened True once open was tried
+     */
+    static bool s_opened;
+
+    /**
+     * @brief s_entries The thumbnails of each key, one per width
+     */
+    static QHash<QString, QList<Entry> > s_entries;
+
+    /**
+     * @brief s_locations The last key stored for each location, for the media offline
+     */
+    static QHash<QString, QString> s_locations;
+
+    /**
+     * @brief s_keys The keys of the files already read, saved in the index
+     */
+    static QHash<QString, FileKey> s_keys;
+
+    /**
+     * @brief s_newKeys The keys computed since the index was written
+     */
+    static int s_newKeys;
+
+    /**
+     * @brief KEYS_PER_WRITE Keys computed before the index is written again
+     */
+    static const int KEYS_PER_WRITE = 32;
+
+    /**
+     * @brief s_dead The bytes of the pack taken by replaced records
+     */
+    static quint64 s_dead;
+
+    /**
+     * @brief s_mutex Protect the pack and the indexes
+     */
+    static QMutex s_mutex;
+};
+
+#endif // THUMBNAILSTORE_H
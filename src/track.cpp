@@ -25,6 +25,8 @@
 
 #include "track.h"
 
+#include <string.h>
+
 #include <vlc/plugins/vlc_fourcc.h>
 #include <vlc/plugins/vlc_common.h>
 #include <vlc/plugins/vlc_es.h>
@@ -43,6 +45,21 @@ Track::Track(libvlc_media_track_t** vlcTrack, QObject *parent) :
     QObject(parent),
     _vlcTrack(**vlcTrack)
 {
+    // the sizes and the rate are read from the structure before 2.1.0, the one kept by the copies
+    memset(&_vlcTrackInfo, 0, sizeof(_vlcTrackInfo));
+    _vlcTrackInfo.i_codec = _vlcTrack.i_codec;
+    _vlcTrackInfo.i_id = _vlcTrack.i_id;
+    _vlcTrackInfo.i_type = _vlcTrack.i_type;
+    _vlcTrackInfo.i_profile = _vlcTrack.i_profile;
+    _vlcTrackInfo.i_level = _vlcTrack.i_level;
+
+    if (_vlcTrack.i_type == libvlc_track_video && _vlcTrack.video != NULL) {
+        _vlcTrackInfo.u.video.i_width = _vlcTrack.video->i_width;
+        _vlcTrackInfo.u.video.i_height = _vlcTrack.video->i_height;
+    } else if (_vlcTrack.i_type == libvlc_track_audio && _vlcTrack.audio != NULL) {
+        _vlcTrackInfo.u.audio.i_channels = _vlcTrack.audio->i_channels;
+        _vlcTrackInfo.u.audio.i_rate = _vlcTrack.audio->i_rate;
+    }
 }
 
 Track::Track(QObject *parent) :
@@ -55,6 +72,7 @@ Track::Track(const Track &track) :
     QObject()
 {
     _vlcTrackInfo = track._vlcTrackInfo;
+    _vlcTrack = track._vlcTrack;
 }
 
 Track::~Track()
@@ -65,6 +83,7 @@ Track & Track::operator=(const Track &track)
 {
     if (this != &track) {
         _vlcTrackInfo = track._vlcTrackInfo;
+        _vlcTrack = track._vlcTrack;
     }
 
     return *this;
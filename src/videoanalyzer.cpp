@@ -0,0 +1,412 @@
+/**********************************************************************************
+ * This file is part of Open Projection Program (OPP).
+ *
+ * Copyright (C) 2013 Catalogue Ouvert du Cinéma <dev@cinemaouvert.fr>
+ *
+ * Authors: Jerome Blanchi <d.j.a.y@free.fr>
+ *
+ * Open Projection Program is an initiative of Catalogue Ouvert du Cinéma.
+ * The software was developed by four students of University of Poitiers
+ * as school project.
+ *
+ * Open Projection Program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Open Projection Program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Open Projection Program. If not, see <http://www.gnu.org/licenses/>.
+ **********************************************************************************/
+
+#include "videoanalyzer.h"
+
+#include <math.h>
+
+#include <QDebug>
+
+#ifdef __SSE2__
+# include <emmintrin.h>
+#endif
+
+#include "VLCApplication.h"
+#include "jobscheduler.h"
+
+// bits per pixel of the I420 pictures, smem copies only the luma plane
+#define I420_BITS 12
+
+VideoAnalyzer::VideoAnalyzer(VLCApplication *vlcApp, int width, int height, QObject *parent) :
+    QObject(parent),
+    _vlcApp(vlcApp),
+    _width(width),
+    _height(height),
+    _done(0),
+    _total(0)
+{
+    _vlcApp->jobScheduler()->addClient(this, JobScheduler::DecodeResource, JobScheduler::LowPriority);
+}
+
+VideoAnalyzer::~VideoAnalyzer()
+{
+    cancel();
+    _vlcApp->jobScheduler()->removeClient(this);
+}
+
+void VideoAnalyzer::analyze(Media *media)
+{
+    if (media == NULL || media->isImage() || media->isAudio() || _queue.contains(media))
+        return;
+
+    foreach (Job *job, _jobs)
+        if (job->media == media)
+            return;
+
+    _queue.append(media);
+    _total++;
+    startJobs();
+}
+
+void VideoAnalyzer::cancel()
+{
+    _queue.clear();
+    _vlcApp->jobScheduler()->withdraw(this);
+
+    foreach (Job *job, _jobs) {
+        releaseJob(job);
+        delete job->measure;
+        delete job;
+        _vlcApp->jobScheduler()->release(this);
+    }
+    _jobs.clear();
+
+    _done = 0;
+    _total = 0;
+}
+
+void VideoAnalyzer::statistics(const uchar *luma, int count, double *mean, double *deviation)
+{
+    quint64 sum = 0;
+    quint64 squares = 0;
+    int i = 0;
+
+#ifdef __SSE2__
+    const __m128i zero = _mm_setzero_si128();
+
+    while (i + 16 <= count) {
+        // the 32 bits sums of squares hold 8192 vectors of 255
+        int end = qMin(count - 15, i + 8192 * 16);
+        __m128i sums = zero;
+        __m128i squareSums = zero;
+        quint64 halves[2];
+        quint32 lanes[4];
+
+        for (; i < end; i += 16) {
+            __m128i x = _mm_loadu_si128((const __m128i *)(luma + i));
+            __m128i low = _mm_unpacklo_epi8(x, zero);
+            __m128i high = _mm_unpackhi_epi8(x, zero);
+
+            sums = _mm_add_epi64(sums, _mm_sad_epu8(x, zero));
+            squareSums = _mm_add_epi32(squareSums, _mm_add_epi32(_mm_madd_epi16(low, low),
+                                                                 _mm_madd_epi16(high, high)));
+        }
+
+        _mm_storeu_si128((__m128i *)halves, sums);
+        sum += halves[0] + halves[1];
+        _mm_storeu_si128((__m128i *)lanes, squareSums);
+        squares += (quint64)lanes[0] + lanes[1] + lanes[2] + lanes[3];
+    }
+#endif
+
+    for (; i < count; i++) {
+        sum += luma[i];
+        squares += luma[i] * luma[i];
+    }
+
+    if (count <= 0) {
+        *mean = 0.0;
+        *deviation = 0.0;
+        return;
+    }
+
+    *mean = (double)sum / count;
+    *deviation = sqrt(qMax(0.0, (double)squares / count - *mean * *mean));
+}
+
+void VideoAnalyzer::addColumns(const uchar *luma, int width, int height, quint32 *sums, quint32 *squares)
+{
+    for (int y = 0; y < height; y++, luma += width) {
+        int x = 0;
+
+#ifdef __SSE2__
+        const __m128i zero = _mm_setzero_si128();
+
+        for (; x + 8 <= width; x += 8) {
+            __m128i v = _mm_unpacklo_epi8(_mm_loadl_epi64((const __m128i *)(luma + x)), zero);
+            __m128i square = _mm_mullo_epi16(v, v);
+            __m128i *s = (__m128i *)(sums + x);
+            __m128i *q = (__m128i *)(squares + x);
+
+            _mm_storeu_si128(s, _mm_add_epi32(_mm_loadu_si128(s), _mm_unpacklo_epi16(v, zero)));
+            _mm_storeu_si128(s + 1, _mm_add_epi32(_mm_loadu_si128(s + 1), _mm_unpackhi_epi16(v, zero)));
+            _mm_storeu_si128(q, _mm_add_epi32(_mm_loadu_si128(q), _mm_unpacklo_epi16(square, zero)));
+            _mm_storeu_si128(q + 1, _mm_add_epi32(_mm_loadu_si128(q + 1), _mm_unpackhi_epi16(square, zero)));
+        }
+#endif
+
+        for (; x < width; x++) {
+            sums[x] += luma[x];
+            squares[x] += luma[x] * luma[x];
+        }
+    }
+}
+
+quint64 VideoAnalyzer::curvature(const uchar *above, const uchar *line, const uchar *below, int width)
+{
+    quint64 sum = 0;
+    int x = 0;
+
+#ifdef __SSE2__
+    const __m128i zero = _mm_setzero_si128();
+    const __m128i ones = _mm_set1_epi16(1);
+    __m128i sums = zero;
+    quint32 lanes[4];
+
+    // a lane adds at most 2 * 510 per vector, far from overflowing on a line
+    for (; x + 8 <= width; x += 8) {
+        __m128i a = _mm_unpacklo_epi8(_mm_loadl_epi64((const __m128i *)(above + x)), zero);
+        __m128i l = _mm_unpacklo_epi8(_mm_loadl_epi64((const __m128i *)(line + x)), zero);
+        __m128i b = _mm_unpacklo_epi8(_mm_loadl_epi64((const __m128i *)(below + x)), zero);
+        __m128i d = _mm_sub_epi16(_mm_add_epi16(a, b), _mm_add_epi16(l, l));
+
+        d = _mm_max_epi16(d, _mm_sub_epi16(zero, d));
+        sums = _mm_add_epi32(sums, _mm_madd_epi16(d, ones));
+    }
+
+    _mm_storeu_si128((__m128i *)lanes, sums);
+    sum = (quint64)lanes[0] + lanes[1] + lanes[2] + lanes[3];
+#endif
+
+    for (; x < width; x++)
+        sum += qAbs(above[x] + below[x] - 2 * line[x]);
+
+    return sum;
+}
+
+QList<VideoAnalyzer::Segment> VideoAnalyzer::segments(Media *media)
+{
+    Q_UNUSED(media);
+
+    Segment whole = { 0, 0 };
+
+    return QList<Segment>() << whole;
+}
+
+void VideoAnalyzer::startJobs()
+{
+    while (!_queue.isEmpty()) {
+        Media *media = _queue.first();
+
+        if (media == NULL) {
+            _queue.removeFirst();
+            continue;
+        }
+
+        if (media->videoTracks().isEmpty()) {
+            _queue.removeFirst();
+            _done++;
+            emit progress(_done, _total);
+            continue;
+        }
+
+        // the scheduler calls again when a slot is free
+        if (!_vlcApp->jobScheduler()->acquire(this))
+            break;
+
+        _queue.removeFirst();
+
+        Job *job = new Job;
+        job->media = media;
+        job->segments = segments(media);
+        job->segment = 0;
+        job->vlcMedia = NULL;
+        job->player = NULL;
+        job->measure = createMeasure(media);
+        job->decoded = false;
+
+        _jobs.append(job);
+        startSegment(job);
+    }
+
+    if (_jobs.isEmpty() && _queue.isEmpty() && _total > 0) {
+        _done = 0;
+        _total = 0;
+        emit finished();
+    }
+}
+
+void VideoAnalyzer::startSegment(Job *job)
+{
+    const Segment &segment = job->segments.at(job->segment);
+    QString scale;
+
+    if (_width > 0 && _height > 0)
+        scale = QString(",width=%1,height=%2").arg(_width).arg(_height);
+
+    // decode to I420 pictures in memory, without waiting for the clock
+    const QString output = QString(":sout=#transcode{vcodec=I420%1,acodec=none,scodec=none}"
+                                   ":smem{video-prerender-callback=%2,video-postrender-callback=%3,video-data=%4,time-sync=false}")
+            .arg(scale)
+            .arg((long long)(intptr_t)&VideoAnalyzer::prerenderCallback)
+            .arg((long long)(intptr_t)&VideoAnalyzer::postrenderCallback)
+            .arg((long long)(intptr_t)job);
+
+    job->vlcMedia = libvlc_media_new_path(_vlcApp->vlcInstance(), job->media->location().toStdString().data());
+    libvlc_media_add_option(job->vlcMedia, output.toLocal8Bit().data());
+    libvlc_media_add_option(job->vlcMedia, ":no-sout-audio");
+    libvlc_media_add_option(job->vlcMedia, ":no-sout-spu");
+    libvlc_media_add_option(job->vlcMedia, ":no-sout-all");
+    if (segment.start > 0)
+        libvlc_media_add_option(job->vlcMedia, QString(":start-time=%1").arg(segment.start / 1000.0).toLocal8Bit().data());
+    if (segment.stop > 0)
+        libvlc_media_add_option(job->vlcMedia, QString(":stop-time=%1").arg(segment.stop / 1000.0).toLocal8Bit().data());
+
+    job->player = libvlc_media_player_new_from_media(job->vlcMedia);
+
+    libvlc_event_manager_t *events = libvlc_media_player_event_manager(job->player);
+    libvlc_event_attach(events, libvlc_MediaPlayerEndReached, eventCallback, this);
+    libvlc_event_attach(events, libvlc_MediaPlayerEncounteredError, eventCallback, this);
+
+    // no decoder thread runs yet
+    job->measure->startSegment(job->segment);
+    _vlcApp->jobScheduler()->startPlayer(this, job->player);
+}
+
+VideoAnalyzer::Job *VideoAnalyzer::job(void *player) const
+{
+    foreach (Job *job, _jobs)
+        if (job->player == player)
+            return job;
+
+    return NULL;
+}
+
+void VideoAnalyzer::jobEnded(void *player)
+{
+    Job *job = this->job(player);
+
+    if (job == NULL)
+        return;
+
+    // stopping joins the decoder, the measure of the segment is complete afterwards
+    releaseJob(job);
+
+    if (job->media != NULL && ++job->segment < job->segments.count()) {
+        startSegment(job);
+        return;
+    }
+
+    if (job->media == NULL) {
+        // removed from the bin meanwhile
+    } else if (!job->decoded) {
+        qDebug() << "Video analysis: no picture decoded from" << job->media->location();
+    } else if (storeMeasure(job->media, job->measure)) {
+        emit analyzed(job->media);
+    }
+
+    finishJob(job);
+}
+
+void VideoAnalyzer::jobFailed(void *player)
+{
+    Job *job = this->job(player);
+
+    if (job == NULL)
+        return;
+
+    releaseJob(job);
+
+    if (job->media != NULL)
+        qDebug() << "Video analysis: can not decode" << job->media->location();
+
+    finishJob(job);
+}
+
+void VideoAnalyzer::finishJob(Job *job)
+{
+    _jobs.removeOne(job);
+    delete job->measure;
+    delete job;
+    _vlcApp->jobScheduler()->release(this);
+
+    _done++;
+    emit progress(_done, _total);
+
+    startJobs();
+}
+
+void VideoAnalyzer::releaseJob(Job *job)
+{
+    if (job->player == NULL)
+        return;
+
+    _vlcApp->jobScheduler()->removePlayer(job->player);
+
+    libvlc_event_manager_t *events = libvlc_media_player_event_manager(job->player);
+    libvlc_event_detach(events, libvlc_MediaPlayerEndReached, eventCallback, this);
+    libvlc_event_detach(events, libvlc_MediaPlayerEncounteredError, eventCallback, this);
+
+    libvlc_media_player_stop(job->player);
+    libvlc_media_player_release(job->player);
+    libvlc_media_release(job->vlcMedia);
+    job->player = NULL;
+    job->vlcMedia = NULL;
+}
+
+/***********************************************************************\
+                          LIBVLC CALLBACKS
+\***********************************************************************/
+
+void VideoAnalyzer::prerenderCallback(void *data, uint8_t **buffer, size_t size)
+{
+    Job *job = (Job *)data;
+
+    if ((size_t)job->buffer.size() < size)
+        job->buffer.resize(size);
+
+    *buffer = (uint8_t *)job->buffer.data();
+}
+
+void VideoAnalyzer::postrenderCallback(void *data, uint8_t *buffer, int width, int height,
+                                       int bits, size_t size, int64_t pts)
+{
+    Job *job = (Job *)data;
+
+    // the transcoder could not convert this track
+    if (bits != I420_BITS || width <= 0 || height <= 0 || size < (size_t)width * height)
+        return;
+
+    // the measure lives in the decoder thread until the player is stopped
+    job->measure->process(buffer, width, height, pts);
+    job->decoded = true;
+}
+
+void VideoAnalyzer::eventCallback(const libvlc_event_t *event, void *data)
+{
+    VideoAnalyzer *analyzer = (VideoAnalyzer *)data;
+    void *player = event->p_obj;
+
+    switch (event->type) {
+    case libvlc_MediaPlayerEndReached:
+        QMetaObject::invokeMethod(analyzer, "jobEnded", Qt::QueuedConnection, Q_ARG(void *, player));
+        break;
+    case libvlc_MediaPlayerEncounteredError:
+        QMetaObject::invokeMethod(analyzer, "jobFailed", Qt::QueuedConnection, Q_ARG(void *, player));
+        break;
+    default:
+        break;
+    }
+}
@@ -0,0 +1,295 @@
+/**********************************************************************************
+ * This file is part of Open Projection Program (OPP).
+ *
+ * Copyright (C) 2013 Catalogue Ouvert du Cinéma <dev@cinemaouvert.fr>
+ *
+ * Authors: Jerome Blanchi <d.j.a.y@free.fr>
+ *
+ * Open Projection Program is an initiative of Catalogue Ouvert du Cinéma.
+ * The software was developed by four students of University of Poitiers
+ * as school project.
+ *
+ * Open Projection Program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Open Projection Program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Open Projection Program. If not, see <http://www.gnu.org/licenses/>.
+ **********************************************************************************/
+
+#ifndef VIDEOANALYZER_H
+#define VIDEOANALYZER_H
+
+#include <QObject>
+#include <QList>
+#include <QPointer>
+#include <QByteArray>
+
+#include <vlc/vlc.h>
+
+#include "media.h"
+
+class VLCApplication;
+
+/**
+ * @brief Decode the pictures of media in background to measure them
+ *
+ * The video track of each media is decoded by its own libvlc player into
+ * memory, as fast as the decoder goes (no clock, no audio), so several media
+ * are analyzed at once on several cores. Only the luma plane of the pictures
+ * is given to the measure, scaled to the size of the analyzer. A subclass
+ * chooses the segments of each media to decode, creates the measure and
+ * stores it when the segments are decoded.
+ */
+class VideoAnalyzer : public QObject
+{
+    Q_OBJECT
+public:
+    /**
+     * @brief Part of a media to decode
+     */
+    struct Segment {
+        /**
+         * @brief start The start time (ms)
+         */
+        int start;
+
+        /**
+         * @brief stop The stop time (ms), 0 for the end of the media
+         */
+        int stop;
+    };
+
+    /**
+     * @brief Measure of the pictures of one media
+     */
+    class Measure
+    {
+    public:
+        virtual ~Measure() {}
+
+        /**
+         * @brief Called before the decoding of each segment
+         * @param index The index of the segment
+         */
+        virtual void startSegment(int index) { Q_UNUSED(index); }
+
+        /**
+         * @brief Measure a decoded picture, called in the decoder thread
+         * @param luma The luma plane, one byte per pixel, lines are not padded
+         * @param width The width of the plane
+         * @param height The height of the plane
+         * @param pts The date of the picture in the stream (us)
+         */
+        virtual void process(const uchar *luma, int width, int height, qint64 pts) = 0;
+    };
+
+    /**
+     * @brief Create a video analyzer
+     * @param vlcApp The libvlc instance
+     * @param width The width of the pictures measured, 0 for the source width
+     * @param height The height of the pictures measured, 0 for the source height
+     * @param parent The parent object
+     */
+    VideoAnalyzer(VLCApplication *vlcApp, int width, int height, QObject *parent = 0);
+    virtual ~VideoAnalyzer();
+
+    /**
+     * @brief Add a media to the analysis queue
+     * @param media The media, skipped if already queued or without video
+     */
+    void analyze(Media *media);
+
+
+    /**
+     * @brief Allow to know if an analysis is running
+     * @return True if running, false otherwise
+     */
+    inline bool isRunning() const { return !_jobs.isEmpty(); }
+
+    /**
+     * @brief Compute the mean and the standard deviation of luma samples
+     * @param luma The samples
+     * @param count The number of samples
+     * @param mean Set to the mean
+     * @param deviation Set to the standard deviation
+     */
+    static void statistics(const uchar *luma, int count, double *mean, double *deviation);
+
+    /**
+     * @brief Add the luma samples of each column to its sums
+     * @param luma The first line
+     * @param width The number of columns
+     * @param height The number of lines
+     * @param sums The sums of the samples of each column
+     * @param squares The sums of the squares of the samples of each column
+     */
+    static void addColumns(const uchar *luma, int width, int height, quint32 *sums, quint32 *squares);
+
+    /**
+     * @brief Measure the vertical detail of a line: the sum of |above - 2 line + below|
+     * @param above The line above
+     * @param line The line
+     * @param below The line below
+     * @param width The number of samples of the lines
+     * @return The sum
+     */
+    static quint64 curvature(const uchar *above, const uchar *line, const uchar *below, int width);
+
+public slots:
+    /**
+     * @brief Stop the running analyses and clear the queue
+     */
+    void cancel();
+
+signals:
+    /**
+     * @brief Emitted when the measure of a media is stored
+     * @param media The media
+     */
+    void analyzed(Media *media);
+
+    /**
+     * @brief Emitted each time a media is done
+     * @param done The number of media done since the queue was empty
+     * @param total The number of media queued since the queue was empty
+     */
+    void progress(int done, int total);
+
+    /**
+     * @brief Emitted when the queue is empty
+     */
+    void finished();
+
+protected:
+    /**
+     * @brief Get the parts of a media to decode, the whole media by default
+     * @param media The media
+     * @return The segments, decoded in this order
+     */
+    virtual QList<Segment> segments(Media *media);
+
+    /**
+     * @brief Create the measure of a media
+     * @param media The media
+     * @return The measure, owned by the analyzer
+     */
+    virtual Measure *createMeasure(Media *media) = 0;
+
+    /**
+     * @brief Store the measure of a media completely decoded
+     * @param media The media
+     * @param measure The measure, deleted afterwards
+     * @return True if stored, false otherwise
+     */
+    virtual bool storeMeasure(Media *media, Measure *measure) = 0;
+
+private slots:
+    /**
+     * @brief Start jobs from the queue when the scheduler gives a slot
+     */
+    void startJobs();
+
+    /**
+     * @brief Decode the next segment of a player or store its measure
+     * @param player The libvlc player of the job
+     */
+    void jobEnded(void *player);
+
+    /**
+     * @brief Drop the job of a player which could not decode its media
+     * @param player The libvlc player of the job
+     */
+    void jobFailed(void *player);
+
+private:
+    /**
+     * @brief Analysis of one media
+     */
+    struct Job {
+        QPointer<Media> media;
+        QList<Segment> segments;
+        int segment;
+        libvlc_media_t *vlcMedia;
+        libvlc_media_player_t *player;
+        Measure *measure;
+        bool decoded;
+        QByteArray buffer;
+    };
+
+    /**
+     * @brief Start the player of the current segment of a job
+     */
+    void startSegment(Job *job);
+
+    /**
+     * @brief Find the job of a player
+     */
+    Job *job(void *player) const;
+
+    /**
+     * @brief Delete a released job and start the next ones
+     */
+    void finishJob(Job *job);
+
+    /**
+     * @brief Stop and release the player and the media of a job, keep its measure
+     */
+    void releaseJob(Job *job);
+
+    /**
+     * @brief libvlc stream output callback, give the buffer to copy the picture into
+     */
+    static void prerenderCallback(void *data, uint8_t **buffer, size_t size);
+
+    /**
+     * @brief libvlc stream output callback, measure the decoded picture
+     */
+    static void postrenderCallback(void *data, uint8_t *buffer, int width, int height,
+                                   int bits, size_t size, int64_t pts);
+
+    /**
+     * @brief libvlc event callback
+     */
+    static void eventCallback(const libvlc_event_t *event, void *data);
+
+    VLCApplication *_vlcApp;
+
+    /**
+     * @brief _width The width of the pictures measured, 0 for the source width
+     */
+    int _width;
+
+    /**
+     * @brief _height The height of the pictures measured, 0 for the source height
+     */
+    int _height;
+
+    /**
+     * @brief _queue The media waiting for a free job
+     */
+    QList<QPointer<Media> > _queue;
+
+    /**
+     * @brief _jobs The running jobs
+     */
+    QList<Job*> _jobs;
+
+    /**
+     * @brief _done The number of media done since the queue was empty
+     */
+    int _done;
+
+    /**
+     * @brief _total The number of media queued since the queue was empty
+     */
+    int _total;
+};
+
+#endif // VIDEOANALYZER_H
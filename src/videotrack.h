@@ -30,6 +30,18 @@
 
 #include "track.h"
 
+/**
+ * @enum ScanType
+ * @brief Contains the scan types found by the interlace detection
+ */
+enum ScanType {
+    UnknownScan = 0,
+    Progressive = 1,
+    InterlacedTff = 2,
+    InterlacedBff = 3,
+    Telecined = 4
+};
+
 /**
  * @brief Manage video track information
  */
@@ -0,0 +1,256 @@
+/**********************************************************************************
+ * This file is part of Open Projection Program (OPP).
+ *
+ * Copyright (C) 2013 Catalogue Ouvert du Cinéma <dev@cinemaouvert.fr>
+ *
+ * Authors: Jerome Blanchi <d.j.a.y@free.fr>
+ *
+ * Open Projection Program is an initiative of Catalogue Ouvert du Cinéma.
+ * The software was developed by four students of University of Poitiers
+ * as school project.
+ *
+ * Open Projection Program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Open Projection Program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Open Projection Program. If not, see <http://www.gnu.org/licenses/>.
+ **********************************************************************************/
+
+#include "waveform.h"
+
+#include <math.h>
+
+#include <QCoreApplication>
+#include <QCryptographicHash>
+#include <QDataStream>
+#include <QDateTime>
+#include <QDebug>
+#include <QDir>
+#include <QFile>
+#include <QFileInfo>
+
+#ifdef __SSE__
+# include <xmmintrin.h>
+#endif
+
+/* "OPPW" and the version of the file */
+static const quint32 FILE_MAGIC = 0x4f505057;
+static const quint32 FILE_VERSION = 1;
+
+/* minimum, maximum and sum of the squares of count samples */
+static void reduce(const float *samples, unsigned count, float *min, float *max, double *sum)
+{
+    unsigned i = 0;
+
+#ifdef __SSE__
+    __m128 vmin = _mm_set1_ps(*min);
+    __m128 vmax = _mm_set1_ps(*max);
+    __m128 vsum = _mm_setzero_ps();
+    float values[4];
+
+    for (; i + 4 <= count; i += 4) {
+        __m128 x = _mm_loadu_ps(samples + i);
+        vmin = _mm_min_ps(vmin, x);
+        vmax = _mm_max_ps(vmax, x);
+        vsum = _mm_add_ps(vsum, _mm_mul_ps(x, x));
+    }
+
+    _mm_storeu_ps(values, vmin);
+    *min = qMin(qMin(values[0], values[1]), qMin(values[2], values[3]));
+    _mm_storeu_ps(values, vmax);
+    *max = qMax(qMax(values[0], values[1]), qMax(values[2], values[3]));
+    _mm_storeu_ps(values, vsum);
+    *sum += (double)values[0] + values[1] + values[2] + values[3];
+#endif
+
+    for (; i < count; ++i) {
+        *min = qMin(*min, samples[i]);
+        *max = qMax(*max, samples[i]);
+        *sum += samples[i] * samples[i];
+    }
+}
+
+static qint8 toLevel(float value)
+{
+    return (qint8)qBound(-127, qRound(value * 127.f), 127);
+}
+
+Waveform::Waveform(unsigned channels, unsigned rate) :
+    _channels(channels),
+    _rate(rate),
+    _min(0.f),
+    _max(0.f),
+    _sum(0.0),
+    _frames(0)
+{
+}
+
+double Waveform::bucketDuration(int index) const
+{
+    double frames = BUCKET_FRAMES;
+
+    for (int i = 0; i < index; ++i)
+        frames *= LEVEL_FACTOR;
+
+    return _rate > 0 ? frames * 1000.0 / _rate : 0.0;
+}
+
+int Waveform::levelFor(double duration) const
+{
+    for (int index = _levels.count() - 1; index > 0; --index)
+        if (bucketDuration(index) <= duration)
+            return index;
+
+    return 0;
+}
+
+void Waveform::append(const float *samples, unsigned frames)
+{
+    if (_levels.isEmpty())
+        _levels.append(QVector<Peak>());
+
+    while (frames > 0) {
+        unsigned count = qMin(frames, BUCKET_FRAMES - _frames);
+
+        reduce(samples, count * _channels, &_min, &_max, &_sum);
+        samples += count * _channels;
+        frames -= count;
+        _frames += count;
+
+        if (_frames == (unsigned)BUCKET_FRAMES) {
+            Peak peak;
+            peak.min = toLevel(_min);
+            peak.max = toLevel(_max);
+            peak.rms = (quint8)qMin(255, qRound(sqrt(_sum / (BUCKET_FRAMES * _channels)) * 255.0));
+            _levels.first().append(peak);
+
+            _min = _max = 0.f;
+            _sum = 0.0;
+            _frames = 0;
+        }
+    }
+}
+
+void Waveform::finish()
+{
+    if (_levels.isEmpty())
+        return;
+
+    if (_frames > 0) {
+        Peak peak;
+        peak.min = toLevel(_min);
+        peak.max = toLevel(_max);
+        peak.rms = (quint8)qMin(255, qRound(sqrt(_sum / (_frames * _channels)) * 255.0));
+        _levels.first().append(peak);
+
+        _min = _max = 0.f;
+        _sum = 0.0;
+        _frames = 0;
+    }
+
+    _levels.resize(1);
+
+    while (_levels.last().count() > MIN_BUCKETS) {
+        const QVector<Peak> &fine = _levels.last();
+        QVector<Peak> coarse;
+        coarse.reserve(fine.count() / LEVEL_FACTOR + 1);
+
+        for (int i = 0; i < fine.count(); i += LEVEL_FACTOR) {
+            int end = qMin(i + LEVEL_FACTOR, fine.count());
+            Peak peak = fine.at(i);
+            int squares = 0;
+
+            for (int j = i; j < end; ++j) {
+                peak.min = qMin(peak.min, fine.at(j).min);
+                peak.max = qMax(peak.max, fine.at(j).max);
+                squares += fine.at(j).rms * fine.at(j).rms;
+            }
+            peak.rms = (quint8)qRound(sqrt((double)squares / (end - i)));
+            coarse.append(peak);
+        }
+
+        _levels.append(coarse);
+    }
+}
+
+bool Waveform::save(const QString &fileName) const
+{
+    QDir().mkpath(QFileInfo(fileName).path());
+
+    QFile file(fileName);
+    if (!file.open(QIODevice::WriteOnly)) {
+        qDebug() << "Waveform: can not write" << fileName;
+        return false;
+    }
+
+    QDataStream stream(&file);
+    stream << FILE_MAGIC << FILE_VERSION << (quint32)_channels << (quint32)_rate
+           << (quint32)BUCKET_FRAMES << (quint32)LEVEL_FACTOR << (quint32)_levels.count();
+
+    foreach (const QVector<Peak> &level, _levels) {
+        stream << (quint32)level.count();
+        stream.writeRawData((const char *)level.constData(), level.count() * sizeof(Peak));
+    }
+
+    return stream.status() == QDataStream::Ok;
+}
+
+bool Waveform::load(const QString &fileName)
+{
+    QFile file(fileName);
+    if (!file.open(QIODevice::ReadOnly))
+        return false;
+
+    QDataStream stream(&file);
+    quint32 magic, version, channels, rate, bucketFrames, levelFactor, levelCount;
+    stream >> magic >> version >> channels >> rate >> bucketFrames >> levelFactor >> levelCount;
+
+    if (stream.status() != QDataStream::Ok || magic != FILE_MAGIC || version != FILE_VERSION
+            || bucketFrames != (quint32)BUCKET_FRAMES || levelFactor != (quint32)LEVEL_FACTOR) {
+        qDebug() << "Waveform: unknown file" << fileName;
+        return false;
+    }
+
+    QVector<QVector<Peak> > levels;
+    for (quint32 i = 0; i < levelCount; ++i) {
+        quint32 count;
+        stream >> count;
+        if (stream.status() != QDataStream::Ok || count > (quint32)(file.size() / sizeof(Peak)))
+            return false;
+
+        QVector<Peak> level(count);
+        if (stream.readRawData((char *)level.data(), count * sizeof(Peak)) != (int)(count * sizeof(Peak)))
+            return false;
+        levels.append(level);
+    }
+
+    _channels = channels;
+    _rate = rate;
+    _levels = levels;
+    _frames = 0;
+
+    return true;
+}
+
+QString Waveform::cacheFile(const QString &location)
+{
+    QFileInfo info(location);
+
+    return cacheFile(location, info.size(), info.lastModified());
+}
+
+QString Waveform::cacheFile(const QString &location, qint64 size, const QDateTime &modified)
+{
+    QByteArray key = location.toUtf8() + '|' + QByteArray::number(size)
+            + '|' + modified.toString(Qt::ISODate).toUtf8();
+
+    return qApp->applicationDirPath() + "/waveform/"
+            + QCryptographicHash::hash(key, QCryptographicHash::Md5).toHex() + ".oppw";
+}
@@ -0,0 +1,179 @@
+/**********************************************************************************
+ * This file is part of Open Projection Program (OPP).
+ *
+ * Copyright (C) 2013 Catalogue Ouvert du Cinéma <dev@cinemaouvert.fr>
+ *
+ * Authors: Jerome Blanchi <d.j.a.y@free.fr>
+ *
+ * Open Projection Program is an initiative of Catalogue Ouvert du Cinéma.
+ * The software was developed by four students of University of Poitiers
+ * as school project.
+ *
+ * Open Projection Program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Open Projection Program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Open Projection Program. If not, see <http://www.gnu.org/licenses/>.
+ **********************************************************************************/
+
+#ifndef WAVEFORM_H
+#define WAVEFORM_H
+
+#include <QString>
+#include <QDateTime>
+#include <QVector>
+
+/**
+ * @brief Overview of an audio track: minimum, maximum and RMS per time bucket
+ *
+ * The finest level has a bucket every BUCKET_FRAMES frames, each coarser
+ * level merges LEVEL_FACTOR buckets of the previous one. The values are
+ * stored on 8 bits, about 1.4 MB for two hours at 48 kHz.
+ */
+class Waveform
+{
+public:
+    /**
+     * @brief Levels of a bucket, full scale is 127 (min, max) and 255 (rms)
+     */
+    struct Peak {
+        qint8 min;
+        qint8 max;
+        quint8 rms;
+    };
+
+    /**
+     * @brief Create an empty waveform
+     * @param channels The number of interleaved channels of the samples
+     * @param rate The sample rate (Hz)
+     */
+    Waveform(unsigned channels = 2, unsigned rate = 48000);
+
+    /**
+     * @brief Allow to know if the waveform has data
+     * @return True if empty, false otherwise
+     */
+    inline bool isEmpty() const { return _levels.isEmpty() || _levels.first().isEmpty(); }
+
+    /**
+     * @brief Get the number of levels
+     */
+    inline int levelCount() const { return _levels.count(); }
+
+    /**
+     * @brief Get the buckets of a level, from the finest (0)
+     */
+    inline const QVector<Peak> &level(int index) const { return _levels.at(index); }
+
+    /**
+     * @brief Get the duration of the buckets of a level
+     * @param index The level
+     * @return The duration in ms
+     */
+    double bucketDuration(int index) const;
+
+    /**
+     * @brief Find the coarsest level with buckets no longer than a duration
+     * @param duration The duration (ms), typically the duration of a pixel
+     * @return The level
+     */
+    int levelFor(double duration) const;
+
+    /**
+     * @brief Add decoded samples to the finest level
+     * @param samples The interleaved samples, full scale is 1
+     * @param frames The number of frames (samples per channel)
+     */
+    void append(const float *samples, unsigned frames);
+
+    /**
+     * @brief Close the last bucket and build the coarser levels
+     */
+    void finish();
+
+    /**
+     * @brief Write the waveform into a file
+     * @return True on success, false otherwise
+     */
+    bool save(const QString &fileName) const;
+
+    /**
+     * @brief Read a waveform written by save
+     * @return True on success, false otherwise
+     */
+    bool load(const QString &fileName);
+
+    /**
+     * @brief Get the cache file of the waveform of a media file
+     *
+     * The name depends on the location, the size and the date of the file,
+     * so a replaced file gets a new waveform.
+     *
+     * @param location The media location
+     * @return The file name
+     */
+    static QString cacheFile(const QString &location);
+
+    /**
+     * @brief Get the cache file of a version of a media file
+     * @param location The media location
+     * @param size The size of the file
+     * @param modified The date of the file
+     * @return The file name
+     */
+    static QString cacheFile(const QString &location, qint64 size, const QDateTime &modified);
+
+    /**
+     * @brief BUCKET_FRAMES Frames of a bucket of the finest level
+     */
+    static const int BUCKET_FRAMES = 1024;
+
+    /**
+     * @brief LEVEL_FACTOR Buckets of a level merged in a bucket of the next one
+     */
+    static const int LEVEL_FACTOR = 4;
+
+    /**
+     * @brief MIN_BUCKETS No coarser level is built under this number of buckets
+     */
+    static const int MIN_BUCKETS = 256;
+
+private:
+    unsigned _channels;
+
+    unsigned _rate;
+
+    /**
+     * @brief _levels The buckets of each level, from the finest
+     */
+    QVector<QVector<Peak> > _levels;
+
+    /**
+     * @brief _min The minimum of the current bucket
+     */
+    float _min;
+
+    /**
+     * @brief _max The maximum of the current bucket
+     */
+    float _max;
+
+    /**
+     * @brief _sum The sum of the squares of the current bucket
+     */
+    double _sum;
+
+    /**
+     * @brief _frames The frames already in the current bucket
+     */
+    unsigned _frames;
+};
+
+#endif // WAVEFORM_H
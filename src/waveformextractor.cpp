@@ -0,0 +1,66 @@
+/**********************************************************************************
+ * This file is part of Open Projection Program (OPP).
+ *
+ * Copyright (C) 2013 Catalogue Ouvert du Cinéma <dev@cinemaouvert.fr>
+ *
+ * Authors: Jerome Blanchi <d.j.a.y@free.fr>
+ *
+ * Open Projection Program is an initiative of Catalogue Ouvert du Cinéma.
+ * The software was developed by four students of University of Poitiers
+ * as school project.
+ *
+ * Open Projection Program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Open Projection Program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Open Projection Program. If not, see <http://www.gnu.org/licenses/>.
+ **********************************************************************************/
+
+#include "waveformextractor.h"
+
+#include "waveform.h"
+#include "VLCApplication.h"
+#include "jobscheduler.h"
+
+/**
+ * @brief Waveform fed by the analyzer
+ */
+class WaveformMeasure : public AudioAnalyzer::Measure
+{
+public:
+    WaveformMeasure() : waveform(AudioAnalyzer::CHANNELS, AudioAnalyzer::RATE) {}
+
+    void process(const float *samples, unsigned frames) { waveform.append(samples, frames); }
+
+    Waveform waveform;
+};
+
+WaveformExtractor::WaveformExtractor(VLCApplication *vlcApp, QObject *parent) :
+    AudioAnalyzer(vlcApp, parent)
+{
+    // the waveform is waited for on screen
+    vlcApp->jobScheduler()->setPriority(this, JobScheduler::HighPriority);
+}
+
+AudioAnalyzer::Measure *WaveformExtractor::createMeasure(Media *media)
+{
+    Q_UNUSED(media);
+
+    return new WaveformMeasure;
+}
+
+bool WaveformExtractor::storeMeasure(Media *media, Measure *measure)
+{
+    Waveform &waveform = ((WaveformMeasure *)measure)->waveform;
+
+    waveform.finish();
+
+    return waveform.save(Waveform::cacheFile(media->location()));
+}
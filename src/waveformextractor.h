@@ -0,0 +1,52 @@
+/**********************************************************************************
+ * This file is part of Open Projection Program (OPP).
+ *
+ * Copyright (C) 2013 Catalogue Ouvert du Cinéma <dev@cinemaouvert.fr>
+ *
+ * Authors: Jerome Blanchi <d.j.a.y@free.fr>
+ *
+ * Open Projection Program is an initiative of Catalogue Ouvert du Cinéma.
+ * The software was developed by four students of University of Poitiers
+ * as school project.
+ *
+ * Open Projection Program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Open Projection Program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Open Projection Program. If not, see <http://www.gnu.org/licenses/>.
+ **********************************************************************************/
+
+#ifndef WAVEFORMEXTRACTOR_H
+#define WAVEFORMEXTRACTOR_H
+
+#include "audioanalyzer.h"
+
+/**
+ * @brief Build the waveform of media in background, the result is written in the waveform cache
+ */
+class WaveformExtractor : public AudioAnalyzer
+{
+    Q_OBJECT
+public:
+    explicit WaveformExtractor(VLCApplication *vlcApp, QObject *parent = 0);
+
+protected:
+    /**
+     * @brief Create an empty waveform
+     */
+    Measure *createMeasure(Media *media);
+
+    /**
+     * @brief Write the waveform in the cache file of the media
+     */
+    bool storeMeasure(Media *media, Measure *measure);
+};
+
+#endif // WAVEFORMEXTRACTOR_H
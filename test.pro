@@ -2,7 +2,15 @@ TARGET = unittest
 TEMPLATE = app
 
 QT += testlib
-QT -= gui
+QT += xml
+QT += network
+QT += webkit
+
+greaterThan(QT_MAJOR_VERSION, 4) {
+    QT += widgets
+    QT += printsupport
+    QT += webkitwidgets
+}
 
 CONFIG += console
 CONFIG -= app_bundle
@@ -12,10 +20,28 @@ INCLUDEPATH += ./src
 
 SOURCES += test/main.cpp \
     test/test1.cpp \
-    test/test2.cpp
+    test/test2.cpp \
+    test/fingerprinttest.cpp \
+    test/loudnessmetertest.cpp \
+    test/mediasettingstest.cpp \
+    test/oppmodulestest.cpp \
+    test/playlistplayertest.cpp
 
 HEADERS += test/autotest.h \
     test/test1.h \
-    test/test2.h
+    test/test2.h \
+    test/fingerprinttest.h \
+    test/loudnessmetertest.h \
+    test/mediasettingstest.h \
+    test/oppmodulestest.h \
+    test/playlistplayertest.h
+
+# the classes tested are linked from the application, without its main
+include(src/CORE.pri)
+include(src/C_MediaPlayer/C_MediaPlayer.pri)
+include(src/C_Playlist/C_Playlist.pri)
+include(src/UI.pri)
+include(src/U_PlayerControl/U_PlayerControl.pri)
+include(src/U_PlaylistHandler/U_PlaylistHandler.pri)
 
-include(src/core.pri)
+SOURCES -= src/main.cpp
@@ -0,0 +1,76 @@
+#include "fingerprinttest.h"
+
+#include <QFileInfo>
+#include <QTemporaryFile>
+
+#include "fingerprint.h"
+
+// reference values of the xxHash library
+void FingerprintTest::hash_data()
+{
+    QTest::addColumn<QByteArray>("data");
+    QTest::addColumn<quint64>("seed");
+    QTest::addColumn<quint64>("hash");
+
+    QByteArray fox("The quick brown fox jumps over the lazy dog");
+
+    QTest::newRow("empty") << QByteArray() << Q_UINT64_C(0) << Q_UINT64_C(0xef46db3751d8e999);
+    QTest::newRow("a") << QByteArray("a") << Q_UINT64_C(0) << Q_UINT64_C(0xd24ec4f1a98c6e5b);
+    QTest::newRow("abc") << QByteArray("abc") << Q_UINT64_C(0) << Q_UINT64_C(0x44bc2cf5ad770999);
+    QTest::newRow("fox") << fox << Q_UINT64_C(0) << Q_UINT64_C(0x0b242d361fda71bc);
+    QTest::newRow("fox seeded") << fox << Q_UINT64_C(2654435761) << Q_UINT64_C(0xb31b9019ec176b0c);
+}
+
+void FingerprintTest::hash()
+{
+    QFETCH(QByteArray, data);
+    QFETCH(quint64, seed);
+    QFETCH(quint64, hash);
+
+    QCOMPARE(Fingerprint::hash(data, seed), hash);
+}
+
+// the blocks are chained from the size, computed with the xxHash library
+void FingerprintTest::compute_data()
+{
+    QTest::addColumn<int>("size");
+    QTest::addColumn<QString>("fingerprint");
+
+    QTest::newRow("smaller than a block") << 100 << QString("100-b5753b9ab65da1e0");
+    QTest::newRow("three blocks") << 200000 << QString("200000-1b496b5a44253218");
+}
+
+void FingerprintTest::compute()
+{
+    QFETCH(int, size);
+    QFETCH(QString, fingerprint);
+
+    QByteArray content(size, 0);
+    for (int i = 0; i < size; ++i)
+        content[i] = (char)(i % 251);
+
+    QTemporaryFile file;
+    QVERIFY(file.open());
+    QCOMPARE(file.write(content), (qint64)size);
+    file.flush();
+
+    QCOMPARE(Fingerprint::compute(file.fileName()), fingerprint);
+    QCOMPARE(Fingerprint::size(fingerprint), (qint64)size);
+}
+
+void FingerprintTest::computeMissing()
+{
+    QVERIFY(Fingerprint::compute(QString("/nonexistent/opp/media.mkv")).isEmpty());
+    QCOMPARE(Fingerprint::size(QString()), (qint64)-1);
+}
+
+void FingerprintTest::computeEmpty()
+{
+    QTemporaryFile file;
+    QVERIFY(file.open());
+
+    // every empty file would match
+    QVERIFY(Fingerprint::compute(file.fileName()).isEmpty());
+    QVERIFY(Fingerprint::search(QStringList() << QString("0-0000000000000000"),
+                                QStringList() << QFileInfo(file.fileName()).absolutePath()).isEmpty());
+}
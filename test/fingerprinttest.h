@@ -0,0 +1,21 @@
+#ifndef FINGERPRINTTEST_H
+#define FINGERPRINTTEST_H
+
+#include "autotest.h"
+
+class FingerprintTest : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    void hash_data();
+    void hash();
+    void compute_data();
+    void compute();
+    void computeMissing();
+    void computeEmpty();
+};
+
+DECLARE_TEST(FingerprintTest)
+
+#endif // FINGERPRINTTEST_H
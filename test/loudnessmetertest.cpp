@@ -0,0 +1,115 @@
+#include "loudnessmetertest.h"
+
+#include <math.h>
+
+#include <QStringList>
+#include <QVector>
+
+#include "loudnessmeter.h"
+
+static const unsigned RATE = 48000;
+
+/**
+ * @brief Measure a stereo sine made of segments
+ * @param meter The meter
+ * @param segments The segments, as "level(dBFS)/length(s)" separated by spaces
+ * @param frequency The frequency of the sine (Hz)
+ * @param phase The phase of the sine at the start (rad)
+ */
+static void measureSine(LoudnessMeter *meter, const QString &segments, double frequency = 1000.0, double phase = 0.0)
+{
+    foreach (QString segment, segments.split(' ', QString::SkipEmptyParts)) {
+        double amplitude = pow(10.0, segment.section('/', 0, 0).toDouble() / 20.0);
+        unsigned frames = (unsigned)(segment.section('/', 1, 1).toDouble() * RATE + 0.5);
+
+        QVector<float> samples(frames * 2);
+        for (unsigned i = 0; i < frames; ++i)
+            samples[2 * i] = samples[2 * i + 1] = amplitude * sin(2.0 * M_PI * frequency * i / RATE + phase);
+
+        meter->process(samples.constData(), frames);
+    }
+}
+
+// EBU Tech 3341 cases 1 to 5, stereo 1 kHz sine: +/- 0.1 LU
+void LoudnessMeterTest::integratedLoudness_data()
+{
+    QTest::addColumn<QString>("segments");
+    QTest::addColumn<double>("loudness");
+
+    QTest::newRow("case 1") << QString("-23/20") << -23.0;
+    QTest::newRow("case 2") << QString("-33/20") << -33.0;
+    QTest::newRow("case 3") << QString("-36/10 -23/60 -36/10") << -23.0;
+    QTest::newRow("case 4") << QString("-72/10 -36/10 -23/60 -36/10 -72/10") << -23.0;
+    QTest::newRow("case 5") << QString("-26/20 -20/20.1 -26/20") << -23.0;
+}
+
+void LoudnessMeterTest::integratedLoudness()
+{
+    QFETCH(QString, segments);
+    QFETCH(double, loudness);
+
+    LoudnessMeter meter(2, RATE);
+    measureSine(&meter, segments);
+
+    QVERIFY2(fabs(meter.integratedLoudness() - loudness) <= 0.1,
+             qPrintable(QString("measured %1 LUFS").arg(meter.integratedLoudness())));
+}
+
+// EBU Tech 3342 cases 1 to 3, stereo 1 kHz sine: +/- 1 LU
+void LoudnessMeterTest::loudnessRange_data()
+{
+    QTest::addColumn<QString>("segments");
+    QTest::addColumn<double>("range");
+
+    QTest::newRow("case 1") << QString("-20/20 -30/20") << 10.0;
+    QTest::newRow("case 2") << QString("-20/20 -15/20") << 5.0;
+    QTest::newRow("case 3") << QString("-40/20 -20/20") << 20.0;
+}
+
+void LoudnessMeterTest::loudnessRange()
+{
+    QFETCH(QString, segments);
+    QFETCH(double, range);
+
+    LoudnessMeter meter(2, RATE);
+    measureSine(&meter, segments);
+
+    QVERIFY2(fabs(meter.loudnessRange() - range) <= 1.0,
+             qPrintable(QString("measured %1 LU").arg(meter.loudnessRange())));
+}
+
+// EBU Tech 3341 true peak tolerance: -0.4 to +0.2 dB
+void LoudnessMeterTest::truePeak_data()
+{
+    QTest::addColumn<double>("level");
+    QTest::addColumn<double>("frequency");
+    QTest::addColumn<double>("phase");
+
+    QTest::newRow("1 kHz") << -6.0 << 1000.0 << 0.0;
+    // every sample is 3 dB under the peak of the sine
+    QTest::newRow("rate / 4 between samples") << 0.0 << RATE / 4.0 << M_PI / 4.0;
+}
+
+void LoudnessMeterTest::truePeak()
+{
+    QFETCH(double, level);
+    QFETCH(double, frequency);
+    QFETCH(double, phase);
+
+    LoudnessMeter meter(2, RATE);
+    measureSine(&meter, QString("%1/1").arg(level), frequency, phase);
+
+    QVERIFY2(meter.truePeak() >= level - 0.4 && meter.truePeak() <= level + 0.2,
+             qPrintable(QString("measured %1 dBTP").arg(meter.truePeak())));
+}
+
+void LoudnessMeterTest::silence()
+{
+    LoudnessMeter meter(2, RATE);
+    QVector<float> samples(RATE * 2, 0.f);
+    meter.process(samples.constData(), RATE);
+
+    QCOMPARE(meter.duration(), 1000);
+    QCOMPARE(meter.integratedLoudness(), (double)LoudnessMeter::LOUDNESS_FLOOR);
+    QCOMPARE(meter.truePeak(), (double)LoudnessMeter::LOUDNESS_FLOOR);
+}
@@ -0,0 +1,22 @@
+#ifndef LOUDNESSMETERTEST_H
+#define LOUDNESSMETERTEST_H
+
+#include "autotest.h"
+
+class LoudnessMeterTest : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    void integratedLoudness_data();
+    void integratedLoudness();
+    void loudnessRange_data();
+    void loudnessRange();
+    void truePeak_data();
+    void truePeak();
+    void silence();
+};
+
+DECLARE_TEST(LoudnessMeterTest)
+
+#endif // LOUDNESSMETERTEST_H
@@ -0,0 +1,92 @@
+#include "mediasettingstest.h"
+
+#include <string.h>
+
+#include "mediasettings.h"
+
+#define FOURCC(a, b, c, d) ((uint)(a) | ((uint)(b) << 8) | ((uint)(c) << 16) | ((uint)(d) << 24))
+
+/**
+ * @brief Build a video track as read from libvlc
+ */
+static VideoTrack videoTrack(unsigned width, unsigned height, uint codec)
+{
+    libvlc_video_track_t video;
+    memset(&video, 0, sizeof(video));
+    video.i_width = width;
+    video.i_height = height;
+
+    libvlc_media_track_t track;
+    memset(&track, 0, sizeof(track));
+    track.i_codec = codec;
+    track.i_type = libvlc_track_video;
+    track.video = &video;
+
+    libvlc_media_track_t *tracks = &track;
+
+    return VideoTrack(&tracks);
+}
+
+void MediaSettingsTest::autoDeinterlacing_data()
+{
+    QTest::addColumn<int>("scanType");
+    QTest::addColumn<int>("deinterlacing");
+
+    QTest::newRow("unknown") << (int)UnknownScan << (int)Discard;
+    QTest::newRow("progressive") << (int)Progressive << (int)NoDeinterlacing;
+    QTest::newRow("top field first") << (int)InterlacedTff << (int)Linear;
+    QTest::newRow("bottom field first") << (int)InterlacedBff << (int)Linear;
+    QTest::newRow("telecined") << (int)Telecined << (int)Ivtc;
+}
+
+void MediaSettingsTest::autoDeinterlacing()
+{
+    QFETCH(int, scanType);
+    QFETCH(int, deinterlacing);
+
+    QCOMPARE((int)MediaSettings::autoDeinterlacing((ScanType)scanType), deinterlacing);
+}
+
+void MediaSettingsTest::autoDecoderProfile_data()
+{
+    QTest::addColumn<uint>("width");
+    QTest::addColumn<uint>("height");
+    QTest::addColumn<uint>("codec");
+    QTest::addColumn<int>("profile");
+
+    const uint h264 = FOURCC('h', '2', '6', '4');
+
+    QTest::newRow("SD") << 720u << 576u << h264 << (int)LightProfile;
+    QTest::newRow("720p") << 1280u << 720u << h264 << (int)StandardProfile;
+    QTest::newRow("1080p") << 1920u << 1080u << h264 << (int)StandardProfile;
+    QTest::newRow("1440p") << 2560u << 1440u << h264 << (int)HeavyProfile;
+    QTest::newRow("DCI 4K") << 4096u << 2160u << h264 << (int)HeavyProfile;
+    QTest::newRow("HEVC SD") << 720u << 576u << FOURCC('h', 'e', 'v', 'c') << (int)HeavyProfile;
+    QTest::newRow("VP9 SD") << 720u << 576u << FOURCC('V', 'P', '9', '0') << (int)HeavyProfile;
+}
+
+void MediaSettingsTest::autoDecoderProfile()
+{
+    QFETCH(uint, width);
+    QFETCH(uint, height);
+    QFETCH(uint, codec);
+    QFETCH(int, profile);
+
+    QList<VideoTrack> tracks;
+    tracks << videoTrack(width, height, codec);
+
+    QCOMPARE((int)MediaSettings::autoDecoderProfile(tracks), profile);
+}
+
+void MediaSettingsTest::autoDecoderProfileTracks()
+{
+    const uint h264 = FOURCC('h', '2', '6', '4');
+    QList<VideoTrack> tracks;
+
+    // no video, nothing to decode
+    QCOMPARE((int)MediaSettings::autoDecoderProfile(tracks), (int)LightProfile);
+
+    // the heaviest track sets the profile
+    tracks << videoTrack(720, 576, h264) << videoTrack(1920, 1080, h264);
+    QCOMPARE((int)MediaSettings::autoDecoderProfile(tracks), (int)StandardProfile);
+}
@@ -0,0 +1,20 @@
+#ifndef MEDIASETTINGSTEST_H
+#define MEDIASETTINGSTEST_H
+
+#include "autotest.h"
+
+class MediaSettingsTest : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    void autoDeinterlacing_data();
+    void autoDeinterlacing();
+    void autoDecoderProfile_data();
+    void autoDecoderProfile();
+    void autoDecoderProfileTracks();
+};
+
+DECLARE_TEST(MediaSettingsTest)
+
+#endif // MEDIASETTINGSTEST_H
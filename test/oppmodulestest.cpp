@@ -0,0 +1,56 @@
+#include "oppmodulestest.h"
+
+#include <QCoreApplication>
+#include <QDir>
+
+#include <vlc/vlc.h>
+
+#include "opp_control.h"
+
+/**
+ * @brief Tell if a module is in a list of filters given by libvlc
+ */
+static bool hasModule(libvlc_module_description_t *list, const char *name)
+{
+    bool found = false;
+
+    for (libvlc_module_description_t *module = list; module != NULL; module = module->p_next)
+        if (qstrcmp(module->psz_name, name) == 0)
+            found = true;
+
+    libvlc_module_description_list_release(list);
+
+    return found;
+}
+
+// the modules are built in the "modules" directory next to the binaries (see modules/modules.pri)
+void OppModulesTest::initTestCase()
+{
+    _vlcInstance = NULL;
+
+    QDir modules(QCoreApplication::applicationDirPath() + "/modules");
+    QVERIFY2(modules.exists(), "build modules/modules.pro before the tests");
+
+    qputenv("VLC_PLUGIN_PATH", QDir::toNativeSeparators(modules.absolutePath()).toLocal8Bit());
+
+    const char *args[] = { "--ignore-config", "--no-plugins-cache", "--intf=dummy" };
+    _vlcInstance = libvlc_new(sizeof(args) / sizeof(*args), args);
+    QVERIFY(_vlcInstance != NULL);
+}
+
+void OppModulesTest::cleanupTestCase()
+{
+    if (_vlcInstance != NULL)
+        libvlc_release(_vlcInstance);
+}
+
+// listed only if the core accepts the ABI and the capability of the module
+void OppModulesTest::videoFilter()
+{
+    QVERIFY(hasModule(libvlc_video_filter_list_get(_vlcInstance), OPP_VIDEO_FILTER));
+}
+
+void OppModulesTest::audioFilter()
+{
+    QVERIFY(hasModule(libvlc_audio_filter_list_get(_vlcInstance), OPP_AUDIO_FILTER));
+}
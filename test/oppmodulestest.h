@@ -0,0 +1,24 @@
+#ifndef OPPMODULESTEST_H
+#define OPPMODULESTEST_H
+
+#include "autotest.h"
+
+struct libvlc_instance_t;
+
+class OppModulesTest : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    void initTestCase();
+    void cleanupTestCase();
+    void videoFilter();
+    void audioFilter();
+
+private:
+    libvlc_instance_t *_vlcInstance;
+};
+
+DECLARE_TEST(OppModulesTest)
+
+#endif // OPPMODULESTEST_H
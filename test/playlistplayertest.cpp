@@ -0,0 +1,30 @@
+#include "playlistplayertest.h"
+
+#include "PlaylistPlayer.h"
+
+void PlaylistPlayerTest::nextIndex_data()
+{
+    QTest::addColumn<int>("currentIndex");
+    QTest::addColumn<int>("count");
+    QTest::addColumn<int>("loop");
+    QTest::addColumn<int>("next");
+
+    QTest::newRow("empty") << 0 << 0 << (int)PlaylistPlayer::BIGLOOP << -1;
+    QTest::newRow("no loop, middle") << 1 << 3 << (int)PlaylistPlayer::NOLOOP << 2;
+    QTest::newRow("no loop, last") << 2 << 3 << (int)PlaylistPlayer::NOLOOP << -1;
+    QTest::newRow("big loop, middle") << 1 << 3 << (int)PlaylistPlayer::BIGLOOP << 2;
+    QTest::newRow("big loop, last") << 2 << 3 << (int)PlaylistPlayer::BIGLOOP << 0;
+    QTest::newRow("big loop, single item") << 0 << 1 << (int)PlaylistPlayer::BIGLOOP << 0;
+    QTest::newRow("single loop, middle") << 1 << 3 << (int)PlaylistPlayer::SINGLELOOP << 1;
+    QTest::newRow("single loop, last") << 2 << 3 << (int)PlaylistPlayer::SINGLELOOP << 2;
+}
+
+void PlaylistPlayerTest::nextIndex()
+{
+    QFETCH(int, currentIndex);
+    QFETCH(int, count);
+    QFETCH(int, loop);
+    QFETCH(int, next);
+
+    QCOMPARE(PlaylistPlayer::nextIndex(currentIndex, count, (PlaylistPlayer::Loop)loop), next);
+}
@@ -0,0 +1,17 @@
+#ifndef PLAYLISTPLAYERTEST_H
+#define PLAYLISTPLAYERTEST_H
+
+#include "autotest.h"
+
+class PlaylistPlayerTest : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    void nextIndex_data();
+    void nextIndex();
+};
+
+DECLARE_TEST(PlaylistPlayerTest)
+
+#endif // PLAYLISTPLAYERTEST_H
@@ -1,7 +1,7 @@
 #ifndef TEST1_H
 #define TEST1_H
 
-#include "AutoTest.h"
+#include "autotest.h"
 
 class Test1 : public QObject
 {
@@ -1,7 +1,7 @@
 #ifndef TEST2_H
 #define TEST2_H
 
-#include "AutoTest.h"
+#include "autotest.h"
 
 class Test2 : public QObject
 {